@@ -370,6 +370,243 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data,
   freemem(cpiv);
 }
 
+void
+decomp_blockpartialaca_rkmatrix(matrixentry_t entry, void *data,
+				const uint * ridx, const uint rows,
+				const uint * cidx, const uint cols, real accur,
+				uint block, uint ** rpivot, uint ** cpivot,
+				prkmatrix R)
+{
+  pamatrix  A, B, X, Y, AI, BJ;
+  amatrix   Xtmp, Ytmp, AItmp, BJtmp;
+  bool     *rused, *cused;
+  uint     *rpiv, *cpiv, *rsel, *csel, *ridxp, *cidxp;
+  uint      i, j, l, m, p, q, k, kmax, i_k, j_k, ldx, ldy;
+  real      error, starterror, normx, normy, M;
+  field     alpha;
+  pfield    aa, bb, xx, yy;
+
+  if (block < 1) {
+    block = 1;
+  }
+
+  kmax = UINT_MIN(rows, cols);
+
+  rused = (bool *) allocmem(rows * sizeof(bool));
+  cused = (bool *) allocmem(cols * sizeof(bool));
+  rpiv = allocuint(kmax);
+  cpiv = allocuint(kmax);
+  rsel = allocuint(block);
+  csel = allocuint(block);
+  ridxp = allocuint(block);
+  cidxp = allocuint(block);
+
+  for (i = 0; i < rows; ++i) {
+    rused[i] = false;
+  }
+
+  for (j = 0; j < cols; ++j) {
+    cused[j] = false;
+  }
+
+  A = &R->A;
+  B = &R->B;
+  resize_amatrix(A, rows, 0);
+  resize_amatrix(B, cols, 0);
+
+  k = 0;
+  q = 0;
+  error = 1.0;
+  starterror = 1.0;
+
+  while (error > accur && k < kmax) {
+    p = UINT_MIN(block, kmax - k);
+
+    /* Choose the next block of pivot rows: spread over the block in the
+     * first step, afterwards the maxima of the last block of columns. */
+    if (k == 0) {
+      for (l = 0; l < p; ++l) {
+	i_k = (2 * l + 1) * rows / (2 * p);
+	rsel[l] = i_k;
+	rused[i_k] = true;
+      }
+    }
+    else {
+      aa = A->a;
+      for (l = 0; l < p; ++l) {
+	m = k - q + UINT_MIN(l, q - 1);
+	M = -1.0;
+	i_k = rows;
+	for (i = 0; i < rows; ++i) {
+	  if (!rused[i] && ABSSQR(aa[i + m * A->ld]) > M) {
+	    M = ABSSQR(aa[i + m * A->ld]);
+	    i_k = i;
+	  }
+	}
+	if (i_k == rows) {
+	  break;
+	}
+	rsel[l] = i_k;
+	rused[i_k] = true;
+      }
+      p = l;
+    }
+
+    if (p == 0) {
+      break;
+    }
+
+    /* Get the adjoint row panel and subtract the current approximation,
+     * Y = G_{|I}^* - B A_{|I}^* */
+    for (l = 0; l < p; ++l) {
+      ridxp[l] = ridx[rsel[l]];
+    }
+    Y = init_amatrix(&Ytmp, cols, p);
+    entry(ridxp, cidx, data, true, Y);
+    conjugate_amatrix(Y);
+
+    if (k > 0) {
+      AI = init_amatrix(&AItmp, p, k);
+      for (m = 0; m < k; ++m) {
+	for (l = 0; l < p; ++l) {
+	  AI->a[l + m * AI->ld] = A->a[rsel[l] + m * A->ld];
+	}
+      }
+      addmul_amatrix(-1.0, false, B, true, AI, Y);
+      uninit_amatrix(AI);
+    }
+
+    /* Eliminate within the panel and choose the pivot columns. */
+    yy = Y->a;
+    ldy = Y->ld;
+    q = 0;
+    for (l = 0; l < p; ++l) {
+      for (m = 0; m < q; ++m) {
+	alpha = yy[csel[m] + l * ldy] / yy[csel[m] + m * ldy];
+	for (j = 0; j < cols; ++j) {
+	  yy[j + l * ldy] -= alpha * yy[j + m * ldy];
+	}
+      }
+
+      M = 0.0;
+      j_k = cols;
+      for (j = 0; j < cols; ++j) {
+	if (!cused[j] && ABSSQR(yy[j + l * ldy]) > M) {
+	  M = ABSSQR(yy[j + l * ldy]);
+	  j_k = j;
+	}
+      }
+
+      if (j_k < cols) {
+	cused[j_k] = true;
+	csel[q] = j_k;
+	rpiv[k + q] = rsel[l];
+	cpiv[k + q] = j_k;
+	if (q < l) {
+	  for (j = 0; j < cols; ++j) {
+	    yy[j + q * ldy] = yy[j + l * ldy];
+	  }
+	}
+	q++;
+      }
+    }
+
+    if (q == 0) {
+      /* All chosen rows are already reproduced exactly. */
+      uninit_amatrix(Y);
+      error = 0.0;
+      break;
+    }
+
+    /* Get the column panel and subtract the current approximation,
+     * X = G_{|J} - A B_{|J}^* */
+    for (l = 0; l < q; ++l) {
+      cidxp[l] = cidx[csel[l]];
+    }
+    X = init_amatrix(&Xtmp, rows, q);
+    entry(ridx, cidxp, data, false, X);
+
+    if (k > 0) {
+      BJ = init_amatrix(&BJtmp, q, k);
+      for (m = 0; m < k; ++m) {
+	for (l = 0; l < q; ++l) {
+	  BJ->a[l + m * BJ->ld] = B->a[csel[l] + m * B->ld];
+	}
+      }
+      addmul_amatrix(-1.0, false, A, true, BJ, X);
+      uninit_amatrix(BJ);
+    }
+
+    /* Eliminate within the panel. */
+    xx = X->a;
+    ldx = X->ld;
+    for (l = 1; l < q; ++l) {
+      for (m = 0; m < l; ++m) {
+	i_k = rpiv[k + m];
+	alpha = xx[i_k + l * ldx] / xx[i_k + m * ldx];
+	for (i = 0; i < rows; ++i) {
+	  xx[i + l * ldx] -= alpha * xx[i + m * ldx];
+	}
+      }
+    }
+
+    /* Append the new crosses and estimate the error. */
+    resizecopy_amatrix(A, rows, k + q);
+    resizecopy_amatrix(B, cols, k + q);
+    aa = A->a;
+    bb = B->a;
+
+    for (l = 0; l < q; ++l) {
+      alpha = 1.0 / xx[rpiv[k + l] + l * ldx];
+      normx = 0.0;
+      for (i = 0; i < rows; ++i) {
+	aa[i + (k + l) * A->ld] = xx[i + l * ldx] * alpha;
+	normx += ABSSQR(aa[i + (k + l) * A->ld]);
+      }
+      normy = 0.0;
+      for (j = 0; j < cols; ++j) {
+	bb[j + (k + l) * B->ld] = yy[j + l * ldy];
+	normy += ABSSQR(bb[j + (k + l) * B->ld]);
+      }
+
+      if (k + l == 0) {
+	starterror = REAL_SQRT(normx * normy);
+      }
+      error = REAL_SQRT(normx * normy) / starterror;
+    }
+
+    k += q;
+
+    uninit_amatrix(X);
+    uninit_amatrix(Y);
+  }
+
+  R->k = k;
+
+  if (rpivot != NULL) {
+    *rpivot = allocuint(k);
+    for (i = 0; i < k; ++i) {
+      (*rpivot)[i] = ridx[rpiv[i]];
+    }
+  }
+
+  if (cpivot != NULL) {
+    *cpivot = allocuint(k);
+    for (i = 0; i < k; ++i) {
+      (*cpivot)[i] = cidx[cpiv[i]];
+    }
+  }
+
+  freemem(cidxp);
+  freemem(ridxp);
+  freemem(csel);
+  freemem(rsel);
+  freemem(cpiv);
+  freemem(rpiv);
+  freemem(cused);
+  freemem(rused);
+}
+
 void
 copy_lower_aca_amatrix(bool unit, pcamatrix A, uint * xi, pamatrix B)
 {
@@ -116,6 +116,45 @@ decomp_partialaca_rkmatrix(matrixentry_t entry, void *data, const uint *ridx,
     const uint rows, const uint *cidx, const uint cols, real accur,
     uint **rpivot, uint **cpivot, prkmatrix R);
 
+/**
+ * @brief This routine computes the adaptive cross approximation using blocked
+ * partial pivoting of an implicitly given matrix @f$ A @f$.
+ *
+ * Instead of a single pivot, every step chooses up to <tt>block</tt> pivot
+ * rows, evaluates the corresponding rows of @f$ A @f$ with one call of
+ * <tt>entry</tt>, and subtracts the current approximation with a
+ * matrix-matrix multiplication. The pivot columns are found by elimination
+ * within this panel, the corresponding columns of @f$ A @f$ are again
+ * evaluated with one call of <tt>entry</tt> and updated the same way.
+ * The next pivot rows are the maxima of the new columns.
+ *
+ * The iteration stops if the norm of the last rank-1 term relative to the
+ * first one drops below <tt>accur</tt>, as in
+ * @ref decomp_partialaca_rkmatrix, which is recovered for
+ * <tt>block == 1</tt>.
+ *
+ * @param entry Callback function defining the matrix @f$ A @f$, see
+ * @ref decomp_partialaca_rkmatrix.
+ * @param data An additional void-pointer to some data-object that will be needed
+ * by <tt>entry</tt> to compute the matrix entries.
+ * @param ridx An array of all row indices defining the complete matrix @f$ A @f$.
+ * @param rows Number of rows for the implicit matrix and therefore the length of
+ * <tt>ridx</tt>.
+ * @param cidx An array of all column indices defining the complete matrix @f$ A @f$.
+ * @param cols Number of columns for the implicit matrix and therefore the length of
+ * <tt>cidx</tt>.
+ * @param accur Accuracy defining how good the approximation has to be relative
+ * to the input matrix.
+ * @param block Maximal number of pivots chosen in one step.
+ * @param rpivot Returns an array of row pivot indices, if <tt>rpivot != NULL</tt>.
+ * @param cpivot Returns an array of column pivot indices, if <tt>cpivot != NULL</tt>.
+ * @param R The resulting low rank matrix is returned via <tt>R</tt> .
+ */
+HEADER_PREFIX void
+decomp_blockpartialaca_rkmatrix(matrixentry_t entry, void *data,
+    const uint *ridx, const uint rows, const uint *cidx, const uint cols,
+    real accur, uint block, uint **rpivot, uint **cpivot, prkmatrix R);
+
 /**
  * @brief Copies the lower triangular part of a matrix <tt>A</tt> to a matrix <tt>B</tt>
  * after applying the row pivoting denoted by <tt>xi</tt>.
@@ -37,6 +37,25 @@ init_amatrix(pamatrix a, uint rows, uint cols)
   return a;
 }
 
+pamatrix
+init_scratch_amatrix(pamatrix a, uint rows, uint cols)
+{
+  assert(a != NULL);
+
+  a->a = (field *) allocscratch(sizeof(field) * rows * cols);
+  a->ld = rows;
+  a->rows = rows;
+  a->cols = cols;
+  a->owner = NULL;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_amatrix++;
+
+  return a;
+}
+
 pamatrix
 init_sub_amatrix(pamatrix a, pamatrix src, uint rows, uint roff,
 		 uint cols, uint coff)
@@ -90,7 +109,7 @@ init_pointer_amatrix(pamatrix a, pfield src, uint rows, uint cols)
   a->a = src;
   a->rows = rows;
   a->ld = rows;
-  a->cols = rows;
+  a->cols = cols;
   a->owner = src;
 
 #ifdef USE_OPENMP
@@ -72,6 +72,21 @@ struct _amatrix {
 HEADER_PREFIX pamatrix
 init_amatrix(pamatrix a, uint rows, uint cols);
 
+/** @brief Initialize an @ref amatrix object for a temporary matrix.
+ *
+ *  Like @ref init_amatrix, but the coefficient array is taken from the
+ *  scratch stack of the calling thread, see @ref allocscratch.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_amatrix
+ *  in the same thread, preferably in reverse order of initialization.
+ *
+ *  @param a Object to be initialized.
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @returns Initialized @ref amatrix object. */
+HEADER_PREFIX pamatrix
+init_scratch_amatrix(pamatrix a, uint rows, uint cols);
+
 /** @brief Initialize an @ref amatrix object to represent a submatrix.
  *
  *  Sets up the components of the object and uses part of the storage
@@ -35,6 +35,23 @@ init_avector(pavector v, uint dim)
   return v;
 }
 
+pavector
+init_scratch_avector(pavector v, uint dim)
+{
+  assert(v != NULL);
+
+  v->v = (field *) allocscratch(sizeof(field) * dim);
+  v->dim = dim;
+  v->owner = NULL;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_avector++;
+
+  return v;
+}
+
 pavector
 init_sub_avector(pavector v, pavector src, uint dim, uint off)
 {
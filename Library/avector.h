@@ -64,6 +64,20 @@ struct _avector {
 HEADER_PREFIX pavector
 init_avector(pavector v, uint dim);
 
+/** @brief Initialize an @ref avector object for a temporary vector.
+ *
+ *  Like @ref init_avector, but the coefficient array is taken from the
+ *  scratch stack of the calling thread, see @ref allocscratch.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_avector
+ *  in the same thread, preferably in reverse order of initialization.
+ *
+ *  @param v Object to be initialized.
+ *  @param dim Dimension of the new vector.
+ *  @returns Initialized @ref avector object. */
+HEADER_PREFIX pavector
+init_scratch_avector(pavector v, uint dim);
+
 /** @brief Initialize an @ref avector object to represent a subvector.
  *
  *  Sets up the components of the object and uses part of the storage
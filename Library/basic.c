@@ -6,6 +6,7 @@
 
 #include "basic.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #ifdef WIN32
 #include <Windows.h>
@@ -35,6 +36,42 @@
 
 int       max_pardepth = 0;
 
+/* Initial size of the scratch stack in bytes */
+#define SCRATCHSIZE ((size_t) 1 << 16)
+
+/* Alignment of blocks on the scratch stack in bytes */
+#define ALIGN_SCRATCH 16
+
+/* Header preceding every block on the scratch stack, its size is a
+ * multiple of ALIGN_SCRATCH */
+typedef union {
+  struct {
+    /* Offset of the header of the previous block */
+    size_t    prev;
+    /* Set if the block has been released */
+    size_t    released;
+  } h;
+  char      pad[ALIGN_SCRATCH];
+} scratchheader;
+
+typedef struct {
+  /* Storage of the stack */
+  char     *mem;
+  /* Size of the storage */
+  size_t    size;
+  /* First unused byte */
+  size_t    top;
+  /* Offset of the header of the topmost block, SIZE_MAX if empty */
+  size_t    last;
+  /* Largest size requested so far, used when the stack is empty */
+  size_t    want;
+} scratchstack;
+
+static scratchstack scratch = { NULL, 0, 0, SIZE_MAX, 0 };
+#ifdef USE_OPENMP
+#pragma omp threadprivate(scratch)
+#endif
+
 /* ------------------------------------------------------------
  * Set up the library
  * ------------------------------------------------------------ */
@@ -80,10 +117,324 @@ init_h2lib(int *argc, char ***argv)
 #endif
 }
 
+/* Release the scratch stack of this thread unless it is still in use */
+static void
+releasestack()
+{
+  if (scratch.top == 0) {
+    free(scratch.mem);
+    scratch.mem = NULL;
+    scratch.size = 0;
+    scratch.want = 0;
+  }
+}
+
 void
 uninit_h2lib()
 {
+  /* Every thread of the team, including the calling one, releases its
+   * own stack; the threads of the outermost team are reused by OpenMP
+   * runtimes, so this also covers the stacks grown in earlier parallel
+   * regions */
+#ifdef USE_OPENMP
+#pragma omp parallel
+#endif
+  releasestack();
+}
+
+/* ------------------------------------------------------------
+ * Arenas
+ * ------------------------------------------------------------ */
+
+/* Alignment of slabs and of large allocations in bytes */
+#define ALIGN_ARENA 64
+
+/* Alignment of small allocations in bytes */
+#define ALIGN_SMALL_ARENA 16
+
+/* Default and maximal size of a slab in bytes */
+#define SLABSIZE_ARENA ((size_t) 1 << 20)
+#define MAXSLABSIZE_ARENA ((size_t) 1 << 26)
+
+typedef struct _arenaslab arenaslab;
+typedef arenaslab *parenaslab;
+
+struct _arenaslab {
+  /* Usable storage, aligned to ALIGN_ARENA */
+  char     *mem;
+  /* Size of the usable storage */
+  size_t    size;
+  /* Number of bytes already handed out */
+  size_t    used;
+  /* Previously filled slab */
+  parenaslab next;
+};
+
+struct _arena {
+  /* Current slab, followed by the older ones */
+  parenaslab slab;
+  /* Size of the next slab */
+  size_t    slabsize;
+  /* Bounds of all slabs, used to reject foreign pointers quickly */
+  const char *lo, *hi;
+
+  /* List of all arenas */
+  parena    next;
+  parena    prev;
+};
+
+/* All arenas, searched by freemem */
+static parena arenas = NULL;
+
+/* Arena used by the allocation functions of this thread */
+static parena current_arena = NULL;
+#ifdef USE_OPENMP
+#pragma omp threadprivate(current_arena)
+#endif
+
+static void
+new_slab(parena a, size_t sz)
+{
+  parenaslab s;
+  size_t    size;
+
+  size = a->slabsize;
+  while (size < sz)
+    size *= 2;
+
+  s = (parenaslab) malloc(sizeof(arenaslab) + size + ALIGN_ARENA);
+  if (s == NULL) {
+    (void) fprintf(stderr, "Allocation of arena slab with %lu bytes failed\n",
+		   (unsigned long) size);
+    abort();
+  }
+
+  s->mem = (char *) (((size_t) (s + 1) + ALIGN_ARENA - 1)
+		     / ALIGN_ARENA * ALIGN_ARENA);
+  s->size = size;
+  s->used = 0;
+  s->next = a->slab;
+  a->slab = s;
+
+  if (a->lo == NULL || s->mem < a->lo)
+    a->lo = s->mem;
+  if (a->hi == NULL || s->mem + size > a->hi)
+    a->hi = s->mem + size;
+
+  if (a->slabsize < MAXSLABSIZE_ARENA)
+    a->slabsize *= 2;
+}
+
+static void *
+getmem_arena(parena a, size_t sz)
+{
+  parenaslab s;
+  size_t    align, off;
+
+  if (sz == 0)
+    return NULL;
+
+  align = (sz >= ALIGN_ARENA ? ALIGN_ARENA : ALIGN_SMALL_ARENA);
+
+  s = a->slab;
+  off = (s ? (s->used + align - 1) / align * align : 0);
+  if (s == NULL || off + sz > s->size) {
+    new_slab(a, sz);
+    s = a->slab;
+    off = 0;
+  }
+
+  s->used = off + sz;
+
+  return s->mem + off;
+}
+
+/* Storage for the allocation functions, taken from the selected arena
+ * if there is one */
+static void *
+getmem(size_t sz)
+{
+  if (current_arena)
+    return getmem_arena(current_arena, sz);
+
+  return malloc(sz);
+}
+
+parena
+new_arena(size_t slabsize)
+{
+  parena    a;
+
+  a = (parena) malloc(sizeof(arena));
+  if (a == NULL) {
+    (void) fprintf(stderr, "Allocation of arena failed\n");
+    abort();
+  }
+
+  a->slab = NULL;
+  a->slabsize = (slabsize > 0 ? slabsize : SLABSIZE_ARENA);
+  a->lo = a->hi = NULL;
+
+#ifdef USE_OPENMP
+#pragma omp critical(arena)
+#endif
+  {
+    a->prev = NULL;
+    a->next = arenas;
+    if (arenas)
+      arenas->prev = a;
+    arenas = a;
+  }
+
+  return a;
+}
+
+void
+del_arena(parena a)
+{
+  parenaslab s, s1;
+
+  assert(current_arena != a);
+
+#ifdef USE_OPENMP
+#pragma omp critical(arena)
+#endif
+  {
+    if (a->prev)
+      a->prev->next = a->next;
+    else
+      arenas = a->next;
+    if (a->next)
+      a->next->prev = a->prev;
+  }
+
+  s = a->slab;
+  while (s) {
+    s1 = s->next;
+    free(s);
+    s = s1;
+  }
+
+  free(a);
+}
+
+parena
+select_arena(parena a)
+{
+  parena    old;
+
+  old = current_arena;
+  current_arena = a;
+
+  return old;
+}
+
+bool
+contains_arena(pcarena a, const void *ptr)
+{
+  parenaslab s;
+  const char *p = (const char *) ptr;
+
+  if (p < a->lo || p >= a->hi)
+    return false;
+
+  for (s = a->slab; s; s = s->next)
+    if (p >= s->mem && p < s->mem + s->size)
+      return true;
+
+  return false;
+}
+
+size_t
+getsize_arena(pcarena a)
+{
+  parenaslab s;
+  size_t    sz;
+
+  sz = sizeof(arena);
+  for (s = a->slab; s; s = s->next)
+    sz += sizeof(arenaslab) + s->size + ALIGN_ARENA;
 
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ * Scratch storage
+ * ------------------------------------------------------------ */
+
+void *
+allocscratch(size_t sz)
+{
+  scratchheader *hd;
+  void     *ptr;
+  size_t    need;
+
+  if (sz == 0)
+    return NULL;
+
+  need = sizeof(scratchheader)
+    + (sz + ALIGN_SCRATCH - 1) / ALIGN_SCRATCH * ALIGN_SCRATCH;
+
+  if (scratch.top + need > scratch.want)
+    scratch.want = scratch.top + need;
+
+  /* Enlarge the stack only while it is empty */
+  if (scratch.top == 0 && scratch.want > scratch.size) {
+    free(scratch.mem);
+    scratch.size = (scratch.size > 0 ? scratch.size : SCRATCHSIZE);
+    while (scratch.size < scratch.want)
+      scratch.size *= 2;
+    scratch.mem = (char *) malloc(scratch.size);
+    if (scratch.mem == NULL) {
+      (void) fprintf(stderr, "Allocation of scratch stack with %lu bytes"
+		     " failed\n", (unsigned long) scratch.size);
+      abort();
+    }
+  }
+
+  /* Fall back to the heap if the stack is full */
+  if (scratch.top + need > scratch.size) {
+    ptr = malloc(sz);
+    if (ptr == NULL) {
+      (void) fprintf(stderr, "Allocation of %lu bytes failed\n",
+		     (unsigned long) sz);
+      abort();
+    }
+    return ptr;
+  }
+
+  hd = (scratchheader *) (scratch.mem + scratch.top);
+  hd->h.prev = scratch.last;
+  hd->h.released = 0;
+  scratch.last = scratch.top;
+  scratch.top += need;
+
+  return hd + 1;
+}
+
+/* Release a block if it belongs to the scratch stack of this thread */
+static bool
+releasescratch(void *ptr)
+{
+  scratchheader *hd;
+  const char *p = (const char *) ptr;
+
+  if (p < scratch.mem || p >= scratch.mem + scratch.size)
+    return false;
+
+  hd = (scratchheader *) ptr - 1;
+  hd->h.released = 1;
+
+  /* Pop all released blocks from the top of the stack */
+  while (scratch.last != SIZE_MAX) {
+    hd = (scratchheader *) (scratch.mem + scratch.last);
+    if (!hd->h.released)
+      break;
+    scratch.top = scratch.last;
+    scratch.last = hd->h.prev;
+  }
+
+  return true;
 }
 
 /* ------------------------------------------------------------
@@ -95,7 +446,7 @@ _h2_allocmem(size_t sz, const char *filename, int line)
 {
   void     *ptr;
 
-  ptr = malloc(sz);
+  ptr = getmem(sz);
   if (ptr == NULL && sz > 0) {
     (void) fprintf(stderr, "Memory allocation of %lu bytes failed in %s:%d\n",
 		   (unsigned long) sz, filename, line);
@@ -118,7 +469,7 @@ _h2_allocuint(size_t sz, const char *filename, int line)
     abort();
   }
 
-  ptr = (uint *) malloc(dsz);
+  ptr = (uint *) getmem(dsz);
   if (ptr == NULL && dsz > 0) {
     (void) fprintf(stderr,
 		   "Vector allocation of %lu entries failed in %s:%d\n",
@@ -142,7 +493,7 @@ _h2_allocreal(size_t sz, const char *filename, int line)
     abort();
   }
 
-  ptr = (real *) malloc(dsz);
+  ptr = (real *) getmem(dsz);
   if (ptr == NULL && dsz > 0) {
     (void) fprintf(stderr,
 		   "Vector allocation of %lu entries failed in %s:%d\n",
@@ -166,7 +517,7 @@ _h2_allocfield(size_t sz, const char *filename, int line)
     abort();
   }
 
-  ptr = (field *) malloc(dsz);
+  ptr = (field *) getmem(dsz);
   if (ptr == NULL && dsz > 0) {
     (void) fprintf(stderr,
 		   "Vector allocation of %lu entries failed in %s:%d\n",
@@ -190,7 +541,7 @@ _h2_allocmatrix(size_t rows, size_t cols, const char *filename, int line)
     abort();
   }
 
-  ptr = (field *) malloc(dsz);
+  ptr = (field *) getmem(dsz);
   if (ptr == NULL && dsz > 0) {
     (void) fprintf(stderr,
 		   "Matrix allocation with %lu rows and %lu columns failed in %s:%d\n",
@@ -205,6 +556,15 @@ _h2_allocmatrix(size_t rows, size_t cols, const char *filename, int line)
 void
 freemem(void *ptr)
 {
+  parena    a;
+
+  if (releasescratch(ptr))
+    return;
+
+  for (a = arenas; a; a = a->next)
+    if (contains_arena(a, ptr))
+      return;
+
   free(ptr);
 }
 
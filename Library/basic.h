@@ -20,6 +20,15 @@ typedef struct _stopwatch stopwatch;
 /** @brief Pointer to a @ref stopwatch object. */
 typedef stopwatch *pstopwatch;
 
+/** @brief Arena providing storage from a few large slabs. */
+typedef struct _arena arena;
+
+/** @brief Pointer to an @ref arena object. */
+typedef arena *parena;
+
+/** @brief Pointer to a constant @ref arena object. */
+typedef const arena *pcarena;
+
 #include <stdlib.h>
 #include <assert.h>
 #include <stdarg.h>
@@ -71,7 +80,10 @@ init_h2lib(int *argc, char ***argv);
 /** @brief Uninitialize the library.
  *
  *  This function cleans up the run-time environment once the
- *  library is no longer neede. */
+ *  library is no longer neede.
+ *  The scratch stacks of all threads of an OpenMP team are released;
+ *  stacks of threads that only took part in nested parallel regions
+ *  are kept until the program ends. */
 HEADER_PREFIX void
 uninit_h2lib();
 
@@ -532,12 +544,86 @@ _h2_allocfield(size_t sz, const char *filename, int line);
 field *
 _h2_allocmatrix(size_t rows, size_t cols, const char *filename, int line);
 
+/** @brief Allocate temporary storage from the scratch stack of the
+ *  calling thread.
+ *
+ *  The scratch stack is a buffer that is reused for short-lived
+ *  workspaces, so that no calls to <tt>malloc</tt> and no page faults
+ *  are required once it has reached its working size. Blocks should
+ *  be released in reverse order of allocation by @ref freemem called
+ *  from the same thread; blocks released out of order are reclaimed
+ *  as soon as the blocks above them have been released.
+ *  If the stack is too small, the storage is taken from the heap and
+ *  the stack is enlarged the next time it is empty.
+ *
+ *  @param sz Storage size in bytes.
+ *  @returns Pointer to storage, aligned to 16 bytes. */
+HEADER_PREFIX void *
+allocscratch(size_t sz);
+
 /** @brief Release allocated storage.
+ *
+ *  Storage taken from an @ref arena is only released together with
+ *  the arena, so this function does nothing for such pointers.
+ *  Storage taken from the scratch stack by @ref allocscratch is
+ *  returned to the stack.
  *
  *  @param ptr Pointer to allocated storage. */
 void
 freemem(void *ptr);
 
+/* ------------------------------------------------------------
+ * Arenas
+ * ------------------------------------------------------------ */
+
+/** @brief Create an @ref arena.
+ *
+ *  An arena hands out storage from a few large slabs aligned to
+ *  cache lines. While it is selected by @ref select_arena, all
+ *  allocations of the calling thread by @ref allocmem and its relatives
+ *  use the arena instead of <tt>malloc</tt>.
+ *  @ref freemem ignores storage belonging to an arena, everything is
+ *  released at once by @ref del_arena.
+ *
+ *  Arenas should not be created or deleted while other threads are
+ *  allocating or releasing storage.
+ *
+ *  @param slabsize Size of the first slab in bytes, later slabs grow
+ *         geometrically. Zero selects a default of one megabyte.
+ *  @returns New @ref arena object. */
+HEADER_PREFIX parena
+new_arena(size_t slabsize);
+
+/** @brief Delete an @ref arena and release all storage taken from it.
+ *
+ *  @param a Object to be deleted, must not be selected. */
+HEADER_PREFIX void
+del_arena(parena a);
+
+/** @brief Select the @ref arena used by @ref allocmem and its relatives
+ *  in the calling thread.
+ *
+ *  @param a New arena, <tt>NULL</tt> selects <tt>malloc</tt>.
+ *  @returns Previously selected arena, to be restored by the caller. */
+HEADER_PREFIX parena
+select_arena(parena a);
+
+/** @brief Check whether storage belongs to an @ref arena.
+ *
+ *  @param a Arena.
+ *  @param ptr Pointer to storage.
+ *  @returns <tt>true</tt> if <tt>ptr</tt> lies in one of the slabs of
+ *           <tt>a</tt>. */
+HEADER_PREFIX bool
+contains_arena(pcarena a, const void *ptr);
+
+/** @brief Compute the size of an @ref arena.
+ *
+ *  @param a Arena.
+ *  @returns Size of all slabs in bytes. */
+HEADER_PREFIX size_t
+getsize_arena(pcarena a);
+
 /* ------------------------------------------------------------
  * Sorting
  * ------------------------------------------------------------ */
@@ -1406,17 +1406,8 @@ assemble_bem2d_greenhybrid_row_rkmatrix(pccluster rc, uint rname,
 
   (void) cname;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    grc = par->grcn[rname];
-
-    if (grc == NULL) {
-      grc = par->grcn[rname] = new_greencluster2d(rc);
-      assemble_row_greencluster2d(bem, grc);
-    }
-  }
+  grc = par->grcn[rname];
+  assert(grc != NULL);
 
   V = grc->V;
   rank = V->cols;
@@ -1513,17 +1504,8 @@ assemble_bem2d_greenhybrid_col_rkmatrix(pccluster rc, uint rname,
 
   (void) rname;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    gcc = par->gccn[cname];
-
-    if (gcc == NULL) {
-      gcc = par->gccn[cname] = new_greencluster2d(cc);
-      assemble_col_greencluster2d(bem, gcc);
-    }
-  }
+  gcc = par->gccn[cname];
+  assert(gcc != NULL);
 
   V = gcc->V;
   rank = V->cols;
@@ -1551,29 +1533,11 @@ assemble_bem2d_greenhybrid_mixed_rkmatrix(pccluster rc, uint rname,
   uint     *xihatV, *xihatW;
   uint      rankV, rankW;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    grc = par->grcn[rname];
-
-    if (grc == NULL) {
-      grc = par->grcn[rname] = new_greencluster2d(rc);
-      assemble_row_greencluster2d(bem, grc);
-    }
-  }
+  grc = par->grcn[rname];
+  assert(grc != NULL);
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    gcc = par->gccn[cname];
-
-    if (gcc == NULL) {
-      gcc = par->gccn[cname] = new_greencluster2d(cc);
-      assemble_col_greencluster2d(bem, gcc);
-    }
-  }
+  gcc = par->gccn[cname];
+  assert(gcc != NULL);
 
   rankV = grc->V->cols;
   rankW = gcc->V->cols;
@@ -3185,6 +3149,103 @@ setup_hmatrix_aprx_green_mixed_bem2d(pbem2d bem, pccluster rc,
   bem->transfer_col = NULL;
 }
 
+/* Collect the row clusters of all admissible leaves, indexed by their
+ * names */
+static void
+collect_row_greencluster2d(pcblock b, uint bname, uint rname, uint cname,
+			   uint pardepth, void *data)
+{
+  pccluster *rcn = (pccluster *) data;
+
+  (void) bname;
+  (void) cname;
+  (void) pardepth;
+
+  if (b->son == NULL && b->a) {
+    rcn[rname] = b->rc;
+  }
+}
+
+/* Collect the column clusters of all admissible leaves, indexed by their
+ * names */
+static void
+collect_col_greencluster2d(pcblock b, uint bname, uint rname, uint cname,
+			   uint pardepth, void *data)
+{
+  pccluster *ccn = (pccluster *) data;
+
+  (void) bname;
+  (void) rname;
+  (void) pardepth;
+
+  if (b->son == NULL && b->a) {
+    ccn[cname] = b->cc;
+  }
+}
+
+/* Set up the greencluster2d objects of all row clusters that appear in
+ * admissible leaves of the block tree before the assembly starts.
+ * The clusters are independent and are set up in parallel, while the
+ * assembly of the leaves only reads them and needs no lock. */
+static void
+setup_row_greencluster2d(pcbem2d bem, pccluster rc, pcblock tree)
+{
+  pparbem2d par = bem->par;
+  pccluster *rcn;
+  uint      n = rc->desc;
+  uint      i;
+
+  rcn = (pccluster *) allocmem((size_t) n * sizeof(pccluster));
+  for (i = 0; i < n; ++i) {
+    rcn[i] = NULL;
+  }
+
+  iterate_block(tree, 0, 0, 0, collect_row_greencluster2d, NULL, rcn);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(max_pardepth > 0)
+#endif
+  for (i = 0; i < n; ++i) {
+    if (rcn[i] != NULL) {
+      par->grcn[i] = new_greencluster2d(rcn[i]);
+      assemble_row_greencluster2d(bem, par->grcn[i]);
+    }
+  }
+
+  freemem(rcn);
+}
+
+/* Set up the greencluster2d objects of all column clusters that appear
+ * in admissible leaves of the block tree, see
+ * setup_row_greencluster2d */
+static void
+setup_col_greencluster2d(pcbem2d bem, pccluster cc, pcblock tree)
+{
+  pparbem2d par = bem->par;
+  pccluster *ccn;
+  uint      n = cc->desc;
+  uint      i;
+
+  ccn = (pccluster *) allocmem((size_t) n * sizeof(pccluster));
+  for (i = 0; i < n; ++i) {
+    ccn[i] = NULL;
+  }
+
+  iterate_block(tree, 0, 0, 0, collect_col_greencluster2d, NULL, ccn);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(max_pardepth > 0)
+#endif
+  for (i = 0; i < n; ++i) {
+    if (ccn[i] != NULL) {
+      par->gccn[i] = new_greencluster2d(ccn[i]);
+      assemble_col_greencluster2d(bem, par->gccn[i]);
+    }
+  }
+
+  freemem(ccn);
+}
+
 void
 setup_hmatrix_aprx_greenhybrid_row_bem2d(pbem2d bem, pccluster rc,
 					 pccluster cc, pcblock tree, uint m,
@@ -3196,7 +3257,6 @@ setup_hmatrix_aprx_greenhybrid_row_bem2d(pbem2d bem, pccluster rc,
   uint      n, i;
 
   (void) cc;
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->fundamental_row != NULL);
@@ -3235,6 +3295,8 @@ setup_hmatrix_aprx_greenhybrid_row_bem2d(pbem2d bem, pccluster rc,
   }
 
   par->grcnn = n;
+
+  setup_row_greencluster2d(bem, rc, tree);
 }
 
 void
@@ -3248,7 +3310,6 @@ setup_hmatrix_aprx_greenhybrid_col_bem2d(pbem2d bem, pccluster rc,
   uint      i, n;
 
   (void) rc;
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->kernel_col != NULL);
@@ -3287,6 +3348,8 @@ setup_hmatrix_aprx_greenhybrid_col_bem2d(pbem2d bem, pccluster rc,
   }
 
   par->gccnn = n;
+
+  setup_col_greencluster2d(bem, cc, tree);
 }
 
 void
@@ -3299,7 +3362,6 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem2d(pbem2d bem, pccluster rc,
 
   uint      i, n;
 
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->fundamental_row != NULL);
@@ -3341,6 +3403,8 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem2d(pbem2d bem, pccluster rc,
 
   par->grcnn = n;
 
+  setup_row_greencluster2d(bem, rc, tree);
+
   n = par->gccnn;
 
   if (par->gccn != NULL && par->gccnn > 0) {
@@ -3362,6 +3426,8 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem2d(pbem2d bem, pccluster rc,
   }
 
   par->gccnn = n;
+
+  setup_col_greencluster2d(bem, cc, tree);
 }
 
 void
@@ -1340,7 +1340,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_green_mixed_bem2d(pbem2d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -1401,7 +1403,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_greenhybrid_row_bem2d(pbem2d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -1443,7 +1447,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_greenhybrid_col_bem2d(pbem2d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -4,6 +4,8 @@
  ------------------------------------------------------------ */
 
 /* C STD LIBRARY */
+#include <math.h>
+#include <stdint.h>
 #include <string.h>
 /* CORE 0 */
 #include "basic.h"
@@ -27,6 +29,15 @@
  */
 #define INTERPOLATION_EPS_BEM3D 5.0e-3
 
+/*
+ * @brief Relative resolution of the coupling matrix cache.
+ *
+ * Cluster boxes and offsets are rounded to multiples of
+ * @f$\texttt{COUPLINGCACHE\_EPS\_BEM3D}@f$ times the diameter of the root
+ * clusters before they are compared.
+ */
+#define COUPLINGCACHE_EPS_BEM3D 1.0e-10
+
 /*
  * Just an abbreviation for the struct _greencluster3d .
  */
@@ -53,6 +64,32 @@ typedef greenclusterbasis3d *pgreenclusterbasis3d;
  */
 typedef const greenclusterbasis3d *pcgreenclusterbasis3d;
 
+/*
+ * Just an abbreviation for the struct _couplingcache3d .
+ */
+typedef struct _couplingcache3d couplingcache3d;
+/*
+ * Pointer to a @ref couplingcache3d object.
+ */
+typedef couplingcache3d *pcouplingcache3d;
+/*
+ * Pointer to a constant @ref couplingcache3d object.
+ */
+typedef const couplingcache3d *pccouplingcache3d;
+
+/*
+ * Just an abbreviation for the struct _couplingentry3d .
+ */
+typedef struct _couplingentry3d couplingentry3d;
+/*
+ * Pointer to a @ref couplingentry3d object.
+ */
+typedef couplingentry3d *pcouplingentry3d;
+/*
+ * Pointer to a constant @ref couplingentry3d object.
+ */
+typedef const couplingentry3d *pccouplingentry3d;
+
 /*
  * @brief Substructure used for approximating @ref _hmatrix "h-", @ref
  * _uniformhmatrix "uniformh-" and @ref _h2matrix "h2matrices".
@@ -77,6 +114,24 @@ struct _aprxbem3d {
    */
   uint      k_inter;
 
+  /*
+   * @brief Interpolation orders of the row clusters for variable-order
+   * interpolation, indexed by cluster names, <tt>NULL</tt> otherwise.
+   */
+  uint     *m_row_var;
+
+  /*
+   * @brief Interpolation orders of the column clusters for variable-order
+   * interpolation, indexed by cluster names, <tt>NULL</tt> otherwise.
+   */
+  uint     *m_col_var;
+
+  /*
+   * @brief Cache for coupling matrices of translation-invariant kernels,
+   * <tt>NULL</tt> if not used.
+   */
+  pcouplingcache3d cache_inter;
+
   /*
    * @brief Number of interval segments for green-quadrature.
    */
@@ -185,6 +240,17 @@ struct _aprxbem3d {
    */
   real      accur_aca;
 
+  /*
+   * @brief Maximal number of pivots per step for the blocked ACA with partial
+   * pivoting.
+   */
+  uint      block_aca;
+
+  /*
+   * @brief Accuracy for the randomized range finder.
+   */
+  real      accur_rand;
+
   /*
    * @brief This flag indicated if blockwise recompression technique should be used or
    * not.
@@ -266,6 +332,25 @@ struct _greencluster3d {
 /** number of sons for current cluster */
 };
 
+/* Coupling matrix shared by all admissible blocks whose clusters have the
+ * same boxes up to a translation */
+struct _couplingentry3d {
+  int64_t   key[9];		/* rounded extents of both boxes and their offset */
+  uint      kr;			/* rank of the row basis */
+  uint      kc;			/* rank of the column basis */
+  void      (*fundamental) (pcbem3d bem, const real (*X)[3],
+			    const real (*Y)[3], pamatrix V);
+  pamatrix  S;			/* shared coupling matrix */
+  pcouplingentry3d next;	/* next entry in the same bucket */
+};
+
+struct _couplingcache3d {
+  real      h;			/* resolution used to round coordinates */
+  uint      buckets;		/* number of buckets, a power of two */
+  uint      entries;		/* number of distinct coupling matrices */
+  pcouplingentry3d *bucket;	/* hash table */
+};
+
 struct _greenclusterbasis3d {
   uint     *xi;
   /** local indices of pivot elements */
@@ -279,6 +364,180 @@ struct _greenclusterbasis3d {
   uint      m;
 };
 
+/* ------------------------------------------------------------
+ Coupling matrix cache
+ ------------------------------------------------------------ */
+
+static    pcouplingcache3d
+new_couplingcache3d(real h)
+{
+  pcouplingcache3d cache;
+  uint      i;
+
+  assert(h > 0.0);
+
+  cache = (pcouplingcache3d) allocmem(sizeof(couplingcache3d));
+
+  cache->h = h;
+  cache->buckets = 64;
+  cache->entries = 0;
+  cache->bucket = (pcouplingentry3d *)
+    allocmem(sizeof(pcouplingentry3d) * cache->buckets);
+  for (i = 0; i < cache->buckets; i++) {
+    cache->bucket[i] = NULL;
+  }
+
+  return cache;
+}
+
+static void
+del_couplingcache3d(pcouplingcache3d cache)
+{
+  pcouplingentry3d e, next;
+  uint      i;
+
+  for (i = 0; i < cache->buckets; i++) {
+    for (e = cache->bucket[i]; e != NULL; e = next) {
+      next = e->next;
+      del_amatrix(e->S);
+      freemem(e);
+    }
+  }
+  freemem(cache->bucket);
+  freemem(cache);
+}
+
+static    size_t
+getsize_couplingcache3d(pccouplingcache3d cache)
+{
+  pcouplingentry3d e;
+  size_t    sz;
+  uint      i;
+
+  sz = sizeof(couplingcache3d);
+  sz += sizeof(pcouplingentry3d) * cache->buckets;
+  for (i = 0; i < cache->buckets; i++) {
+    for (e = cache->bucket[i]; e != NULL; e = e->next) {
+      sz += sizeof(couplingentry3d) + getsize_amatrix(e->S);
+    }
+  }
+
+  return sz;
+}
+
+static    uint64_t
+hash_couplingentry3d(pccouplingentry3d e)
+{
+  uint64_t  hash;
+  uint      i;
+
+  hash = ((uint64_t) e->kr << 32) ^ e->kc;
+  for (i = 0; i < 9; i++) {
+    hash = (hash ^ (uint64_t) e->key[i]) * 0x100000001b3ULL;
+  }
+
+  return hash ^ (hash >> 29);
+}
+
+static    bool
+equal_couplingentry3d(pccouplingentry3d e, pccouplingentry3d f)
+{
+  uint      i;
+
+  if (e->kr != f->kr || e->kc != f->kc || e->fundamental != f->fundamental) {
+    return false;
+  }
+  for (i = 0; i < 9; i++) {
+    if (e->key[i] != f->key[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Fill the key of an entry: the extents of the row and column boxes and the
+ * offset between them, rounded to multiples of cache->h */
+static void
+setkey_couplingentry3d(pccouplingcache3d cache, pccluster rc, pccluster cc,
+		       pcouplingentry3d e)
+{
+  uint      i;
+
+  for (i = 0; i < 3; i++) {
+    e->key[i] = (int64_t) llround((rc->bmax[i] - rc->bmin[i]) / cache->h);
+    e->key[3 + i] = (int64_t) llround((cc->bmax[i] - cc->bmin[i]) / cache->h);
+    e->key[6 + i] = (int64_t) llround((cc->bmin[i] - rc->bmin[i]) / cache->h);
+  }
+}
+
+static    pcouplingentry3d
+find_couplingcache3d(pccouplingcache3d cache, pccouplingentry3d key)
+{
+  pcouplingentry3d e;
+
+  e = cache->bucket[hash_couplingentry3d(key) & (cache->buckets - 1)];
+  while (e != NULL && !equal_couplingentry3d(e, key)) {
+    e = e->next;
+  }
+
+  return e;
+}
+
+static void
+grow_couplingcache3d(pcouplingcache3d cache)
+{
+  pcouplingentry3d *bucket;
+  pcouplingentry3d e, next;
+  uint      buckets, i, j;
+
+  buckets = 2 * cache->buckets;
+  bucket = (pcouplingentry3d *) allocmem(sizeof(pcouplingentry3d) * buckets);
+  for (i = 0; i < buckets; i++) {
+    bucket[i] = NULL;
+  }
+
+  for (i = 0; i < cache->buckets; i++) {
+    for (e = cache->bucket[i]; e != NULL; e = next) {
+      next = e->next;
+      j = hash_couplingentry3d(e) & (buckets - 1);
+      e->next = bucket[j];
+      bucket[j] = e;
+    }
+  }
+
+  freemem(cache->bucket);
+  cache->bucket = bucket;
+  cache->buckets = buckets;
+}
+
+/* Insert a new entry unless an equal one has been added in the meantime,
+ * returns the entry stored in the cache */
+static    pcouplingentry3d
+insert_couplingcache3d(pcouplingcache3d cache, pcouplingentry3d e)
+{
+  pcouplingentry3d f;
+  uint      j;
+
+  f = find_couplingcache3d(cache, e);
+  if (f != NULL) {
+    del_amatrix(e->S);
+    freemem(e);
+    return f;
+  }
+
+  if (cache->entries >= cache->buckets) {
+    grow_couplingcache3d(cache);
+  }
+
+  j = hash_couplingentry3d(e) & (cache->buckets - 1);
+  e->next = cache->bucket[j];
+  cache->bucket[j] = e;
+  cache->entries++;
+
+  return e;
+}
+
 static void
 uninit_interpolation_bem3d(paprxbem3d aprx)
 {
@@ -286,6 +545,18 @@ uninit_interpolation_bem3d(paprxbem3d aprx)
     freemem(aprx->x_inter);
     aprx->x_inter = NULL;
   }
+  if (aprx->m_row_var != NULL) {
+    freemem(aprx->m_row_var);
+    aprx->m_row_var = NULL;
+  }
+  if (aprx->m_col_var != NULL) {
+    freemem(aprx->m_col_var);
+    aprx->m_col_var = NULL;
+  }
+  if (aprx->cache_inter != NULL) {
+    del_couplingcache3d(aprx->cache_inter);
+    aprx->cache_inter = NULL;
+  }
   aprx->m_inter = 0;
   aprx->k_inter = 0;
 }
@@ -318,6 +589,13 @@ static void
 uninit_aca_bem3d(paprxbem3d aprx)
 {
   aprx->accur_aca = 0.0;
+  aprx->block_aca = 0;
+}
+
+static void
+uninit_rand_bem3d(paprxbem3d aprx)
+{
+  aprx->accur_rand = 0.0;
 }
 
 static void
@@ -452,6 +730,9 @@ new_aprxbem3d()
   aprx->x_inter = NULL;
   aprx->m_inter = 0;
   aprx->k_inter = 0;
+  aprx->m_row_var = NULL;
+  aprx->m_col_var = NULL;
+  aprx->cache_inter = NULL;
 
   /* Green */
   aprx->m_green = 0;
@@ -469,6 +750,10 @@ new_aprxbem3d()
 
   /* ACA */
   aprx->accur_aca = 0.0;
+  aprx->block_aca = 0;
+
+  /* Randomized range finder */
+  aprx->accur_rand = 0.0;
 
   /* Recompression */
   aprx->recomp = false;
@@ -488,6 +773,7 @@ del_aprxbem3d(paprxbem3d aprx)
   uninit_interpolation_bem3d(aprx);
   uninit_green_bem3d(aprx);
   uninit_aca_bem3d(aprx);
+  uninit_rand_bem3d(aprx);
   uninit_recompression_bem3d(aprx);
 
   freemem(aprx);
@@ -510,6 +796,8 @@ new_kernelbem3d()
   kernels->dnz_fundamental_col = NULL;
   kernels->lagrange_row = NULL;
   kernels->lagrange_col = NULL;
+  kernels->dlagrange_row = NULL;
+  kernels->dlagrange_col = NULL;
 
   return kernels;
 }
@@ -632,6 +920,10 @@ new_bem3d(pcsurface3d gr)
   bem->mass = NULL;
   bem->v2t = NULL;
   bem->alpha = 0.0;
+  bem->beta = 0.0;
+  bem->accuracy = ACCURACY_FULL_BEM3D;
+  bem->window_a = 0.0;
+  bem->window_b = 0.0;
 
   bem->N_neumann = 0;
   bem->basis_neumann = BASIS_NONE_BEM3D;
@@ -639,6 +931,7 @@ new_bem3d(pcsurface3d gr)
   bem->basis_dirichlet = BASIS_NONE_BEM3D;
 
   bem->nearfield = NULL;
+  bem->nearfield_wave = NULL;
   bem->farfield_rk = NULL;
   bem->farfield_u = NULL;
   bem->leaf_row = NULL;
@@ -917,353 +1210,504 @@ build_bem3d_cluster(pcbem3d bem, uint clf, basisfunctionbem3d basis)
 }
 
 /****************************************************
- * Nearfield integration routines
+ * Near-field pair table
  ****************************************************/
 
-void
-assemble_cc_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		       bool ntrans, pamatrix N, kernel_func3d kernel)
+/* Collect the triangles in the support of the basis functions idx[0], ...,
+ * idx[size-1] without duplicates. mark[t] == stamp indicates that triangle t
+ * has already been found. */
+static    uint
+collect_triangles_bem3d(pcbem3d bem, basisfunctionbem3d basis,
+			const uint * idx, uint size, uint * mark, uint stamp,
+			uint * tri)
 {
-  const pcsurface3d gr = bem->gr;
-  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
-  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
-  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
-  const real *gr_g = (const real *) gr->g;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
-
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *nx, *ny;
-  const uint *tri_t, *tri_s;
-  real     *xq, *yq, *wq;
-  uint      tp[3], sp[3];
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
-  field     sum;
-  uint      q, nq, ss, tt, s, t;
-
-  for (s = 0; s < cols; ++s) {
-    ss = (cidx == NULL ? s : cidx[s]);
-    tri_s = gr_t[ss];
-    factor = gr_g[ss] * bem->kernel_const;
-    ny = gr_n[ss];
+  plistnode v;
+  uint      i, n, vv;
 
-    for (t = 0; t < rows; ++t) {
-      tt = (ridx == NULL ? t : ridx[t]);
-      tri_t = gr_t[tt];
-      factor2 = factor * gr_g[tt];
-      nx = gr_n[tt];
+  n = 0;
+  if (basis == BASIS_CONSTANT_BEM3D) {
+    for (i = 0; i < size; ++i) {
+      tri[n++] = idx[i];
+    }
+  }
+  else {
+    assert(basis == BASIS_LINEAR_BEM3D);
+    for (i = 0; i < size; ++i) {
+      for (v = bem->v2t[idx[i]], vv = v->data; v->next != NULL;
+	   v = v->next, vv = v->data) {
+	if (mark[vv] != stamp) {
+	  mark[vv] = stamp;
+	  tri[n++] = vv;
+	}
+      }
+    }
+  }
 
-      select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				   &wq, &nq, &sum);
-      wq += 9 * nq;
+  return n;
+}
 
-      A_t = gr_x[tri_t[tp[0]]];
-      B_t = gr_x[tri_t[tp[1]]];
-      C_t = gr_x[tri_t[tp[2]]];
-      A_s = gr_x[tri_s[sp[0]]];
-      B_s = gr_x[tri_s[sp[1]]];
-      C_s = gr_x[tri_s[sp[2]]];
+/* Traverse the block tree. If pos == NULL, the number of pairs within the
+ * inadmissible leaves is added to cnt[t] for every row triangle t,
+ * otherwise the column triangles are stored in col starting at pos[t]. */
+static void
+collect_pairs_bem3d(pcbem3d bem, pcblock b, basisfunctionbem3d rbasis,
+		    basisfunctionbem3d cbasis, uint * mark, uint * stamp,
+		    uint * rtri, uint * ctri, uint * cnt, uint * pos,
+		    uint * col)
+{
+  uint      i, j, rn, cn;
 
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
-
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
-
-	sum += wq[q] * kernel(x, y, nx, ny, (void *) bem);
+  if (b->son) {
+    for (j = 0; j < b->csons; ++j) {
+      for (i = 0; i < b->rsons; ++i) {
+	collect_pairs_bem3d(bem, b->son[i + j * b->rsons], rbasis, cbasis,
+			    mark, stamp, rtri, ctri, cnt, pos, col);
       }
-      if (ntrans) {
-	aa[s + t * ld] = CONJ(sum) * factor2;
+    }
+  }
+  else if (!b->a) {
+    (*stamp)++;
+    rn = collect_triangles_bem3d(bem, rbasis, b->rc->idx, b->rc->size,
+				 mark, *stamp, rtri);
+    (*stamp)++;
+    cn = collect_triangles_bem3d(bem, cbasis, b->cc->idx, b->cc->size,
+				 mark, *stamp, ctri);
+
+    for (i = 0; i < rn; ++i) {
+      if (pos == NULL) {
+	cnt[rtri[i]] += cn;
       }
       else {
-	aa[t + s * ld] = sum * factor2;
-      }
-
-      if (bem->alpha != 0.0 && tt == ss) {
-	if (ntrans) {
-	  aa[t + t * ld] += 0.5 * CONJ(bem->alpha) * gr_g[tt];
-	}
-	else {
-	  aa[t + t * ld] += 0.5 * bem->alpha * gr_g[tt];
+	for (j = 0; j < cn; ++j) {
+	  col[pos[rtri[i]]++] = ctri[j];
 	}
       }
     }
   }
 }
 
-void
-assemble_cc_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		      bool ntrans, pamatrix N, kernel_func3d kernel)
+static    bool
+leq_pairs_bem3d(uint i, uint j, void *data)
 {
-  const pcsurface3d gr = bem->gr;
-  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
-  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
-  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
-  const real *gr_g = (const real *) gr->g;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
-
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *nx, *ny;
-  const uint *tri_t, *tri_s;
-  real     *xq, *yq, *wq;
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
-  field     sum;
-  uint      q, nq, ss, tt, s, t;
-
-  xq = bem->sq->x_dist;
-  yq = bem->sq->y_dist;
-  nq = bem->sq->n_dist;
-  wq = bem->sq->w_dist + 9 * nq;
-
-  for (s = 0; s < cols; ++s) {
-    ss = (cidx == NULL ? s : cidx[s]);
-    tri_s = gr_t[ss];
-    factor = gr_g[ss] * bem->kernel_const;
+  uint     *col = (uint *) data;
 
-    A_s = gr_x[tri_s[0]];
-    B_s = gr_x[tri_s[1]];
-    C_s = gr_x[tri_s[2]];
-    ny = gr_n[ss];
+  return col[i] <= col[j];
+}
 
-    for (t = 0; t < rows; ++t) {
-      tt = (ridx == NULL ? t : ridx[t]);
-      tri_t = gr_t[tt];
-      factor2 = factor * gr_g[tt];
+static void
+swap_pairs_bem3d(uint i, uint j, void *data)
+{
+  uint     *col = (uint *) data;
+  uint      h;
 
-      A_t = gr_x[tri_t[0]];
-      B_t = gr_x[tri_t[1]];
-      C_t = gr_x[tri_t[2]];
-      nx = gr_n[tt];
+  h = col[i];
+  col[i] = col[j];
+  col[j] = h;
+}
 
-      sum = bem->sq->base_dist;
+void
+setup_nearfield_pairs_bem3d(pbem3d bem, pcblock b)
+{
+  const uint triangles = bem->gr->triangles;
+  basisfunctionbem3d rbasis, cbasis;
+  uint     *ptr, *pos, *col, *mark, *rtri, *ctri;
+  uint      stamp, i, k, n, nz;
+
+  rbasis = bem->basis_neumann;
+  cbasis = (bem->basis_dirichlet == BASIS_NONE_BEM3D ?
+	    bem->basis_neumann : bem->basis_dirichlet);
+
+  ptr = allocuint(triangles + 1);
+  pos = allocuint(triangles + 1);
+  mark = allocuint(triangles);
+  rtri = allocuint(triangles);
+  ctri = allocuint(triangles);
+  for (i = 0; i < triangles; ++i) {
+    pos[i] = 0;
+    mark[i] = 0;
+  }
+  stamp = 0;
 
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
+  /* Count the pairs for every row triangle, including duplicates */
+  collect_pairs_bem3d(bem, b, rbasis, cbasis, mark, &stamp, rtri, ctri, pos,
+		      NULL, NULL);
 
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
+  ptr[0] = 0;
+  for (i = 0; i < triangles; ++i) {
+    ptr[i + 1] = ptr[i] + pos[i];
+    pos[i] = ptr[i];
+  }
+  col = allocuint(ptr[triangles]);
 
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
+  collect_pairs_bem3d(bem, b, rbasis, cbasis, mark, &stamp, rtri, ctri, NULL,
+		      pos, col);
 
-	sum += wq[q] * kernel(x, y, nx, ny, (void *) bem);
-      }
-      if (ntrans) {
-	aa[s + t * ld] = CONJ(sum) * factor2;
-      }
-      else {
-	aa[t + s * ld] = sum * factor2;
+  /* Remove duplicates and sort every row */
+  for (i = 0; i < triangles; ++i) {
+    mark[i] = triangles;
+  }
+  nz = 0;
+  for (i = 0; i < triangles; ++i) {
+    n = nz;
+    for (k = ptr[i]; k < ptr[i + 1]; ++k) {
+      if (mark[col[k]] != i) {
+	mark[col[k]] = i;
+	col[nz++] = col[k];
       }
     }
+    ptr[i] = n;
+    heapsort(nz - n, leq_pairs_bem3d, swap_pairs_bem3d, col + n);
   }
+  ptr[triangles] = nz;
+
+  setup_pairs_singquad2d(bem->sq, (const uint(*)[3]) bem->gr->t, triangles,
+			 ptr, col);
+
+  freemem(ctri);
+  freemem(rtri);
+  freemem(mark);
+  freemem(pos);
 }
 
 void
-assemble_cl_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		       bool ntrans, pamatrix N, kernel_func3d kernel)
+setup_adaptive_quadrature_bem3d(pbem3d bem, uint qmin)
 {
-  const pcsurface3d gr = bem->gr;
-  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
-  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
-  const preal gr_g = (const preal) gr->g;
-  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
-  const uint triangles = gr->triangles;
-  plistnode *v2t = bem->v2t;
-  field    *quad;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
+  psingquad2d sq = bem->sq;
+  basisfunctionbem3d rbasis, cbasis;
+  uint      o, off;
 
-  ptri_list tl, tl1;
-  pvert_list vl;
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *ns, *nt;
-  const uint *tri_t, *tri_s;
-  plistnode v;
-  real     *xq, *yq, *wq, *mass;
-  uint      tp[3], sp[3], tri_tp[3], tri_sp[3];
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
-  field     res, base;
-  uint      i, j, t, s, q, nq, cj;
-  uint      ii, jj, tt, ss, vv;
+  if (qmin == 0) {
+    del_adaptive_singquad2d(sq);
+    return;
+  }
 
-  clear_amatrix(N);
+  rbasis = bem->basis_neumann;
+  cbasis = (bem->basis_dirichlet == BASIS_NONE_BEM3D ?
+	    bem->basis_neumann : bem->basis_dirichlet);
 
-  quad = allocfield(bem->sq->nmax);
+  setup_adaptive_singquad2d(sq, bem->gr, qmin);
 
-  tl = NULL;
+  /* Weight the cached rules just like the constructors weight the others */
+  for (o = 1; o <= sq->q; ++o) {
+    off = sq->adapt_off[o];
+    if (rbasis == BASIS_LINEAR_BEM3D && cbasis == BASIS_LINEAR_BEM3D) {
+      weight_basisfunc_ll_singquad2d(sq->x_adapt + 2 * off,
+				     sq->y_adapt + 2 * off,
+				     sq->w_adapt + 10 * off,
+				     sq->adapt_off[o + 1] - off);
+    }
+    else if (rbasis == BASIS_CONSTANT_BEM3D
+	     && cbasis == BASIS_LINEAR_BEM3D) {
+      weight_basisfunc_cl_singquad2d(sq->x_adapt + 2 * off,
+				     sq->y_adapt + 2 * off,
+				     sq->w_adapt + 10 * off,
+				     sq->adapt_off[o + 1] - off);
+    }
+  }
+}
 
-  cj = 0;
-  for (i = 0; i < cols; ++i) {
-    ii = (cidx == NULL ? i : cidx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
+bool
+beyond_window_bem3d(pcbem3d bem, pccluster rc, pccluster cc)
+{
+  /* The maximum norm distance of the bounding boxes is a lower bound for
+   * the euclidean distance of all pairs of points */
+  return (bem->window_b > 0.0
+	  && getdist_max_cluster(rc, cc) >= bem->window_b);
+}
 
-      tl1 = tl;
-      while (tl1 && tl1->t != vv) {
-	tl1 = tl1->next;
-      }
+/****************************************************
+ * Nearfield integration routines
+ ****************************************************/
 
-      if (tl1 == NULL) {
-	tl1 = tl = new_tri_list(tl);
-	tl->t = vv;
-	cj++;
-      }
+/* Map the barycentric quadrature coordinates (t,s) stored in
+ * xq[0..nq-1], xq[nq..2nq-1] onto the triangle (A,B,C). The resulting points
+ * are stored in structure-of-arrays layout, i.e. the k-th component of the
+ * q-th point can be found at x[q + k * nq]. */
+static void
+eval_quadpoints_bem3d(const real * A, const real * B, const real * C,
+		      const real * xq, uint nq, real * x)
+{
+  const real *tq = xq;
+  const real *sq = xq + nq;
+  real     *x0 = x;
+  real     *x1 = x + nq;
+  real     *x2 = x + 2 * nq;
+  real      a, b, c;
+  uint      q;
+
+  for (q = 0; q < nq; ++q) {
+    a = 1.0 - tq[q];
+    b = tq[q] - sq[q];
+    c = sq[q];
+
+    x0[q] = A[0] * a + B[0] * b + C[0] * c;
+    x1[q] = A[1] * a + B[1] * b + C[1] * c;
+    x2[q] = A[2] * a + B[2] * b + C[2] * c;
+  }
+}
 
-      tl1->vl = new_vert_list(tl1->vl);
-      tl1->vl->v = i;
+/* Evaluate the kernel function for all nq pairs of quadrature points
+ * given in structure-of-arrays layout. If no batched kernel is available,
+ * the scalar kernel is called for every single pair of points. If a kernel
+ * for several wavenumbers is given, the results for the wavenumber kw[j] are
+ * stored in quad[j * nq], ..., quad[j * nq + nq - 1]. */
+static void
+eval_kernel_bem3d(pcbem3d bem, kernel_func3d kernel,
+		  kernel_batch_func3d kernel_batch,
+		  kernel_wave_func3d kernel_wave, uint nk, const real * kw,
+		  uint nq, const real * xx, const real * yy, const real * nx,
+		  const real * ny, field * quad)
+{
+  real      x[3], y[3];
+  uint      q;
+
+  if (kernel_wave) {
+    kernel_wave(nq, xx, yy, nx, ny, (void *) bem, nk, kw, quad);
+  }
+  else if (kernel_batch) {
+    assert(nk == 1);
+    kernel_batch(nq, xx, yy, nx, ny, (void *) bem, quad);
+  }
+  else {
+    assert(nk == 1);
+    for (q = 0; q < nq; ++q) {
+      x[0] = xx[q];
+      x[1] = xx[q + nq];
+      x[2] = xx[q + 2 * nq];
+      y[0] = yy[q];
+      y[1] = yy[q + nq];
+      y[2] = yy[q + 2 * nq];
+
+      quad[q] = kernel(x, y, nx, ny, (void *) bem);
     }
   }
+}
 
-  for (s = 0, tl1 = tl; s < cj; s++, tl1 = tl1->next) {
-    ss = tl1->t;
-    assert(ss < triangles);
-    factor = gr_g[ss] * bem->kernel_const;
-    tri_s = gr_t[ss];
-    ns = gr_n[ss];
-    for (t = 0; t < rows; t++) {
-      tt = (ridx == NULL ? t : ridx[t]);
-      assert(tt < triangles);
-      tri_t = gr_t[tt];
-      nt = gr_n[tt];
+static    ptri_list
+build_tri_list_bem3d(pcbem3d bem, const uint * idx, uint n, uint * tn)
+{
+  plistnode *v2t = bem->v2t;
+  ptri_list tl, tl1;
+  plistnode v;
+  uint      i, ii, vv, tj;
 
-      factor2 = factor * gr_g[tt];
+  tl = NULL;
 
-      select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				   &wq, &nq, &base);
+  tj = 0;
+  for (i = 0; i < n; ++i) {
+    ii = (idx == NULL ? i : idx[i]);
+    for (v = v2t[ii], vv = v->data; v->next != NULL;
+	 v = v->next, vv = v->data) {
 
-      for (i = 0; i < 3; ++i) {
-	tri_tp[i] = tri_t[tp[i]];
-	tri_sp[i] = tri_s[sp[i]];
+      tl1 = tl;
+      while (tl1 && tl1->t != vv) {
+	tl1 = tl1->next;
       }
 
-      A_t = gr_x[tri_tp[0]];
-      B_t = gr_x[tri_tp[1]];
-      C_t = gr_x[tri_tp[2]];
-      A_s = gr_x[tri_sp[0]];
-      B_s = gr_x[tri_sp[1]];
-      C_s = gr_x[tri_sp[2]];
+      if (tl1 == NULL) {
+	tl1 = tl = new_tri_list(tl);
+	tl->t = vv;
+	tj++;
+      }
 
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
+      tl1->vl = new_vert_list(tl1->vl);
+      tl1->vl->v = i;
+    }
+  }
 
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
+  *tn = tj;
 
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
+  return tl;
+}
 
-	quad[q] = kernel(x, y, nt, ns, (void *) bem);
-      }
+/* Select the quadrature rule for a pair of triangles. For near field
+ * computations the singular quadrature rules are used, otherwise all pairs of
+ * triangles are assumed to be disjoint. Disjoint pairs use the
+ * distance-adaptive rules if they have been set up, their order is returned
+ * in ord, while ord is zero for all other rules. Returns the number of common
+ * vertices. */
+static    uint
+select_quadrature_bem3d(pcbem3d bem, bool near, uint tt, uint ss,
+			const uint * tri_t, const uint * tri_s, uint * tp,
+			uint * sp, real ** xq, real ** yq, real ** wq,
+			uint * nq, field * base, uint * ord)
+{
+  pcsingquad2d sq = bem->sq;
+  uint      p;
 
-      vl = tl1->vl;
-      while (vl) {
-	j = vl->v;
-	if (j < cols) {
-	  jj = cidx == NULL ? j : cidx[j];
-	  for (i = 0; i < 3; ++i) {
-	    if (jj == tri_sp[i]) {
-	      res = base;
+  *ord = 0;
 
-	      for (q = 0; q < nq; ++q) {
-		res += wq[q] * quad[q];
-	      }
+  if (near) {
+    p = lookup_quadrature_singquad2d(sq, tt, ss, tri_t, tri_s, tp, sp, xq,
+				     yq, wq, nq, base);
+    if (p == 0 && sq->adapt_qmin > 0) {
+      *ord = select_adaptive_singquad2d(sq, tt, ss, xq, yq, wq, nq, base);
+    }
 
-	      if (ntrans) {
-		aa[j + t * ld] += res * factor2;
-	      }
-	      else {
-		aa[t + j * ld] += res * factor2;
-	      }
-	    }
-	    wq += nq;
-	  }
-	  wq -= 3 * nq;
-	}
-	vl = vl->next;
+    return p;
+  }
+
+  tp[0] = sp[0] = 0;
+  tp[1] = sp[1] = 1;
+  tp[2] = sp[2] = 2;
+
+  if (sq->adapt_qmin > 0) {
+    *ord = select_adaptive_singquad2d(sq, tt, ss, xq, yq, wq, nq, base);
+  }
+  else {
+    *xq = sq->x_dist;
+    *yq = sq->y_dist;
+    *wq = sq->w_dist;
+    *nq = sq->n_dist;
+    *base = sq->base_dist;
+  }
+
+  return 0;
+}
+
+/* Number of points that have to be stored in the buffer used by
+ * dist_quadpoints_bem3d. */
+static    uint
+dist_points_bem3d(pcbem3d bem)
+{
+  pcsingquad2d sq = bem->sq;
+
+  if (sq->adapt_qmin > 0 && sq->adapt_off[sq->q + 1] > sq->n_dist) {
+    return sq->adapt_off[sq->q + 1];
+  }
+
+  return sq->n_dist;
+}
+
+/* Quadrature points of the rule for disjoint pairs in the column triangle s.
+ * The points for every order are computed at most once per column,
+ * ystamp[ord] records the column they belong to. */
+static const real *
+dist_quadpoints_bem3d(pcbem3d bem, const uint * tri_s, uint s, uint ord,
+		      const real * yq, uint nq, real * ydist, uint * ystamp)
+{
+  const     real(*gr_x)[3] = (const real(*)[3]) bem->gr->x;
+  real     *y;
+
+  y = ydist + 3 * (ord == 0 ? 0 : bem->sq->adapt_off[ord]);
+
+  if (ystamp[ord] != s + 1) {
+    eval_quadpoints_bem3d(gr_x[tri_s[0]], gr_x[tri_s[1]], gr_x[tri_s[2]], yq,
+			  nq, y);
+    ystamp[ord] = s + 1;
+  }
+
+  return y;
+}
+
+static void
+assemble_cc_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		  bool ntrans, uint nk, const real * kw, pamatrix * N,
+		  bool near, kernel_func3d kernel,
+		  kernel_batch_func3d kernel_batch,
+		  kernel_wave_func3d kernel_wave)
+{
+  const pcsurface3d gr = bem->gr;
+  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
+  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
+  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
+  const real *gr_g = (const real *) gr->g;
+  uint      rows = ntrans ? N[0]->cols : N[0]->rows;
+  uint      cols = ntrans ? N[0]->rows : N[0]->cols;
+  field    *aa;
+  longindex ld;
+
+  const real *nx, *ny, *yp;
+  const uint *tri_t, *tri_s;
+  real     *xq, *yq, *wq, *xx, *yy, *ydist;
+  field    *quad;
+  uint     *ystamp;
+  uint      tp[3], sp[3];
+  real      factor, factor2;
+  field     sum, base;
+  uint      p, q, nq, ord, ss, tt, s, t, i, j;
+
+  xx = allocreal(3 * bem->sq->nmax);
+  yy = allocreal(3 * bem->sq->nmax);
+  ydist = allocreal(3 * dist_points_bem3d(bem));
+  ystamp = allocuint(bem->sq->q + 1);
+  for (i = 0; i <= bem->sq->q; ++i) {
+    ystamp[i] = 0;
+  }
+  quad = allocfield(nk * bem->sq->nmax);
+
+  for (s = 0; s < cols; ++s) {
+    ss = (cidx == NULL ? s : cidx[s]);
+    tri_s = gr_t[ss];
+    factor = gr_g[ss] * bem->kernel_const;
+    ny = gr_n[ss];
+
+    for (t = 0; t < rows; ++t) {
+      tt = (ridx == NULL ? t : ridx[t]);
+      tri_t = gr_t[tt];
+      factor2 = factor * gr_g[tt];
+      nx = gr_n[tt];
+
+      p = select_quadrature_bem3d(bem, near, tt, ss, tri_t, tri_s, tp, sp,
+				  &xq, &yq, &wq, &nq, &base, &ord);
+      wq += 9 * nq;
+
+      eval_quadpoints_bem3d(gr_x[tri_t[tp[0]]], gr_x[tri_t[tp[1]]],
+			    gr_x[tri_t[tp[2]]], xq, nq, xx);
+      if (p == 0) {
+	/* Quadrature points for disjoint pairs only depend on the column */
+	yp = dist_quadpoints_bem3d(bem, tri_s, s, ord, yq, nq, ydist, ystamp);
+      }
+      else {
+	eval_quadpoints_bem3d(gr_x[tri_s[sp[0]]], gr_x[tri_s[sp[1]]],
+			      gr_x[tri_s[sp[2]]], yq, nq, yy);
+	yp = yy;
       }
 
-      if (bem->alpha != 0.0 && tt == ss) {
+      eval_kernel_bem3d(bem, kernel, kernel_batch, kernel_wave, nk, kw, nq, xx,
+			yp, nx, ny, quad);
 
-	for (i = 0; i < 3; ++i) {
-	  tri_sp[i] = tri_s[i];
+      for (j = 0; j < nk; ++j) {
+	aa = N[j]->a;
+	ld = N[j]->ld;
+
+	sum = base;
+	for (q = 0; q < nq; ++q) {
+	  sum += wq[q] * quad[q + j * nq];
 	}
 
-	mass = bem->mass;
-	factor2 = bem->alpha * gr_g[tt];
+	if (ntrans) {
+	  aa[s + t * ld] = CONJ(sum) * factor2;
+	}
+	else {
+	  aa[t + s * ld] = sum * factor2;
+	}
 
-	vl = tl1->vl;
-	while (vl) {
-	  j = vl->v;
-	  if (j < cols) {
-	    jj = cidx == NULL ? j : cidx[j];
-	    for (i = 0; i < 3; ++i) {
-	      if (jj == tri_sp[i]) {
-		if (ntrans) {
-		  aa[j + t * ld] += factor2 * *mass;
-		}
-		else {
-		  aa[t + j * ld] += factor2 * *mass;
-		}
-	      }
-	      mass++;
-	    }
-	    mass = bem->mass;
+	if (near && bem->alpha != 0.0 && tt == ss) {
+	  if (ntrans) {
+	    aa[t + t * ld] += 0.5 * CONJ(bem->alpha) * gr_g[tt];
+	  }
+	  else {
+	    aa[t + t * ld] += 0.5 * bem->alpha * gr_g[tt];
 	  }
-	  vl = vl->next;
 	}
       }
     }
   }
 
-  del_tri_list(tl);
   freemem(quad);
+  freemem(ystamp);
+  freemem(ydist);
+  freemem(yy);
+  freemem(xx);
 }
 
-void
-assemble_cl_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		      bool ntrans, pamatrix N, kernel_func3d kernel)
+static void
+assemble_cl_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		  bool ntrans, uint nk, const real * kw, pamatrix * N,
+		  bool near, kernel_func3d kernel,
+		  kernel_batch_func3d kernel_batch,
+		  kernel_wave_func3d kernel_wave)
 {
   const pcsurface3d gr = bem->gr;
   const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
@@ -1271,58 +1715,38 @@ assemble_cl_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
   const preal gr_g = (const preal) gr->g;
   const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
   const uint triangles = gr->triangles;
-  plistnode *v2t = bem->v2t;
-  field    *quad;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
+  uint      rows = ntrans ? N[0]->cols : N[0]->rows;
+  uint      cols = ntrans ? N[0]->rows : N[0]->cols;
+  field    *aa;
+  longindex ld;
 
   ptri_list tl, tl1;
   pvert_list vl;
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *ns, *nt;
+  const real *ns, *nt, *yp;
   const uint *tri_t, *tri_s;
-  plistnode v;
-  real     *xq, *yq, *wq;
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
+  real     *xq, *yq, *wq, *mass, *xx, *yy, *ydist;
+  field    *quad;
+  uint      tp[3], sp[3], tri_tp[3], tri_sp[3];
+  real      factor, factor2;
   field     res, base;
-  uint      i, j, t, s, q, nq, cj;
-  uint      ii, jj, tt, ss, vv;
-
-  clear_amatrix(N);
-
-  quad = allocfield(bem->sq->nmax);
-
-  tl = NULL;
-
-  xq = bem->sq->x_dist;
-  yq = bem->sq->y_dist;
-  wq = bem->sq->w_dist;
-  nq = bem->sq->n_dist;
-  base = bem->sq->base_dist;
-
-  cj = 0;
-  for (i = 0; i < cols; ++i) {
-    ii = (cidx == NULL ? i : cidx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
-
-      tl1 = tl;
-      while (tl1 && tl1->t != vv) {
-	tl1 = tl1->next;
-      }
+  uint     *ystamp;
+  uint      i, j, t, s, p, q, nq, ord, cj;
+  uint      jj, tt, ss, kk;
 
-      if (tl1 == NULL) {
-	tl1 = tl = new_tri_list(tl);
-	tl->t = vv;
-	cj++;
-      }
+  for (kk = 0; kk < nk; ++kk) {
+    clear_amatrix(N[kk]);
+  }
 
-      tl1->vl = new_vert_list(tl1->vl);
-      tl1->vl->v = i;
-    }
+  xx = allocreal(3 * bem->sq->nmax);
+  yy = allocreal(3 * bem->sq->nmax);
+  ydist = allocreal(3 * dist_points_bem3d(bem));
+  ystamp = allocuint(bem->sq->q + 1);
+  for (i = 0; i <= bem->sq->q; ++i) {
+    ystamp[i] = 0;
   }
+  quad = allocfield(nk * bem->sq->nmax);
+
+  tl = build_tri_list_bem3d(bem, cidx, cols, &cj);
 
   for (s = 0, tl1 = tl; s < cj; s++, tl1 = tl1->next) {
     ss = tl1->t;
@@ -1331,62 +1755,59 @@ assemble_cl_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
     tri_s = gr_t[ss];
     ns = gr_n[ss];
 
-    A_s = gr_x[tri_s[0]];
-    B_s = gr_x[tri_s[1]];
-    C_s = gr_x[tri_s[2]];
-
     for (t = 0; t < rows; t++) {
       tt = (ridx == NULL ? t : ridx[t]);
       assert(tt < triangles);
       tri_t = gr_t[tt];
-      factor2 = factor * gr_g[tt];
       nt = gr_n[tt];
 
-      A_t = gr_x[tri_t[0]];
-      B_t = gr_x[tri_t[1]];
-      C_t = gr_x[tri_t[2]];
-
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
+      factor2 = factor * gr_g[tt];
 
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
+      p = select_quadrature_bem3d(bem, near, tt, ss, tri_t, tri_s, tp, sp,
+				  &xq, &yq, &wq, &nq, &base, &ord);
 
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
+      for (i = 0; i < 3; ++i) {
+	tri_tp[i] = tri_t[tp[i]];
+	tri_sp[i] = tri_s[sp[i]];
+      }
 
-	quad[q] = kernel(x, y, nt, ns, (void *) bem);
+      eval_quadpoints_bem3d(gr_x[tri_tp[0]], gr_x[tri_tp[1]],
+			    gr_x[tri_tp[2]], xq, nq, xx);
+      if (p == 0) {
+	/* Quadrature points for disjoint pairs only depend on the column */
+	yp = dist_quadpoints_bem3d(bem, tri_s, s, ord, yq, nq, ydist, ystamp);
+      }
+      else {
+	eval_quadpoints_bem3d(gr_x[tri_sp[0]], gr_x[tri_sp[1]],
+			      gr_x[tri_sp[2]], yq, nq, yy);
+	yp = yy;
       }
 
+      eval_kernel_bem3d(bem, kernel, kernel_batch, kernel_wave, nk, kw, nq, xx,
+			yp, nt, ns, quad);
+
       vl = tl1->vl;
       while (vl) {
 	j = vl->v;
 	if (j < cols) {
 	  jj = cidx == NULL ? j : cidx[j];
 	  for (i = 0; i < 3; ++i) {
-	    if (jj == tri_s[i]) {
-	      res = base;
+	    if (jj == tri_sp[i]) {
+	      for (kk = 0; kk < nk; ++kk) {
+		aa = N[kk]->a;
+		ld = N[kk]->ld;
 
-	      for (q = 0; q < nq; ++q) {
-		res += wq[q] * quad[q];
-	      }
+		res = base;
+		for (q = 0; q < nq; ++q) {
+		  res += wq[q] * quad[q + kk * nq];
+		}
 
-	      if (ntrans) {
-		aa[j + t * ld] += res * factor2;
-	      }
-	      else {
-		aa[t + j * ld] += res * factor2;
+		if (ntrans) {
+		  aa[j + t * ld] += res * factor2;
+		}
+		else {
+		  aa[t + j * ld] += res * factor2;
+		}
 	      }
 	    }
 	    wq += nq;
@@ -1395,16 +1816,59 @@ assemble_cl_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
 	}
 	vl = vl->next;
       }
+
+      if (near && bem->alpha != 0.0 && tt == ss) {
+
+	for (i = 0; i < 3; ++i) {
+	  tri_sp[i] = tri_s[i];
+	}
+
+	mass = bem->mass;
+	factor2 = bem->alpha * gr_g[tt];
+
+	vl = tl1->vl;
+	while (vl) {
+	  j = vl->v;
+	  if (j < cols) {
+	    jj = cidx == NULL ? j : cidx[j];
+	    for (i = 0; i < 3; ++i) {
+	      if (jj == tri_sp[i]) {
+		for (kk = 0; kk < nk; ++kk) {
+		  aa = N[kk]->a;
+		  ld = N[kk]->ld;
+
+		  if (ntrans) {
+		    aa[j + t * ld] += factor2 * *mass;
+		  }
+		  else {
+		    aa[t + j * ld] += factor2 * *mass;
+		  }
+		}
+	      }
+	      mass++;
+	    }
+	    mass = bem->mass;
+	  }
+	  vl = vl->next;
+	}
+      }
     }
   }
 
   del_tri_list(tl);
   freemem(quad);
+  freemem(ystamp);
+  freemem(ydist);
+  freemem(yy);
+  freemem(xx);
 }
 
-void
-assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		       bool ntrans, pamatrix N, kernel_func3d kernel)
+static void
+assemble_ll_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		  bool ntrans, uint nk, const real * kw, pamatrix * N,
+		  bool near, kernel_func3d kernel,
+		  kernel_batch_func3d kernel_batch,
+		  kernel_wave_func3d kernel_wave)
 {
   const pcsurface3d gr = bem->gr;
   const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
@@ -1412,83 +1876,47 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
   const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
   const preal gr_g = (const preal) gr->g;
   const uint triangles = gr->triangles;
-  plistnode *v2t = bem->v2t;
-  field    *quad;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
+  uint      rows = ntrans ? N[0]->cols : N[0]->rows;
+  uint      cols = ntrans ? N[0]->rows : N[0]->cols;
+  field    *aa;
+  longindex ld;
 
   ptri_list tl_r, tl1_r, tl_c, tl1_c;
   pvert_list vl_r, vl_c;
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *nt, *ns;
+  const real *nt, *ns, *yp;
   const uint *tri_t, *tri_s;
-  plistnode v;
-  real     *xq, *yq, *wq, *ww;
+  real     *xq, *yq, *wq, *ww, *xx, *yy, *ydist;
+  field    *quad;
   uint      tp[3], sp[3], tri_tp[3], tri_sp[3];
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
+  real      factor, factor2;
   field     base, res;
   real     *mass;
-  uint      i, j, t, s, k, l, rj, cj, tt, ss, q, nq, ii, jj, vv;
-
-  quad = allocfield(bem->sq->nmax);
-
-  clear_amatrix(N);
-
-  tl_r = NULL;
-  tl_c = NULL;
-
-  rj = 0;
-  for (i = 0; i < rows; ++i) {
-    ii = (ridx == NULL ? i : ridx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
+  uint     *ystamp;
+  uint      i, j, t, s, k, l, rj, cj, tt, ss, p, q, nq, ord, ii, jj, kk;
 
-      tl1_r = tl_r;
-      while (tl1_r && tl1_r->t != vv) {
-	tl1_r = tl1_r->next;
-      }
-
-      if (tl1_r == NULL) {
-	tl1_r = tl_r = new_tri_list(tl_r);
-	tl_r->t = vv;
-	rj++;
-      }
-
-      tl1_r->vl = new_vert_list(tl1_r->vl);
-      tl1_r->vl->v = i;
-    }
+  xx = allocreal(3 * bem->sq->nmax);
+  yy = allocreal(3 * bem->sq->nmax);
+  ydist = allocreal(3 * dist_points_bem3d(bem));
+  ystamp = allocuint(bem->sq->q + 1);
+  for (i = 0; i <= bem->sq->q; ++i) {
+    ystamp[i] = 0;
   }
+  quad = allocfield(nk * bem->sq->nmax);
 
-  cj = 0;
-  for (i = 0; i < cols; ++i) {
-    ii = (cidx == NULL ? i : cidx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
-
-      tl1_c = tl_c;
-      while (tl1_c && tl1_c->t != vv) {
-	tl1_c = tl1_c->next;
-      }
-
-      if (tl1_c == NULL) {
-	tl1_c = tl_c = new_tri_list(tl_c);
-	tl_c->t = vv;
-	cj++;
-      }
-
-      tl1_c->vl = new_vert_list(tl1_c->vl);
-      tl1_c->vl->v = i;
-    }
+  for (kk = 0; kk < nk; ++kk) {
+    clear_amatrix(N[kk]);
   }
 
+  tl_r = build_tri_list_bem3d(bem, ridx, rows, &rj);
+  tl_c = build_tri_list_bem3d(bem, cidx, cols, &cj);
+
   for (s = 0, tl1_c = tl_c; s < cj; s++, tl1_c = tl1_c->next) {
     ss = tl1_c->t;
     assert(ss < triangles);
     factor = gr_g[ss] * bem->kernel_const;
     tri_s = gr_t[ss];
     ns = gr_n[ss];
+
     for (t = 0, tl1_r = tl_r; t < rj; t++, tl1_r = tl1_r->next) {
       tt = tl1_r->t;
       assert(tt < triangles);
@@ -1496,43 +1924,29 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
       tri_t = gr_t[tt];
       nt = gr_n[tt];
 
-      select_quadrature_singquad2d(bem->sq, tri_t, tri_s, tp, sp, &xq, &yq,
-				   &wq, &nq, &base);
+      p = select_quadrature_bem3d(bem, near, tt, ss, tri_t, tri_s, tp, sp,
+				  &xq, &yq, &wq, &nq, &base, &ord);
 
       for (i = 0; i < 3; ++i) {
 	tri_tp[i] = tri_t[tp[i]];
 	tri_sp[i] = tri_s[sp[i]];
       }
 
-      A_t = gr_x[tri_tp[0]];
-      B_t = gr_x[tri_tp[1]];
-      C_t = gr_x[tri_tp[2]];
-      A_s = gr_x[tri_sp[0]];
-      B_s = gr_x[tri_sp[1]];
-      C_s = gr_x[tri_sp[2]];
-
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
-
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
-
-	quad[q] = kernel(x, y, nt, ns, (void *) bem);
+      eval_quadpoints_bem3d(gr_x[tri_tp[0]], gr_x[tri_tp[1]],
+			    gr_x[tri_tp[2]], xq, nq, xx);
+      if (p == 0) {
+	/* Quadrature points for disjoint pairs only depend on the column */
+	yp = dist_quadpoints_bem3d(bem, tri_s, s, ord, yq, nq, ydist, ystamp);
+      }
+      else {
+	eval_quadpoints_bem3d(gr_x[tri_sp[0]], gr_x[tri_sp[1]],
+			      gr_x[tri_sp[2]], yq, nq, yy);
+	yp = yy;
       }
 
+      eval_kernel_bem3d(bem, kernel, kernel_batch, kernel_wave, nk, kw, nq, xx,
+			yp, nt, ns, quad);
+
       vl_c = tl1_c->vl;
       while (vl_c) {
 	j = vl_c->v;
@@ -1547,18 +1961,23 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
 	      ii = ((ridx == NULL) ? i : ridx[i]);
 	      for (l = 0; l < 3; ++l) {
 		if (ii == tri_tp[l]) {
-		  res = base;
-
 		  ww = wq + (l + k * 3) * nq;
-		  for (q = 0; q < nq; ++q) {
-		    res += ww[q] * quad[q];
-		  }
 
-		  if (ntrans) {
-		    aa[j + i * ld] += CONJ(res * factor2);
-		  }
-		  else {
-		    aa[i + j * ld] += res * factor2;
+		  for (kk = 0; kk < nk; ++kk) {
+		    aa = N[kk]->a;
+		    ld = N[kk]->ld;
+
+		    res = base;
+		    for (q = 0; q < nq; ++q) {
+		      res += ww[q] * quad[q + kk * nq];
+		    }
+
+		    if (ntrans) {
+		      aa[j + i * ld] += CONJ(res * factor2);
+		    }
+		    else {
+		      aa[i + j * ld] += res * factor2;
+		    }
 		  }
 		}
 	      }
@@ -1569,7 +1988,7 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
 	vl_c = vl_c->next;
       }
 
-      if (bem->alpha != 0.0 && tt == ss) {
+      if (near && bem->alpha != 0.0 && tt == ss) {
 	for (i = 0; i < 3; ++i) {
 	  tri_tp[i] = tri_t[i];
 	  tri_sp[i] = tri_s[i];
@@ -1592,11 +2011,16 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
 		ii = ((ridx == NULL) ? i : ridx[i]);
 		for (l = 0; l < 3; ++l) {
 		  if (ii == tri_tp[l]) {
-		    if (ntrans) {
-		      aa[j + i * ld] += CONJ(mass[l + k * 3] * factor2);
-		    }
-		    else {
-		      aa[i + j * ld] += mass[l + k * 3] * factor2;
+		    for (kk = 0; kk < nk; ++kk) {
+		      aa = N[kk]->a;
+		      ld = N[kk]->ld;
+
+		      if (ntrans) {
+			aa[j + i * ld] += CONJ(mass[l + k * 3] * factor2);
+		      }
+		      else {
+			aa[i + j * ld] += mass[l + k * 3] * factor2;
+		      }
 		    }
 		  }
 		}
@@ -1614,180 +2038,139 @@ assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
   del_tri_list(tl_c);
 
   freemem(quad);
+  freemem(ystamp);
+  freemem(ydist);
+  freemem(yy);
+  freemem(xx);
 }
 
 void
-assemble_ll_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
-		      bool ntrans, pamatrix N, kernel_func3d kernel)
+assemble_cc_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		       bool ntrans, pamatrix N, kernel_func3d kernel)
 {
-  const pcsurface3d gr = bem->gr;
-  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
-  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
-  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
-  const preal gr_g = (const preal) gr->g;
-  const uint triangles = gr->triangles;
-  plistnode *v2t = bem->v2t;
-  field    *quad;
-  field    *aa = N->a;
-  uint      rows = ntrans ? N->cols : N->rows;
-  uint      cols = ntrans ? N->rows : N->cols;
-  longindex ld = N->ld;
-
-  ptri_list tl_r, tl1_r, tl_c, tl1_c;
-  pvert_list vl_r, vl_c;
-  const real *A_t, *B_t, *C_t, *A_s, *B_s, *C_s, *nt, *ns;
-  const uint *tri_t, *tri_s;
-  plistnode v;
-  real     *xq, *yq, *wq, *ww;
-  real      Ax, Bx, Cx, Ay, By, Cy, tx, sx, ty, sy, x[3], y[3], factor,
-    factor2;
-  field     base, res;
-  uint      i, j, t, s, k, l, rj, cj, tt, ss, q, nq, ii, jj, vv;
-
-  xq = bem->sq->x_dist;
-  yq = bem->sq->y_dist;
-  nq = bem->sq->n_dist;
-  wq = bem->sq->w_dist;
-
-  quad = allocfield(bem->sq->nmax);
-
-  clear_amatrix(N);
-
-  tl_r = NULL;
-  tl_c = NULL;
-
-  rj = 0;
-  for (i = 0; i < rows; ++i) {
-    ii = (ridx == NULL ? i : ridx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
-
-      tl1_r = tl_r;
-      while (tl1_r && tl1_r->t != vv) {
-	tl1_r = tl1_r->next;
-      }
-
-      if (tl1_r == NULL) {
-	tl1_r = tl_r = new_tri_list(tl_r);
-	tl_r->t = vv;
-	rj++;
-      }
-
-      tl1_r->vl = new_vert_list(tl1_r->vl);
-      tl1_r->vl->v = i;
-    }
-  }
-
-  cj = 0;
-  for (i = 0; i < cols; ++i) {
-    ii = (cidx == NULL ? i : cidx[i]);
-    for (v = v2t[ii], vv = v->data; v->next != NULL;
-	 v = v->next, vv = v->data) {
+  assemble_cc_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, kernel,
+		    NULL, NULL);
+}
 
-      tl1_c = tl_c;
-      while (tl1_c && tl1_c->t != vv) {
-	tl1_c = tl1_c->next;
-      }
+void
+assemble_cc_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		      bool ntrans, pamatrix N, kernel_func3d kernel)
+{
+  assemble_cc_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, kernel,
+		    NULL, NULL);
+}
 
-      if (tl1_c == NULL) {
-	tl1_c = tl_c = new_tri_list(tl_c);
-	tl_c->t = vv;
-	cj++;
-      }
+void
+assemble_cl_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		       bool ntrans, pamatrix N, kernel_func3d kernel)
+{
+  assemble_cl_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, kernel,
+		    NULL, NULL);
+}
 
-      tl1_c->vl = new_vert_list(tl1_c->vl);
-      tl1_c->vl->v = i;
-    }
-  }
+void
+assemble_cl_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		      bool ntrans, pamatrix N, kernel_func3d kernel)
+{
+  assemble_cl_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, kernel,
+		    NULL, NULL);
+}
 
-  for (s = 0, tl1_c = tl_c; s < cj; s++, tl1_c = tl1_c->next) {
-    ss = tl1_c->t;
-    assert(ss < triangles);
-    factor = gr_g[ss] * bem->kernel_const;
-    tri_s = gr_t[ss];
-    ns = gr_n[ss];
+void
+assemble_ll_near_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		       bool ntrans, pamatrix N, kernel_func3d kernel)
+{
+  assemble_ll_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, kernel,
+		    NULL, NULL);
+}
 
-    A_s = gr_x[tri_s[0]];
-    B_s = gr_x[tri_s[1]];
-    C_s = gr_x[tri_s[2]];
+void
+assemble_ll_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+		      bool ntrans, pamatrix N, kernel_func3d kernel)
+{
+  assemble_ll_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, kernel,
+		    NULL, NULL);
+}
 
-    for (t = 0, tl1_r = tl_r; t < rj; t++, tl1_r = tl1_r->next) {
-      tt = tl1_r->t;
-      assert(tt < triangles);
-      factor2 = factor * gr_g[tt];
-      tri_t = gr_t[tt];
-      nt = gr_n[tt];
+void
+assemble_cc_near_batch_bem3d(const uint * ridx, const uint * cidx,
+			     pcbem3d bem, bool ntrans, pamatrix N,
+			     kernel_batch_func3d kernel)
+{
+  assemble_cc_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, NULL,
+		    kernel, NULL);
+}
 
-      A_t = gr_x[tri_t[0]];
-      B_t = gr_x[tri_t[1]];
-      C_t = gr_x[tri_t[2]];
+void
+assemble_cc_far_batch_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, pamatrix N,
+			    kernel_batch_func3d kernel)
+{
+  assemble_cc_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, NULL,
+		    kernel, NULL);
+}
 
-      base = bem->sq->base_dist;
+void
+assemble_cl_near_batch_bem3d(const uint * ridx, const uint * cidx,
+			     pcbem3d bem, bool ntrans, pamatrix N,
+			     kernel_batch_func3d kernel)
+{
+  assemble_cl_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, NULL,
+		    kernel, NULL);
+}
 
-      for (q = 0; q < nq; ++q) {
-	tx = xq[q];
-	sx = xq[q + nq];
-	ty = yq[q];
-	sy = yq[q + nq];
-	Ax = 1.0 - tx;
-	Bx = tx - sx;
-	Cx = sx;
-	Ay = 1.0 - ty;
-	By = ty - sy;
-	Cy = sy;
-
-	x[0] = A_t[0] * Ax + B_t[0] * Bx + C_t[0] * Cx;
-	x[1] = A_t[1] * Ax + B_t[1] * Bx + C_t[1] * Cx;
-	x[2] = A_t[2] * Ax + B_t[2] * Bx + C_t[2] * Cx;
-	y[0] = A_s[0] * Ay + B_s[0] * By + C_s[0] * Cy;
-	y[1] = A_s[1] * Ay + B_s[1] * By + C_s[1] * Cy;
-	y[2] = A_s[2] * Ay + B_s[2] * By + C_s[2] * Cy;
-
-	quad[q] = kernel(x, y, nt, ns, (void *) bem);
-      }
+void
+assemble_cl_far_batch_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, pamatrix N,
+			    kernel_batch_func3d kernel)
+{
+  assemble_cl_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, NULL,
+		    kernel, NULL);
+}
 
-      vl_c = tl1_c->vl;
-      while (vl_c) {
-	j = vl_c->v;
-	assert(j < cols);
-	jj = ((cidx == NULL) ? j : cidx[j]);
-	for (k = 0; k < 3; ++k) {
-	  if (jj == tri_s[k]) {
-	    vl_r = tl1_r->vl;
-	    while (vl_r) {
-	      i = vl_r->v;
-	      assert(i < rows);
-	      ii = ((ridx == NULL) ? i : ridx[i]);
-	      for (l = 0; l < 3; ++l) {
-		if (ii == tri_t[l]) {
-		  res = base;
+void
+assemble_ll_near_batch_bem3d(const uint * ridx, const uint * cidx,
+			     pcbem3d bem, bool ntrans, pamatrix N,
+			     kernel_batch_func3d kernel)
+{
+  assemble_ll_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, true, NULL,
+		    kernel, NULL);
+}
 
-		  ww = wq + (l + k * 3) * nq;
-		  for (q = 0; q < nq; ++q) {
-		    res += ww[q] * quad[q];
-		  }
+void
+assemble_ll_far_batch_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, pamatrix N,
+			    kernel_batch_func3d kernel)
+{
+  assemble_ll_bem3d(ridx, cidx, bem, ntrans, 1, NULL, &N, false, NULL,
+		    kernel, NULL);
+}
 
-		  if (ntrans) {
-		    aa[j + i * ld] += CONJ(res * factor2);
-		  }
-		  else {
-		    aa[i + j * ld] += res * factor2;
-		  }
-		}
-	      }
-	      vl_r = vl_r->next;
-	    }
-	  }
-	}
-	vl_c = vl_c->next;
-      }
-    }
-  }
+void
+assemble_cc_near_wave_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, uint nk, const real * k,
+			    pamatrix * N, kernel_wave_func3d kernel)
+{
+  assemble_cc_bem3d(ridx, cidx, bem, ntrans, nk, k, N, true, NULL, NULL,
+		    kernel);
+}
 
-  del_tri_list(tl_r);
-  del_tri_list(tl_c);
+void
+assemble_cl_near_wave_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, uint nk, const real * k,
+			    pamatrix * N, kernel_wave_func3d kernel)
+{
+  assemble_cl_bem3d(ridx, cidx, bem, ntrans, nk, k, N, true, NULL, NULL,
+		    kernel);
+}
 
-  freemem(quad);
+void
+assemble_ll_near_wave_bem3d(const uint * ridx, const uint * cidx,
+			    pcbem3d bem, bool ntrans, uint nk, const real * k,
+			    pamatrix * N, kernel_wave_func3d kernel)
+{
+  assemble_ll_bem3d(ridx, cidx, bem, ntrans, nk, k, N, true, NULL, NULL,
+		    kernel);
 }
 
 void
@@ -2494,24 +2877,71 @@ fill_dnz_col_l_bem3d(const uint * idx, const real(*Z)[3],
  ****************************************************/
 
 static void
-setup_interpolation_bem3d(paprxbem3d aprx, uint m)
+chebyshev_points_bem3d(uint m, real * x)
 {
   real      e;
   uint      i;
 
+  /* build tschebyscheff-points */
+  e = 1.0 / (2.0 * m);
+
+  for (i = 0; i < m; ++i) {
+    x[i] = cos(M_PI * (2.0 * i * e + e));
+  }
+}
+
+static void
+setup_interpolation_bem3d(paprxbem3d aprx, uint m)
+{
   uninit_interpolation_bem3d(aprx);
 
   aprx->x_inter = allocreal(m);
   aprx->m_inter = m;
   aprx->k_inter = m * m * m;
 
-  /* build tschebyscheff-points */
-  e = 1.0 / (2.0 * m);
+  chebyshev_points_bem3d(m, aprx->x_inter);
+}
 
-  for (i = 0; i < m; ++i) {
-    aprx->x_inter[i] = cos(M_PI * (2.0 * i * e + e));
+static void
+fill_varorder_bem3d(pccluster t, uint level, uint depth, uint m0,
+		    real alpha, uint * m, uint tname)
+{
+  uint      tname1, i;
+
+  m[tname] = m0 + (uint) (alpha * (depth - level));
+
+  tname1 = tname + 1;
+  for (i = 0; i < t->sons; i++) {
+    fill_varorder_bem3d(t->son[i], level + 1, depth, m0, alpha, m, tname1);
+    tname1 += t->son[i]->desc;
   }
+  assert(tname1 == tname + t->desc);
+}
+
+/* Interpolation orders m_l = m0 + alpha (L - l) for all clusters of a tree
+ * of depth L, indexed by cluster names */
+static uint *
+new_varorder_bem3d(pccluster t, uint m0, real alpha)
+{
+  uint     *m;
+
+  m = allocuint(t->desc);
+  fill_varorder_bem3d(t, 0, getdepth_cluster(t), m0, alpha, m, 0);
+
+  return m;
+}
+
+static void
+setup_varinterpolation_bem3d(paprxbem3d aprx, pccluster rc, pccluster cc,
+			     uint m0, real alpha)
+{
+  assert(m0 > 0);
+  assert(alpha >= 0.0);
 
+  setup_interpolation_bem3d(aprx, m0);
+
+  aprx->m_row_var = new_varorder_bem3d(rc, m0, alpha);
+  aprx->m_col_var = new_varorder_bem3d(cc, m0, alpha);
 }
 
 static void
@@ -2580,6 +3010,16 @@ setup_aca_bem3d(paprxbem3d aprx, real accur)
   aprx->accur_aca = accur;
 }
 
+static void
+setup_rand_bem3d(paprxbem3d aprx, real accur)
+{
+  assert(accur > 0.0);
+
+  uninit_rand_bem3d(aprx);
+
+  aprx->accur_rand = accur;
+}
+
 void
 build_bem3d_cube_quadpoints(pcbem3d bem, const real a[3], const real b[3],
 			    const real delta, real(**Z)[3], real(**N)[3])
@@ -2695,12 +3135,9 @@ build_bem3d_cube_quadpoints(pcbem3d bem, const real a[3], const real b[3],
 }
 
 static void
-assemble_interpoints3d_array(pcbem3d bem, pccluster t, real(*X)[3])
+assemble_interpoints3d_order_array(pccluster t, const real * x, uint m,
+				   real(*X)[3])
 {
-  pcaprxbem3d aprx = bem->aprx;
-  real     *x = aprx->x_inter;
-  uint      m = aprx->m_inter;
-  uint      k = aprx->k_inter;
   real      ax = t->bmin[0];
   real      bx = t->bmax[0];
   real      ay = t->bmin[1];
@@ -2747,16 +3184,21 @@ assemble_interpoints3d_array(pcbem3d bem, pccluster t, real(*X)[3])
     }
   }
 
-  assert(index == k);
+  assert(index == m * m * m);
 }
 
 static void
-assemble_interpoints3d_avector(pcbem3d bem, pccluster t,
-			       pavector px, pavector py, pavector pz)
+assemble_interpoints3d_array(pcbem3d bem, pccluster t, real(*X)[3])
 {
   pcaprxbem3d aprx = bem->aprx;
-  real     *x = aprx->x_inter;
-  uint      m = aprx->m_inter;
+
+  assemble_interpoints3d_order_array(t, aprx->x_inter, aprx->m_inter, X);
+}
+
+static void
+assemble_interpoints3d_order_avector(pccluster t, const real * x, uint m,
+				     pavector px, pavector py, pavector pz)
+{
   real      ax = t->bmin[0];
   real      bx = t->bmax[0];
   real      ay = t->bmin[1];
@@ -2798,6 +3240,16 @@ assemble_interpoints3d_avector(pcbem3d bem, pccluster t,
   }
 }
 
+static void
+assemble_interpoints3d_avector(pcbem3d bem, pccluster t,
+			       pavector px, pavector py, pavector pz)
+{
+  pcaprxbem3d aprx = bem->aprx;
+
+  assemble_interpoints3d_order_avector(t, aprx->x_inter, aprx->m_inter, px,
+				       py, pz);
+}
+
 static void
 assemble_bem3d_inter_row_rkmatrix(pccluster rc, uint rname,
 				  pccluster cc, uint cname, pcbem3d bem,
@@ -3125,17 +3577,8 @@ assemble_bem3d_greenhybrid_row_rkmatrix(pccluster rc, uint rname,
 
   (void) cname;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    grc = par->grcn[rname];
-
-    if (grc == NULL) {
-      grc = par->grcn[rname] = new_greencluster3d(rc);
-      assemble_row_greencluster3d(bem, grc);
-    }
-  }
+  grc = par->grcn[rname];
+  assert(grc != NULL);
 
   V = grc->V;
   rank = V->cols;
@@ -3230,17 +3673,8 @@ assemble_bem3d_greenhybrid_col_rkmatrix(pccluster rc, uint rname,
 
   (void) rname;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    gcc = par->gccn[cname];
-
-    if (gcc == NULL) {
-      gcc = par->gccn[cname] = new_greencluster3d(cc);
-      assemble_col_greencluster3d(bem, gcc);
-    }
-  }
+  gcc = par->gccn[cname];
+  assert(gcc != NULL);
 
   V = gcc->V;
   rank = V->cols;
@@ -3271,29 +3705,11 @@ assemble_bem3d_greenhybrid_mixed_rkmatrix(pccluster rc, uint rname,
   uint     *xihatV, *xihatW;
   uint      rankV, rankW;
 
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    grc = par->grcn[rname];
-
-    if (grc == NULL) {
-      grc = par->grcn[rname] = new_greencluster3d(rc);
-      assemble_row_greencluster3d(bem, grc);
-    }
-  }
-
-#ifdef USE_OPENMP
-#pragma omp critical(greenhybrid)
-#endif
-  {
-    gcc = par->gccn[cname];
+  grc = par->grcn[rname];
+  assert(grc != NULL);
 
-    if (gcc == NULL) {
-      gcc = par->gccn[cname] = new_greencluster3d(cc);
-      assemble_col_greencluster3d(bem, gcc);
-    }
-  }
+  gcc = par->gccn[cname];
+  assert(gcc != NULL);
 
   rankV = grc->V->cols;
   rankW = gcc->V->cols;
@@ -3366,6 +3782,50 @@ assemble_bem3d_PACA_rkmatrix(pccluster rc, uint rname, pccluster cc,
 			     accur, NULL, NULL, R);
 }
 
+static void
+assemble_bem3d_blockPACA_rkmatrix(pccluster rc, uint rname, pccluster cc,
+				  uint cname, pcbem3d bem, prkmatrix R)
+{
+  paprxbem3d aprx = bem->aprx;
+  const real accur = aprx->accur_aca;
+  const uint block = aprx->block_aca;
+  matrixentry_t entry = (matrixentry_t) bem->nearfield_far;
+  const uint *ridx = rc->idx;
+  const uint *cidx = cc->idx;
+  const uint rows = rc->size;
+  const uint cols = cc->size;
+
+  (void) rname;
+  (void) cname;
+
+  decomp_blockpartialaca_rkmatrix(entry, (void *) bem, ridx, rows, cidx,
+				  cols, accur, block, NULL, NULL, R);
+}
+
+static void
+assemble_bem3d_RAND_rkmatrix(pccluster rc, uint rname, pccluster cc,
+			     uint cname, pcbem3d bem, prkmatrix R)
+{
+  paprxbem3d aprx = bem->aprx;
+  const real accur = aprx->accur_rand;
+  const uint *ridx = rc->idx;
+  const uint *cidx = cc->idx;
+  const uint rows = rc->size;
+  const uint cols = cc->size;
+
+  pamatrix  G;
+
+  (void) rname;
+  (void) cname;
+
+  G = new_amatrix(rows, cols);
+  bem->nearfield_far(ridx, cidx, bem, false, G);
+
+  decomp_random_rkmatrix(G, NULL, accur, R);
+
+  del_amatrix(G);
+}
+
 static void
 assemble_bem3d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
 			    uint cname, pcbem3d bem, prkmatrix R)
@@ -3447,131 +3907,350 @@ assemble_bem3d_HCA_rkmatrix(pccluster rc, uint rname, pccluster cc,
 }
 
 static void
-assemble_bem3d_inter_row_clusterbasis(pcbem3d bem, pclusterbasis rb,
-				      uint rname)
+assemble_bem3d_inter_row_clusterbasis(pcbem3d bem, pclusterbasis rb,
+				      uint rname)
+{
+  paprxbem3d aprx = bem->aprx;
+  pkernelbem3d kernels = bem->kernels;
+  pamatrix  V = &rb->V;
+  pccluster t = rb->t;
+  const uint m = aprx->m_inter;
+  const uint k = aprx->k_inter;
+
+  pavector  px, py, pz;
+
+  (void) rname;
+
+  px = new_avector(m);
+  py = new_avector(m);
+  pz = new_avector(m);
+
+  assemble_interpoints3d_avector(bem, t, px, py, pz);
+
+  resize_amatrix(V, t->size, k);
+  rb->k = k;
+  update_clusterbasis(rb);
+
+  kernels->lagrange_row(t->idx, px, py, pz, bem, V);
+
+  del_avector(px);
+  del_avector(py);
+  del_avector(pz);
+}
+
+static void
+assemble_bem3d_inter_transfer_clusterbasis(pcbem3d bem,
+					   pclusterbasis cb, uint rname)
+{
+  paprxbem3d aprx = bem->aprx;
+  pccluster t = cb->t;
+  uint      sons = t->sons;
+  const uint m = aprx->m_inter;
+  const uint k = aprx->k_inter;
+
+  pamatrix  E;
+  real(*X)[3];
+  pavector  px, py, pz;
+  uint      s;
+
+  (void) rname;
+
+  X = (real(*)[3]) allocmem(3 * k * sizeof(real));
+  px = new_avector(m);
+  py = new_avector(m);
+  pz = new_avector(m);
+
+  assemble_interpoints3d_avector(bem, t, px, py, pz);
+
+  resize_clusterbasis(cb, k);
+
+  for (s = 0; s < sons; ++s) {
+    E = &cb->son[s]->E;
+
+    assemble_interpoints3d_array(bem, cb->son[s]->t, X);
+
+    assemble_bem3d_lagrange_amatrix((const real(*)[3]) X, px, py, pz, E);
+  }
+
+  del_avector(px);
+  del_avector(py);
+  del_avector(pz);
+  freemem(X);
+}
+
+static void
+assemble_bem3d_inter_col_clusterbasis(pcbem3d bem, pclusterbasis cb,
+				      uint cname)
+{
+  paprxbem3d aprx = bem->aprx;
+  pkernelbem3d kernels = bem->kernels;
+  pamatrix  V = &cb->V;
+  pccluster t = cb->t;
+  const uint m = aprx->m_inter;
+  const uint k = aprx->k_inter;
+
+  pavector  px, py, pz;
+
+  (void) cname;
+
+  px = new_avector(m);
+  py = new_avector(m);
+  pz = new_avector(m);
+
+  assemble_interpoints3d_avector(bem, t, px, py, pz);
+
+  resize_amatrix(V, t->size, k);
+  cb->k = k;
+  update_clusterbasis(cb);
+
+  kernels->lagrange_col(t->idx, px, py, pz, bem, V);
+
+  del_avector(px);
+  del_avector(py);
+  del_avector(pz);
+}
+
+static void
+assemble_bem3d_inter_coupling(pcbem3d bem, pccluster rc, pccluster cc,
+			      pamatrix S)
+{
+  pkernelbem3d kernels = bem->kernels;
+  const uint kr = S->rows;
+  const uint kc = S->cols;
+
+  real(*xi_r)[3], (*xi_c)[3];
+
+  xi_r = (real(*)[3]) allocreal(3 * kr);
+  xi_c = (real(*)[3]) allocreal(3 * kc);
+
+  assemble_interpoints3d_array(bem, rc, xi_r);
+  assemble_interpoints3d_array(bem, cc, xi_c);
+
+  kernels->fundamental(bem, (const real(*)[3]) xi_r, (const real(*)[3]) xi_c,
+		       S);
+
+  freemem(xi_r);
+  freemem(xi_c);
+}
+
+static void
+assemble_bem3d_inter_uniform(uint rname, uint cname, pcbem3d bem, puniform U)
+{
+  pamatrix  S = &U->S;
+
+  (void) rname;
+  (void) cname;
+
+  resize_amatrix(S, U->rb->k, U->cb->k);
+
+  assemble_bem3d_inter_coupling(bem, U->rb->t, U->cb->t, S);
+}
+
+static void
+assemble_bem3d_inter_cached_uniform(uint rname, uint cname, pcbem3d bem,
+				    puniform U)
+{
+  pcouplingcache3d cache = bem->aprx->cache_inter;
+  pccluster rc = U->rb->t;
+  pccluster cc = U->cb->t;
+  const uint kr = U->rb->k;
+  const uint kc = U->cb->k;
+  pamatrix  S = &U->S;
+
+  couplingentry3d key;
+  pcouplingentry3d e;
+
+  (void) rname;
+  (void) cname;
+
+  assert(cache != NULL);
+
+  key.kr = kr;
+  key.kc = kc;
+  key.fundamental = bem->kernels->fundamental;
+  setkey_couplingentry3d(cache, rc, cc, &key);
+
+#ifdef USE_OPENMP
+#pragma omp critical(couplingcache3d)
+#endif
+  e = find_couplingcache3d(cache, &key);
+
+  if (e == NULL) {
+    /* Compute the coupling matrix outside of the critical region */
+    e = (pcouplingentry3d) allocmem(sizeof(couplingentry3d));
+    *e = key;
+    e->S = new_amatrix(kr, kc);
+    assemble_bem3d_inter_coupling(bem, rc, cc, e->S);
+
+#ifdef USE_OPENMP
+#pragma omp critical(couplingcache3d)
+#endif
+    e = insert_couplingcache3d(cache, e);
+  }
+
+  /* Share the coefficients of the cached matrix */
+  uninit_amatrix(S);
+  init_sub_amatrix(S, e->S, kr, 0, kc, 0);
+}
+
+static void
+assemble_bem3d_varinter_clusterbasis(pcbem3d bem, pclusterbasis b, uint m,
+				     bool row)
 {
-  paprxbem3d aprx = bem->aprx;
   pkernelbem3d kernels = bem->kernels;
-  pamatrix  V = &rb->V;
-  pccluster t = rb->t;
-  const uint m = aprx->m_inter;
-  const uint k = aprx->k_inter;
+  pamatrix  V = &b->V;
+  pccluster t = b->t;
+  const uint k = m * m * m;
 
   pavector  px, py, pz;
+  real     *x;
 
-  (void) rname;
-
+  x = allocreal(m);
   px = new_avector(m);
   py = new_avector(m);
   pz = new_avector(m);
 
-  assemble_interpoints3d_avector(bem, t, px, py, pz);
+  chebyshev_points_bem3d(m, x);
+  assemble_interpoints3d_order_avector(t, x, m, px, py, pz);
 
   resize_amatrix(V, t->size, k);
-  rb->k = k;
-  update_clusterbasis(rb);
+  b->k = k;
+  update_clusterbasis(b);
 
-  kernels->lagrange_row(t->idx, px, py, pz, bem, V);
+  if (row) {
+    kernels->lagrange_row(t->idx, px, py, pz, bem, V);
+  }
+  else {
+    kernels->lagrange_col(t->idx, px, py, pz, bem, V);
+  }
 
   del_avector(px);
   del_avector(py);
   del_avector(pz);
+  freemem(x);
 }
 
 static void
-assemble_bem3d_inter_transfer_clusterbasis(pcbem3d bem,
-					   pclusterbasis cb, uint rname)
+assemble_bem3d_varinter_row_clusterbasis(pcbem3d bem, pclusterbasis rb,
+					 uint rname)
+{
+  assemble_bem3d_varinter_clusterbasis(bem, rb, bem->aprx->m_row_var[rname],
+				       true);
+}
+
+static void
+assemble_bem3d_varinter_col_clusterbasis(pcbem3d bem, pclusterbasis cb,
+					 uint cname)
+{
+  assemble_bem3d_varinter_clusterbasis(bem, cb, bem->aprx->m_col_var[cname],
+				       false);
+}
+
+/* Transfer matrices for variable orders: the Lagrange polynomials of the
+ * father, order m[tname], are evaluated in the interpolation points of
+ * every son, which may use a different order */
+static void
+assemble_bem3d_varinter_transfer_clusterbasis(pclusterbasis cb,
+					      const uint * m, uint tname)
 {
-  paprxbem3d aprx = bem->aprx;
   pccluster t = cb->t;
   uint      sons = t->sons;
-  const uint m = aprx->m_inter;
-  const uint k = aprx->k_inter;
+  const uint mt = m[tname];
 
   pamatrix  E;
   real(*X)[3];
+  real     *x;
   pavector  px, py, pz;
-  uint      s;
-
-  (void) rname;
+  uint      s, m1, tname1;
 
-  X = (real(*)[3]) allocmem(3 * k * sizeof(real));
-  px = new_avector(m);
-  py = new_avector(m);
-  pz = new_avector(m);
+  x = allocreal(mt);
+  px = new_avector(mt);
+  py = new_avector(mt);
+  pz = new_avector(mt);
 
-  assemble_interpoints3d_avector(bem, t, px, py, pz);
+  chebyshev_points_bem3d(mt, x);
+  assemble_interpoints3d_order_avector(t, x, mt, px, py, pz);
+  freemem(x);
 
-  resize_clusterbasis(cb, k);
+  resize_clusterbasis(cb, mt * mt * mt);
 
+  tname1 = tname + 1;
   for (s = 0; s < sons; ++s) {
     E = &cb->son[s]->E;
+    m1 = m[tname1];
+    assert(cb->son[s]->k == m1 * m1 * m1);
 
-    assemble_interpoints3d_array(bem, cb->son[s]->t, X);
+    x = allocreal(m1);
+    X = (real(*)[3]) allocmem(3 * m1 * m1 * m1 * sizeof(real));
+
+    chebyshev_points_bem3d(m1, x);
+    assemble_interpoints3d_order_array(cb->son[s]->t, x, m1, X);
 
     assemble_bem3d_lagrange_amatrix((const real(*)[3]) X, px, py, pz, E);
+
+    freemem(X);
+    freemem(x);
+
+    tname1 += t->son[s]->desc;
   }
+  assert(tname1 == tname + t->desc);
 
   del_avector(px);
   del_avector(py);
   del_avector(pz);
-  freemem(X);
 }
 
 static void
-assemble_bem3d_inter_col_clusterbasis(pcbem3d bem, pclusterbasis cb,
-				      uint cname)
+assemble_bem3d_varinter_transfer_row_clusterbasis(pcbem3d bem,
+						  pclusterbasis rb,
+						  uint rname)
 {
-  paprxbem3d aprx = bem->aprx;
-  pkernelbem3d kernels = bem->kernels;
-  pamatrix  V = &cb->V;
-  pccluster t = cb->t;
-  const uint m = aprx->m_inter;
-  const uint k = aprx->k_inter;
-
-  pavector  px, py, pz;
-
-  (void) cname;
-
-  px = new_avector(m);
-  py = new_avector(m);
-  pz = new_avector(m);
-
-  assemble_interpoints3d_avector(bem, t, px, py, pz);
-
-  resize_amatrix(V, t->size, k);
-  cb->k = k;
-  update_clusterbasis(cb);
-
-  kernels->lagrange_col(t->idx, px, py, pz, bem, V);
+  assemble_bem3d_varinter_transfer_clusterbasis(rb, bem->aprx->m_row_var,
+						rname);
+}
 
-  del_avector(px);
-  del_avector(py);
-  del_avector(pz);
+static void
+assemble_bem3d_varinter_transfer_col_clusterbasis(pcbem3d bem,
+						  pclusterbasis cb,
+						  uint cname)
+{
+  assemble_bem3d_varinter_transfer_clusterbasis(cb, bem->aprx->m_col_var,
+						cname);
 }
 
 static void
-assemble_bem3d_inter_uniform(uint rname, uint cname, pcbem3d bem, puniform U)
+assemble_bem3d_varinter_uniform(uint rname, uint cname, pcbem3d bem,
+				puniform U)
 {
   pkernelbem3d kernels = bem->kernels;
   pccluster rc = U->rb->t;
   pccluster cc = U->cb->t;
+  const uint mr = bem->aprx->m_row_var[rname];
+  const uint mc = bem->aprx->m_col_var[cname];
   const uint kr = U->rb->k;
   const uint kc = U->cb->k;
   pamatrix  S = &U->S;
 
   real(*xi_r)[3], (*xi_c)[3];
+  real     *x;
 
-  (void) rname;
-  (void) cname;
+  assert(kr == mr * mr * mr);
+  assert(kc == mc * mc * mc);
 
   resize_amatrix(S, kr, kc);
 
   xi_r = (real(*)[3]) allocreal(3 * kr);
   xi_c = (real(*)[3]) allocreal(3 * kc);
 
-  assemble_interpoints3d_array(bem, rc, xi_r);
-  assemble_interpoints3d_array(bem, cc, xi_c);
+  x = allocreal(mr);
+  chebyshev_points_bem3d(mr, x);
+  assemble_interpoints3d_order_array(rc, x, mr, xi_r);
+  freemem(x);
+
+  x = allocreal(mc);
+  chebyshev_points_bem3d(mc, x);
+  assemble_interpoints3d_order_array(cc, x, mc, xi_c);
+  freemem(x);
 
   kernels->fundamental(bem, (const real(*)[3]) xi_r, (const real(*)[3]) xi_c,
 		       S);
@@ -5087,10 +5766,409 @@ assemble_bem3d_dn_lagrange_linear_amatrix(const uint * idx, pcavector px,
     }
   }
 
-  del_tri_list(tl);
-  freemem(quad);
+  del_tri_list(tl);
+  freemem(quad);
+}
+
+/* ------------------------------------------------------------
+ Directional H^2-matrices
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+
+/* Values and first derivatives of the one-dimensional Lagrange
+ * polynomials for the interpolation points p in x */
+static void
+lagrange_diff_1d_bem3d(pcavector p, real x, real * l, real * dl)
+{
+  const uint m = p->dim;
+  real      prod;
+  uint      j, l1, l2;
+
+  for (j = 0; j < m; j++) {
+    l[j] = 1.0;
+    dl[j] = 0.0;
+
+    for (l1 = 0; l1 < m; l1++) {
+      if (l1 != j) {
+	l[j] *= (x - REAL(p->v[l1])) / REAL(p->v[j] - p->v[l1]);
+
+	prod = 1.0 / REAL(p->v[j] - p->v[l1]);
+	for (l2 = 0; l2 < m; l2++) {
+	  if (l2 != j && l2 != l1) {
+	    prod *= (x - REAL(p->v[l2])) / REAL(p->v[j] - p->v[l2]);
+	  }
+	}
+	dl[j] += prod;
+      }
+    }
+  }
+}
+
+/* Add w e^{i kappa <x,dir>} L_nu(x) or, if dn is set,
+ * w e^{i kappa <x,dir>} (dL_nu/dn(x) + i kappa <n,dir> L_nu(x)) to the
+ * entries V[i,nu] for all nu */
+static void
+add_dlagrange_point_bem3d(const real * x, const real * n, field w,
+			  pcavector px, pcavector py, pcavector pz,
+			  const real * dir, real kappa, bool dn,
+			  real * lx, real * ly, real * lz,
+			  real * dlx, real * dly, real * dlz, uint i,
+			  pamatrix V)
+{
+  const uint mx = px->dim;
+  const uint my = py->dim;
+  const uint mz = pz->dim;
+  longindex ld = V->ld;
+  field     phase, ikn;
+  real      arg, lxy, val;
+  uint      jx, jy, jz, index;
+
+  lagrange_diff_1d_bem3d(px, x[0], lx, dlx);
+  lagrange_diff_1d_bem3d(py, x[1], ly, dly);
+  lagrange_diff_1d_bem3d(pz, x[2], lz, dlz);
+
+  arg = kappa * REAL_DOT3(x, dir);
+  phase = w * (REAL_COS(arg) + I * REAL_SIN(arg));
+
+  index = 0;
+  if (dn) {
+    ikn = I * kappa * REAL_DOT3(n, dir);
+
+    for (jx = 0; jx < mx; jx++) {
+      for (jy = 0; jy < my; jy++) {
+	lxy = lx[jx] * ly[jy];
+	for (jz = 0; jz < mz; jz++) {
+	  val = n[0] * dlx[jx] * ly[jy] * lz[jz]
+	    + n[1] * lx[jx] * dly[jy] * lz[jz] + n[2] * lxy * dlz[jz];
+	  V->a[i + index * ld] += phase * (val + ikn * lxy * lz[jz]);
+	  index++;
+	}
+      }
+    }
+  }
+  else {
+    for (jx = 0; jx < mx; jx++) {
+      for (jy = 0; jy < my; jy++) {
+	lxy = lx[jx] * ly[jy];
+	for (jz = 0; jz < mz; jz++) {
+	  V->a[i + index * ld] += phase * lxy * lz[jz];
+	  index++;
+	}
+      }
+    }
+  }
+}
+
+static void
+assemble_bem3d_dlagrange_amatrix(const uint * idx, pcavector px,
+				 pcavector py, pcavector pz, const real * dir,
+				 pcbem3d bem, bool linear, bool dn, pamatrix V)
+{
+  pcsurface3d gr = bem->gr;
+  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
+  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
+  const     real(*gr_n)[3] = (const real(*)[3]) gr->n;
+  const preal gr_g = (const preal) gr->g;
+  plistnode *v2t = bem->v2t;
+  uint      rows = V->rows;
+  uint      nq = bem->sq->n_single;
+  real     *xx = bem->sq->x_single;
+  real     *yy = bem->sq->y_single;
+  real      kappa = bem->k;
+
+  const real *A, *B, *C, *ww;
+  real     *lx, *ly, *lz, *dlx, *dly, *dlz;
+  real      x[3], tx, sx, Ax, Bx, Cx;
+  plistnode v;
+  uint      i, tt, q, lv;
+  longindex ii, vv;
+
+  lx = allocreal(px->dim);
+  ly = allocreal(py->dim);
+  lz = allocreal(pz->dim);
+  dlx = allocreal(px->dim);
+  dly = allocreal(py->dim);
+  dlz = allocreal(pz->dim);
+
+  clear_amatrix(V);
+
+  for (i = 0; i < rows; i++) {
+    ii = (idx == NULL ? i : idx[i]);
+
+    if (linear) {
+      for (v = v2t[ii], vv = v->data; v->next != NULL;
+	   v = v->next, vv = v->data) {
+	A = gr_x[gr_t[vv][0]];
+	B = gr_x[gr_t[vv][1]];
+	C = gr_x[gr_t[vv][2]];
+
+	/* Local number of the vertex in the triangle */
+	lv = (gr_t[vv][0] == ii ? 0 : (gr_t[vv][1] == ii ? 1 : 2));
+	ww = bem->sq->w_single + lv * nq;
+
+	for (q = 0; q < nq; q++) {
+	  tx = xx[q];
+	  sx = yy[q];
+	  Ax = 1.0 - tx;
+	  Bx = tx - sx;
+	  Cx = sx;
+
+	  x[0] = A[0] * Ax + B[0] * Bx + C[0] * Cx;
+	  x[1] = A[1] * Ax + B[1] * Bx + C[1] * Cx;
+	  x[2] = A[2] * Ax + B[2] * Bx + C[2] * Cx;
+
+	  add_dlagrange_point_bem3d(x, gr_n[vv], gr_g[vv] * ww[q], px, py, pz,
+				    dir, kappa, dn, lx, ly, lz, dlx, dly, dlz,
+				    i, V);
+	}
+      }
+    }
+    else {
+      tt = ii;
+      A = gr_x[gr_t[tt][0]];
+      B = gr_x[gr_t[tt][1]];
+      C = gr_x[gr_t[tt][2]];
+      ww = bem->sq->w_single + 3 * nq;
+
+      for (q = 0; q < nq; q++) {
+	tx = xx[q];
+	sx = yy[q];
+	Ax = 1.0 - tx;
+	Bx = tx - sx;
+	Cx = sx;
+
+	x[0] = A[0] * Ax + B[0] * Bx + C[0] * Cx;
+	x[1] = A[1] * Ax + B[1] * Bx + C[1] * Cx;
+	x[2] = A[2] * Ax + B[2] * Bx + C[2] * Cx;
+
+	add_dlagrange_point_bem3d(x, gr_n[tt], gr_g[tt] * ww[q], px, py, pz,
+				  dir, kappa, dn, lx, ly, lz, dlx, dly, dlz,
+				  i, V);
+      }
+    }
+  }
+
+  freemem(dlz);
+  freemem(dly);
+  freemem(dlx);
+  freemem(lz);
+  freemem(ly);
+  freemem(lx);
+}
+
+void
+assemble_bem3d_dlagrange_const_amatrix(const uint * idx, pcavector px,
+				       pcavector py, pcavector pz,
+				       const real * dir, pcbem3d bem,
+				       pamatrix V)
+{
+  assemble_bem3d_dlagrange_amatrix(idx, px, py, pz, dir, bem, false, false,
+				   V);
+}
+
+void
+assemble_bem3d_dlagrange_linear_amatrix(const uint * idx, pcavector px,
+					pcavector py, pcavector pz,
+					const real * dir, pcbem3d bem,
+					pamatrix V)
+{
+  assemble_bem3d_dlagrange_amatrix(idx, px, py, pz, dir, bem, true, false,
+				   V);
+}
+
+void
+assemble_bem3d_dn_dlagrange_const_amatrix(const uint * idx, pcavector px,
+					  pcavector py, pcavector pz,
+					  const real * dir, pcbem3d bem,
+					  pamatrix V)
+{
+  assemble_bem3d_dlagrange_amatrix(idx, px, py, pz, dir, bem, false, true,
+				   V);
+}
+
+void
+assemble_bem3d_dn_dlagrange_linear_amatrix(const uint * idx, pcavector px,
+					   pcavector py, pcavector pz,
+					   const real * dir, pcbem3d bem,
+					   pamatrix V)
+{
+  assemble_bem3d_dlagrange_amatrix(idx, px, py, pz, dir, bem, true, true,
+				   V);
+}
+
+void
+setup_dh2matrix_aprx_inter_bem3d(pbem3d bem, uint m)
+{
+  assert(bem->kernels->dlagrange_row != NULL);
+  assert(bem->kernels->dlagrange_col != NULL);
+  assert(bem->kernels->fundamental != NULL);
+
+  setup_interpolation_bem3d(bem->aprx, m);
+}
+
+static void
+assemble_bem3d_dh2matrix_dclusterbasis(pcbem3d bem, pdclusterbasis cb,
+				       bool row)
+{
+  pkernelbem3d kernels = bem->kernels;
+  pccluster t = cb->t;
+  const uint m = bem->aprx->m_inter;
+  const uint k = bem->aprx->k_inter;
+  real      kappa = bem->k;
+
+  pamatrix  E;
+  pdclusterbasis cb1;
+  pavector  px, py, pz;
+  real(*X)[3];
+  real      d[3], arg;
+  field     phase;
+  uint      i, j, jd, s, iota;
+
+  for (s = 0; s < cb->sons; s++) {
+    assemble_bem3d_dh2matrix_dclusterbasis(bem, cb->son[s], row);
+  }
+
+  px = new_avector(m);
+  py = new_avector(m);
+  pz = new_avector(m);
+
+  assemble_interpoints3d_avector(bem, t, px, py, pz);
+
+  if (cb->sons > 0) {
+    X = (real(*)[3]) allocreal(3 * k);
+
+    for (s = 0; s < cb->sons; s++) {
+      cb1 = cb->son[s];
+
+      assemble_interpoints3d_array(bem, cb1->t, X);
+
+      for (iota = 0; iota < cb->directions; iota++) {
+	E = cb->E + s + iota * cb->sons;
+	jd = cb->dirson[s + iota * cb->sons];
+
+	/* E[nu',nu] = e^{i kappa <xi'_nu', c - c'>} L_nu(xi'_nu') */
+	assemble_bem3d_lagrange_amatrix((const real(*)[3]) X, px, py, pz, E);
+
+	d[0] = cb->dir[iota][0] - cb1->dir[jd][0];
+	d[1] = cb->dir[iota][1] - cb1->dir[jd][1];
+	d[2] = cb->dir[iota][2] - cb1->dir[jd][2];
+
+	for (i = 0; i < E->rows; i++) {
+	  arg = kappa * REAL_DOT3(X[i], d);
+	  phase = REAL_COS(arg) + I * REAL_SIN(arg);
+	  for (j = 0; j < E->cols; j++) {
+	    E->a[i + j * E->ld] *= phase;
+	  }
+	}
+      }
+    }
+
+    freemem(X);
+  }
+  else {
+    for (iota = 0; iota < cb->directions; iota++) {
+      if (row) {
+	kernels->dlagrange_row(t->idx, px, py, pz, cb->dir[iota], bem,
+			       cb->V + iota);
+      }
+      else {
+	kernels->dlagrange_col(t->idx, px, py, pz, cb->dir[iota], bem,
+			       cb->V + iota);
+      }
+    }
+  }
+
+  del_avector(pz);
+  del_avector(py);
+  del_avector(px);
+}
+
+void
+assemble_bem3d_dh2matrix_row_dclusterbasis(pcbem3d bem, pdclusterbasis rb)
+{
+  resize_dclusterbasis(rb, bem->aprx->k_inter);
+
+  assemble_bem3d_dh2matrix_dclusterbasis(bem, rb, true);
+}
+
+void
+assemble_bem3d_dh2matrix_col_dclusterbasis(pcbem3d bem, pdclusterbasis cb)
+{
+  resize_dclusterbasis(cb, bem->aprx->k_inter);
+
+  assemble_bem3d_dh2matrix_dclusterbasis(bem, cb, false);
+}
+
+static void
+assemble_bem3d_duniform(pcbem3d bem, pduniform u)
+{
+  pccluster rc = u->rb->t;
+  pccluster cc = u->cb->t;
+  const real *rdir = u->rb->dir[u->rd];
+  const real *cdir = u->cb->dir[u->cd];
+  const uint kr = u->rb->k;
+  const uint kc = u->cb->k;
+  pamatrix  S = &u->S;
+  real      kappa = bem->k;
+
+  real(*xi_r)[3], (*xi_c)[3];
+  field    *rphase, cphase;
+  real      arg;
+  uint      i, j;
+
+  resize_amatrix(S, kr, kc);
+
+  xi_r = (real(*)[3]) allocreal(3 * kr);
+  xi_c = (real(*)[3]) allocreal(3 * kc);
+  rphase = allocfield(kr);
+
+  assemble_interpoints3d_array(bem, rc, xi_r);
+  assemble_interpoints3d_array(bem, cc, xi_c);
+
+  bem->kernels->fundamental(bem, (const real(*)[3]) xi_r,
+			    (const real(*)[3]) xi_c, S);
+
+  /* S[nu,mu] = g(xi_nu,eta_mu) e^{-i kappa <xi_nu,c_t>}
+   * e^{i kappa <eta_mu,c_s>} */
+  for (i = 0; i < kr; i++) {
+    arg = kappa * REAL_DOT3(xi_r[i], rdir);
+    rphase[i] = REAL_COS(arg) - I * REAL_SIN(arg);
+  }
+  for (j = 0; j < kc; j++) {
+    arg = kappa * REAL_DOT3(xi_c[j], cdir);
+    cphase = REAL_COS(arg) + I * REAL_SIN(arg);
+    for (i = 0; i < kr; i++) {
+      S->a[i + j * S->ld] *= rphase[i] * cphase;
+    }
+  }
+
+  freemem(rphase);
+  freemem(xi_c);
+  freemem(xi_r);
+}
+
+void
+assemble_bem3d_dh2matrix(pcbem3d bem, pdh2matrix G)
+{
+  uint      i;
+
+  if (G->son) {
+    for (i = 0; i < G->rsons * G->csons; i++) {
+      assemble_bem3d_dh2matrix(bem, G->son[i]);
+    }
+  }
+  else if (G->u) {
+    assemble_bem3d_duniform(bem, G->u);
+  }
+  else {
+    assert(G->f);
+    bem->nearfield(G->rb->t->idx, G->cb->t->idx, bem, false, G->f);
+  }
 }
 
+#endif
+
 void
 integrate_bem3d_const_avector(pbem3d bem, boundary_func3d rhs, pavector f,
 			      void *data)
@@ -5413,6 +6491,15 @@ build_bem3d_amatrix(pccluster row, pccluster col, void *data)
   return N;
 }
 
+void
+fill_bem3d_amatrix(const uint * ridx, const uint * cidx, void *data,
+		   pamatrix N)
+{
+  pcbem3d   bem = (pcbem3d) data;
+
+  bem->nearfield(ridx, cidx, bem, false, N);
+}
+
 /* ------------------------------------------------------------
  Initializerfunctions for h-matrix approximations
  ------------------------------------------------------------ */
@@ -5599,6 +6686,103 @@ setup_hmatrix_aprx_green_mixed_bem3d(pbem3d bem, pccluster rc,
  Greenhybrid
  ------------------------------------------------------------ */
 
+/* Collect the row clusters of all admissible leaves, indexed by their
+ * names */
+static void
+collect_row_greencluster3d(pcblock b, uint bname, uint rname, uint cname,
+			   uint pardepth, void *data)
+{
+  pccluster *rcn = (pccluster *) data;
+
+  (void) bname;
+  (void) cname;
+  (void) pardepth;
+
+  if (b->son == NULL && b->a) {
+    rcn[rname] = b->rc;
+  }
+}
+
+/* Collect the column clusters of all admissible leaves, indexed by their
+ * names */
+static void
+collect_col_greencluster3d(pcblock b, uint bname, uint rname, uint cname,
+			   uint pardepth, void *data)
+{
+  pccluster *ccn = (pccluster *) data;
+
+  (void) bname;
+  (void) rname;
+  (void) pardepth;
+
+  if (b->son == NULL && b->a) {
+    ccn[cname] = b->cc;
+  }
+}
+
+/* Set up the greencluster3d objects of all row clusters that appear in
+ * admissible leaves of the block tree before the assembly starts.
+ * The clusters are independent and are set up in parallel, while the
+ * assembly of the leaves only reads them and needs no lock. */
+static void
+setup_row_greencluster3d(pcbem3d bem, pccluster rc, pcblock tree)
+{
+  pparbem3d par = bem->par;
+  pccluster *rcn;
+  uint      n = rc->desc;
+  uint      i;
+
+  rcn = (pccluster *) allocmem((size_t) n * sizeof(pccluster));
+  for (i = 0; i < n; ++i) {
+    rcn[i] = NULL;
+  }
+
+  iterate_block(tree, 0, 0, 0, collect_row_greencluster3d, NULL, rcn);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(max_pardepth > 0)
+#endif
+  for (i = 0; i < n; ++i) {
+    if (rcn[i] != NULL) {
+      par->grcn[i] = new_greencluster3d(rcn[i]);
+      assemble_row_greencluster3d(bem, par->grcn[i]);
+    }
+  }
+
+  freemem(rcn);
+}
+
+/* Set up the greencluster3d objects of all column clusters that appear
+ * in admissible leaves of the block tree, see
+ * setup_row_greencluster3d */
+static void
+setup_col_greencluster3d(pcbem3d bem, pccluster cc, pcblock tree)
+{
+  pparbem3d par = bem->par;
+  pccluster *ccn;
+  uint      n = cc->desc;
+  uint      i;
+
+  ccn = (pccluster *) allocmem((size_t) n * sizeof(pccluster));
+  for (i = 0; i < n; ++i) {
+    ccn[i] = NULL;
+  }
+
+  iterate_block(tree, 0, 0, 0, collect_col_greencluster3d, NULL, ccn);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if(max_pardepth > 0)
+#endif
+  for (i = 0; i < n; ++i) {
+    if (ccn[i] != NULL) {
+      par->gccn[i] = new_greencluster3d(ccn[i]);
+      assemble_col_greencluster3d(bem, par->gccn[i]);
+    }
+  }
+
+  freemem(ccn);
+}
+
 void
 setup_hmatrix_aprx_greenhybrid_row_bem3d(pbem3d bem, pccluster rc,
 					 pccluster cc, pcblock tree, uint m,
@@ -5610,7 +6794,6 @@ setup_hmatrix_aprx_greenhybrid_row_bem3d(pbem3d bem, pccluster rc,
   uint      n, i;
 
   (void) cc;
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->fundamental_row != NULL);
@@ -5649,6 +6832,8 @@ setup_hmatrix_aprx_greenhybrid_row_bem3d(pbem3d bem, pccluster rc,
   }
 
   par->grcnn = n;
+
+  setup_row_greencluster3d(bem, rc, tree);
 }
 
 void
@@ -5662,7 +6847,6 @@ setup_hmatrix_aprx_greenhybrid_col_bem3d(pbem3d bem, pccluster rc,
   uint      i, n;
 
   (void) rc;
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->kernel_col != NULL);
@@ -5701,6 +6885,8 @@ setup_hmatrix_aprx_greenhybrid_col_bem3d(pbem3d bem, pccluster rc,
   }
 
   par->gccnn = n;
+
+  setup_col_greencluster3d(bem, cc, tree);
 }
 
 void
@@ -5713,7 +6899,6 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem3d(pbem3d bem, pccluster rc,
 
   uint      i, n;
 
-  (void) tree;
 
   assert(quadpoints != NULL);
   assert(bem->kernels->fundamental_row != NULL);
@@ -5755,6 +6940,8 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem3d(pbem3d bem, pccluster rc,
 
   par->grcnn = n;
 
+  setup_row_greencluster3d(bem, rc, tree);
+
   n = par->gccnn;
 
   if (par->gccn != NULL && par->gccnn != 0) {
@@ -5776,6 +6963,8 @@ setup_hmatrix_aprx_greenhybrid_mixed_bem3d(pbem3d bem, pccluster rc,
   }
 
   par->gccnn = n;
+
+  setup_col_greencluster3d(bem, cc, tree);
 }
 
 /* ------------------------------------------------------------
@@ -5826,6 +7015,56 @@ setup_hmatrix_aprx_paca_bem3d(pbem3d bem, pccluster rc, pccluster cc,
   bem->transfer_col = NULL;
 }
 
+void
+setup_hmatrix_aprx_blockpaca_bem3d(pbem3d bem, pccluster rc, pccluster cc,
+				   pcblock tree, real accur, uint block)
+{
+
+  (void) rc;
+  (void) cc;
+  (void) tree;
+
+  assert(bem->nearfield_far != NULL);
+  assert(block > 0);
+
+  setup_aca_bem3d(bem->aprx, accur);
+  bem->aprx->block_aca = block;
+
+  bem->farfield_rk = assemble_bem3d_blockPACA_rkmatrix;
+  bem->farfield_u = NULL;
+
+  bem->leaf_row = NULL;
+  bem->leaf_col = NULL;
+  bem->transfer_row = NULL;
+  bem->transfer_col = NULL;
+}
+
+/* ------------------------------------------------------------
+ Randomized range finder
+ ------------------------------------------------------------ */
+
+void
+setup_hmatrix_aprx_rand_bem3d(pbem3d bem, pccluster rc, pccluster cc,
+			      pcblock tree, real accur)
+{
+
+  (void) rc;
+  (void) cc;
+  (void) tree;
+
+  assert(bem->nearfield_far != NULL);
+
+  setup_rand_bem3d(bem->aprx, accur);
+
+  bem->farfield_rk = assemble_bem3d_RAND_rkmatrix;
+  bem->farfield_u = NULL;
+
+  bem->leaf_row = NULL;
+  bem->leaf_col = NULL;
+  bem->transfer_row = NULL;
+  bem->transfer_col = NULL;
+}
+
 /* ------------------------------------------------------------
  HCA
  ------------------------------------------------------------ */
@@ -5895,6 +7134,76 @@ setup_h2matrix_aprx_inter_bem3d(pbem3d bem, pcclusterbasis rb,
   bem->transfer_col = assemble_bem3d_inter_transfer_clusterbasis;
 }
 
+void
+setup_h2matrix_aprx_inter_cached_bem3d(pbem3d bem, pcclusterbasis rb,
+				       pcclusterbasis cb, pcblock tree,
+				       uint m)
+{
+  real      diam;
+
+  setup_h2matrix_aprx_inter_bem3d(bem, rb, cb, tree, m);
+
+  diam = REAL_MAX(getdiam_2_cluster(rb->t), getdiam_2_cluster(cb->t));
+  if (diam <= 0.0) {
+    diam = 1.0;
+  }
+  bem->aprx->cache_inter =
+    new_couplingcache3d(COUPLINGCACHE_EPS_BEM3D * diam);
+
+  bem->farfield_u = assemble_bem3d_inter_cached_uniform;
+}
+
+uint
+getcachedcouplings_bem3d(pcbem3d bem)
+{
+  return (bem->aprx->cache_inter != NULL ?
+	  bem->aprx->cache_inter->entries : 0);
+}
+
+size_t
+getsize_couplingcache_bem3d(pcbem3d bem)
+{
+  return (bem->aprx->cache_inter != NULL ?
+	  getsize_couplingcache3d(bem->aprx->cache_inter) : 0);
+}
+
+void
+del_couplingcache_bem3d(pbem3d bem)
+{
+  real      h;
+
+  if (bem->aprx->cache_inter != NULL) {
+    /* Keep an empty cache, so that the approximation scheme can still be
+     * used for further assemblies */
+    h = bem->aprx->cache_inter->h;
+    del_couplingcache3d(bem->aprx->cache_inter);
+    bem->aprx->cache_inter = new_couplingcache3d(h);
+  }
+}
+
+void
+setup_h2matrix_aprx_varinter_bem3d(pbem3d bem, pcclusterbasis rb,
+				   pcclusterbasis cb, pcblock tree, uint m0,
+				   real alpha)
+{
+
+  (void) tree;
+
+  assert(bem->kernels->lagrange_row != NULL);
+  assert(bem->kernels->lagrange_col != NULL);
+  assert(bem->kernels->fundamental != NULL);
+
+  setup_varinterpolation_bem3d(bem->aprx, rb->t, cb->t, m0, alpha);
+
+  bem->farfield_rk = NULL;
+  bem->farfield_u = assemble_bem3d_varinter_uniform;
+
+  bem->leaf_row = assemble_bem3d_varinter_row_clusterbasis;
+  bem->leaf_col = assemble_bem3d_varinter_col_clusterbasis;
+  bem->transfer_row = assemble_bem3d_varinter_transfer_row_clusterbasis;
+  bem->transfer_col = assemble_bem3d_varinter_transfer_col_clusterbasis;
+}
+
 void
 setup_h2matrix_aprx_greenhybrid_bem3d(pbem3d bem, pcclusterbasis rb,
 				      pcclusterbasis cb, pcblock tree, uint m,
@@ -6065,13 +7374,23 @@ assemble_bem3d_block_hmatrix(pcblock b, uint bname, uint rname,
   (void) pardepth;
 
   if (G->r) {
-    bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
-    if (aprx->recomp == true) {
-      trunc_rkmatrix(0, aprx->accur_recomp, G->r);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      setrank_rkmatrix(G->r, 0);
+    }
+    else {
+      bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
+      if (aprx->recomp == true) {
+	trunc_rkmatrix(0, aprx->accur_recomp, G->r);
+      }
     }
   }
   else if (G->f) {
-    bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    }
   }
 }
 
@@ -6090,13 +7409,23 @@ assemblecoarsen_bem3d_block_hmatrix(pcblock b, uint bname,
   (void) pardepth;
 
   if (G->r) {
-    bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
-    if (aprx->recomp == true) {
-      trunc_rkmatrix(NULL, aprx->accur_recomp, G->r);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      setrank_rkmatrix(G->r, 0);
+    }
+    else {
+      bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
+      if (aprx->recomp == true) {
+	trunc_rkmatrix(NULL, aprx->accur_recomp, G->r);
+      }
     }
   }
   else if (G->f) {
-    bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    }
   }
   else {
     assert(G->son != NULL);
@@ -6120,7 +7449,12 @@ assemble_nearfield_bem3d_block_hmatrix(pcblock b, uint bname,
   (void) pardepth;
 
   if (G->f) {
-    bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(G->rc->idx, G->cc->idx, bem, false, G->f);
+    }
   }
 }
 
@@ -6139,10 +7473,107 @@ assemble_farfield_bem3d_block_hmatrix(pcblock b, uint bname,
   (void) pardepth;
 
   if (G->r) {
-    bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
-    if (aprx->recomp == true) {
-      trunc_rkmatrix(0, aprx->accur_recomp, G->r);
+    if (beyond_window_bem3d(bem, G->rc, G->cc)) {
+      setrank_rkmatrix(G->r, 0);
+    }
+    else {
+      bem->farfield_rk(G->rc, rname, G->cc, cname, bem, G->r);
+      if (aprx->recomp == true) {
+	trunc_rkmatrix(0, aprx->accur_recomp, G->r);
+      }
+    }
+  }
+}
+
+/* Simultaneous assembly of nearfield matrices for several wavenumbers */
+struct _wavebem3d {
+  pbem3d   *bem;
+  uint      nk;
+  real     *k;
+};
+
+typedef struct _wavebem3d wavebem3d;
+
+static void
+assemble_nearfield_wave_bem3d(pbem3d * bem, uint nk, const real * k,
+			      const uint * ridx, const uint * cidx,
+			      pamatrix * N)
+{
+  uint      j;
+
+  if (bem[0]->nearfield_wave) {
+    bem[0]->nearfield_wave(ridx, cidx, bem[0], false, nk, k, N);
+  }
+  else {
+    for (j = 0; j < nk; ++j) {
+      bem[j]->nearfield(ridx, cidx, bem[j], false, N[j]);
+    }
+  }
+}
+
+static void
+assemble_nearfield_bem3d_block_wave_hmatrix(pcblock b, uint bname,
+					    uint rname, uint cname,
+					    uint pardepth, void *data)
+{
+  wavebem3d *wd = (wavebem3d *) data;
+  pbem3d   *bem = wd->bem;
+  uint      nk = wd->nk;
+  phmatrix  G = bem[0]->par->hn[bname];
+  pamatrix *N;
+  uint      j;
+
+  (void) b;
+  (void) rname;
+  (void) cname;
+  (void) pardepth;
+
+  if (G->f && beyond_window_bem3d(bem[0], G->rc, G->cc)) {
+    for (j = 0; j < nk; ++j) {
+      clear_amatrix(bem[j]->par->hn[bname]->f);
+    }
+  }
+  else if (G->f) {
+    N = (pamatrix *) allocmem(sizeof(pamatrix) * nk);
+    for (j = 0; j < nk; ++j) {
+      N[j] = bem[j]->par->hn[bname]->f;
+    }
+    assemble_nearfield_wave_bem3d(bem, nk, wd->k, G->rc->idx, G->cc->idx,
+				  N);
+    freemem(N);
+  }
+}
+
+static void
+assemble_nearfield_bem3d_block_wave_h2matrix(pcblock b, uint bname,
+					     uint rname, uint cname,
+					     uint pardepth, void *data)
+{
+  wavebem3d *wd = (wavebem3d *) data;
+  pbem3d   *bem = wd->bem;
+  uint      nk = wd->nk;
+  ph2matrix G = bem[0]->par->h2n[bname];
+  pamatrix *N;
+  uint      j;
+
+  (void) b;
+  (void) rname;
+  (void) cname;
+  (void) pardepth;
+
+  if (G->f && beyond_window_bem3d(bem[0], G->rb->t, G->cb->t)) {
+    for (j = 0; j < nk; ++j) {
+      clear_amatrix(bem[j]->par->h2n[bname]->f);
+    }
+  }
+  else if (G->f) {
+    N = (pamatrix *) allocmem(sizeof(pamatrix) * nk);
+    for (j = 0; j < nk; ++j) {
+      N[j] = bem[j]->par->h2n[bname]->f;
     }
+    assemble_nearfield_wave_bem3d(bem, nk, wd->k, G->rb->t->idx,
+				  G->cb->t->idx, N);
+    freemem(N);
   }
 }
 
@@ -6215,10 +7646,25 @@ assemble_bem3d_block_h2matrix(pcblock b, uint bname, uint rname,
   (void) pardepth;
 
   if (G->u) {
-    bem->farfield_u(rname, cname, bem, G->u);
+    if (G->u->S.owner != NULL) {
+      /* Coupling matrix shared with a cache, do not overwrite it */
+      uninit_amatrix(&G->u->S);
+      init_amatrix(&G->u->S, G->rb->k, G->cb->k);
+    }
+    if (beyond_window_bem3d(bem, G->rb->t, G->cb->t)) {
+      clear_amatrix(&G->u->S);
+    }
+    else {
+      bem->farfield_u(rname, cname, bem, G->u);
+    }
   }
   else if (G->f) {
-    bem->nearfield(G->rb->t->idx, G->cb->t->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, G->rb->t, G->cb->t)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(G->rb->t->idx, G->cb->t->idx, bem, false, G->f);
+    }
   }
 }
 
@@ -6238,7 +7684,12 @@ assemble_nearfield_bem3d_block_h2matrix(pcblock b, uint bname,
   (void) pardepth;
 
   if (G->f) {
-    bem->nearfield(G->rb->t->idx, G->cb->t->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, G->rb->t, G->cb->t)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(G->rb->t->idx, G->cb->t->idx, bem, false, G->f);
+    }
   }
 }
 
@@ -6256,7 +7707,17 @@ assemble_farfield_bem3d_block_h2matrix(pcblock b, uint bname,
   (void) pardepth;
 
   if (G->u) {
-    bem->farfield_u(rname, cname, bem, G->u);
+    if (G->u->S.owner != NULL) {
+      /* Coupling matrix shared with a cache, do not overwrite it */
+      uninit_amatrix(&G->u->S);
+      init_amatrix(&G->u->S, G->rb->k, G->cb->k);
+    }
+    if (beyond_window_bem3d(bem, G->rb->t, G->cb->t)) {
+      clear_amatrix(&G->u->S);
+    }
+    else {
+      bem->farfield_u(rname, cname, bem, G->u);
+    }
   }
 }
 
@@ -6333,7 +7794,9 @@ assemblehiercomp_bem3d_block_h2matrix(pcblock b, uint bname,
   if (G->u) {
     R = new_rkmatrix(rows, cols, 0);
 
-    bem->farfield_rk(rc, rname, cc, cname, bem, R);
+    if (!beyond_window_bem3d(bem, rc, cc)) {
+      bem->farfield_rk(rc, rname, cc, cname, bem, R);
+    }
     convert_rkmatrix_uniform(R, G->u, tm, rwn + bname, cwn + bname);
 
     ref_clusterbasis(&G->rb, G->u->rb);
@@ -6342,7 +7805,12 @@ assemblehiercomp_bem3d_block_h2matrix(pcblock b, uint bname,
     del_rkmatrix(R);
   }
   else if (G->f) {
-    bem->nearfield(rc->idx, cc->idx, bem, false, G->f);
+    if (beyond_window_bem3d(bem, rc, cc)) {
+      clear_amatrix(G->f);
+    }
+    else {
+      bem->nearfield(rc->idx, cc->idx, bem, false, G->f);
+    }
 
     rwn[bname] = new_leaf_clusteroperator(rc);
     resize_clusteroperator(rwn[bname], 0, G->rb->k);
@@ -6390,6 +7858,66 @@ assemble_farfield_bem3d_h2matrix(pbem3d bem, pblock b, ph2matrix G)
   par->h2n = NULL;
 }
 
+void
+assemble_bem3d_wave_hmatrix(pbem3d * bem, uint nk, pblock b, phmatrix * G)
+{
+  wavebem3d wd;
+  uint      j;
+
+  wd.bem = bem;
+  wd.nk = nk;
+  wd.k = allocreal(nk);
+  for (j = 0; j < nk; ++j) {
+    assert(bem[j]->gr == bem[0]->gr);
+    assert(bem[j]->nearfield_wave == bem[0]->nearfield_wave);
+    wd.k[j] = bem[j]->k;
+    bem[j]->par->hn = enumerate_hmatrix(b, G[j]);
+  }
+
+  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
+		      assemble_nearfield_bem3d_block_wave_hmatrix, &wd);
+
+  for (j = 0; j < nk; ++j) {
+    iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
+			assemble_farfield_bem3d_block_hmatrix, bem[j]);
+
+    freemem(bem[j]->par->hn);
+    bem[j]->par->hn = NULL;
+  }
+
+  freemem(wd.k);
+}
+
+void
+assemble_bem3d_wave_h2matrix(pbem3d * bem, uint nk, pblock b, ph2matrix * G)
+{
+  wavebem3d wd;
+  uint      j;
+
+  wd.bem = bem;
+  wd.nk = nk;
+  wd.k = allocreal(nk);
+  for (j = 0; j < nk; ++j) {
+    assert(bem[j]->gr == bem[0]->gr);
+    assert(bem[j]->nearfield_wave == bem[0]->nearfield_wave);
+    wd.k[j] = bem[j]->k;
+    bem[j]->par->h2n = enumerate_h2matrix(b, G[j]);
+  }
+
+  iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
+		      assemble_nearfield_bem3d_block_wave_h2matrix, &wd);
+
+  for (j = 0; j < nk; ++j) {
+    iterate_byrow_block(b, 0, 0, 0, max_pardepth, NULL,
+			assemble_farfield_bem3d_block_h2matrix, bem[j]);
+
+    freemem(bem[j]->par->h2n);
+    bem[j]->par->h2n = NULL;
+  }
+
+  freemem(wd.k);
+}
+
 void
 assemblehiercomp_bem3d_h2matrix(pbem3d bem, pblock b, ph2matrix G)
 {
@@ -27,6 +27,7 @@
 #include "hmatrix.h"
 #include "clusterbasis.h"
 #include "h2matrix.h"
+#include "dh2matrix.h"
 /* CORE 3 */
 #include "hcoarsen.h"
 #include "h2update.h"
@@ -168,6 +169,40 @@ enum _basisfunctionbem3d {
  */
 typedef enum _basisfunctionbem3d basisfunctionbem3d;
 
+/**
+ * @brief Possible accuracies for the evaluation of oscillatory kernel
+ * functions.
+ *
+ * The trigonometric functions within e.g. the Helmholtz kernel
+ * @f$ e^{\iota \kappa r} / r @f$ can either be evaluated by the standard
+ * library or by short polynomial approximations. The latter can be evaluated
+ * by the vector units of the processor and are considerably faster. Since the
+ * error of an @f$\mathcal H@f$- or @f$\mathcal H^2@f$-matrix approximation
+ * is usually much larger than the machine precision, the reduced accuracies
+ * are sufficient for most applications.
+ */
+enum _accuracybem3d {
+  /**
+   * @brief Evaluate the kernel function up to machine precision.
+   */
+  ACCURACY_FULL_BEM3D = 0,
+  /**
+   * @brief Evaluate the kernel function up to a relative error of about
+   * @f$10^{-10}@f$.
+   */
+  ACCURACY_HIGH_BEM3D = 1,
+  /**
+   * @brief Evaluate the kernel function up to a relative error of about
+   * @f$10^{-6}@f$.
+   */
+  ACCURACY_LOW_BEM3D = 2
+};
+
+/**
+ * This is just an abbreviation for the enum @ref _accuracybem3d .
+ */
+typedef enum _accuracybem3d accuracybem3d;
+
 /**
  * Defining a type for function that map from the boundary @f$ \Gamma @f$ of
  * the domain to a field @f$ \mathbb K @f$.
@@ -198,6 +233,52 @@ typedef field (*boundary_func3d)(const real *x, const real *n, void *data);
 typedef field (*kernel_func3d)(const real *x, const real *y, const real *nx,
     const real *ny, void *data);
 
+/**
+ * @brief Evaluate a fundamental solution or its normal derivatives for a
+ * whole batch of pairs of points @f$(x_i, y_i)@f$.
+ *
+ * The points are stored in structure-of-arrays layout, i.e. the
+ * @f$k@f$-th component of the @f$i@f$-th point can be found at
+ * <tt>x[i + k * n]</tt>. This allows implementations to process several
+ * pairs of points at once using the vector units of the processor.
+ *
+ * @param n Number of pairs of points.
+ * @param x First evaluation points, an array of length <tt>3 * n</tt>.
+ * @param y Second evaluation points, an array of length <tt>3 * n</tt>.
+ * @param nx Normal vector that belongs to all points in @p x.
+ * @param ny Normal vector that belongs to all points in @p y.
+ * @param data Additional data that is needed to evaluate the function.
+ * @param res Array of length @p n that will be filled with the
+ *        results.
+ */
+typedef void (*kernel_batch_func3d)(uint n, const real *x, const real *y,
+    const real *nx, const real *ny, void *data, field *res);
+
+/**
+ * @brief Evaluate a fundamental solution or its normal derivatives for a
+ * whole batch of pairs of points @f$(x_i, y_i)@f$ and several wavenumbers
+ * @f$k_j@f$ at once.
+ *
+ * The points are stored like for @ref kernel_batch_func3d. Distances and
+ * other geometric quantities only have to be computed once for all
+ * wavenumbers.
+ *
+ * @param n Number of pairs of points.
+ * @param x First evaluation points, an array of length <tt>3 * n</tt>.
+ * @param y Second evaluation points, an array of length <tt>3 * n</tt>.
+ * @param nx Normal vector that belongs to all points in @p x.
+ * @param ny Normal vector that belongs to all points in @p y.
+ * @param data Additional data that is needed to evaluate the function.
+ * @param nk Number of wavenumbers.
+ * @param k Array of length @p nk containing the wavenumbers.
+ * @param res Array of length <tt>n * nk</tt>, the result for the
+ *        @f$i@f$-th pair of points and the @f$j@f$-th wavenumber is stored
+ *        in <tt>res[i + j * n]</tt>.
+ */
+typedef void (*kernel_wave_func3d)(uint n, const real *x, const real *y,
+    const real *nx, const real *ny, void *data, uint nk, const real *k,
+    field *res);
+
 /**
  * This is just an abbreviation for the struct @ref _listnode .
  */
@@ -300,6 +381,12 @@ struct _bem3d {
    */
   field alpha;
 
+  /**
+   * @brief Coefficient of the single layer part of combined operators
+   * @f$ K + \alpha M + \beta V @f$, zero for all other operators.
+   */
+  field beta;
+
   /**
    * @brief Wavevector for Helmholtz type kernels
    */
@@ -312,6 +399,31 @@ struct _bem3d {
    */
   real k;
 
+  /**
+   * @brief Accuracy used for the evaluation of oscillatory kernel functions,
+   * defaults to @ref ACCURACY_FULL_BEM3D .
+   */
+  accuracybem3d accuracy;
+
+  /**
+   * @brief Start of the smooth cutoff of windowed kernel functions.
+   *
+   * Windowed kernels are multiplied by a smooth function @f$ w(r) @f$ of the
+   * distance @f$ r = \|x-y\|_2 @f$ that equals one for
+   * @f$ r \leq @f$ <tt>window_a</tt> and zero for
+   * @f$ r \geq @f$ <tt>window_b</tt>.
+   */
+  real window_a;
+
+  /**
+   * @brief End of the smooth cutoff of windowed kernel functions, zero if
+   * the kernel is not windowed.
+   *
+   * Blocks whose bounding boxes are at least <tt>window_b</tt> apart are
+   * structural zeros, see @ref beyond_window_bem3d .
+   */
+  real window_b;
+
   /**
    * @brief A constant factor extracted from the kernel function to speed up
    * quadrature.
@@ -380,6 +492,19 @@ struct _bem3d {
   void (*nearfield_far)(const uint *ridx, const uint *cidx, pcbem3d bem,
       bool ntrans, pamatrix N);
 
+  /**
+   * @brief Computes nearfield entries of Galerkin matrices for several
+   * wavenumbers at once.
+   *
+   * Like <tt>nearfield</tt>, but the entries for the wavenumbers
+   * <tt>k[0], ..., k[nk-1]</tt> are stored in the matrices
+   * <tt>N[0], ..., N[nk-1]</tt>, while the wavenumber <tt>bem->k</tt> is
+   * ignored. Quadrature points and distances are only computed once for all
+   * wavenumbers. May be NULL if the operator does not support this.
+   */
+  void (*nearfield_wave)(const uint *ridx, const uint *cidx, pcbem3d bem,
+      bool ntrans, uint nk, const real *k, pamatrix *N);
+
   /**
    * @brief Computes rank-k-approximations of a given block.
    *
@@ -966,6 +1091,30 @@ struct _kernelbem3d {
    */
   void (*lagrange_col)(const uint *idx, pcavector px, pcavector py,
       pcavector pz, pcbem3d bem, pamatrix W);
+
+  /**
+   * @brief Integrate directional Lagrange polynomials for the row
+   * @ref _dclusterbasis "dclusterbasis" of a directional
+   * @f$ \mathcal H^2 @f$-matrix.
+   *
+   * Like <tt>lagrange_row</tt>, but every Lagrange polynomial is multiplied
+   * by the plane wave @f$ e^{\iota \kappa \langle \vec x, \vec c \rangle}
+   * @f$ for the direction @f$ \vec c @f$ given by <tt>dir</tt>.
+   */
+  void (*dlagrange_row)(const uint *idx, pcavector px, pcavector py,
+      pcavector pz, const real *dir, pcbem3d bem, pamatrix V);
+
+  /**
+   * @brief Integrate directional Lagrange polynomials for the column
+   * @ref _dclusterbasis "dclusterbasis" of a directional
+   * @f$ \mathcal H^2 @f$-matrix.
+   *
+   * Like <tt>lagrange_col</tt>, but every Lagrange polynomial is multiplied
+   * by the plane wave @f$ e^{\iota \kappa \langle \vec y, \vec c \rangle}
+   * @f$ for the direction @f$ \vec c @f$ given by <tt>dir</tt>.
+   */
+  void (*dlagrange_col)(const uint *idx, pcavector px, pcavector py,
+      pcavector pz, const real *dir, pcbem3d bem, pamatrix W);
 };
 
 /**
@@ -1178,6 +1327,64 @@ HEADER_PREFIX pcluster build_bem3d_cluster(pcbem3d bem, uint clf,
  * Nearfield quadrature rountines
  ****************************************************/
 
+/**
+ * @brief Set up the near-field pair table of the quadrature rules of a
+ * @ref _bem3d "bem3d" object.
+ *
+ * All pairs of triangles contributing to the inadmissible leaves of the
+ * block tree @p b are collected, classified once and stored within
+ * <tt>bem->sq</tt>, see @ref setup_pairs_singquad2d. Afterwards the
+ * near-field quadrature routines look up the quadrature case and the vertex
+ * permutations of these pairs instead of determining them again.
+ * The table only depends on the geometry, therefore it can be reused for
+ * repeated assemblies, e.g. with different wavenumbers.
+ *
+ * @param bem @ref _bem3d "Bem3d" object, the row and column basis functions
+ *        are taken from <tt>bem->basis_neumann</tt> and
+ *        <tt>bem->basis_dirichlet</tt>.
+ * @param b Block tree, whose inadmissible leaves define the near field.
+ */
+HEADER_PREFIX void
+setup_nearfield_pairs_bem3d(pbem3d bem, pcblock b);
+
+/**
+ * @brief Switch on the distance-adaptive regular quadrature of a
+ * @ref _bem3d "bem3d" object.
+ *
+ * Instead of the fixed order <tt>q_regular</tt> passed to the constructor,
+ * every pair of disjoint triangles is integrated by a tensor Gauss rule
+ * whose order is chosen from the ratio of the distance and the diameter of
+ * the triangles, see @ref setup_adaptive_singquad2d. Since most pairs in
+ * the near field are well separated, far fewer quadrature points are
+ * needed at the same accuracy. The rules for all orders are cached within
+ * <tt>bem->sq</tt> and weighted for the basis functions of <tt>bem</tt>.
+ *
+ * @param bem @ref _bem3d "Bem3d" object, the row and column basis functions
+ *        are taken from <tt>bem->basis_neumann</tt> and
+ *        <tt>bem->basis_dirichlet</tt>.
+ * @param qmin Minimal order of the regular quadrature, zero switches the
+ *        adaptive mode off again.
+ */
+HEADER_PREFIX void
+setup_adaptive_quadrature_bem3d(pbem3d bem, uint qmin);
+
+/**
+ * @brief Check if a block lies entirely beyond the cutoff of a windowed
+ * kernel function.
+ *
+ * If <tt>bem->window_b</tt> is positive and the bounding boxes of @p rc and
+ * @p cc are at least <tt>bem->window_b</tt> apart, the kernel vanishes on
+ * the entire block. The assembly routines store such blocks as structural
+ * zeros without evaluating the kernel.
+ *
+ * @param bem @ref _bem3d "Bem3d" object.
+ * @param rc Row cluster.
+ * @param cc Column cluster.
+ * @return <tt>true</tt> if the block @f$ (t,s) @f$ is a structural zero.
+ */
+HEADER_PREFIX bool
+beyond_window_bem3d(pcbem3d bem, pccluster rc, pccluster cc);
+
 /**
  * @brief Compute general entries of a boundary integral operator with
  * piecewise constant basis functions for both Ansatz and test functions.
@@ -1351,6 +1558,254 @@ HEADER_PREFIX void
 assemble_ll_far_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
     bool ntrans, pamatrix N, kernel_func3d kernel);
 
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for both Ansatz and test functions.
+ *
+ * In contrast to @ref assemble_cc_near_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_cc_near_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_cc_near_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for both Ansatz and test functions.
+ *
+ * In contrast to @ref assemble_cc_far_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @attention This routines assumes that all pairs of triangles are disjoint and
+ * therefore optimizes the quadrature routine.
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_cc_far_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_cc_far_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for Test and piecewise linear basis
+ * functions for Ansatz functions.
+ *
+ * In contrast to @ref assemble_cl_near_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_cl_near_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_cl_near_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for Test and piecewise linear basis
+ * functions for Ansatz functions.
+ *
+ * In contrast to @ref assemble_cl_far_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @attention This routines assumes that all pairs of triangles are disjoint and
+ * therefore optimizes the quadrature routine.
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_cl_far_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_cl_far_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise linear basis functions for both Ansatz and test functions.
+ *
+ * In contrast to @ref assemble_ll_near_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_ll_near_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_ll_near_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise linear basis functions for both Ansatz and test functions.
+ *
+ * In contrast to @ref assemble_ll_far_bem3d the kernel function is evaluated
+ * for all quadrature points of a pair of triangles by a single call to a
+ * @ref kernel_batch_func3d .
+ *
+ * @attention This routines assumes that all pairs of triangles are disjoint and
+ * therefore optimizes the quadrature routine.
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N->rows-1</tt> are used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N->cols-1</tt> are
+ * used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in matrix <tt>N</tt> . If <tt>ntrans == true</tt> the matrix entries will
+ * be stored in a transposed way.
+ * @param N Matrix the entries are stored in, see
+ *        @ref assemble_ll_far_bem3d .
+ * @param kernel Defines the batched kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_ll_far_batch_bem3d(const uint * ridx, const uint * cidx, pcbem3d bem,
+    bool ntrans, pamatrix N, kernel_batch_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for both Ansatz and test functions
+ * for several wavenumbers at once.
+ *
+ * In contrast to @ref assemble_cc_near_batch_bem3d the quadrature points
+ * of every pair of triangles are passed to a @ref kernel_wave_func3d ,
+ * which evaluates the kernel function for all wavenumbers.
+ *
+ * @param ridx Defines the indices of row boundary elements used. If
+ * <tt>ridx</tt> equals NULL, then Elements <tt>0, ..., N[0]->rows-1</tt> are
+ * used.
+ * @param cidx Defines the indices of column boundary elements used.
+ * If <tt>cidx</tt> equals NULL, then Elements <tt>0, ..., N[0]->cols-1</tt>
+ * are used.
+ * @param bem @ref _bem3d "Bem3d" object, that contains additional
+ *        Information for the computation of the matrix entries.
+ * @param ntrans Is a boolean flag to indicates the way of storing the entries
+ * in the matrices <tt>N[j]</tt> .
+ * @param nk Number of wavenumbers.
+ * @param k Array of length @p nk containing the wavenumbers.
+ * @param N Array of @p nk matrices of identical size, <tt>N[j]</tt> receives
+ *        the entries for the wavenumber <tt>k[j]</tt>.
+ * @param kernel Defines the kernel function @f$g@f$ to be used within
+ *        the computation.
+ */
+HEADER_PREFIX void
+assemble_cc_near_wave_bem3d(const uint * ridx, const uint * cidx,
+    pcbem3d bem, bool ntrans, uint nk, const real * k, pamatrix * N,
+    kernel_wave_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise constant basis functions for Ansatz functions and piecewise
+ * linear basis functions for test functions for several wavenumbers at once.
+ *
+ * See @ref assemble_cc_near_wave_bem3d for a description of the
+ * parameters.
+ *
+ * @param ridx Indices of row boundary elements or NULL.
+ * @param cidx Indices of column vertices or NULL.
+ * @param bem @ref _bem3d "Bem3d" object.
+ * @param ntrans Store the entries in a transposed way.
+ * @param nk Number of wavenumbers.
+ * @param k Array of length @p nk containing the wavenumbers.
+ * @param N Array of @p nk matrices of identical size.
+ * @param kernel Defines the kernel function @f$g@f$.
+ */
+HEADER_PREFIX void
+assemble_cl_near_wave_bem3d(const uint * ridx, const uint * cidx,
+    pcbem3d bem, bool ntrans, uint nk, const real * k, pamatrix * N,
+    kernel_wave_func3d kernel);
+
+/**
+ * @brief Compute general entries of a boundary integral operator with
+ * piecewise linear basis functions for both Ansatz and test functions for
+ * several wavenumbers at once.
+ *
+ * See @ref assemble_cc_near_wave_bem3d for a description of the
+ * parameters.
+ *
+ * @param ridx Indices of row vertices or NULL.
+ * @param cidx Indices of column vertices or NULL.
+ * @param bem @ref _bem3d "Bem3d" object.
+ * @param ntrans Store the entries in a transposed way.
+ * @param nk Number of wavenumbers.
+ * @param k Array of length @p nk containing the wavenumbers.
+ * @param N Array of @p nk matrices of identical size.
+ * @param kernel Defines the kernel function @f$g@f$.
+ */
+HEADER_PREFIX void
+assemble_ll_near_wave_bem3d(const uint * ridx, const uint * cidx,
+    pcbem3d bem, bool ntrans, uint nk, const real * k, pamatrix * N,
+    kernel_wave_func3d kernel);
+
 /****************************************************
  * Compute single integrals with kernel functions
  ****************************************************/
@@ -1970,7 +2425,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_green_mixed_bem3d(pbem3d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -2031,7 +2488,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_greenhybrid_row_bem3d(pbem3d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -2073,7 +2532,9 @@ HEADER_PREFIX void setup_hmatrix_aprx_greenhybrid_col_bem3d(pbem3d bem,
  * scheme are set within the bem object.
  * @param rc Root of the row @ref _cluster "clustertree".
  * @param cc Root of the column @ref _cluster "clustertree".
- * @param tree Root of the @ref _block "blocktree".
+ * @param tree Root of the @ref _block "blocktree". The pivots and matrices
+ * of all clusters appearing in its admissible leaves are computed in
+ * advance, so this has to be the block tree used for the assembly.
  * @param m Number of gaussian quadrature points in each patch of the
  * parameterization.
  * @param l Number of subdivisions for gaussian quadrature in each patch of the
@@ -2132,6 +2593,50 @@ HEADER_PREFIX void setup_hmatrix_aprx_aca_bem3d(pbem3d bem, pccluster rc,
 HEADER_PREFIX void setup_hmatrix_aprx_paca_bem3d(pbem3d bem, pccluster rc,
     pccluster cc, pcblock tree, real accur);
 
+/**
+ * @brief Approximate matrix block with blocked ACA using partial pivoting.
+ *
+ * Like @ref setup_hmatrix_aprx_paca_bem3d, but up to <tt>block</tt> pivots
+ * are chosen in every step, so that whole panels of rows and columns are
+ * evaluated by one call of <tt>nearfield_far</tt> and updated by
+ * matrix-matrix multiplications, see @ref decomp_blockpartialaca_rkmatrix.
+ * @param bem All needed callback functions and parameters for this approximation
+ * scheme are set within the bem object.
+ * @param rc Root of the row @ref _cluster "clustertree".
+ * @param cc Root of the column @ref _cluster "clustertree".
+ * @param tree Root of the @ref _block "blocktree".
+ * @param accur Assesses the minimum accuracy for the ACA approximation.
+ * @param block Maximal number of pivots per step.
+ */
+HEADER_PREFIX void setup_hmatrix_aprx_blockpaca_bem3d(pbem3d bem,
+    pccluster rc, pccluster cc, pcblock tree, real accur, uint block);
+
+/* ------------------------------------------------------------
+ Randomized range finder
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Approximate matrix block with a randomized range finder.
+ *
+ * Every admissible block @f$ G_{|t \times s} @f$ is evaluated by one call
+ * of <tt>nearfield_far</tt> and multiplied by Gaussian test matrices until
+ * the a posteriori error estimate drops below <tt>accur</tt>, see
+ * @ref rangefinder_rkmatrix. The resulting basis is orthonormalized by
+ * QR decompositions and the approximation
+ * @f[
+ * G_{|t \times s} \approx A_b \, B_b^*
+ * @f]
+ * is truncated to the minimal rank.
+ * @param bem All needed callback functions and parameters for this approximation
+ * scheme are set within the bem object.
+ * @param rc Root of the row @ref _cluster "clustertree".
+ * @param cc Root of the column @ref _cluster "clustertree".
+ * @param tree Root of the @ref _block "blocktree".
+ * @param accur Assesses the minimum relative accuracy of the approximation.
+ */
+HEADER_PREFIX void setup_hmatrix_aprx_rand_bem3d(pbem3d bem, pccluster rc,
+    pccluster cc, pcblock tree, real accur);
+
 /* ------------------------------------------------------------
  HCA
  ------------------------------------------------------------ */
@@ -2275,6 +2780,101 @@ HEADER_PREFIX void setup_h2matrix_recomp_bem3d(pbem3d bem, bool hiercomp,
 HEADER_PREFIX void setup_h2matrix_aprx_inter_bem3d(pbem3d bem,
     pcclusterbasis rb, pcclusterbasis cb, pcblock tree, uint m);
 
+/**
+ * @brief Initialize the @ref _bem3d "bem3d" object for approximating an
+ * @ref _h2matrix "h2matrix" with tensorinterpolation, sharing coupling
+ * matrices between translated blocks.
+ *
+ * Like @ref setup_h2matrix_aprx_inter_bem3d, but the coupling matrices are
+ * kept in a cache within the @ref _bem3d "bem3d" object. Two admissible blocks
+ * whose row and column boxes coincide up to a common translation have the same
+ * coupling matrix if the kernel is translation-invariant, e.g., for the Laplace
+ * or Helmholtz kernel with fixed wave number. Such a matrix is computed only
+ * once, and the @ref _uniform "uniform" blocks refer to the cached
+ * coefficients instead of storing their own copies.
+ *
+ * The cache is keyed by the extents of both boxes, their offset, the ranks and
+ * the kernel function. It is released by @ref del_couplingcache_bem3d, by the
+ * next call of an interpolation setup function or by @ref del_bem3d, so the
+ * @ref _h2matrix "h2matrix" must not be used afterwards unless it is
+ * assembled again. Since the @ref _uniform "uniform" blocks
+ * do not own their coefficients, @ref getsize_h2matrix does not count them,
+ * see @ref getsize_couplingcache_bem3d. The shared coupling
+ * matrices must not be modified, e.g., by @ref compress_uniform or by
+ * @f$\mathcal H^2@f$-matrix arithmetic.
+ *
+ * @param bem All needed callback functions and parameters for this approximation
+ * scheme are set within the bem object.
+ * @param rb Root of the row @ref _clusterbasis "clusterbasis".
+ * @param cb Root of the column @ref _clusterbasis "clusterbasis".
+ * @param tree Root of the @ref _block "blocktree".
+ * @param m Number of Chebyshev interpolation points in each spatial dimension.
+ */
+HEADER_PREFIX void setup_h2matrix_aprx_inter_cached_bem3d(pbem3d bem,
+    pcclusterbasis rb, pcclusterbasis cb, pcblock tree, uint m);
+
+/**
+ * @brief Number of distinct coupling matrices in the cache set up by
+ * @ref setup_h2matrix_aprx_inter_cached_bem3d.
+ *
+ * @param bem BEM-object containing the cache.
+ * @return Number of cached coupling matrices, zero if no cache is used.
+ */
+HEADER_PREFIX uint getcachedcouplings_bem3d(pcbem3d bem);
+
+/**
+ * @brief Storage of the coupling matrix cache of a @ref _bem3d "bem3d"
+ * object.
+ *
+ * Together with @ref getsize_h2matrix this gives the storage of an
+ * @ref _h2matrix "h2matrix" assembled with
+ * @ref setup_h2matrix_aprx_inter_cached_bem3d.
+ *
+ * @param bem BEM-object containing the cache.
+ * @return Size of the cache and its coupling matrices in bytes, zero if no
+ * cache is used.
+ */
+HEADER_PREFIX size_t getsize_couplingcache_bem3d(pcbem3d bem);
+
+/**
+ * @brief Release the coupling matrices cached by
+ * @ref setup_h2matrix_aprx_inter_cached_bem3d.
+ *
+ * Should be called once the @ref _h2matrix "h2matrices" assembled with the
+ * cache have been deleted, since they refer to the cached coefficients.
+ * Matrices that are still in use have to be assembled again afterwards. The
+ * approximation scheme stays active and starts with an empty cache.
+ *
+ * @param bem BEM-object containing the cache.
+ */
+HEADER_PREFIX void del_couplingcache_bem3d(pbem3d bem);
+
+/**
+ * @brief Initialize the @ref _bem3d "bem3d" object for approximating an
+ * @ref _h2matrix "h2matrix" with variable-order tensorinterpolation.
+ *
+ * Like @ref setup_h2matrix_aprx_inter_bem3d, but a cluster @f$ t @f$ on level
+ * @f$ \ell @f$ of a cluster tree of depth @f$ L @f$ uses
+ * @f[
+ * m_t = m_0 + \lfloor \alpha (L - \ell) \rfloor
+ * @f]
+ * Chebyshev points in each spatial dimension, so the rank grows from the
+ * leaves towards the root. The transfer matrices evaluate the Lagrange
+ * polynomials of order @f$ m_t @f$ in the interpolation points of the sons,
+ * which may use a lower order.
+ *
+ * @param bem All needed callback functions and parameters for this approximation
+ * scheme are set within the bem object.
+ * @param rb Root of the row @ref _clusterbasis "clusterbasis".
+ * @param cb Root of the column @ref _clusterbasis "clusterbasis".
+ * @param tree Root of the @ref _block "blocktree".
+ * @param m0 Number of Chebyshev interpolation points in each spatial dimension
+ * on the deepest level.
+ * @param alpha Increase of the number of points per level.
+ */
+HEADER_PREFIX void setup_h2matrix_aprx_varinter_bem3d(pbem3d bem,
+    pcclusterbasis rb, pcclusterbasis cb, pcblock tree, uint m0, real alpha);
+
 /**
  * @brief  Initialize the @ref _bem3d "bem3d" object for approximating
  * a @ref _h2matrix "h2matrix" with green's method and ACA based
@@ -2531,6 +3131,32 @@ HEADER_PREFIX void assemble_nearfield_bem3d_hmatrix(pbem3d bem, pblock b,
 HEADER_PREFIX void assemble_farfield_bem3d_hmatrix(pbem3d bem, pblock b,
     phmatrix G);
 
+/**
+ * @brief Fills several @ref _hmatrix "hmatrices" sharing the same block tree
+ * for different wavenumbers.
+ *
+ * The nearfield parts of all matrices are computed in a single traversal of
+ * the block tree. If <tt>bem[0]->nearfield_wave</tt> is available, the
+ * quadrature points and distances of every pair of triangles are computed
+ * only once and just the kernel function is evaluated for every wavenumber.
+ * The farfield parts are filled afterwards using the approximation
+ * techniques of the individual @ref _bem3d "bem3d" objects.
+ *
+ * @attention All @ref _bem3d "bem3d" objects have to be distinct, describe
+ * the same operator on the same geometry and differ only in their
+ * wavenumbers. Every one has to be initialized with an approximation
+ * technique, see @ref assemble_bem3d_hmatrix.
+ *
+ * @param bem Array of @p nk @ref _bem3d "bem3d" objects, <tt>bem[j]->k</tt>
+ *        is the wavenumber used for <tt>G[j]</tt>.
+ * @param nk Number of wavenumbers.
+ * @param b Root of the @ref _block "blocktree".
+ * @param G Array of @p nk @ref _hmatrix "hmatrices" to be filled,
+ *        <tt>b</tt> has to be appropriate to all of them.
+ */
+HEADER_PREFIX void assemble_bem3d_wave_hmatrix(pbem3d *bem, uint nk,
+    pblock b, phmatrix *G);
+
 /* ------------------------------------------------------------
  Fill h2-matrix
  ------------------------------------------------------------ */
@@ -2666,6 +3292,30 @@ HEADER_PREFIX void assemble_nearfield_bem3d_h2matrix(pbem3d bem, pblock b,
 HEADER_PREFIX void assemble_farfield_bem3d_h2matrix(pbem3d bem, pblock b,
     ph2matrix G);
 
+/**
+ * @brief Fills several @ref _h2matrix "h2matrices" sharing the same block
+ * tree for different wavenumbers.
+ *
+ * The nearfield parts of all matrices are computed in a single traversal of
+ * the block tree, see @ref assemble_bem3d_wave_hmatrix. The coupling
+ * matrices are filled afterwards using the approximation techniques of the
+ * individual @ref _bem3d "bem3d" objects.
+ *
+ * @attention The @ref _clusterbasis "clusterbasis" of all matrices have to be
+ * computed before calling this function. Cluster bases that do not depend
+ * on the wavenumber, e.g. those of @ref setup_h2matrix_aprx_inter_bem3d, can
+ * be shared by all matrices and have to be filled only once.
+ *
+ * @param bem Array of @p nk distinct @ref _bem3d "bem3d" objects,
+ *        <tt>bem[j]->k</tt> is the wavenumber used for <tt>G[j]</tt>.
+ * @param nk Number of wavenumbers.
+ * @param b Root of the @ref _block "blocktree".
+ * @param G Array of @p nk @ref _h2matrix "h2matrices" to be filled,
+ *        <tt>b</tt> has to be appropriate to all of them.
+ */
+HEADER_PREFIX void assemble_bem3d_wave_h2matrix(pbem3d *bem, uint nk,
+    pblock b, ph2matrix *G);
+
 /**
  * @brief Fills an @ref _h2matrix "h2matrix" with a predefined approximation
  * technique using hierarchical recompression.
@@ -2885,6 +3535,172 @@ HEADER_PREFIX void assemble_bem3d_dn_lagrange_linear_amatrix(const uint *idx,
 HEADER_PREFIX void assemble_bem3d_lagrange_amatrix(const real (*X)[3],
     pcavector px, pcavector py, pcavector pz, pamatrix V);
 
+/* ------------------------------------------------------------
+ directional H2-matrices
+ ------------------------------------------------------------ */
+
+#ifdef USE_COMPLEX
+/**
+ * @brief Integrate directional Lagrange polynomials using piecewise
+ * constant basis functions.
+ *
+ * The matrix entries of <tt>V</tt> will be computed as
+ * @f[
+ * \left( V \right)_{i\mu} := \int_\Gamma \, \varphi_i(\vec x) \,
+ * e^{\iota \kappa \langle \vec x, \vec c \rangle} \, \mathcal L_\mu
+ * (\vec x) \, \mathrm d \vec x
+ * @f]
+ * with the wavenumber @f$ \kappa @f$ taken from <tt>bem->k</tt> and the
+ * Lagrange polynomials as in @ref assemble_bem3d_lagrange_const_amatrix .
+ *
+ * @param idx This array describes the permutation of the degrees of freedom.
+ * In case <tt>idx == NULL</tt> it is assumed the degrees of freedom are
+ * @f$ 0, 1, \ldots , \texttt{V->rows} -1 @f$ instead.
+ * @param px Interpolation points in x-direction.
+ * @param py Interpolation points in y-direction.
+ * @param pz Interpolation points in z-direction.
+ * @param dir Direction @f$ \vec c @f$, either a unit vector or zero.
+ * @param bem BEM-object containing additional information for computation
+ * of the matrix entries.
+ * @param V Matrix to store the computed results as stated above.
+ */
+HEADER_PREFIX void assemble_bem3d_dlagrange_const_amatrix(const uint *idx,
+    pcavector px, pcavector py, pcavector pz, const real *dir, pcbem3d bem,
+    pamatrix V);
+
+/**
+ * @brief Integrate directional Lagrange polynomials using piecewise
+ * linear basis functions.
+ *
+ * See @ref assemble_bem3d_dlagrange_const_amatrix for details.
+ *
+ * @param idx This array describes the permutation of the degrees of freedom.
+ * @param px Interpolation points in x-direction.
+ * @param py Interpolation points in y-direction.
+ * @param pz Interpolation points in z-direction.
+ * @param dir Direction @f$ \vec c @f$, either a unit vector or zero.
+ * @param bem BEM-object containing additional information for computation
+ * of the matrix entries.
+ * @param V Matrix to store the computed results.
+ */
+HEADER_PREFIX void assemble_bem3d_dlagrange_linear_amatrix(const uint *idx,
+    pcavector px, pcavector py, pcavector pz, const real *dir, pcbem3d bem,
+    pamatrix V);
+
+/**
+ * @brief Integrate the normal derivatives of the conjugated directional
+ * Lagrange polynomials using piecewise constant basis functions.
+ *
+ * The matrix entries of <tt>V</tt> will be computed as
+ * @f[
+ * \left( V \right)_{i\mu} := \overline{\int_\Gamma \, \varphi_i(\vec x)
+ * \, \frac{\partial}{\partial n} \left( e^{-\iota \kappa \langle \vec
+ * x, \vec c \rangle} \mathcal L_\mu \right) (\vec x) \, \mathrm d \vec
+ * x} ,
+ * @f]
+ * i.e., these are the column basis matrices for the double layer potential.
+ *
+ * @param idx This array describes the permutation of the degrees of freedom.
+ * @param px Interpolation points in x-direction.
+ * @param py Interpolation points in y-direction.
+ * @param pz Interpolation points in z-direction.
+ * @param dir Direction @f$ \vec c @f$, either a unit vector or zero.
+ * @param bem BEM-object containing additional information for computation
+ * of the matrix entries.
+ * @param V Matrix to store the computed results as stated above.
+ */
+HEADER_PREFIX void assemble_bem3d_dn_dlagrange_const_amatrix(const uint *idx,
+    pcavector px, pcavector py, pcavector pz, const real *dir, pcbem3d bem,
+    pamatrix V);
+
+/**
+ * @brief Integrate the normal derivatives of the conjugated directional
+ * Lagrange polynomials using piecewise linear basis functions.
+ *
+ * See @ref assemble_bem3d_dn_dlagrange_const_amatrix for details.
+ *
+ * @param idx This array describes the permutation of the degrees of freedom.
+ * @param px Interpolation points in x-direction.
+ * @param py Interpolation points in y-direction.
+ * @param pz Interpolation points in z-direction.
+ * @param dir Direction @f$ \vec c @f$, either a unit vector or zero.
+ * @param bem BEM-object containing additional information for computation
+ * of the matrix entries.
+ * @param V Matrix to store the computed results.
+ */
+HEADER_PREFIX void assemble_bem3d_dn_dlagrange_linear_amatrix(const uint *idx,
+    pcavector px, pcavector py, pcavector pz, const real *dir, pcbem3d bem,
+    pamatrix V);
+
+/**
+ * @brief Initialize the @ref _bem3d "bem3d" object for directional
+ * interpolation of oscillatory kernels.
+ *
+ * For an admissible block @f$ (t,s) @f$ with directions @f$ c @f$ the
+ * kernel function is approximated by
+ * @f[
+ * g(\vec x, \vec y) \approx \sum_{\nu, \mu}
+ * e^{\iota \kappa \langle \vec x, \vec c \rangle} \mathcal L_{t,\nu}
+ * (\vec x) \, g(\xi_{t,\nu}, \xi_{s,\mu})
+ * e^{-\iota \kappa \langle \xi_{t,\nu} - \xi_{s,\mu}, \vec c \rangle}
+ * \, \mathcal L_{s,\mu}(\vec y)
+ * e^{-\iota \kappa \langle \vec y, \vec c \rangle} ,
+ * @f]
+ * i.e., only the smooth factor @f$ g(\vec x, \vec y) e^{-\iota \kappa
+ * \langle \vec x - \vec y, \vec c \rangle} @f$ is interpolated by
+ * tensor Chebyshev interpolation of order <tt>m</tt>.
+ *
+ * @param bem All needed callback functions and parameters for this
+ * approximation scheme are set within the bem object.
+ * @param m Number of Chebyshev interpolation points in each spatial
+ * dimension.
+ */
+HEADER_PREFIX void setup_dh2matrix_aprx_inter_bem3d(pbem3d bem, uint m);
+
+/**
+ * @brief Fill a row @ref _dclusterbasis "dclusterbasis" by directional
+ * interpolation.
+ *
+ * Leaf matrices are computed by <tt>bem->kernels->dlagrange_row</tt> , the
+ * transfer matrices are given by
+ * @f$ (E_{t',c})_{\nu'\nu} = e^{\iota \kappa \langle \xi_{t',\nu'},
+ * \vec c - \vec c' \rangle} \mathcal L_{t,\nu}(\xi_{t',\nu'}) @f$ .
+ *
+ * @param bem BEM-object initialized by @ref setup_dh2matrix_aprx_inter_bem3d .
+ * @param rb Directional cluster basis, will be resized to rank
+ * @f$ m^3 @f$ .
+ */
+HEADER_PREFIX void assemble_bem3d_dh2matrix_row_dclusterbasis(pcbem3d bem,
+    pdclusterbasis rb);
+
+/**
+ * @brief Fill a column @ref _dclusterbasis "dclusterbasis" by directional
+ * interpolation.
+ *
+ * See @ref assemble_bem3d_dh2matrix_row_dclusterbasis , the leaf matrices
+ * are computed by <tt>bem->kernels->dlagrange_col</tt> .
+ *
+ * @param bem BEM-object initialized by @ref setup_dh2matrix_aprx_inter_bem3d .
+ * @param cb Directional cluster basis, will be resized to rank
+ * @f$ m^3 @f$ .
+ */
+HEADER_PREFIX void assemble_bem3d_dh2matrix_col_dclusterbasis(pcbem3d bem,
+    pdclusterbasis cb);
+
+/**
+ * @brief Fill the coupling matrices and nearfield blocks of a
+ * @ref _dh2matrix "dh2matrix".
+ *
+ * The cluster bases <tt>G->rb</tt> and <tt>G->cb</tt> have to be filled
+ * before by @ref assemble_bem3d_dh2matrix_row_dclusterbasis and
+ * @ref assemble_bem3d_dh2matrix_col_dclusterbasis .
+ *
+ * @param bem BEM-object initialized by @ref setup_dh2matrix_aprx_inter_bem3d .
+ * @param G Directional @f$ \mathcal H^2 @f$-matrix to be filled.
+ */
+HEADER_PREFIX void assemble_bem3d_dh2matrix(pcbem3d bem, pdh2matrix G);
+#endif
+
 /* ------------------------------------------------------------
  some useful functions
  ------------------------------------------------------------ */
@@ -3086,6 +3902,32 @@ HEADER_PREFIX prkmatrix build_bem3d_rkmatrix(pccluster row, pccluster col,
 HEADER_PREFIX pamatrix build_bem3d_amatrix(pccluster row, pccluster col,
     void* data);
 
+/**
+ * @brief Fill callback for matrix-free nearfield blocks, computes the
+ * submatrix for the row indices <tt>ridx</tt> and column indices
+ * <tt>cidx</tt>.
+ *
+ * This function matches @ref fillblock_t and simply calls
+ * <tt>((pcbem3d)data)->nearfield</tt>. Passing it to
+ * @ref build_from_block_matrixfree_hmatrix or
+ * @ref build_from_block_matrixfree_h2matrix yields matrices whose
+ * nearfield is recomputed in every matrix-vector product instead of
+ * being stored. The farfield is filled as usual by
+ * @ref assemble_bem3d_hmatrix or @ref assemble_bem3d_h2matrix, which
+ * skip matrix-free leaves.
+ *
+ * @attention The @ref _bem3d "bem3d" object has to stay alive and
+ * unchanged as long as the matrix is used.
+ *
+ * @param ridx Row indices of the block.
+ * @param cidx Column indices of the block.
+ * @param data This object has to be a valid @ref _bem3d "bem3d"
+ * object.
+ * @param N Target matrix, its size has to match the index sets.
+ */
+HEADER_PREFIX void fill_bem3d_amatrix(const uint *ridx, const uint *cidx,
+    void *data, pamatrix N);
+
 /** @} */
 
 #endif /* BEM3D_H_ */
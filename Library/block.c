@@ -150,6 +150,34 @@ admissible_2_min_cluster(pcluster rc, pcluster cc, void *data)
   return i;
 }
 
+bool
+admissible_max_cutoff_cluster(pcluster rc, pcluster cc, void *data)
+{
+  real      cutoff = ((real *) data)[1];
+
+  /* Blocks beyond the cutoff are structural zeros and are never
+   * subdivided, no matter how large the clusters are. */
+  if (cutoff > 0.0 && getdist_max_cluster(rc, cc) >= cutoff) {
+    return true;
+  }
+
+  return admissible_max_cluster(rc, cc, data);
+}
+
+bool
+admissible_parabolic_cluster(pcluster rc, pcluster cc, void *data)
+{
+  real      eta = ((real *) data)[0];
+  real      eta2 = ((real *) data)[1];
+  real      kappa = ((real *) data)[2];
+  real      diam, dist;
+
+  diam = REAL_MAX(getdiam_2_cluster(rc), getdiam_2_cluster(cc));
+  dist = getdist_2_cluster(rc, cc);
+
+  return (diam <= eta * dist && kappa * diam * diam <= eta2 * dist);
+}
+
 /* ------------------------------------------------------------
  Constructors and destructors
  ------------------------------------------------------------ */
@@ -150,6 +150,48 @@ admissible_sphere_cluster(pcluster rc, pcluster cc, void* data);
 HEADER_PREFIX bool
 admissible_2_min_cluster(pcluster rc, pcluster cc, void* data);
 
+/** @brief Check the admissibility condition in the maximum norm for kernels
+ * with a finite cutoff distance.
+ *
+ * The block @f$ (t,s) @f$ is admissible, if it is admissible in the sense of
+ * @ref admissible_max_cluster or if
+ * @f$ \text{dist}_{\infty} (B_t, B_s) \geq r_{\text{cut}} @f$.
+ * In the latter case a kernel function that vanishes beyond the distance
+ * @f$ r_{\text{cut}} @f$ is zero on the entire block, so the block is not
+ * subdivided any further, see @ref build_from_block_cutoff_hmatrix and
+ * @ref build_from_block_cutoff_h2matrix.
+ *
+ * @param rc Row cluster @f$t@f$.
+ * @param cc Col cluster @f$s@f$.
+ * @param data Has to be a pointer to an array of two reals, the first one
+ *        is eta and the second one is @f$ r_{\text{cut}} @f$. A
+ *        non-positive cutoff yields @ref admissible_max_cluster.
+ * @returns TRUE, if the block @f$ (t,s) @f$ is admissible, otherwise FALSE.
+ */
+HEADER_PREFIX bool
+admissible_max_cutoff_cluster(pcluster rc, pcluster cc, void* data);
+
+/** @brief Check the parabolic admissibility condition for directional
+ * approximations of oscillatory kernel functions.
+ *
+ * The block @f$ (t,s) @f$ is admissible, if
+ * @f$ \max \{\text{diam}_2 (B_t), \text{diam}_2 (B_s)\} \leq \eta
+ * \text{dist}_2 (B_t, B_s) @f$ and
+ * @f$ \kappa \max \{\text{diam}_2 (B_t), \text{diam}_2 (B_s)\}^2 \leq
+ * \eta_2 \text{dist}_2 (B_t, B_s) @f$.
+ * The second condition ensures that @f$ e^{\iota \kappa \|x-y\|} @f$ is
+ * well approximated by a plane wave in the direction between the clusters,
+ * see @ref build_from_block_dh2matrix.
+ *
+ * @param rc Row cluster @f$t@f$.
+ * @param cc Col cluster @f$s@f$.
+ * @param data Has to be a pointer to an array of three reals containing
+ *        @f$ \eta @f$, @f$ \eta_2 @f$ and the wavenumber @f$ \kappa @f$.
+ * @returns TRUE, if the block @f$ (t,s) @f$ is admissible, otherwise FALSE.
+ */
+HEADER_PREFIX bool
+admissible_parabolic_cluster(pcluster rc, pcluster cc, void* data);
+
 /* ------------------------------------------------------------
  Constructors and destructors
  ------------------------------------------------------------ */
@@ -40,6 +40,8 @@ init_raw_clusterbasis(pclusterbasis cb, pccluster t)
 
   cb->Z = NULL;
 
+  cb->arena = NULL;
+
 #ifdef USE_OPENMP
 #pragma omp atomic
 #endif
@@ -147,9 +149,14 @@ new_leaf_clusterbasis(pccluster t)
 void
 del_clusterbasis(pclusterbasis cb)
 {
+  parena    a = cb->arena;
+
   uninit_clusterbasis(cb);
 
   freemem(cb);
+
+  if (a)
+    del_arena(a);
 }
 
 /* ------------------------------------------------------------
@@ -259,6 +266,24 @@ build_from_cluster_clusterbasis(pccluster t)
   return cb;
 }
 
+pclusterbasis
+build_from_cluster_arena_clusterbasis(pccluster t)
+{
+  pclusterbasis cb;
+  parena    a, old;
+
+  a = new_arena(0);
+  old = select_arena(a);
+
+  cb = build_from_cluster_clusterbasis(t);
+
+  (void) select_arena(old);
+
+  cb->arena = a;
+
+  return cb;
+}
+
 /* ------------------------------------------------------------
    Clone a cluster basis
    ------------------------------------------------------------ */
@@ -1355,6 +1380,103 @@ backward_clusterbasis_trans_amatrix(pcclusterbasis cb, pamatrix Yt,
   uninit_amatrix(Yc);
 }
 
+void
+forward_permutation_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix X,
+					 pamatrix Xt)
+{
+  amatrix   loc1, loc2;
+  pamatrix  Xt1, Xc;
+  uint      i, j, xtoff;
+
+  assert(Xt->rows == cb->ktree);
+  assert(X->cols == Xt->cols);
+
+  Xc = init_sub_amatrix(&loc1, Xt, cb->k, 0, Xt->cols, 0);
+  clear_amatrix(Xc);
+
+  if (cb->sons > 0) {
+    xtoff = cb->k;
+    for (i = 0; i < cb->sons; i++) {
+      Xt1 =
+	init_sub_amatrix(&loc2, Xt, cb->son[i]->ktree, xtoff, Xt->cols, 0);
+
+      forward_permutation_clusterbasis_amatrix(cb->son[i], X, Xt1);
+
+      uninit_amatrix(Xt1);
+
+      Xt1 = init_sub_amatrix(&loc2, Xt, cb->son[i]->k, xtoff, Xt->cols, 0);
+
+      addmul_amatrix(1.0, true, &cb->son[i]->E, false, Xt1, Xc);
+      uninit_amatrix(Xt1);
+
+      xtoff += cb->son[i]->ktree;
+    }
+    assert(xtoff == cb->ktree);
+  }
+  else {
+    Xt1 = init_sub_amatrix(&loc2, Xt, cb->t->size, cb->k, Xt->cols, 0);
+
+    /* Find and copy rows */
+    for (j = 0; j < X->cols; j++)
+      for (i = 0; i < cb->t->size; i++)
+	Xt1->a[i + j * Xt1->ld] = X->a[cb->t->idx[i] + j * X->ld];
+
+    addmul_amatrix(1.0, true, &cb->V, false, Xt1, Xc);
+
+    uninit_amatrix(Xt1);
+  }
+
+  uninit_amatrix(Xc);
+}
+
+void
+backward_permutation_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt,
+					  pamatrix Y)
+{
+  amatrix   loc1, loc2;
+  pamatrix  Yt1, Yc;
+  uint      i, j, ytoff;
+
+  assert(Yt->rows == cb->ktree);
+  assert(Y->cols == Yt->cols);
+
+  Yc = init_sub_amatrix(&loc1, Yt, cb->k, 0, Yt->cols, 0);
+
+  if (cb->sons > 0) {
+    ytoff = cb->k;
+
+    for (i = 0; i < cb->sons; i++) {
+      Yt1 = init_sub_amatrix(&loc2, Yt, cb->son[i]->k, ytoff, Yt->cols, 0);
+      addmul_amatrix(1.0, false, &cb->son[i]->E, false, Yc, Yt1);
+      uninit_amatrix(Yt1);
+
+      Yt1 =
+	init_sub_amatrix(&loc2, Yt, cb->son[i]->ktree, ytoff, Yt->cols, 0);
+
+      backward_permutation_clusterbasis_amatrix(cb->son[i], Yt1, Y);
+
+      uninit_amatrix(Yt1);
+
+      ytoff += cb->son[i]->ktree;
+    }
+    assert(ytoff == cb->ktree);
+  }
+  else {
+    Yt1 = init_sub_amatrix(&loc2, Yt, cb->t->size, cb->k, Yt->cols, 0);
+
+    addmul_amatrix(1.0, false, &cb->V, false, Yc, Yt1);
+
+    /* Find and add rows */
+    for (j = 0; j < Y->cols; j++)
+      for (i = 0; i < cb->t->size; i++)
+	Y->a[cb->t->idx[i] + j * Y->ld] += Yt1->a[i + j * Yt1->ld];
+
+    uninit_amatrix(Yt1);
+  }
+
+  uninit_amatrix(Yc);
+}
+
 /* ------------------------------------------------------------
    Simple computations
    ------------------------------------------------------------ */
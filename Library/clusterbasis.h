@@ -68,6 +68,11 @@ struct _clusterbasis {
   puniform rlist;
   /** @brief List of matrices using this basis as column basis */
   puniform clist;
+
+  /** @brief Arena containing the storage of the entire tree, only set
+   *  for the root of a basis created by
+   *  @ref build_from_cluster_arena_clusterbasis */
+  parena arena;
 };
 
 /* ------------------------------------------------------------
@@ -249,6 +254,20 @@ resize_clusterbasis(pclusterbasis cb, int k);
 HEADER_PREFIX pclusterbasis
 build_from_cluster_clusterbasis(pccluster t);
 
+/** @brief Construct a @ref clusterbasis from a cluster tree, taking
+ *  the storage from an @ref arena.
+ *
+ *  Like @ref build_from_cluster_clusterbasis, but all nodes are placed
+ *  in one @ref arena that is released at once when the root is deleted.
+ *  Matrices allocated later, e.g., by @ref resize_clusterbasis, are
+ *  not part of the arena.
+ *
+ *  @param t Root cluster.
+ *  @returns New root @ref clusterbasis object following the
+ *         structure of the cluster tree. */
+HEADER_PREFIX pclusterbasis
+build_from_cluster_arena_clusterbasis(pccluster t);
+
 /* ------------------------------------------------------------
  * Clone a cluster basis
  * ------------------------------------------------------------ */
@@ -705,6 +724,41 @@ backward_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt, pamatrix Yp);
 HEADER_PREFIX void
 backward_clusterbasis_trans_amatrix(pcclusterbasis cb, pamatrix Yt, pamatrix Yp);
 
+/** @brief Matrix forward transformation in original numbering.
+ *
+ *  Compute @f$\widehat{X}_t = V_t^* X@f$ for all elements of the
+ *  cluster basis.
+ *
+ *  Matrix version of @ref forward_clusterbasis_avector, all columns
+ *  of @f$X@f$ are transformed by matrix-matrix products.
+ *
+ *  @param cb Cluster basis.
+ *  @param X Source matrix using the original numbering of the
+ *         indices in the rows.
+ *  @param Xt Target matrix with <tt>cb->ktree</tt> rows, will
+ *         be filled with a mix of transformed coefficients and
+ *         permuted coefficients. */
+HEADER_PREFIX void
+forward_permutation_clusterbasis_amatrix(pcclusterbasis cb, pcamatrix X,
+    pamatrix Xt);
+
+/** @brief Matrix backward transformation in original numbering.
+ *
+ *  Compute @f$Y \gets Y + V_t \widehat{Y}_t@f$ for all elements of the
+ *  cluster basis.
+ *
+ *  Matrix version of @ref backward_clusterbasis_avector.
+ *
+ *  @param cb Cluster basis.
+ *  @param Yt Source matrix with <tt>cb->ktree</tt> rows, filled
+ *         with a mix of transformed coefficients and permuted coefficients.
+ *         The matrix will be overwritten by the function.
+ *  @param Y Target matrix using the original numbering of the
+ *         indices in the rows. */
+HEADER_PREFIX void
+backward_permutation_clusterbasis_amatrix(pcclusterbasis cb, pamatrix Yt,
+    pamatrix Y);
+
 /* ------------------------------------------------------------
  * Simple computations
  * ------------------------------------------------------------ */
@@ -0,0 +1,421 @@
+/* ------------------------------------------------------------
+ * This is the file "dclusterbasis.c" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+#include "dclusterbasis.h"
+
+#include "basic.h"
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+pdclusterbasis
+new_dclusterbasis(pccluster t, uint directions)
+{
+  pdclusterbasis cb;
+  uint      i, n;
+
+  assert(directions > 0);
+
+  cb = (pdclusterbasis) allocmem(sizeof(dclusterbasis));
+
+  cb->t = t;
+  cb->k = 0;
+  cb->directions = directions;
+  cb->dir = (real(*)[3]) allocreal(3 * directions);
+  for (i = 0; i < directions; i++) {
+    cb->dir[i][0] = cb->dir[i][1] = cb->dir[i][2] = 0.0;
+  }
+
+  cb->sons = t->sons;
+  cb->son = NULL;
+  cb->dirson = NULL;
+  cb->E = NULL;
+  cb->V = NULL;
+
+  if (cb->sons > 0) {
+    n = cb->sons * directions;
+
+    cb->son = (pdclusterbasis *) allocmem(sizeof(pdclusterbasis) * cb->sons);
+    for (i = 0; i < cb->sons; i++) {
+      cb->son[i] = NULL;
+    }
+
+    cb->dirson = allocuint(n);
+    cb->E = (pamatrix) allocmem(sizeof(amatrix) * n);
+    for (i = 0; i < n; i++) {
+      cb->dirson[i] = 0;
+      init_amatrix(cb->E + i, 0, 0);
+    }
+  }
+  else {
+    cb->V = (pamatrix) allocmem(sizeof(amatrix) * directions);
+    for (i = 0; i < directions; i++) {
+      init_amatrix(cb->V + i, 0, 0);
+    }
+  }
+
+  update_dclusterbasis(cb);
+
+  return cb;
+}
+
+void
+del_dclusterbasis(pdclusterbasis cb)
+{
+  uint      i;
+
+  if (cb->sons > 0) {
+    for (i = 0; i < cb->sons * cb->directions; i++) {
+      uninit_amatrix(cb->E + i);
+    }
+    freemem(cb->E);
+    freemem(cb->dirson);
+
+    for (i = 0; i < cb->sons; i++) {
+      if (cb->son[i]) {
+	del_dclusterbasis(cb->son[i]);
+      }
+    }
+    freemem(cb->son);
+  }
+  else {
+    for (i = 0; i < cb->directions; i++) {
+      uninit_amatrix(cb->V + i);
+    }
+    freemem(cb->V);
+  }
+
+  freemem(cb->dir);
+  freemem(cb);
+}
+
+/* ------------------------------------------------------------
+ * Low-level management
+ * ------------------------------------------------------------ */
+
+void
+update_dclusterbasis(pdclusterbasis cb)
+{
+  uint      stree;
+  uint      i;
+
+  stree = 0;
+
+  if (cb->sons == 0) {
+    stree += cb->t->size;
+  }
+  else {
+    for (i = 0; i < cb->sons; i++) {
+      if (cb->son[i]) {
+	stree += cb->son[i]->ktree;
+      }
+    }
+  }
+
+  cb->ktree = stree + cb->directions * cb->k;
+}
+
+void
+resize_dclusterbasis(pdclusterbasis cb, uint k)
+{
+  uint      i, iota;
+
+  if (cb->sons > 0) {
+    for (i = 0; i < cb->sons; i++) {
+      resize_dclusterbasis(cb->son[i], k);
+    }
+
+    for (iota = 0; iota < cb->directions; iota++) {
+      for (i = 0; i < cb->sons; i++) {
+	resize_amatrix(cb->E + i + iota * cb->sons, cb->son[i]->k, k);
+      }
+    }
+  }
+  else {
+    for (iota = 0; iota < cb->directions; iota++) {
+      resize_amatrix(cb->V + iota, cb->t->size, k);
+    }
+  }
+
+  cb->k = k;
+
+  update_dclusterbasis(cb);
+}
+
+/* ------------------------------------------------------------
+ * Build directional cluster basis based on cluster
+ * ------------------------------------------------------------ */
+
+/* Normalized centers of an m x m subdivision of the six faces of the
+ * cube [-1,1]^3 */
+static void
+cubedirections(uint m, real(*dir)[3])
+{
+  real      h, a, b, norm;
+  uint      face, axis, i, j, n;
+
+  h = 2.0 / m;
+  n = 0;
+
+  for (face = 0; face < 6; face++) {
+    axis = face / 2;
+
+    for (j = 0; j < m; j++) {
+      b = -1.0 + (j + 0.5) * h;
+
+      for (i = 0; i < m; i++) {
+	a = -1.0 + (i + 0.5) * h;
+
+	dir[n][axis] = (face % 2 == 0 ? 1.0 : -1.0);
+	dir[n][(axis + 1) % 3] = a;
+	dir[n][(axis + 2) % 3] = b;
+
+	norm = REAL_NORM3(dir[n][0], dir[n][1], dir[n][2]);
+	dir[n][0] /= norm;
+	dir[n][1] /= norm;
+	dir[n][2] /= norm;
+
+	n++;
+      }
+    }
+  }
+}
+
+pdclusterbasis
+build_from_cluster_dclusterbasis(pccluster t, real kappa, real dirfac)
+{
+  pdclusterbasis cb, cb1;
+  uint      m, i, iota;
+
+  m = (uint) (dirfac * kappa * getdiam_2_cluster(t));
+
+  cb = new_dclusterbasis(t, (m > 0 ? 6 * m * m : 1));
+  if (m > 0) {
+    cubedirections(m, cb->dir);
+  }
+
+  if (cb->sons > 0) {
+    for (i = 0; i < cb->sons; i++) {
+      cb1 = build_from_cluster_dclusterbasis(t->son[i], kappa, dirfac);
+      cb->son[i] = cb1;
+
+      for (iota = 0; iota < cb->directions; iota++) {
+	cb->dirson[i + iota * cb->sons] =
+	  finddirection_dclusterbasis(cb1, cb->dir[iota]);
+      }
+    }
+  }
+
+  update_dclusterbasis(cb);
+
+  return cb;
+}
+
+uint
+finddirection_dclusterbasis(pcdclusterbasis cb, const real * d)
+{
+  real      best, prod;
+  uint      iota, ibest;
+
+  ibest = 0;
+  best = REAL_DOT3(cb->dir[0], d);
+
+  for (iota = 1; iota < cb->directions; iota++) {
+    prod = REAL_DOT3(cb->dir[iota], d);
+    if (prod > best) {
+      best = prod;
+      ibest = iota;
+    }
+  }
+
+  return ibest;
+}
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+size_t
+getsize_dclusterbasis(pcdclusterbasis cb)
+{
+  size_t    sz;
+  uint      i;
+
+  sz = (size_t) sizeof(dclusterbasis);
+  sz += (size_t) sizeof(real) * 3 * cb->directions;
+
+  if (cb->sons > 0) {
+    sz += (size_t) sizeof(pdclusterbasis) * cb->sons;
+    sz += (size_t) (sizeof(uint) + sizeof(amatrix))
+      * cb->sons * cb->directions;
+    for (i = 0; i < cb->sons * cb->directions; i++) {
+      sz += getsize_heap_amatrix(cb->E + i);
+    }
+    for (i = 0; i < cb->sons; i++) {
+      sz += getsize_dclusterbasis(cb->son[i]);
+    }
+  }
+  else {
+    sz += (size_t) sizeof(amatrix) * cb->directions;
+    for (i = 0; i < cb->directions; i++) {
+      sz += getsize_heap_amatrix(cb->V + i);
+    }
+  }
+
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ * Forward and backward transformation
+ * ------------------------------------------------------------ */
+
+pavector
+new_coeffs_dclusterbasis_avector(pcdclusterbasis cb)
+{
+  pavector  xt;
+
+  xt = new_avector(cb->ktree);
+
+  return xt;
+}
+
+void
+forward_dclusterbasis_avector(pcdclusterbasis cb, pcavector x, pavector xt)
+{
+  avector   loc1, loc2, loc3;
+  pavector  xt1, xc, xc1, xp;
+  uint      k = cb->k;
+  uint      i, iota, xtoff;
+
+  assert(xt->dim == cb->ktree);
+
+  if (cb->sons > 0) {
+    xtoff = cb->directions * k;
+    for (i = 0; i < cb->sons; i++) {
+      /* This part corresponds to the subtree rooted in the i-th son */
+      xt1 = init_sub_avector(&loc2, xt, cb->son[i]->ktree, xtoff);
+
+      /* Compute coefficients in the subtree */
+      forward_dclusterbasis_avector(cb->son[i], x, xt1);
+
+      uninit_avector(xt1);
+
+      xtoff += cb->son[i]->ktree;
+    }
+    assert(xtoff == cb->ktree);
+
+    /* Multiply by transfer matrices, every direction of the father
+     * collects the closest direction of each son */
+    for (iota = 0; iota < cb->directions; iota++) {
+      xc = init_sub_avector(&loc1, xt, k, iota * k);
+      clear_avector(xc);
+
+      xtoff = cb->directions * k;
+      for (i = 0; i < cb->sons; i++) {
+	xc1 = init_sub_avector(&loc3, xt, cb->son[i]->k,
+			       xtoff
+			       + cb->dirson[i + iota * cb->sons]
+			       * cb->son[i]->k);
+
+	mvm_amatrix_avector(1.0, true, cb->E + i + iota * cb->sons, xc1, xc);
+
+	uninit_avector(xc1);
+
+	xtoff += cb->son[i]->ktree;
+      }
+
+      uninit_avector(xc);
+    }
+  }
+  else {
+    /* Permuted entries of x */
+    xp = init_sub_avector(&loc2, xt, cb->t->size, cb->directions * k);
+
+    /* Find and copy entries */
+    for (i = 0; i < cb->t->size; i++)
+      xp->v[i] = x->v[cb->t->idx[i]];
+
+    /* Multiply by leaf matrices */
+    for (iota = 0; iota < cb->directions; iota++) {
+      xc = init_sub_avector(&loc1, xt, k, iota * k);
+      clear_avector(xc);
+
+      mvm_amatrix_avector(1.0, true, cb->V + iota, xp, xc);
+
+      uninit_avector(xc);
+    }
+
+    uninit_avector(xp);
+  }
+}
+
+void
+backward_dclusterbasis_avector(pcdclusterbasis cb, pavector yt, pavector y)
+{
+  avector   loc1, loc2, loc3;
+  pavector  yt1, yc, yc1, yp;
+  uint      k = cb->k;
+  uint      i, iota, ytoff;
+
+  assert(yt->dim == cb->ktree);
+
+  if (cb->sons > 0) {
+    /* Multiply by transfer matrices, every direction of the father
+     * contributes to the closest direction of each son */
+    for (iota = 0; iota < cb->directions; iota++) {
+      yc = init_sub_avector(&loc1, yt, k, iota * k);
+
+      ytoff = cb->directions * k;
+      for (i = 0; i < cb->sons; i++) {
+	yc1 = init_sub_avector(&loc3, yt, cb->son[i]->k,
+			       ytoff
+			       + cb->dirson[i + iota * cb->sons]
+			       * cb->son[i]->k);
+
+	mvm_amatrix_avector(1.0, false, cb->E + i + iota * cb->sons, yc, yc1);
+
+	uninit_avector(yc1);
+
+	ytoff += cb->son[i]->ktree;
+      }
+
+      uninit_avector(yc);
+    }
+
+    ytoff = cb->directions * k;
+    for (i = 0; i < cb->sons; i++) {
+      /* This part corresponds to the subtree rooted in the i-th son */
+      yt1 = init_sub_avector(&loc2, yt, cb->son[i]->ktree, ytoff);
+
+      /* Treat coefficients in the subtree */
+      backward_dclusterbasis_avector(cb->son[i], yt1, y);
+
+      uninit_avector(yt1);
+
+      ytoff += cb->son[i]->ktree;
+    }
+    assert(ytoff == cb->ktree);
+  }
+  else {
+    /* Permuted entries of y */
+    yp = init_sub_avector(&loc2, yt, cb->t->size, cb->directions * k);
+
+    /* Multiply by leaf matrices */
+    for (iota = 0; iota < cb->directions; iota++) {
+      yc = init_sub_avector(&loc1, yt, k, iota * k);
+
+      mvm_amatrix_avector(1.0, false, cb->V + iota, yc, yp);
+
+      uninit_avector(yc);
+    }
+
+    /* Find and copy entries */
+    for (i = 0; i < cb->t->size; i++)
+      y->v[cb->t->idx[i]] += yp->v[i];
+
+    uninit_avector(yp);
+  }
+}
@@ -0,0 +1,208 @@
+/* ------------------------------------------------------------
+ * This is the file "dclusterbasis.h" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+/** @file dclusterbasis.h
+ */
+
+#ifndef DCLUSTERBASIS_H
+#define DCLUSTERBASIS_H
+
+/** @defgroup dclusterbasis dclusterbasis
+ *  @brief Representation of directional cluster bases for
+ *  directional @f$\mathcal{H}^2@f$-matrices.
+ *
+ *  The @ref dclusterbasis class represents a directional cluster basis
+ *  @f$(V_{t,c})_{t\in{\mathcal T}_{\mathcal{I}},c\in D_t}@f$,
+ *  where @f$D_t@f$ is a set of unit directions depending on the
+ *  diameter of @f$t@f$ and the wavenumber. For non-leaf clusters the
+ *  basis is described by transfer matrices,
+ *  @f$V_{t,c} = \sum_{t'\in\operatorname{sons}(t)} V_{t',c'} E_{t',c}@f$,
+ *  where @f$c'\in D_{t'}@f$ is the son direction closest to @f$c@f$.
+ *
+ *  Low-frequency clusters use the single direction @f$c=0@f$, in this
+ *  case the basis is an ordinary cluster basis.
+ *
+ *  @{ */
+
+/** @brief Representation of a directional cluster basis. */
+typedef struct _dclusterbasis dclusterbasis;
+
+/** @brief Pointer to @ref dclusterbasis object. */
+typedef dclusterbasis *pdclusterbasis;
+
+/** @brief Pointer to constant @ref dclusterbasis object. */
+typedef const dclusterbasis *pcdclusterbasis;
+
+#include "cluster.h"
+#include "amatrix.h"
+#include "avector.h"
+
+/** @brief Representation of a directional cluster basis. */
+struct _dclusterbasis {
+  /** @brief Corresponding cluster. */
+  pccluster t;
+
+  /** @brief Rank, identical for all directions */
+  uint k;
+  /** @brief Number of coefficients in the entire subtree below <tt>t</tt>,
+   *  including the workspace for the permuted entries in leaves */
+  uint ktree;
+
+  /** @brief Number of directions, at least one */
+  uint directions;
+  /** @brief Unit directions, or the zero vector for a low-frequency
+   *  cluster with a single direction */
+  real (*dir)[3];
+
+  /** @brief Leaf matrices @f$V_{t,c}@f$, one per direction,
+   *  only used for leaf clusters */
+  pamatrix V;
+
+  /** @brief Number of sons, either <tt>t->sons</tt> or zero */
+  uint sons;
+  /** @brief Pointers to sons */
+  pdclusterbasis *son;
+
+  /** @brief Directions of the sons, <tt>dirson[i+iota*sons]</tt> is the
+   *  direction of the <tt>i</tt>-th son closest to direction
+   *  <tt>iota</tt> */
+  uint *dirson;
+  /** @brief Transfer matrices, <tt>E[i+iota*sons]</tt> maps the
+   *  coefficients of direction <tt>iota</tt> to the <tt>i</tt>-th son */
+  pamatrix E;
+};
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+/** @brief Create a new @ref dclusterbasis object.
+ *
+ *  Allocates storage for the object and sets up its components.
+ *  The directions are initialized to zero, the sons to null and
+ *  all matrices are empty.
+ *
+ *  @remark Should always be matched by a call to @ref del_dclusterbasis.
+ *
+ *  @param t Corresponding cluster.
+ *  @param directions Number of directions.
+ *  @returns Returns the newly created @ref dclusterbasis object. */
+HEADER_PREFIX pdclusterbasis
+new_dclusterbasis(pccluster t, uint directions);
+
+/** @brief Delete a @ref dclusterbasis object and all of its sons.
+ *
+ *  @param cb Object to be deleted. */
+HEADER_PREFIX void
+del_dclusterbasis(pdclusterbasis cb);
+
+/* ------------------------------------------------------------
+ * Low-level management
+ * ------------------------------------------------------------ */
+
+/** @brief Update the bookkeeping information of a @ref dclusterbasis,
+ *  i.e., <tt>ktree</tt>, after its sons have been changed.
+ *
+ *  @param cb Directional cluster basis that will be updated. */
+HEADER_PREFIX void
+update_dclusterbasis(pdclusterbasis cb);
+
+/** @brief Change the rank of a @ref dclusterbasis and all of its
+ *  descendants, resizing leaf and transfer matrices.
+ *
+ *  The coefficients of the matrices are not initialized.
+ *
+ *  @param cb Directional cluster basis that will be changed.
+ *  @param k New rank for all clusters and directions. */
+HEADER_PREFIX void
+resize_dclusterbasis(pdclusterbasis cb, uint k);
+
+/* ------------------------------------------------------------
+ * Build directional cluster basis based on cluster
+ * ------------------------------------------------------------ */
+
+/** @brief Construct a directional cluster basis with rank zero from
+ *  a @ref cluster tree.
+ *
+ *  A cluster @f$t@f$ with diameter @f$\operatorname{diam}_2(t)@f$ gets
+ *  the @f$6 m_t^2@f$ normalized centers of a regular @f$m_t\times m_t@f$
+ *  subdivision of the faces of the unit cube as directions, where
+ *  @f$m_t = \lfloor \delta \kappa \operatorname{diam}_2(t) \rfloor@f$.
+ *  If @f$m_t=0@f$, the single direction @f$c=0@f$ is used.
+ *  The directions of sons are connected to the closest direction of
+ *  their father.
+ *
+ *  @param t Root cluster.
+ *  @param kappa Wavenumber @f$\kappa@f$.
+ *  @param dirfac Resolution factor @f$\delta@f$ of the directions.
+ *  @returns Directional cluster basis of rank zero. */
+HEADER_PREFIX pdclusterbasis
+build_from_cluster_dclusterbasis(pccluster t, real kappa, real dirfac);
+
+/** @brief Find the direction of a @ref dclusterbasis closest to a given
+ *  vector.
+ *
+ *  @param cb Directional cluster basis.
+ *  @param d Vector, does not need to be normalized.
+ *  @returns Index of the direction maximizing the scalar product
+ *  with <tt>d</tt>. */
+HEADER_PREFIX uint
+finddirection_dclusterbasis(pcdclusterbasis cb, const real * d);
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the size of a @ref dclusterbasis, including all
+ *  descendants and matrices.
+ *
+ *  @param cb Directional cluster basis.
+ *  @returns Size of the object and its descendants in bytes. */
+HEADER_PREFIX size_t
+getsize_dclusterbasis(pcdclusterbasis cb);
+
+/* ------------------------------------------------------------
+ * Forward and backward transformation
+ * ------------------------------------------------------------ */
+
+/** @brief Create a coefficient vector for a @ref dclusterbasis.
+ *
+ *  The coefficients of direction <tt>iota</tt> of the root cluster are
+ *  stored at offset <tt>iota*cb->k</tt>, followed by the coefficient
+ *  vectors of the sons.
+ *
+ *  @param cb Directional cluster basis.
+ *  @returns Vector of dimension <tt>cb->ktree</tt>. */
+HEADER_PREFIX pavector
+new_coeffs_dclusterbasis_avector(pcdclusterbasis cb);
+
+/** @brief Forward transformation.
+ *
+ *  Compute @f$\widehat{x}_{t,c} = V_{t,c}^* x@f$ for all clusters and
+ *  all of their directions.
+ *
+ *  @param cb Directional cluster basis.
+ *  @param x Source vector.
+ *  @param xt Target vector of dimension <tt>cb->ktree</tt>, will be
+ *         filled with the coefficients. */
+HEADER_PREFIX void
+forward_dclusterbasis_avector(pcdclusterbasis cb, pcavector x,
+			      pavector xt);
+
+/** @brief Backward transformation.
+ *
+ *  Compute @f$y \gets y + \sum_{t,c} V_{t,c} \widehat{y}_{t,c}@f$.
+ *
+ *  @param cb Directional cluster basis.
+ *  @param yt Source vector of dimension <tt>cb->ktree</tt>, will be
+ *         overwritten by intermediate results.
+ *  @param y Target vector. */
+HEADER_PREFIX void
+backward_dclusterbasis_avector(pcdclusterbasis cb, pavector yt,
+			       pavector y);
+
+/** @} */
+
+#endif
@@ -0,0 +1,444 @@
+/* ------------------------------------------------------------
+ * This is the file "dh2matrix.c" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+#include "dh2matrix.h"
+
+#include "basic.h"
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+pduniform
+new_duniform(pdclusterbasis rb, uint rd, pdclusterbasis cb, uint cd)
+{
+  pduniform u;
+
+  assert(rd < rb->directions);
+  assert(cd < cb->directions);
+
+  u = (pduniform) allocmem(sizeof(duniform));
+
+  u->rb = rb;
+  u->rd = rd;
+  u->cb = cb;
+  u->cd = cd;
+
+  init_amatrix(&u->S, 0, 0);
+
+  return u;
+}
+
+void
+del_duniform(pduniform u)
+{
+  uninit_amatrix(&u->S);
+
+  freemem(u);
+}
+
+static    pdh2matrix
+new_dh2matrix(pdclusterbasis rb, pdclusterbasis cb)
+{
+  pdh2matrix G;
+
+  G = (pdh2matrix) allocmem(sizeof(dh2matrix));
+
+  G->rb = rb;
+  G->cb = cb;
+
+  G->u = NULL;
+  G->f = NULL;
+
+  G->son = NULL;
+  G->rsons = 0;
+  G->csons = 0;
+
+  G->desc = 0;
+
+  return G;
+}
+
+pdh2matrix
+new_uniform_dh2matrix(pdclusterbasis rb, uint rd, pdclusterbasis cb,
+		      uint cd)
+{
+  pdh2matrix G;
+
+  G = new_dh2matrix(rb, cb);
+
+  G->u = new_duniform(rb, rd, cb, cd);
+
+  G->desc = 1;
+
+  return G;
+}
+
+pdh2matrix
+new_full_dh2matrix(pdclusterbasis rb, pdclusterbasis cb)
+{
+  pdh2matrix G;
+
+  G = new_dh2matrix(rb, cb);
+
+  G->f = new_amatrix(rb->t->size, cb->t->size);
+
+  G->desc = 1;
+
+  return G;
+}
+
+pdh2matrix
+new_super_dh2matrix(pdclusterbasis rb, pdclusterbasis cb, uint rsons,
+		    uint csons)
+{
+  pdh2matrix G;
+  uint      i;
+
+  G = new_dh2matrix(rb, cb);
+
+  G->rsons = rsons;
+  G->csons = csons;
+
+  G->son = (pdh2matrix *) allocmem(sizeof(pdh2matrix) * rsons * csons);
+  for (i = 0; i < rsons * csons; i++)
+    G->son[i] = NULL;
+
+  return G;
+}
+
+void
+update_dh2matrix(pdh2matrix G)
+{
+  uint      desc;
+  uint      i;
+
+  desc = 1;
+
+  if (G->son) {
+    for (i = 0; i < G->rsons * G->csons; i++)
+      desc += G->son[i]->desc;
+  }
+
+  G->desc = desc;
+}
+
+void
+del_dh2matrix(pdh2matrix G)
+{
+  uint      i;
+
+  if (G->son) {
+    for (i = 0; i < G->rsons * G->csons; i++)
+      del_dh2matrix(G->son[i]);
+    freemem(G->son);
+  }
+
+  if (G->f)
+    del_amatrix(G->f);
+
+  if (G->u)
+    del_duniform(G->u);
+
+  freemem(G);
+}
+
+/* ------------------------------------------------------------
+ * Build directional H^2-matrix based on block tree
+ * ------------------------------------------------------------ */
+
+pdh2matrix
+build_from_block_dh2matrix(pcblock b, pdclusterbasis rb, pdclusterbasis cb)
+{
+  pdh2matrix G;
+  pcblock   b1;
+  pdclusterbasis rb1, cb1;
+  real      d[3];
+  uint      rsons, csons;
+  uint      i, j;
+
+  G = NULL;
+
+  if (b->son) {
+    rsons = b->rsons;
+    csons = b->csons;
+
+    G = new_super_dh2matrix(rb, cb, rsons, csons);
+
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++) {
+	b1 = b->son[i + j * rsons];
+
+	rb1 = rb;
+	if (b1->rc != b->rc) {
+	  assert(rb->sons == rsons);
+	  rb1 = rb->son[i];
+	}
+
+	cb1 = cb;
+	if (b1->cc != b->cc) {
+	  assert(cb->sons == csons);
+	  cb1 = cb->son[j];
+	}
+
+	G->son[i + j * rsons] = build_from_block_dh2matrix(b1, rb1, cb1);
+      }
+  }
+  else if (b->a > 0) {
+    /* Direction from the center of the column cluster to the center of
+     * the row cluster */
+    for (i = 0; i < 3; i++) {
+      d[i] = 0.5 * ((b->rc->bmin[i] + b->rc->bmax[i])
+		    - (b->cc->bmin[i] + b->cc->bmax[i]));
+    }
+
+    G = new_uniform_dh2matrix(rb, finddirection_dclusterbasis(rb, d),
+			      cb, finddirection_dclusterbasis(cb, d));
+  }
+  else
+    G = new_full_dh2matrix(rb, cb);
+
+  update_dh2matrix(G);
+
+  return G;
+}
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+size_t
+getsize_dh2matrix(pcdh2matrix G)
+{
+  size_t    sz;
+  uint      i;
+
+  sz = (size_t) sizeof(dh2matrix);
+
+  if (G->u)
+    sz += (size_t) sizeof(duniform) + getsize_heap_amatrix(&G->u->S);
+
+  if (G->f)
+    sz += getsize_amatrix(G->f);
+
+  if (G->son) {
+    sz += (size_t) sizeof(pdh2matrix) * G->rsons * G->csons;
+    for (i = 0; i < G->rsons * G->csons; i++)
+      sz += getsize_dh2matrix(G->son[i]);
+  }
+
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+void
+fastaddeval_dh2matrix_avector(field alpha, pcdh2matrix G, pavector xt,
+			      pavector yt)
+{
+  avector   loc1, loc2;
+  pavector  xp, yp, xt1, yt1;
+  pcdclusterbasis rb = G->rb;
+  pcdclusterbasis cb = G->cb;
+  uint      rsons = G->rsons;
+  uint      csons = G->csons;
+  uint      xtoff, ytoff;
+  uint      i, j;
+
+  if (G->u) {
+    xp = init_sub_avector(&loc1, xt, cb->k, G->u->cd * cb->k);
+    yp = init_sub_avector(&loc2, yt, rb->k, G->u->rd * rb->k);
+
+    addeval_amatrix_avector(alpha, &G->u->S, xp, yp);
+
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
+  else if (G->f) {
+    xp = init_sub_avector(&loc1, xt, cb->t->size, cb->directions * cb->k);
+    yp = init_sub_avector(&loc2, yt, rb->t->size, rb->directions * rb->k);
+
+    addeval_amatrix_avector(alpha, G->f, xp, yp);
+
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
+  else if (G->son) {
+    xtoff = cb->directions * cb->k;
+    for (j = 0; j < csons; j++) {
+      assert(csons == 1 || cb->sons > 0);
+      xt1 = (cb->sons > 0 ?
+	     init_sub_avector(&loc1, xt, cb->son[j]->ktree, xtoff) :
+	     init_sub_avector(&loc1, xt, cb->ktree, 0));
+
+      ytoff = rb->directions * rb->k;
+      for (i = 0; i < rsons; i++) {
+	assert(rsons == 1 || rb->sons > 0);
+	yt1 = (rb->sons > 0 ?
+	       init_sub_avector(&loc2, yt, rb->son[i]->ktree, ytoff) :
+	       init_sub_avector(&loc2, yt, rb->ktree, 0));
+
+	fastaddeval_dh2matrix_avector(alpha, G->son[i + j * rsons], xt1,
+				      yt1);
+
+	uninit_avector(yt1);
+
+	ytoff += (rb->sons > 0 ? rb->son[i]->ktree : rb->t->size);
+      }
+      assert(ytoff == rb->ktree);
+
+      uninit_avector(xt1);
+
+      xtoff += (cb->sons > 0 ? cb->son[j]->ktree : cb->t->size);
+    }
+    assert(xtoff == cb->ktree);
+  }
+}
+
+void
+addeval_dh2matrix_avector(field alpha, pcdh2matrix G, pcavector x,
+			  pavector y)
+{
+  pavector  xt, yt;
+
+  xt = new_coeffs_dclusterbasis_avector(G->cb);
+  yt = new_coeffs_dclusterbasis_avector(G->rb);
+
+  clear_avector(yt);
+
+  forward_dclusterbasis_avector(G->cb, x, xt);
+
+  fastaddeval_dh2matrix_avector(alpha, G, xt, yt);
+
+  backward_dclusterbasis_avector(G->rb, yt, y);
+
+  del_avector(yt);
+  del_avector(xt);
+}
+
+void
+fastaddevaltrans_dh2matrix_avector(field alpha, pcdh2matrix G, pavector xt,
+				   pavector yt)
+{
+  avector   loc1, loc2;
+  pavector  xp, yp, xt1, yt1;
+  pcdclusterbasis rb = G->rb;
+  pcdclusterbasis cb = G->cb;
+  uint      rsons = G->rsons;
+  uint      csons = G->csons;
+  uint      xtoff, ytoff;
+  uint      i, j;
+
+  if (G->u) {
+    xp = init_sub_avector(&loc1, xt, rb->k, G->u->rd * rb->k);
+    yp = init_sub_avector(&loc2, yt, cb->k, G->u->cd * cb->k);
+
+    addevaltrans_amatrix_avector(alpha, &G->u->S, xp, yp);
+
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
+  else if (G->f) {
+    xp = init_sub_avector(&loc1, xt, rb->t->size, rb->directions * rb->k);
+    yp = init_sub_avector(&loc2, yt, cb->t->size, cb->directions * cb->k);
+
+    addevaltrans_amatrix_avector(alpha, G->f, xp, yp);
+
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
+  else if (G->son) {
+    ytoff = cb->directions * cb->k;
+    for (j = 0; j < csons; j++) {
+      yt1 = (cb->sons > 0 ?
+	     init_sub_avector(&loc2, yt, cb->son[j]->ktree, ytoff) :
+	     init_sub_avector(&loc2, yt, cb->ktree, 0));
+
+      xtoff = rb->directions * rb->k;
+      for (i = 0; i < rsons; i++) {
+	xt1 = (rb->sons > 0 ?
+	       init_sub_avector(&loc1, xt, rb->son[i]->ktree, xtoff) :
+	       init_sub_avector(&loc1, xt, rb->ktree, 0));
+
+	fastaddevaltrans_dh2matrix_avector(alpha, G->son[i + j * rsons], xt1,
+					   yt1);
+
+	uninit_avector(xt1);
+
+	xtoff += (rb->sons > 0 ? rb->son[i]->ktree : rb->t->size);
+      }
+      assert(xtoff == rb->ktree);
+
+      uninit_avector(yt1);
+
+      ytoff += (cb->sons > 0 ? cb->son[j]->ktree : cb->t->size);
+    }
+    assert(ytoff == cb->ktree);
+  }
+}
+
+void
+addevaltrans_dh2matrix_avector(field alpha, pcdh2matrix G, pcavector x,
+			       pavector y)
+{
+  pavector  xt, yt;
+
+  xt = new_coeffs_dclusterbasis_avector(G->rb);
+  yt = new_coeffs_dclusterbasis_avector(G->cb);
+
+  clear_avector(yt);
+
+  forward_dclusterbasis_avector(G->rb, x, xt);
+
+  fastaddevaltrans_dh2matrix_avector(alpha, G, xt, yt);
+
+  backward_dclusterbasis_avector(G->cb, yt, y);
+
+  del_avector(yt);
+  del_avector(xt);
+}
+
+real
+norm2diff_amatrix_dh2matrix(pcdh2matrix a, pcamatrix b)
+{
+  pavector  x, y;
+  avector   tmp1, tmp2;
+  uint      rows, cols;
+  uint      i;
+  real      norm;
+
+  rows = a->rb->t->size;
+  cols = a->cb->t->size;
+
+  assert(b->rows == rows);
+  assert(b->cols == cols);
+
+  x = init_avector(&tmp1, cols);
+  y = init_avector(&tmp2, rows);
+
+  random_avector(x);
+  norm = norm2_avector(x);
+
+  for (i = 0; i < NORM_STEPS && norm > 0.0; i++) {
+    scale_avector(1.0 / norm, x);
+
+    clear_avector(y);
+    addeval_dh2matrix_avector(1.0, a, x, y);
+    addeval_amatrix_avector(-1.0, b, x, y);
+
+    clear_avector(x);
+    addevaltrans_dh2matrix_avector(1.0, a, y, x);
+    addevaltrans_amatrix_avector(-1.0, b, y, x);
+
+    norm = norm2_avector(x);
+  }
+
+  uninit_avector(y);
+  uninit_avector(x);
+
+  return REAL_SQRT(norm);
+}
@@ -0,0 +1,267 @@
+/* ------------------------------------------------------------
+ * This is the file "dh2matrix.h" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+/** @file dh2matrix.h
+ */
+
+#ifndef DH2MATRIX_H
+#define DH2MATRIX_H
+
+/** @defgroup dh2matrix dh2matrix
+ *  @brief Representation of a directional @f$\mathcal{H}^2@f$-matrix.
+ *
+ *  The @ref dh2matrix class is used to represent directional
+ *  @f$\mathcal{H}^2@f$-matrices for high-frequency Helmholtz problems.
+ *  An admissible block @f$(t,s)@f$ is approximated by
+ *  @f$V_{t,c_t} S_{ts} W_{s,c_s}^*@f$, where @f$c_t@f$ and @f$c_s@f$ are
+ *  the directions of the @ref dclusterbasis objects closest to the
+ *  direction from the center of @f$s@f$ to the center of @f$t@f$.
+ *  @{ */
+
+/** @brief Representation of a directional @f$\mathcal{H}^2@f$-matrix. */
+typedef struct _dh2matrix dh2matrix;
+
+/** @brief Pointer to @ref dh2matrix object. */
+typedef dh2matrix *pdh2matrix;
+
+/** @brief Pointer to constant @ref dh2matrix object. */
+typedef const dh2matrix *pcdh2matrix;
+
+/** @brief Representation of an admissible block of a @ref dh2matrix. */
+typedef struct _duniform duniform;
+
+/** @brief Pointer to @ref duniform object. */
+typedef duniform *pduniform;
+
+/** @brief Pointer to constant @ref duniform object. */
+typedef const duniform *pcduniform;
+
+#include "amatrix.h"
+#include "block.h"
+#include "dclusterbasis.h"
+#include "settings.h"
+
+/** @brief Representation of an admissible block
+ *  @f$V_{t,c_t} S W_{s,c_s}^*@f$ of a @ref dh2matrix. */
+struct _duniform {
+  /** @brief Row directional cluster basis */
+  pdclusterbasis rb;
+  /** @brief Direction of the row cluster basis */
+  uint rd;
+  /** @brief Column directional cluster basis */
+  pdclusterbasis cb;
+  /** @brief Direction of the column cluster basis */
+  uint cd;
+  /** @brief Coupling matrix */
+  amatrix S;
+};
+
+/** @brief Representation of directional @f$\mathcal{H}^2@f$-matrices.
+ *
+ *  Directional @f$\mathcal{H}^2@f$-matrices are represented recursively:
+ *  a @ref dh2matrix object can be either an @ref amatrix,
+ *  a @ref duniform matrix or divided into submatrices represented
+ *  again by @ref dh2matrix objects. */
+struct _dh2matrix {
+  /** @brief Row directional cluster basis. */
+  pdclusterbasis rb;
+  /** @brief Column directional cluster basis. */
+  pdclusterbasis cb;
+
+  /** @brief Directional uniform matrix, for admissible leaves. */
+  pduniform u;
+
+  /** @brief Standard matrix, for inadmissible leaves. */
+  pamatrix f;
+
+  /** @brief Submatrices. */
+  pdh2matrix *son;
+  /** @brief Number of block rows. */
+  uint rsons;
+  /** @brief Number of block columns. */
+  uint csons;
+
+  /** @brief Number of descendants in matrix tree. */
+  uint desc;
+};
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+/** @brief Create a new @ref duniform object with an empty coupling
+ *  matrix.
+ *
+ *  @param rb Row directional cluster basis.
+ *  @param rd Direction of the row cluster basis.
+ *  @param cb Column directional cluster basis.
+ *  @param cd Direction of the column cluster basis.
+ *  @returns New @ref duniform object. */
+HEADER_PREFIX pduniform
+new_duniform(pdclusterbasis rb, uint rd, pdclusterbasis cb, uint cd);
+
+/** @brief Delete a @ref duniform object.
+ *
+ *  @param u Object to be deleted. */
+HEADER_PREFIX void
+del_duniform(pduniform u);
+
+/** @brief Create a new @ref dh2matrix object representing an
+ *  admissible leaf.
+ *
+ *  @param rb Row directional cluster basis.
+ *  @param rd Direction of the row cluster basis.
+ *  @param cb Column directional cluster basis.
+ *  @param cd Direction of the column cluster basis.
+ *  @returns New @ref dh2matrix object. */
+HEADER_PREFIX pdh2matrix
+new_uniform_dh2matrix(pdclusterbasis rb, uint rd, pdclusterbasis cb,
+		      uint cd);
+
+/** @brief Create a new @ref dh2matrix object representing an
+ *  inadmissible leaf.
+ *
+ *  @param rb Row directional cluster basis.
+ *  @param cb Column directional cluster basis.
+ *  @returns New @ref dh2matrix object. */
+HEADER_PREFIX pdh2matrix
+new_full_dh2matrix(pdclusterbasis rb, pdclusterbasis cb);
+
+/** @brief Create a new @ref dh2matrix object representing a
+ *  subdivided matrix.
+ *
+ *  The submatrices are initialized to null and have to be set by the
+ *  caller, followed by a call to @ref update_dh2matrix.
+ *
+ *  @param rb Row directional cluster basis.
+ *  @param cb Column directional cluster basis.
+ *  @param rsons Number of block rows.
+ *  @param csons Number of block columns.
+ *  @returns New @ref dh2matrix object. */
+HEADER_PREFIX pdh2matrix
+new_super_dh2matrix(pdclusterbasis rb, pdclusterbasis cb, uint rsons,
+		    uint csons);
+
+/** @brief Update the bookkeeping information of a @ref dh2matrix,
+ *  i.e., <tt>desc</tt>, after its submatrices have been set.
+ *
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix. */
+HEADER_PREFIX void
+update_dh2matrix(pdh2matrix G);
+
+/** @brief Delete a @ref dh2matrix object and all of its submatrices.
+ *
+ *  The cluster bases are not deleted.
+ *
+ *  @param G Object to be deleted. */
+HEADER_PREFIX void
+del_dh2matrix(pdh2matrix G);
+
+/* ------------------------------------------------------------
+ * Build directional H^2-matrix based on block tree
+ * ------------------------------------------------------------ */
+
+/** @brief Build a @ref dh2matrix object from a @ref block tree using
+ *  given directional cluster bases.
+ *
+ *  For every admissible leaf @f$(t,s)@f$ the directions of
+ *  <tt>rb</tt> and <tt>cb</tt> closest to the vector connecting the
+ *  centers of the bounding boxes are chosen, see
+ *  @ref finddirection_dclusterbasis.
+ *
+ *  @remark Submatrices for far- and nearfield leaves are created,
+ *  but their coefficients are not initialized.
+ *
+ *  @param b Block tree, usually built with
+ *         @ref admissible_parabolic_cluster.
+ *  @param rb Row directional cluster basis.
+ *  @param cb Column directional cluster basis.
+ *  @returns New @ref dh2matrix object. */
+HEADER_PREFIX pdh2matrix
+build_from_block_dh2matrix(pcblock b, pdclusterbasis rb, pdclusterbasis cb);
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the size of a @ref dh2matrix object without the
+ *  cluster bases.
+ *
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix.
+ *  @returns Size of the matrix tree and its leaves in bytes. */
+HEADER_PREFIX size_t
+getsize_dh2matrix(pcdh2matrix G);
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+/** @brief Fast matrix-vector multiplication in the coefficient
+ *  representation.
+ *
+ *  Compute @f$\widehat{y} \gets \widehat{y} + \alpha S \widehat{x}@f$
+ *  for all blocks, with the coefficients of the directions of every
+ *  @ref duniform matrix.
+ *
+ *  @param alpha Scaling factor.
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix.
+ *  @param xt Coefficients of the source vector computed by
+ *         @ref forward_dclusterbasis_avector for <tt>G->cb</tt>.
+ *  @param yt Coefficients of the target vector for <tt>G->rb</tt>. */
+HEADER_PREFIX void
+fastaddeval_dh2matrix_avector(field alpha, pcdh2matrix G, pavector xt,
+			      pavector yt);
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha G x@f$.
+ *
+ *  @param alpha Scaling factor.
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix.
+ *  @param x Source vector.
+ *  @param y Target vector. */
+HEADER_PREFIX void
+addeval_dh2matrix_avector(field alpha, pcdh2matrix G, pcavector x,
+			  pavector y);
+
+/** @brief Fast adjoint matrix-vector multiplication in the coefficient
+ *  representation.
+ *
+ *  @param alpha Scaling factor.
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix.
+ *  @param xt Coefficients of the source vector computed by
+ *         @ref forward_dclusterbasis_avector for <tt>G->rb</tt>.
+ *  @param yt Coefficients of the target vector for <tt>G->cb</tt>. */
+HEADER_PREFIX void
+fastaddevaltrans_dh2matrix_avector(field alpha, pcdh2matrix G, pavector xt,
+				   pavector yt);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha G^* x@f$.
+ *
+ *  @param alpha Scaling factor.
+ *  @param G Directional @f$\mathcal{H}^2@f$-matrix.
+ *  @param x Source vector.
+ *  @param y Target vector. */
+HEADER_PREFIX void
+addevaltrans_dh2matrix_avector(field alpha, pcdh2matrix G, pcavector x,
+			       pavector y);
+
+/** @brief Approximate the spectral norm @f$\|A-B\|_2@f$ of the difference
+ *  of a directional @f$\mathcal{H}^2@f$-matrix @f$A@f$ and a matrix
+ *  @f$B@f$.
+ *
+ *  The spectral norm is approximated by applying a few steps of the power
+ *  iteration to the matrix @f$(A-B)^* (A-B)@f$ and computing the square root
+ *  of the resulting eigenvalue approximation.
+ *
+ *  @param a Matrix @f$A@f$.
+ *  @param b Matrix @f$B@f$.
+ *  @returns Approximation of @f$\|A-B\|_2@f$. */
+HEADER_PREFIX real
+norm2diff_amatrix_dh2matrix(pcdh2matrix a, pcamatrix b);
+
+/** @} */
+
+#endif
@@ -0,0 +1,586 @@
+/* ------------------------------------------------------------
+ * This is the file "flath2matrix.c" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flath2matrix.h"
+#include "basic.h"
+
+/* Alignment of the coefficient buffer and of every matrix in bytes */
+#define ALIGN_FLATH2MATRIX 64
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+static uint
+countnodes(pcclusterbasis cb)
+{
+  uint      nodes;
+  uint      i;
+
+  nodes = 1;
+  for (i = 0; i < cb->sons; i++)
+    nodes += countnodes(cb->son[i]);
+
+  return nodes;
+}
+
+/* Enumerate the nodes in post-order, the coefficient offsets are
+ * assigned later */
+static uint
+collectnodes(pcclusterbasis cb, pccluster root, pflatbasis fb,
+	     pcclusterbasis * src, uint * nodes, uint * sons, uint * koff)
+{
+  pflatnode n;
+  uint      son, i, j;
+
+  son = *sons;
+  (*sons) += cb->sons;
+
+  for (i = 0; i < cb->sons; i++)
+    fb->son[son + i] = collectnodes(cb->son[i], root, fb, src, nodes, sons,
+				    koff);
+
+  j = *nodes;
+  (*nodes)++;
+
+  n = fb->node + j;
+  n->roff = cb->t->idx - root->idx;
+  n->size = cb->t->size;
+  n->k = cb->k;
+  n->koff = *koff;
+  n->father = j;
+  n->sons = cb->sons;
+  n->son = son;
+  n->voff = 0;
+  n->eoff = 0;
+  (*koff) += cb->k;
+
+  for (i = 0; i < cb->sons; i++)
+    fb->node[fb->son[son + i]].father = j;
+
+  src[j] = cb;
+
+  return j;
+}
+
+static pflatbasis
+build_flatbasis(pcclusterbasis cb, pcclusterbasis * src)
+{
+  pflatbasis fb;
+  uint      nodes, sons, koff;
+
+  fb = (pflatbasis) allocmem(sizeof(flatbasis));
+
+  fb->nodes = countnodes(cb);
+  fb->node = (pflatnode) allocmem(sizeof(flatnode) * fb->nodes);
+  fb->son = allocuint(fb->nodes);
+
+  nodes = sons = koff = 0;
+  (void) collectnodes(cb, cb->t, fb, src, &nodes, &sons, &koff);
+  assert(nodes == fb->nodes);
+  fb->ktree = koff;
+
+  return fb;
+}
+
+static void
+del_flatbasis(pflatbasis fb)
+{
+  freemem(fb->son);
+  freemem(fb->node);
+  freemem(fb);
+}
+
+static uint
+countblocks(pch2matrix h2, bool admissible)
+{
+  uint      blocks;
+  uint      i;
+
+  if (h2->son == NULL)
+    return ((h2->u != NULL) == admissible ? 1 : 0);
+
+  blocks = 0;
+  for (i = 0; i < h2->rsons * h2->csons; i++)
+    blocks += countblocks(h2->son[i], admissible);
+
+  return blocks;
+}
+
+static void
+collectblocks(pch2matrix h2, pcflath2matrix fh, uint rn, uint cn,
+	      uint * couplings, uint * nears)
+{
+  pflatblock b;
+  uint      rn1, cn1, i, j;
+
+  if (h2->son == NULL) {
+    if (h2->u) {
+      /* Lossy compressed coupling matrices have to be restored first */
+      assert(h2->u->CS == NULL);
+      b = fh->coupling + (*couplings);
+      (*couplings)++;
+    }
+    else {
+      assert(h2->f != NULL || h2->fill != NULL);
+      b = fh->near + (*nears);
+      (*nears)++;
+    }
+
+    b->rn = rn;
+    b->cn = cn;
+    b->off = 0;
+    b->h2 = h2;
+  }
+  else {
+    for (j = 0; j < h2->csons; j++) {
+      /* The column basis is only refined if the matrix is */
+      cn1 = (h2->son[j * h2->rsons]->cb == h2->cb ? cn :
+	     fh->cb->son[fh->cb->node[cn].son + j]);
+
+      for (i = 0; i < h2->rsons; i++) {
+	rn1 = (h2->son[i]->rb == h2->rb ? rn :
+	       fh->rb->son[fh->rb->node[rn].son + i]);
+
+	collectblocks(h2->son[i + j * h2->rsons], fh, rn1, cn1, couplings,
+		      nears);
+      }
+    }
+  }
+}
+
+static int
+compare_flatblock(const void *a, const void *b)
+{
+  pcflatblock ba = (pcflatblock) a;
+  pcflatblock bb = (pcflatblock) b;
+
+  if (ba->rn != bb->rn)
+    return (ba->rn < bb->rn ? -1 : 1);
+  if (ba->cn != bb->cn)
+    return (ba->cn < bb->cn ? -1 : 1);
+  return 0;
+}
+
+/* Copy a matrix into the buffer with leading dimension equal to the
+ * number of rows */
+static void
+store_flat(pcflath2matrix fh, pcamatrix a, size_t off)
+{
+  uint      j;
+
+  if (fh->single)
+    convert_amatrix_single(a, fh->scoeff + off);
+  else
+    for (j = 0; j < a->cols; j++)
+      memcpy(fh->coeff + off + (size_t) j * a->rows, a->a + (size_t) j * a->ld,
+	     sizeof(field) * a->rows);
+}
+
+/* Reserve an aligned part of the buffer for a matrix */
+static size_t
+reserve_flat(size_t * off, size_t sz, size_t pad)
+{
+  size_t    start;
+
+  start = *off;
+  (*off) += (sz + pad - 1) / pad * pad;
+
+  return start;
+}
+
+static pflath2matrix
+build_flath2matrix(pch2matrix h2, bool single)
+{
+  pflath2matrix fh;
+  pflatnode n;
+  pflatbasis fb;
+  pflatblock b;
+  pcclusterbasis *rsrc, *csrc, *src;
+  size_t    pad, off;
+  size_t    esize = (single ? sizeof(sfield) : sizeof(field));
+  uint      couplings, nears, i, l;
+
+  fh = (pflath2matrix) allocmem(sizeof(flath2matrix));
+
+  fh->rc = h2->rb->t;
+  fh->cc = h2->cb->t;
+  fh->single = single;
+
+  /* Set up cluster bases, shared if the original matrix uses the same
+   * basis for rows and columns */
+  rsrc = (pcclusterbasis *) allocmem(sizeof(pcclusterbasis)
+				     * countnodes(h2->rb));
+  fh->rb = build_flatbasis(h2->rb, rsrc);
+  if (h2->cb == h2->rb) {
+    csrc = NULL;
+    fh->cb = fh->rb;
+  }
+  else {
+    csrc = (pcclusterbasis *) allocmem(sizeof(pcclusterbasis)
+				       * countnodes(h2->cb));
+    fh->cb = build_flatbasis(h2->cb, csrc);
+  }
+
+  /* Set up block descriptors sorted by rows */
+  fh->couplings = countblocks(h2, true);
+  fh->coupling = (pflatblock) allocmem(sizeof(flatblock) * fh->couplings);
+  fh->nears = countblocks(h2, false);
+  fh->near = (pflatblock) allocmem(sizeof(flatblock) * fh->nears);
+
+  couplings = nears = 0;
+  collectblocks(h2, fh, fh->rb->nodes - 1, fh->cb->nodes - 1, &couplings,
+		&nears);
+  assert(couplings == fh->couplings);
+  assert(nears == fh->nears);
+
+  qsort(fh->coupling, fh->couplings, sizeof(flatblock), compare_flatblock);
+  qsort(fh->near, fh->nears, sizeof(flatblock), compare_flatblock);
+
+  /* Assign aligned offsets in the common buffer */
+  pad = ALIGN_FLATH2MATRIX / esize;
+  if (pad == 0)
+    pad = 1;
+
+  off = 0;
+  for (l = 0; l < 2; l++) {
+    fb = (l == 0 ? fh->rb : fh->cb);
+    if (l == 1 && fb == fh->rb)
+      break;
+
+    for (i = 0; i < fb->nodes; i++) {
+      n = fb->node + i;
+      if (n->sons == 0)
+	n->voff = reserve_flat(&off, (size_t) n->size * n->k, pad);
+      if (i + 1 < fb->nodes)
+	n->eoff = reserve_flat(&off, (size_t) n->k * fb->node[n->father].k,
+			       pad);
+    }
+  }
+  for (i = 0; i < fh->couplings; i++) {
+    b = fh->coupling + i;
+    b->off = reserve_flat(&off, (size_t) fh->rb->node[b->rn].k
+			  * fh->cb->node[b->cn].k, pad);
+  }
+  for (i = 0; i < fh->nears; i++) {
+    b = fh->near + i;
+    if (b->h2->f)
+      b->off = reserve_flat(&off, (size_t) fh->rb->node[b->rn].size
+			    * fh->cb->node[b->cn].size, pad);
+  }
+  fh->ncoeff = off;
+
+  fh->mem = allocmem(esize * fh->ncoeff + ALIGN_FLATH2MATRIX);
+  fh->coeff = NULL;
+  fh->scoeff = NULL;
+  if (single)
+    fh->scoeff = (psfield) (((size_t) fh->mem + ALIGN_FLATH2MATRIX - 1)
+			    / ALIGN_FLATH2MATRIX * ALIGN_FLATH2MATRIX);
+  else
+    fh->coeff = (pfield) (((size_t) fh->mem + ALIGN_FLATH2MATRIX - 1)
+			  / ALIGN_FLATH2MATRIX * ALIGN_FLATH2MATRIX);
+
+  /* Copy coefficients */
+  for (l = 0; l < 2; l++) {
+    fb = (l == 0 ? fh->rb : fh->cb);
+    src = (l == 0 ? rsrc : csrc);
+    if (l == 1 && fb == fh->rb)
+      break;
+
+    for (i = 0; i < fb->nodes; i++) {
+      n = fb->node + i;
+      if (n->sons == 0)
+	store_flat(fh, &src[i]->V, n->voff);
+      if (i + 1 < fb->nodes)
+	store_flat(fh, &src[i]->E, n->eoff);
+    }
+  }
+  for (i = 0; i < fh->couplings; i++) {
+    b = fh->coupling + i;
+    store_flat(fh, &b->h2->u->S, b->off);
+  }
+  for (i = 0; i < fh->nears; i++) {
+    b = fh->near + i;
+    if (b->h2->f)
+      store_flat(fh, b->h2->f, b->off);
+  }
+
+  if (csrc)
+    freemem(csrc);
+  freemem(rsrc);
+
+  return fh;
+}
+
+pflath2matrix
+build_from_h2matrix_flath2matrix(pch2matrix h2)
+{
+  return build_flath2matrix(h2, false);
+}
+
+pflath2matrix
+build_from_h2matrix_single_flath2matrix(pch2matrix h2)
+{
+  return build_flath2matrix(h2, true);
+}
+
+void
+del_flath2matrix(pflath2matrix fh)
+{
+  freemem(fh->mem);
+  freemem(fh->near);
+  freemem(fh->coupling);
+  if (fh->cb != fh->rb)
+    del_flatbasis(fh->cb);
+  del_flatbasis(fh->rb);
+  freemem(fh);
+}
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+size_t
+getsize_flath2matrix(pcflath2matrix fh)
+{
+  size_t    sz;
+
+  sz = (size_t) sizeof(flath2matrix);
+  sz += (size_t) sizeof(flatbasis)
+    + (sizeof(flatnode) + sizeof(uint)) * fh->rb->nodes;
+  if (fh->cb != fh->rb)
+    sz += (size_t) sizeof(flatbasis)
+      + (sizeof(flatnode) + sizeof(uint)) * fh->cb->nodes;
+  sz += (size_t) sizeof(flatblock) * (fh->couplings + fh->nears);
+  sz += (fh->single ? sizeof(sfield) : sizeof(field)) * fh->ncoeff
+    + ALIGN_FLATH2MATRIX;
+
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+/* y += alpha A x or y += alpha A^* x for a matrix in the buffer */
+static void
+addeval_flat(field alpha, bool trans, pcflath2matrix fh, uint rows,
+	     uint cols, size_t off, pfield x, pfield y)
+{
+  avector   tmp1, tmp2;
+  amatrix   tmp3;
+  pavector  x1, y1;
+  pamatrix  N;
+
+  x1 = init_pointer_avector(&tmp1, x, (trans ? rows : cols));
+  y1 = init_pointer_avector(&tmp2, y, (trans ? cols : rows));
+
+  if (fh->single) {
+    if (trans)
+      addevaltrans_single_avector(alpha, rows, cols, fh->scoeff + off, x1,
+				  y1);
+    else
+      addeval_single_avector(alpha, rows, cols, fh->scoeff + off, x1, y1);
+  }
+  else {
+    N = init_pointer_amatrix(&tmp3, fh->coeff + off, rows, cols);
+    mvm_amatrix_avector(alpha, trans, N, x1, y1);
+    uninit_amatrix(N);
+  }
+
+  uninit_avector(y1);
+  uninit_avector(x1);
+}
+
+/* Forward transformation, sons precede their fathers */
+static void
+forward_flatbasis(pcflath2matrix fh, pcflatbasis fb, pcfield xp, pfield xt)
+{
+  pcflatnode n, f;
+  uint      i;
+
+  for (i = 0; i < fb->ktree; i++)
+    xt[i] = 0.0;
+
+  for (i = 0; i < fb->nodes; i++) {
+    n = fb->node + i;
+
+    if (n->sons == 0)
+      addeval_flat(1.0, true, fh, n->size, n->k, n->voff,
+		   (pfield) xp + n->roff, xt + n->koff);
+
+    if (i + 1 < fb->nodes) {
+      f = fb->node + n->father;
+      addeval_flat(1.0, true, fh, n->k, f->k, n->eoff, xt + n->koff,
+		   xt + f->koff);
+    }
+  }
+}
+
+/* Backward transformation, fathers precede their sons */
+static void
+backward_flatbasis(pcflath2matrix fh, pcflatbasis fb, pfield yt, pfield yp)
+{
+  pcflatnode n, f;
+  uint      i;
+
+  i = fb->nodes;
+  while (i-- > 0) {
+    n = fb->node + i;
+
+    if (i + 1 < fb->nodes) {
+      f = fb->node + n->father;
+      addeval_flat(1.0, false, fh, n->k, f->k, n->eoff, yt + f->koff,
+		   yt + n->koff);
+    }
+
+    if (n->sons == 0)
+      addeval_flat(1.0, false, fh, n->size, n->k, n->voff, yt + n->koff,
+		   yp + n->roff);
+  }
+}
+
+/* Nearfield leaf, y += alpha A x or y += alpha A^* x */
+static void
+addeval_near(field alpha, bool trans, pcflath2matrix fh, pcflatblock b,
+	     pfield xp, pfield yp)
+{
+  avector   tmp1, tmp2;
+  amatrix   tmp3;
+  pavector  x1, y1;
+  pamatrix  N;
+  pcflatnode rn = fh->rb->node + b->rn;
+  pcflatnode cn = fh->cb->node + b->cn;
+
+  if (b->h2->f) {
+    if (trans)
+      addeval_flat(alpha, true, fh, rn->size, cn->size, b->off,
+		   xp + rn->roff, yp + cn->roff);
+    else
+      addeval_flat(alpha, false, fh, rn->size, cn->size, b->off,
+		   xp + cn->roff, yp + rn->roff);
+  }
+  else {
+    x1 = (trans ?
+	  init_pointer_avector(&tmp1, xp + rn->roff, rn->size) :
+	  init_pointer_avector(&tmp1, xp + cn->roff, cn->size));
+    y1 = (trans ?
+	  init_pointer_avector(&tmp2, yp + cn->roff, cn->size) :
+	  init_pointer_avector(&tmp2, yp + rn->roff, rn->size));
+
+    N = init_amatrix(&tmp3, rn->size, cn->size);
+    b->h2->fill(b->h2->rb->t->idx, b->h2->cb->t->idx, b->h2->filldata, N);
+    mvm_amatrix_avector(alpha, trans, N, x1, y1);
+    uninit_amatrix(N);
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+}
+
+void
+addeval_flath2matrix_avector(field alpha, pcflath2matrix fh, pcavector x,
+			     pavector y)
+{
+  pcflatblock b;
+  pfield    xp, yp, xt, yt;
+  uint      i;
+
+  assert(x->dim == fh->cc->size);
+  assert(y->dim == fh->rc->size);
+
+  xp = allocfield(fh->cc->size);
+  yp = allocfield(fh->rc->size);
+  xt = allocfield(fh->cb->ktree);
+  yt = allocfield(fh->rb->ktree);
+
+  /* Permutation of x */
+  for (i = 0; i < fh->cc->size; i++)
+    xp[i] = x->v[fh->cc->idx[i]];
+
+  for (i = 0; i < fh->rc->size; i++)
+    yp[i] = 0.0;
+  for (i = 0; i < fh->rb->ktree; i++)
+    yt[i] = 0.0;
+
+  /* Farfield */
+  forward_flatbasis(fh, fh->cb, xp, xt);
+
+  for (i = 0; i < fh->couplings; i++) {
+    b = fh->coupling + i;
+    addeval_flat(alpha, false, fh, fh->rb->node[b->rn].k,
+		 fh->cb->node[b->cn].k, b->off, xt + fh->cb->node[b->cn].koff,
+		 yt + fh->rb->node[b->rn].koff);
+  }
+
+  backward_flatbasis(fh, fh->rb, yt, yp);
+
+  /* Nearfield */
+  for (i = 0; i < fh->nears; i++)
+    addeval_near(alpha, false, fh, fh->near + i, xp, yp);
+
+  /* Reverse permutation of y */
+  for (i = 0; i < fh->rc->size; i++)
+    y->v[fh->rc->idx[i]] += yp[i];
+
+  freemem(yt);
+  freemem(xt);
+  freemem(yp);
+  freemem(xp);
+}
+
+void
+addevaltrans_flath2matrix_avector(field alpha, pcflath2matrix fh,
+				  pcavector x, pavector y)
+{
+  pcflatblock b;
+  pfield    xp, yp, xt, yt;
+  uint      i;
+
+  assert(x->dim == fh->rc->size);
+  assert(y->dim == fh->cc->size);
+
+  xp = allocfield(fh->rc->size);
+  yp = allocfield(fh->cc->size);
+  xt = allocfield(fh->rb->ktree);
+  yt = allocfield(fh->cb->ktree);
+
+  /* Permutation of x */
+  for (i = 0; i < fh->rc->size; i++)
+    xp[i] = x->v[fh->rc->idx[i]];
+
+  for (i = 0; i < fh->cc->size; i++)
+    yp[i] = 0.0;
+  for (i = 0; i < fh->cb->ktree; i++)
+    yt[i] = 0.0;
+
+  /* Farfield */
+  forward_flatbasis(fh, fh->rb, xp, xt);
+
+  for (i = 0; i < fh->couplings; i++) {
+    b = fh->coupling + i;
+    addeval_flat(alpha, true, fh, fh->rb->node[b->rn].k,
+		 fh->cb->node[b->cn].k, b->off, xt + fh->rb->node[b->rn].koff,
+		 yt + fh->cb->node[b->cn].koff);
+  }
+
+  backward_flatbasis(fh, fh->cb, yt, yp);
+
+  /* Nearfield */
+  for (i = 0; i < fh->nears; i++)
+    addeval_near(alpha, true, fh, fh->near + i, xp, yp);
+
+  /* Reverse permutation of y */
+  for (i = 0; i < fh->cc->size; i++)
+    y->v[fh->cc->idx[i]] += yp[i];
+
+  freemem(yt);
+  freemem(xt);
+  freemem(yp);
+  freemem(xp);
+}
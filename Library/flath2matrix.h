@@ -0,0 +1,233 @@
+/* ------------------------------------------------------------
+ * This is the file "flath2matrix.h" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+/** @file flath2matrix.h
+ */
+
+#ifndef FLATH2MATRIX_H
+#define FLATH2MATRIX_H
+
+/** @defgroup flath2matrix flath2matrix
+ *  @brief Read-only flattened representation of an @ref h2matrix
+ *  for fast matrix-vector products.
+ *
+ *  The cluster bases are stored as arrays of nodes in post-order,
+ *  i.e., every son precedes its father and the root comes last,
+ *  so that the forward transformation is a loop over the array and
+ *  the backward transformation a loop in reverse order.
+ *  Admissible and inadmissible leaves are stored in two arrays sorted
+ *  by rows.
+ *  All coefficients, i.e., the leaf matrices @f$V_t@f$, the transfer
+ *  matrices @f$E_t@f$, the coupling matrices and the nearfield
+ *  matrices, share one aligned buffer and can be stored in single
+ *  precision, see @ref build_from_h2matrix_single_flath2matrix.
+ *
+ *  The representation cannot be modified; if the original
+ *  @ref h2matrix changes, a new @ref flath2matrix has to be built.
+ *  @{ */
+
+/** @brief Read-only flattened representation of an @ref h2matrix. */
+typedef struct _flath2matrix flath2matrix;
+
+/** @brief Pointer to @ref flath2matrix object. */
+typedef flath2matrix *pflath2matrix;
+
+/** @brief Pointer to constant @ref flath2matrix object. */
+typedef const flath2matrix *pcflath2matrix;
+
+/** @brief Flattened cluster basis of a @ref flath2matrix. */
+typedef struct _flatbasis flatbasis;
+
+/** @brief Pointer to @ref flatbasis object. */
+typedef flatbasis *pflatbasis;
+
+/** @brief Pointer to constant @ref flatbasis object. */
+typedef const flatbasis *pcflatbasis;
+
+/** @brief Node of a @ref flatbasis. */
+typedef struct _flatnode flatnode;
+
+/** @brief Pointer to @ref flatnode object. */
+typedef flatnode *pflatnode;
+
+/** @brief Pointer to constant @ref flatnode object. */
+typedef const flatnode *pcflatnode;
+
+/** @brief Block of a @ref flath2matrix. */
+typedef struct _flatblock flatblock;
+
+/** @brief Pointer to @ref flatblock object. */
+typedef flatblock *pflatblock;
+
+/** @brief Pointer to constant @ref flatblock object. */
+typedef const flatblock *pcflatblock;
+
+#include "h2matrix.h"
+#include "flathmatrix.h"
+#include "settings.h"
+
+/** @brief Node of a @ref flatbasis, corresponding to one cluster. */
+struct _flatnode {
+  /** @brief First index in the cluster numbering of the root. */
+  uint roff;
+  /** @brief Number of indices. */
+  uint size;
+  /** @brief Rank. */
+  uint k;
+  /** @brief Offset in coefficient vectors. */
+  uint koff;
+
+  /** @brief Index of the father, only valid if this is not the root. */
+  uint father;
+  /** @brief Number of sons. */
+  uint sons;
+  /** @brief Position of the indices of the sons in <tt>son</tt>
+   *  of the @ref flatbasis. */
+  uint son;
+
+  /** @brief Offset of the leaf matrix @f$V_t@f$ in the coefficient
+   *  buffer, <tt>size</tt> rows and <tt>k</tt> columns, only used if
+   *  there are no sons. */
+  size_t voff;
+  /** @brief Offset of the transfer matrix @f$E_t@f$ in the coefficient
+   *  buffer, <tt>k</tt> rows and the rank of the father as columns,
+   *  only used if this is not the root. */
+  size_t eoff;
+};
+
+/** @brief Flattened cluster basis. */
+struct _flatbasis {
+  /** @brief Number of nodes, the root is the last one. */
+  uint nodes;
+  /** @brief Nodes in post-order. */
+  pflatnode node;
+  /** @brief Indices of sons, see <tt>son</tt> in @ref flatnode. */
+  uint *son;
+  /** @brief Total length of coefficient vectors. */
+  uint ktree;
+};
+
+/** @brief Block of a @ref flath2matrix. */
+struct _flatblock {
+  /** @brief Node of the row basis. */
+  uint rn;
+  /** @brief Node of the column basis. */
+  uint cn;
+  /** @brief Offset of the coefficients, the leading dimension is
+   *  the number of rows. */
+  size_t off;
+  /** @brief Original block, used to copy the coefficients and
+   *  to evaluate matrix-free leaves. */
+  pch2matrix h2;
+};
+
+/** @brief Read-only flattened representation of an @ref h2matrix. */
+struct _flath2matrix {
+  /** @brief Row cluster of the original matrix. */
+  pccluster rc;
+  /** @brief Column cluster of the original matrix. */
+  pccluster cc;
+
+  /** @brief Row basis. */
+  pflatbasis rb;
+  /** @brief Column basis, may coincide with <tt>rb</tt>. */
+  pflatbasis cb;
+
+  /** @brief Number of admissible leaves. */
+  uint couplings;
+  /** @brief Admissible leaves, sorted by row nodes. */
+  pflatblock coupling;
+
+  /** @brief Number of inadmissible leaves. */
+  uint nears;
+  /** @brief Inadmissible leaves, sorted by row nodes. */
+  pflatblock near;
+
+  /** @brief Set if coefficients are stored in single precision. */
+  bool single;
+  /** @brief Coefficients, null if <tt>single</tt> is set. */
+  pfield coeff;
+  /** @brief Single precision coefficients, null unless <tt>single</tt>
+   *  is set. */
+  psfield scoeff;
+  /** @brief Number of coefficients. */
+  size_t ncoeff;
+  /** @brief Unaligned memory containing <tt>coeff</tt> or
+   *  <tt>scoeff</tt>. */
+  void *mem;
+};
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+/** @brief Build a @ref flath2matrix from an @ref h2matrix.
+ *
+ *  The coefficients of the cluster bases and all leaves are copied,
+ *  matrix-free leaves keep a reference to the original block and
+ *  its callback.
+ *
+ *  @param h2 Original matrix.
+ *  @returns New @ref flath2matrix object. */
+HEADER_PREFIX pflath2matrix
+build_from_h2matrix_flath2matrix(pch2matrix h2);
+
+/** @brief Build a @ref flath2matrix from an @ref h2matrix, storing
+ *  the coefficients in single precision.
+ *
+ *  Suitable if the approximation error of <tt>h2</tt> is well above
+ *  the single precision rounding error.
+ *
+ *  @param h2 Original matrix.
+ *  @returns New @ref flath2matrix object. */
+HEADER_PREFIX pflath2matrix
+build_from_h2matrix_single_flath2matrix(pch2matrix h2);
+
+/** @brief Delete a @ref flath2matrix object.
+ *
+ *  @param fh Object to be deleted. */
+HEADER_PREFIX void
+del_flath2matrix(pflath2matrix fh);
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the size of a @ref flath2matrix.
+ *
+ *  @param fh Flattened matrix.
+ *  @returns Size of the descriptors and coefficients in bytes. */
+HEADER_PREFIX size_t
+getsize_flath2matrix(pcflath2matrix fh);
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addeval_flath2matrix_avector(field alpha, pcflath2matrix fh, pcavector x,
+			     pavector y);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addevaltrans_flath2matrix_avector(field alpha, pcflath2matrix fh,
+				  pcavector x, pavector y);
+
+/** @} */
+
+#endif
@@ -0,0 +1,683 @@
+/* ------------------------------------------------------------
+ * This is the file "flathmatrix.c" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flathmatrix.h"
+#include "basic.h"
+
+/* Alignment of the coefficient buffer and of every leaf in bytes */
+#define ALIGN_FLATHMATRIX 64
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+static uint
+countleaves(pchmatrix hm)
+{
+  uint      leaves;
+  uint      i;
+
+  if (hm->son == NULL)
+    return 1;
+
+  leaves = 0;
+  for (i = 0; i < hm->rsons * hm->csons; i++)
+    leaves += countleaves(hm->son[i]);
+
+  return leaves;
+}
+
+static void
+collectleaves(pchmatrix hm, uint roff, uint coff, pflatleaf leaf,
+	      uint * leaves)
+{
+  pflatleaf l;
+  uint      roff1, coff1, i, j;
+
+  if (hm->son == NULL) {
+    l = leaf + (*leaves);
+    (*leaves)++;
+
+    l->roff = roff;
+    l->coff = coff;
+    l->rows = hm->rc->size;
+    l->cols = hm->cc->size;
+    l->k = 0;
+    l->off = 0;
+    l->hm = hm;
+
+    if (hm->r) {
+      /* Lossy compressed factors have to be restored first */
+      assert(hm->r->CA == NULL);
+      l->type = RK_FLATLEAF;
+      l->k = hm->r->k;
+    }
+    else if (hm->f)
+      l->type = FULL_FLATLEAF;
+    else {
+      assert(hm->fill != NULL);
+      l->type = FILL_FLATLEAF;
+    }
+  }
+  else {
+    coff1 = coff;
+    for (j = 0; j < hm->csons; j++) {
+      roff1 = roff;
+      for (i = 0; i < hm->rsons; i++) {
+	collectleaves(hm->son[i + j * hm->rsons], roff1, coff1, leaf,
+		      leaves);
+
+	roff1 += hm->son[i]->rc->size;
+      }
+      assert(roff1 == roff + hm->rc->size);
+
+      coff1 += hm->son[j * hm->rsons]->cc->size;
+    }
+    assert(coff1 == coff + hm->cc->size);
+  }
+}
+
+static int
+compare_flatleaf(const void *a, const void *b)
+{
+  pcflatleaf la = (pcflatleaf) a;
+  pcflatleaf lb = (pcflatleaf) b;
+
+  if (la->roff != lb->roff)
+    return (la->roff < lb->roff ? -1 : 1);
+  if (la->coff != lb->coff)
+    return (la->coff < lb->coff ? -1 : 1);
+  return 0;
+}
+
+/* Copy a matrix into the buffer with leading dimension equal to the
+ * number of rows */
+static void
+copy_flat(pcamatrix a, pfield dest)
+{
+  uint      j;
+
+  for (j = 0; j < a->cols; j++)
+    memcpy(dest + (size_t) j * a->rows, a->a + (size_t) j * a->ld,
+	   sizeof(field) * a->rows);
+}
+
+void
+convert_amatrix_single(pcamatrix a, psfield dest)
+{
+  uint      i, j;
+
+  for (j = 0; j < a->cols; j++)
+    for (i = 0; i < a->rows; i++)
+      dest[i + (size_t) j * a->rows] = (sfield) a->a[i + (size_t) j * a->ld];
+}
+
+static pflathmatrix
+build_flathmatrix(pchmatrix hm, bool single)
+{
+  pflathmatrix fh;
+  pflatleaf l;
+  size_t    pad, off, sz;
+  size_t    esize = (single ? sizeof(sfield) : sizeof(field));
+  uint      leaves, i;
+
+  fh = (pflathmatrix) allocmem(sizeof(flathmatrix));
+
+  fh->rc = hm->rc;
+  fh->cc = hm->cc;
+  fh->single = single;
+
+  /* Set up leaf descriptors sorted by rows */
+  fh->leaves = countleaves(hm);
+  fh->leaf = (pflatleaf) allocmem(sizeof(flatleaf) * fh->leaves);
+
+  leaves = 0;
+  collectleaves(hm, 0, 0, fh->leaf, &leaves);
+  assert(leaves == fh->leaves);
+
+  qsort(fh->leaf, fh->leaves, sizeof(flatleaf), compare_flatleaf);
+
+  /* Assign aligned offsets in the common buffer */
+  pad = ALIGN_FLATHMATRIX / esize;
+  if (pad == 0)
+    pad = 1;
+
+  off = 0;
+  fh->kmax = 0;
+  for (i = 0; i < fh->leaves; i++) {
+    l = fh->leaf + i;
+
+    l->off = off;
+
+    switch (l->type) {
+    case RK_FLATLEAF:
+      sz = (size_t) l->k * (l->rows + l->cols);
+      if (l->k > fh->kmax)
+	fh->kmax = l->k;
+      break;
+    case FULL_FLATLEAF:
+      sz = (size_t) l->rows * l->cols;
+      break;
+    default:
+      sz = 0;
+    }
+
+    off += (sz + pad - 1) / pad * pad;
+  }
+  fh->ncoeff = off;
+
+  fh->mem = allocmem(esize * fh->ncoeff + ALIGN_FLATHMATRIX);
+  fh->coeff = NULL;
+  fh->scoeff = NULL;
+  if (single)
+    fh->scoeff = (psfield) (((size_t) fh->mem + ALIGN_FLATHMATRIX - 1)
+			    / ALIGN_FLATHMATRIX * ALIGN_FLATHMATRIX);
+  else
+    fh->coeff = (pfield) (((size_t) fh->mem + ALIGN_FLATHMATRIX - 1)
+			  / ALIGN_FLATHMATRIX * ALIGN_FLATHMATRIX);
+
+  /* Copy coefficients */
+  for (i = 0; i < fh->leaves; i++) {
+    l = fh->leaf + i;
+
+    switch (l->type) {
+    case RK_FLATLEAF:
+      if (single) {
+	convert_amatrix_single(&l->hm->r->A, fh->scoeff + l->off);
+	convert_amatrix_single(&l->hm->r->B,
+			       fh->scoeff + l->off + (size_t) l->rows * l->k);
+      }
+      else {
+	copy_flat(&l->hm->r->A, fh->coeff + l->off);
+	copy_flat(&l->hm->r->B, fh->coeff + l->off + (size_t) l->rows * l->k);
+      }
+      break;
+    case FULL_FLATLEAF:
+      if (single)
+	convert_amatrix_single(l->hm->f, fh->scoeff + l->off);
+      else
+	copy_flat(l->hm->f, fh->coeff + l->off);
+      break;
+    default:
+      break;
+    }
+  }
+
+  return fh;
+}
+
+pflathmatrix
+build_from_hmatrix_flathmatrix(pchmatrix hm)
+{
+  return build_flathmatrix(hm, false);
+}
+
+pflathmatrix
+build_from_hmatrix_single_flathmatrix(pchmatrix hm)
+{
+  return build_flathmatrix(hm, true);
+}
+
+void
+del_flathmatrix(pflathmatrix fh)
+{
+  freemem(fh->mem);
+  freemem(fh->leaf);
+  freemem(fh);
+}
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+size_t
+getsize_flathmatrix(pcflathmatrix fh)
+{
+  size_t    sz;
+
+  sz = (size_t) sizeof(flathmatrix);
+  sz += (size_t) sizeof(flatleaf) * fh->leaves;
+  sz += (fh->single ? sizeof(sfield) : sizeof(field)) * fh->ncoeff
+    + ALIGN_FLATHMATRIX;
+
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ * Single precision coefficients
+ * ------------------------------------------------------------ */
+
+void
+addeval_single_avector(field alpha, uint rows, uint cols, pcsfield a,
+		       pcavector x, pavector y)
+{
+  pfield    yv = y->v;
+  pcsfield  aj;
+  field     xj;
+  uint      i, j;
+
+  assert(x->dim >= cols);
+  assert(y->dim >= rows);
+
+  for (j = 0; j < cols; j++) {
+    xj = alpha * x->v[j];
+    aj = a + (size_t) j * rows;
+    for (i = 0; i < rows; i++)
+      yv[i] += aj[i] * xj;
+  }
+}
+
+void
+addevaltrans_single_avector(field alpha, uint rows, uint cols, pcsfield a,
+			    pcavector x, pavector y)
+{
+  pcfield   xv = x->v;
+  pcsfield  aj;
+  field     sum;
+  uint      i, j;
+
+  assert(x->dim >= rows);
+  assert(y->dim >= cols);
+
+  for (j = 0; j < cols; j++) {
+    aj = a + (size_t) j * rows;
+    sum = 0.0;
+    for (i = 0; i < rows; i++)
+      sum += CONJ((field) aj[i]) * xv[i];
+    y->v[j] += alpha * sum;
+  }
+}
+
+/* Leaf products for single precision coefficients, y += alpha A x or
+ * y += alpha A^* x */
+static void
+addeval_single_flatleaf(field alpha, bool trans, pcflathmatrix fh,
+			pcflatleaf l, pcavector x1, pavector y1, pfield zbuf)
+{
+  avector   tmp;
+  amatrix   tmp2;
+  pavector  z;
+  pamatrix  N;
+  pcsfield  A, B;
+
+  switch (l->type) {
+  case RK_FLATLEAF:
+    if (l->k > 0) {
+      A = fh->scoeff + l->off;
+      B = A + (size_t) l->rows * l->k;
+
+      z = init_pointer_avector(&tmp, zbuf, l->k);
+      clear_avector(z);
+      if (trans) {
+	addevaltrans_single_avector(1.0, l->rows, l->k, A, x1, z);
+	addeval_single_avector(alpha, l->cols, l->k, B, z, y1);
+      }
+      else {
+	addevaltrans_single_avector(1.0, l->cols, l->k, B, x1, z);
+	addeval_single_avector(alpha, l->rows, l->k, A, z, y1);
+      }
+      uninit_avector(z);
+    }
+    break;
+  case FULL_FLATLEAF:
+    if (trans)
+      addevaltrans_single_avector(alpha, l->rows, l->cols,
+				  fh->scoeff + l->off, x1, y1);
+    else
+      addeval_single_avector(alpha, l->rows, l->cols, fh->scoeff + l->off,
+			     x1, y1);
+    break;
+  case FILL_FLATLEAF:
+    N = init_amatrix(&tmp2, l->rows, l->cols);
+    l->hm->fill(l->hm->rc->idx, l->hm->cc->idx, l->hm->filldata, N);
+    mvm_amatrix_avector(alpha, trans, N, x1, y1);
+    uninit_amatrix(N);
+    break;
+  }
+}
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+void
+fastaddeval_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector xp,
+				pavector yp)
+{
+  avector   tmp1, tmp2, tmp3;
+  amatrix   tmp4;
+  pavector  x1, y1, z;
+  pamatrix  N;
+  pcflatleaf l;
+  pfield    zbuf;
+  uint      i;
+
+  assert(xp->dim == fh->cc->size);
+  assert(yp->dim == fh->rc->size);
+
+  zbuf = allocfield(fh->kmax);
+
+  for (i = 0; i < fh->leaves; i++) {
+    l = fh->leaf + i;
+
+    x1 = init_pointer_avector(&tmp1, xp->v + l->coff, l->cols);
+    y1 = init_pointer_avector(&tmp2, yp->v + l->roff, l->rows);
+
+    if (fh->single) {
+      addeval_single_flatleaf(alpha, false, fh, l, x1, y1, zbuf);
+      uninit_avector(y1);
+      uninit_avector(x1);
+      continue;
+    }
+
+    switch (l->type) {
+    case RK_FLATLEAF:
+      if (l->k > 0) {
+	z = init_pointer_avector(&tmp3, zbuf, l->k);
+	clear_avector(z);
+
+	N = init_pointer_amatrix(&tmp4,
+				 fh->coeff + l->off + (size_t) l->rows * l->k,
+				 l->cols, l->k);
+	mvm_amatrix_avector(1.0, true, N, x1, z);
+	uninit_amatrix(N);
+
+	N = init_pointer_amatrix(&tmp4, fh->coeff + l->off, l->rows, l->k);
+	mvm_amatrix_avector(alpha, false, N, z, y1);
+	uninit_amatrix(N);
+
+	uninit_avector(z);
+      }
+      break;
+    case FULL_FLATLEAF:
+      N = init_pointer_amatrix(&tmp4, fh->coeff + l->off, l->rows, l->cols);
+      mvm_amatrix_avector(alpha, false, N, x1, y1);
+      uninit_amatrix(N);
+      break;
+    case FILL_FLATLEAF:
+      N = init_amatrix(&tmp4, l->rows, l->cols);
+      l->hm->fill(l->hm->rc->idx, l->hm->cc->idx, l->hm->filldata, N);
+      mvm_amatrix_avector(alpha, false, N, x1, y1);
+      uninit_amatrix(N);
+      break;
+    }
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+
+  freemem(zbuf);
+}
+
+void
+addeval_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector x,
+			    pavector y)
+{
+  pavector  xp, yp;
+  avector   xtmp, ytmp;
+  uint      i;
+
+  assert(x->dim == fh->cc->size);
+  assert(y->dim == fh->rc->size);
+
+  /* Permutation of x */
+  xp = init_avector(&xtmp, x->dim);
+  for (i = 0; i < xp->dim; i++)
+    xp->v[i] = x->v[fh->cc->idx[i]];
+
+  /* Permutation of y */
+  yp = init_avector(&ytmp, y->dim);
+  for (i = 0; i < yp->dim; i++)
+    yp->v[i] = y->v[fh->rc->idx[i]];
+
+  /* Matrix-vector multiplication */
+  fastaddeval_flathmatrix_avector(alpha, fh, xp, yp);
+
+  /* Reverse permutation of y */
+  for (i = 0; i < yp->dim; i++)
+    y->v[fh->rc->idx[i]] = yp->v[i];
+
+  uninit_avector(yp);
+  uninit_avector(xp);
+}
+
+void
+fastaddevaltrans_flathmatrix_avector(field alpha, pcflathmatrix fh,
+				     pcavector xp, pavector yp)
+{
+  avector   tmp1, tmp2, tmp3;
+  amatrix   tmp4;
+  pavector  x1, y1, z;
+  pamatrix  N;
+  pcflatleaf l;
+  pfield    zbuf;
+  uint      i;
+
+  assert(xp->dim == fh->rc->size);
+  assert(yp->dim == fh->cc->size);
+
+  zbuf = allocfield(fh->kmax);
+
+  for (i = 0; i < fh->leaves; i++) {
+    l = fh->leaf + i;
+
+    x1 = init_pointer_avector(&tmp1, xp->v + l->roff, l->rows);
+    y1 = init_pointer_avector(&tmp2, yp->v + l->coff, l->cols);
+
+    if (fh->single) {
+      addeval_single_flatleaf(alpha, true, fh, l, x1, y1, zbuf);
+      uninit_avector(y1);
+      uninit_avector(x1);
+      continue;
+    }
+
+    switch (l->type) {
+    case RK_FLATLEAF:
+      if (l->k > 0) {
+	z = init_pointer_avector(&tmp3, zbuf, l->k);
+	clear_avector(z);
+
+	N = init_pointer_amatrix(&tmp4, fh->coeff + l->off, l->rows, l->k);
+	mvm_amatrix_avector(1.0, true, N, x1, z);
+	uninit_amatrix(N);
+
+	N = init_pointer_amatrix(&tmp4,
+				 fh->coeff + l->off + (size_t) l->rows * l->k,
+				 l->cols, l->k);
+	mvm_amatrix_avector(alpha, false, N, z, y1);
+	uninit_amatrix(N);
+
+	uninit_avector(z);
+      }
+      break;
+    case FULL_FLATLEAF:
+      N = init_pointer_amatrix(&tmp4, fh->coeff + l->off, l->rows, l->cols);
+      mvm_amatrix_avector(alpha, true, N, x1, y1);
+      uninit_amatrix(N);
+      break;
+    case FILL_FLATLEAF:
+      N = init_amatrix(&tmp4, l->rows, l->cols);
+      l->hm->fill(l->hm->rc->idx, l->hm->cc->idx, l->hm->filldata, N);
+      mvm_amatrix_avector(alpha, true, N, x1, y1);
+      uninit_amatrix(N);
+      break;
+    }
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+
+  freemem(zbuf);
+}
+
+void
+addevaltrans_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector x,
+				 pavector y)
+{
+  pavector  xp, yp;
+  avector   xtmp, ytmp;
+  uint      i;
+
+  assert(x->dim == fh->rc->size);
+  assert(y->dim == fh->cc->size);
+
+  /* Permutation of x */
+  xp = init_avector(&xtmp, x->dim);
+  for (i = 0; i < xp->dim; i++)
+    xp->v[i] = x->v[fh->rc->idx[i]];
+
+  /* Permutation of y */
+  yp = init_avector(&ytmp, y->dim);
+  for (i = 0; i < yp->dim; i++)
+    yp->v[i] = y->v[fh->cc->idx[i]];
+
+  /* Matrix-vector multiplication */
+  fastaddevaltrans_flathmatrix_avector(alpha, fh, xp, yp);
+
+  /* Reverse permutation of y */
+  for (i = 0; i < yp->dim; i++)
+    y->v[fh->cc->idx[i]] = yp->v[i];
+
+  uninit_avector(yp);
+  uninit_avector(xp);
+}
+
+/* Y += alpha A X or Y += alpha A^* X in cluster numbering */
+static void
+fastaddmul_flathmatrix_amatrix(field alpha, bool atrans, pcflathmatrix fh,
+			       pcamatrix Xp, pamatrix Yp)
+{
+  amatrix   tmp1, tmp2, tmp3, tmp4;
+  avector   tmp5, tmp6, tmp7, tmp8;
+  pamatrix  X1, Y1, Z, N;
+  pavector  x, y, x1, y1;
+  pcflatleaf l;
+  pfield    A, B;
+  pfield    zbuf;
+  uint      cols = Xp->cols;
+  uint      i, j;
+
+  zbuf = allocfield((size_t) fh->kmax * cols);
+
+  if (fh->single) {
+    /* Single precision leaves are applied column by column */
+    for (j = 0; j < cols; j++) {
+      x = init_column_avector(&tmp5, (pamatrix) Xp, j);
+      y = init_column_avector(&tmp6, Yp, j);
+      for (i = 0; i < fh->leaves; i++) {
+	l = fh->leaf + i;
+	x1 = (atrans ?
+	      init_sub_avector(&tmp7, x, l->rows, l->roff) :
+	      init_sub_avector(&tmp7, x, l->cols, l->coff));
+	y1 = (atrans ?
+	      init_sub_avector(&tmp8, y, l->cols, l->coff) :
+	      init_sub_avector(&tmp8, y, l->rows, l->roff));
+	addeval_single_flatleaf(alpha, atrans, fh, l, x1, y1, zbuf);
+	uninit_avector(y1);
+	uninit_avector(x1);
+      }
+      uninit_avector(y);
+      uninit_avector(x);
+    }
+
+    freemem(zbuf);
+    return;
+  }
+
+  for (i = 0; i < fh->leaves; i++) {
+    l = fh->leaf + i;
+
+    if (atrans) {
+      X1 = init_sub_amatrix(&tmp1, (pamatrix) Xp, l->rows, l->roff, cols, 0);
+      Y1 = init_sub_amatrix(&tmp2, Yp, l->cols, l->coff, cols, 0);
+    }
+    else {
+      X1 = init_sub_amatrix(&tmp1, (pamatrix) Xp, l->cols, l->coff, cols, 0);
+      Y1 = init_sub_amatrix(&tmp2, Yp, l->rows, l->roff, cols, 0);
+    }
+
+    switch (l->type) {
+    case RK_FLATLEAF:
+      if (l->k > 0) {
+	A = fh->coeff + l->off;
+	B = A + (size_t) l->rows * l->k;
+	if (atrans) {
+	  A = B;
+	  B = fh->coeff + l->off;
+	}
+
+	Z = init_pointer_amatrix(&tmp3, zbuf, l->k, cols);
+	clear_amatrix(Z);
+
+	N = init_pointer_amatrix(&tmp4, B, X1->rows, l->k);
+	addmul_amatrix(1.0, true, N, false, X1, Z);
+	uninit_amatrix(N);
+
+	N = init_pointer_amatrix(&tmp4, A, Y1->rows, l->k);
+	addmul_amatrix(alpha, false, N, false, Z, Y1);
+	uninit_amatrix(N);
+
+	uninit_amatrix(Z);
+      }
+      break;
+    case FULL_FLATLEAF:
+      N = init_pointer_amatrix(&tmp4, fh->coeff + l->off, l->rows, l->cols);
+      addmul_amatrix(alpha, atrans, N, false, X1, Y1);
+      uninit_amatrix(N);
+      break;
+    case FILL_FLATLEAF:
+      N = init_amatrix(&tmp4, l->rows, l->cols);
+      l->hm->fill(l->hm->rc->idx, l->hm->cc->idx, l->hm->filldata, N);
+      addmul_amatrix(alpha, atrans, N, false, X1, Y1);
+      uninit_amatrix(N);
+      break;
+    }
+
+    uninit_amatrix(Y1);
+    uninit_amatrix(X1);
+  }
+
+  freemem(zbuf);
+}
+
+void
+addmul_flathmatrix_amatrix_amatrix(field alpha, bool atrans,
+				   pcflathmatrix fh, pcamatrix X, pamatrix Y)
+{
+  amatrix   tmp1, tmp2;
+  pamatrix  Xp, Yp;
+  pccluster xc = (atrans ? fh->rc : fh->cc);
+  pccluster yc = (atrans ? fh->cc : fh->rc);
+  uint      i, j;
+
+  assert(X->rows == xc->size);
+  assert(Y->rows == yc->size);
+  assert(X->cols == Y->cols);
+
+  /* Permutation of X */
+  Xp = init_amatrix(&tmp1, X->rows, X->cols);
+  for (j = 0; j < X->cols; j++)
+    for (i = 0; i < X->rows; i++)
+      Xp->a[i + j * Xp->ld] = X->a[xc->idx[i] + j * X->ld];
+
+  /* Permutation of Y */
+  Yp = init_amatrix(&tmp2, Y->rows, Y->cols);
+  for (j = 0; j < Y->cols; j++)
+    for (i = 0; i < Y->rows; i++)
+      Yp->a[i + j * Yp->ld] = Y->a[yc->idx[i] + j * Y->ld];
+
+  fastaddmul_flathmatrix_amatrix(alpha, atrans, fh, Xp, Yp);
+
+  /* Reverse permutation of Y */
+  for (j = 0; j < Y->cols; j++)
+    for (i = 0; i < Y->rows; i++)
+      Y->a[yc->idx[i] + j * Y->ld] = Yp->a[i + j * Yp->ld];
+
+  uninit_amatrix(Yp);
+  uninit_amatrix(Xp);
+}
@@ -0,0 +1,272 @@
+/* ------------------------------------------------------------
+ * This is the file "flathmatrix.h" of the H2Lib package.
+ * All rights reserved, 2016
+ * ------------------------------------------------------------ */
+
+/** @file flathmatrix.h
+ */
+
+#ifndef FLATHMATRIX_H
+#define FLATHMATRIX_H
+
+/** @defgroup flathmatrix flathmatrix
+ *  @brief Read-only flattened representation of an @ref hmatrix
+ *  for fast matrix-vector products.
+ *
+ *  A @ref flathmatrix is built once from an @ref hmatrix. Instead of
+ *  a tree of submatrices with individually allocated leaves, it
+ *  contains an array of leaf descriptors sorted by their first row
+ *  and a single aligned buffer holding the coefficients of all
+ *  leaves in the same order, so that products traverse the
+ *  coefficients sequentially.
+ *
+ *  The coefficients can optionally be stored in single precision,
+ *  see @ref build_from_hmatrix_single_flathmatrix. They are converted
+ *  on the fly, vectors and sums use @ref field, so only the storage
+ *  and the memory bandwidth of the products are reduced.
+ *
+ *  The representation cannot be modified; if the original
+ *  @ref hmatrix changes, a new @ref flathmatrix has to be built.
+ *  @{ */
+
+/** @brief Read-only flattened representation of an @ref hmatrix. */
+typedef struct _flathmatrix flathmatrix;
+
+/** @brief Pointer to @ref flathmatrix object. */
+typedef flathmatrix *pflathmatrix;
+
+/** @brief Pointer to constant @ref flathmatrix object. */
+typedef const flathmatrix *pcflathmatrix;
+
+/** @brief Description of one leaf of a @ref flathmatrix. */
+typedef struct _flatleaf flatleaf;
+
+/** @brief Pointer to @ref flatleaf object. */
+typedef flatleaf *pflatleaf;
+
+/** @brief Pointer to constant @ref flatleaf object. */
+typedef const flatleaf *pcflatleaf;
+
+#include "hmatrix.h"
+#include "amatrix.h"
+#include "avector.h"
+#include "settings.h"
+
+/** @brief Types of leaves of a @ref flathmatrix. */
+typedef enum {
+  /** @brief Low-rank leaf @f$A B^*@f$, the coefficients of @f$A@f$
+   *  are followed by those of @f$B@f$. */
+  RK_FLATLEAF,
+  /** @brief Standard matrix. */
+  FULL_FLATLEAF,
+  /** @brief Matrix-free leaf, the coefficients are computed on demand
+   *  by the callback of the original @ref hmatrix. */
+  FILL_FLATLEAF
+} flatleaftype;
+
+/** @brief Description of one leaf of a @ref flathmatrix. */
+struct _flatleaf {
+  /** @brief Type of the leaf. */
+  flatleaftype type;
+
+  /** @brief First row in the cluster numbering of the root. */
+  uint roff;
+  /** @brief First column in the cluster numbering of the root. */
+  uint coff;
+  /** @brief Number of rows. */
+  uint rows;
+  /** @brief Number of columns. */
+  uint cols;
+  /** @brief Rank of a low-rank leaf, zero otherwise. */
+  uint k;
+
+  /** @brief Offset of the coefficients in <tt>coeff</tt>, the leading
+   *  dimensions are <tt>rows</tt> and <tt>cols</tt>, respectively. */
+  size_t off;
+
+  /** @brief Original leaf, only used for matrix-free leaves. */
+  pchmatrix hm;
+};
+
+/** @brief Read-only flattened representation of an @ref hmatrix. */
+struct _flathmatrix {
+  /** @brief Row cluster of the original matrix. */
+  pccluster rc;
+  /** @brief Column cluster of the original matrix. */
+  pccluster cc;
+
+  /** @brief Number of leaves. */
+  uint leaves;
+  /** @brief Leaf descriptors, sorted by first row and first column. */
+  pflatleaf leaf;
+
+  /** @brief Set if coefficients are stored in single precision. */
+  bool single;
+
+  /** @brief Coefficients of all leaves, aligned to the size of a
+   *  cache line, null if <tt>single</tt> is set. */
+  pfield coeff;
+  /** @brief Single precision coefficients of all leaves, aligned to
+   *  the size of a cache line, null unless <tt>single</tt> is set. */
+  psfield scoeff;
+  /** @brief Number of coefficients. */
+  size_t ncoeff;
+  /** @brief Unaligned memory containing <tt>coeff</tt> or
+   *  <tt>scoeff</tt>. */
+  void *mem;
+
+  /** @brief Maximal rank of all leaves, used for workspaces. */
+  uint kmax;
+};
+
+/* ------------------------------------------------------------
+ * Constructors and destructors
+ * ------------------------------------------------------------ */
+
+/** @brief Build a @ref flathmatrix from an @ref hmatrix.
+ *
+ *  The coefficients of all leaves are copied, matrix-free leaves
+ *  keep a reference to the original @ref hmatrix and its callback.
+ *
+ *  @param hm Original matrix.
+ *  @returns New @ref flathmatrix object. */
+HEADER_PREFIX pflathmatrix
+build_from_hmatrix_flathmatrix(pchmatrix hm);
+
+/** @brief Build a @ref flathmatrix from an @ref hmatrix, storing
+ *  the coefficients in single precision.
+ *
+ *  Suitable if the approximation error of <tt>hm</tt> is well above
+ *  the single precision rounding error.
+ *
+ *  @param hm Original matrix.
+ *  @returns New @ref flathmatrix object. */
+HEADER_PREFIX pflathmatrix
+build_from_hmatrix_single_flathmatrix(pchmatrix hm);
+
+/** @brief Delete a @ref flathmatrix object.
+ *
+ *  @param fh Object to be deleted. */
+HEADER_PREFIX void
+del_flathmatrix(pflathmatrix fh);
+
+/* ------------------------------------------------------------
+ * Statistics
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the size of a @ref flathmatrix.
+ *
+ *  @param fh Flattened matrix.
+ *  @returns Size of the descriptors and coefficients in bytes. */
+HEADER_PREFIX size_t
+getsize_flathmatrix(pcflathmatrix fh);
+
+/* ------------------------------------------------------------
+ * Single precision coefficients
+ * ------------------------------------------------------------ */
+
+/** @brief Convert a matrix to single precision.
+ *
+ *  @param a Source matrix.
+ *  @param dest Target array, will be filled column by column with
+ *         leading dimension <tt>a->rows</tt>. */
+HEADER_PREFIX void
+convert_amatrix_single(pcamatrix a, psfield dest);
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$ for a matrix stored in single
+ *  precision, using @ref field for the computation.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param rows Number of rows of @f$A@f$, also the leading dimension.
+ *  @param cols Number of columns of @f$A@f$.
+ *  @param a Coefficients of @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addeval_single_avector(field alpha, uint rows, uint cols, pcsfield a,
+		       pcavector x, pavector y);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$ for a matrix stored in single
+ *  precision, using @ref field for the computation.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param rows Number of rows of @f$A@f$, also the leading dimension.
+ *  @param cols Number of columns of @f$A@f$.
+ *  @param a Coefficients of @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addevaltrans_single_avector(field alpha, uint rows, uint cols, pcsfield a,
+			    pcavector x, pavector y);
+
+/* ------------------------------------------------------------
+ * Matrix-vector multiplication
+ * ------------------------------------------------------------ */
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$ in cluster numbering.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>fh->cc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>fh->rc</tt>. */
+HEADER_PREFIX void
+fastaddeval_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector xp,
+				pavector yp);
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addeval_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector x,
+			    pavector y);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$ in cluster numbering.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param xp Source vector @f$x@f$ in cluster numbering
+ *            with respect to <tt>fh->rc</tt>.
+ *  @param yp Target vector @f$y@f$ in cluster numbering
+ *            with respect to <tt>fh->cc</tt>. */
+HEADER_PREFIX void
+fastaddevaltrans_flathmatrix_avector(field alpha, pcflathmatrix fh,
+				     pcavector xp, pavector yp);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addevaltrans_flathmatrix_avector(field alpha, pcflathmatrix fh, pcavector x,
+				 pavector y);
+
+/** @brief Multiply a block of vectors,
+ *  @f$Y \gets Y + \alpha A X@f$ or @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  Every leaf is applied to all columns of @f$X@f$ at once.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param atrans Set if @f$A^*@f$ is to be used instead of @f$A@f$.
+ *  @param fh Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addmul_flathmatrix_amatrix_amatrix(field alpha, bool atrans,
+				   pcflathmatrix fh, pcamatrix X, pamatrix Y);
+
+/** @} */
+
+#endif
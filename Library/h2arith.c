@@ -251,6 +251,7 @@ add_hmatrix_h2matrix(pchmatrix Gh, ph2matrix Gh2, pclusteroperator rwf,
   pclusteroperator rw, cw;
   uint      i, j;
 
+  assert(!ismatrixfree_h2matrix(Gh2));
   assert(Gh2->rb->t == Gh->rc);
   assert(Gh2->cb->t == Gh->cc);
 
@@ -433,6 +434,10 @@ convert_h2matrix_hmatrix(pch2matrix h2)
     hm = new_full_hmatrix(h2->rb->t, h2->cb->t);
     copy_amatrix(false, h2->f, hm->f);
   }
+  else if (h2->fill) {
+    hm = new_matrixfree_hmatrix(h2->rb->t, h2->cb->t, h2->fill,
+				h2->filldata);
+  }
   else {
     assert(h2->son);
     hm = new_super_hmatrix(h2->rb->t, h2->cb->t, h2->rsons, h2->csons);
@@ -703,10 +708,35 @@ mul_h2matrix_rkmatrix(pch2matrix A, bool btrans, pch2matrix B, real tol)
   return R;
 }
 
-void
-addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
-		  pclusteroperator rwf, pclusteroperator cwf, ptruncmode tm,
-		  real tol)
+/* Rank bound for the accumulated updates of C: beyond the sum of the
+ * ranks of the cluster bases, applying the updates is cheaper than
+ * keeping them */
+static    uint
+maxrank_rkaccum_h2matrix(pch2matrix C)
+{
+  return UINT_MAX(C->rb->k + C->cb->k, 1);
+}
+
+/* C = C + R, either directly or by adding R to the accumulator ra */
+static void
+rkupdate_rkaccum_h2matrix(prkmatrix R, ph2matrix C, prkaccum ra,
+			  pclusteroperator rwf, pclusteroperator cwf,
+			  ptruncmode tm, real tol)
+{
+  if (ra) {
+    assert(ra->Gh2 == C);
+    add_rkaccum(R, ra);
+  }
+  else
+    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+}
+
+/* C = C + alpha A op(B), if ra is not null, low-rank updates of C are
+ * added to the accumulator ra instead of being applied directly */
+static void
+addmul_1_rkaccum_h2matrix(field alpha, pch2matrix A, pch2matrix B,
+			  ph2matrix C, prkaccum ra, pclusteroperator rwf,
+			  pclusteroperator cwf, ptruncmode tm, real tol)
 {
   uint      rows = A->rb->t->size;
   uint      s = A->cb->t->size;
@@ -717,6 +747,8 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
   prkmatrix R, p;
   pamatrix  X;
+  ph2matrix C1;
+  prkaccum  ra1;
   pclusteroperator rw, cw;
   uint      i, j, l;
 
@@ -738,7 +770,7 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
     del_rkmatrix(p);
 
     trunc_rkmatrix(0, tol, R);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -752,7 +784,7 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
     del_rkmatrix(p);
 
     trunc_rkmatrix(0, tol, R);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -778,7 +810,7 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
       scale_amatrix(alpha, &R->B);
     }
 
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -804,7 +836,7 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
       scale_amatrix(alpha, &R->B);
     }
 
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -812,7 +844,7 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
   else if (C->u) {
     R = mul_h2matrix_rkmatrix(A, false, B, tol);
     scale_amatrix(alpha, &R->A);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -846,11 +878,14 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
     for (i = 0; i < rsons; i++) {
       for (j = 0; j < csons; j++) {
+	C1 = C->son[i + j * rsons];
+	ra1 = new_rkaccum(C1, rw, cw, tm, tol, maxrank_rkaccum_h2matrix(C1));
 	for (l = 0; l < ssons; l++) {
-	  addmul_1_h2matrix(alpha, A->son[i + l * rsons],
-			    B->son[l + j * ssons], C->son[i + j * rsons], rw,
-			    cw, tm, tol);
+	  addmul_1_rkaccum_h2matrix(alpha, A->son[i + l * rsons],
+				    B->son[l + j * ssons], C1, ra1, rw, cw,
+				    tm, tol);
 	}
+	del_rkaccum(ra1);
       }
     }
     /*orthogonal_block_h2matrix(C, rw, cw); */
@@ -864,16 +899,24 @@ addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
     R = mul_h2matrix_rkmatrix(A, false, B, tol);
     scale_amatrix(alpha, &R->A);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
 }
 
 void
-addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
+addmul_1_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 		  pclusteroperator rwf, pclusteroperator cwf, ptruncmode tm,
 		  real tol)
+{
+  addmul_1_rkaccum_h2matrix(alpha, A, B, C, NULL, rwf, cwf, tm, tol);
+}
+
+static void
+addmul_2_rkaccum_h2matrix(field alpha, pch2matrix A, pch2matrix B,
+			  ph2matrix C, prkaccum ra, pclusteroperator rwf,
+			  pclusteroperator cwf, ptruncmode tm, real tol)
 {
   uint      rows = A->rb->t->size;
   uint      s = A->cb->t->size;
@@ -884,6 +927,8 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
   prkmatrix R, p;
   pamatrix  X;
+  ph2matrix C1;
+  prkaccum  ra1;
   pclusteroperator rw, cw;
   uint      i, j, l;
 
@@ -905,7 +950,7 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
     del_rkmatrix(p);
 
     trunc_rkmatrix(0, tol, R);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -919,7 +964,7 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
     del_rkmatrix(p);
 
     trunc_rkmatrix(0, tol, R);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -945,7 +990,7 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
       scale_amatrix(alpha, &R->B);
     }
 
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -972,7 +1017,7 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
       scale_amatrix(alpha, &R->B);
     }
 
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -980,7 +1025,7 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
   else if (C->u) {
     R = mul_h2matrix_rkmatrix(A, true, B, tol);
     scale_amatrix(alpha, &R->A);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
@@ -997,11 +1042,14 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
     for (i = 0; i < rsons; i++) {
       for (j = 0; j < csons; j++) {
+	C1 = C->son[i + j * rsons];
+	ra1 = new_rkaccum(C1, rw, cw, tm, tol, maxrank_rkaccum_h2matrix(C1));
 	for (l = 0; l < ssons; l++) {
-	  addmul_2_h2matrix(alpha, A->son[i + l * rsons],
-			    B->son[j + l * csons], C->son[i + j * rsons], rw,
-			    cw, tm, tol);
+	  addmul_2_rkaccum_h2matrix(alpha, A->son[i + l * rsons],
+				    B->son[j + l * csons], C1, ra1, rw, cw,
+				    tm, tol);
 	}
+	del_rkaccum(ra1);
       }
     }
     /*orthogonal_block_h2matrix(C, rw, cw); */
@@ -1015,17 +1063,29 @@ addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
 
     R = mul_h2matrix_rkmatrix(A, true, B, tol);
     scale_amatrix(alpha, &R->A);
-    rkupdate_h2matrix(R, C, rwf, cwf, tm, tol);
+    rkupdate_rkaccum_h2matrix(R, C, ra, rwf, cwf, tm, tol);
 
     del_rkmatrix(R);
   }
 }
 
+void
+addmul_2_h2matrix(field alpha, pch2matrix A, pch2matrix B, ph2matrix C,
+		  pclusteroperator rwf, pclusteroperator cwf, ptruncmode tm,
+		  real tol)
+{
+  addmul_2_rkaccum_h2matrix(alpha, A, B, C, NULL, rwf, cwf, tm, tol);
+}
+
 void
 addmul_h2matrix(field alpha, pch2matrix A, bool btrans, pch2matrix B,
 		ph2matrix C, pclusteroperator rwf, pclusteroperator cwf,
 		ptruncmode tm, real tol)
 {
+  assert(!ismatrixfree_h2matrix(A));
+  assert(!ismatrixfree_h2matrix(B));
+  assert(!ismatrixfree_h2matrix(C));
+
   if (!btrans)
     addmul_1_h2matrix(alpha, A, B, C, rwf, cwf, tm, tol);
   else
@@ -1043,6 +1103,9 @@ mul_h2matrix(field alpha, ph2matrix A, ph2matrix B, ph2matrix h2,
   ph2matrix C;
   pclusteroperator rwf, cwf;
 
+  assert(!ismatrixfree_h2matrix(A));
+  assert(!ismatrixfree_h2matrix(B));
+
   rb = build_from_cluster_clusterbasis(rc);
   cb = build_from_cluster_clusterbasis(cc);
   C = clonestructure_h2matrix(h2, rb, cb);
@@ -1077,6 +1140,7 @@ invert_h2matrix(ph2matrix h2, pclusteroperator rwf, pclusteroperator cwf,
   ph2matrix *work;
 
   assert(t == h2->cb->t);
+  assert(!ismatrixfree_h2matrix(h2));
 
   if (h2->son) {
     assert(h2->csons == sons);
@@ -1182,8 +1246,8 @@ lowersolve_h2matrix_1_avector(bool unit, pch2matrix a, pavector x)
 	roff2 += t->son[j - 1]->size;
 	x2 = init_sub_avector(&sub2, x, t->son[j]->size, roff2);
 
-	x1t = init_avector(&tmp1, a->son[j + i * sons]->cb->ktree);
-	x2t = init_avector(&tmp2, a->son[j + i * sons]->rb->ktree);
+	x1t = init_scratch_avector(&tmp1, a->son[j + i * sons]->cb->ktree);
+	x2t = init_scratch_avector(&tmp2, a->son[j + i * sons]->rb->ktree);
 	clear_avector(x2t);
 	forward_nopermutation_clusterbasis_avector(a->son[j + i * sons]->cb,
 						   x1, x1t);
@@ -1235,8 +1299,8 @@ lowersolve_h2matrix_2_avector(bool unit, pch2matrix a, pavector x)
 	coff2 += t->son[j - 1]->size;
 	x2 = init_sub_avector(&sub2, x, t->son[j]->size, coff2);
 
-	x1t = init_avector(&tmp1, a->son[i + j * sons]->rb->ktree);
-	x2t = init_avector(&tmp2, a->son[i + j * sons]->cb->ktree);
+	x1t = init_scratch_avector(&tmp1, a->son[i + j * sons]->rb->ktree);
+	x2t = init_scratch_avector(&tmp2, a->son[i + j * sons]->cb->ktree);
 	clear_avector(x2t);
 	forward_nopermutation_clusterbasis_avector(a->son[i + j * sons]->rb,
 						   x1, x1t);
@@ -1266,6 +1330,8 @@ lowersolve_h2matrix_2_avector(bool unit, pch2matrix a, pavector x)
 void
 lowersolve_h2matrix_avector(bool unit, bool atrans, pch2matrix a, pavector x)
 {
+  assert(!ismatrixfree_h2matrix(a));
+
   if (!atrans)
     lowersolve_h2matrix_1_avector(unit, a, x);
   else
@@ -1302,8 +1368,8 @@ uppersolve_h2matrix_1_avector(bool unit, pch2matrix a, pavector x)
 	roff2 -= t->son[j]->size;
 	x2 = init_sub_avector(&sub2, x, t->son[j]->size, roff2);
 
-	x1t = init_avector(&tmp1, a->son[j + i * sons]->cb->ktree);
-	x2t = init_avector(&tmp2, a->son[j + i * sons]->rb->ktree);
+	x1t = init_scratch_avector(&tmp1, a->son[j + i * sons]->cb->ktree);
+	x2t = init_scratch_avector(&tmp2, a->son[j + i * sons]->rb->ktree);
 	clear_avector(x2t);
 	forward_nopermutation_clusterbasis_avector(a->son[j + i * sons]->cb,
 						   x1, x1t);
@@ -1355,8 +1421,8 @@ uppersolve_h2matrix_2_avector(bool unit, pch2matrix a, pavector x)
 	coff2 -= t->son[j]->size;
 	x2 = init_sub_avector(&sub2, x, t->son[j]->size, coff2);
 
-	x1t = init_avector(&tmp1, a->son[i + j * sons]->rb->ktree);
-	x2t = init_avector(&tmp2, a->son[i + j * sons]->cb->ktree);
+	x1t = init_scratch_avector(&tmp1, a->son[i + j * sons]->rb->ktree);
+	x2t = init_scratch_avector(&tmp2, a->son[i + j * sons]->cb->ktree);
 	clear_avector(x2t);
 	forward_nopermutation_clusterbasis_avector(a->son[i + j * sons]->rb,
 						   x1, x1t);
@@ -1385,6 +1451,8 @@ uppersolve_h2matrix_2_avector(bool unit, pch2matrix a, pavector x)
 void
 uppersolve_h2matrix_avector(bool unit, bool atrans, pch2matrix a, pavector x)
 {
+  assert(!ismatrixfree_h2matrix(a));
+
   if (!atrans)
     uppersolve_h2matrix_1_avector(unit, a, x);
   else
@@ -1512,6 +1580,8 @@ void
 lowersolve_h2matrix_amatrix(bool unit, bool atrans, pch2matrix A,
 			    bool xtrans, pamatrix X)
 {
+  assert(!ismatrixfree_h2matrix(A));
+
   if (!atrans)
     lowersolve_h2matrix_1_amatrix(unit, A, xtrans, X);
   else
@@ -1645,6 +1715,8 @@ void
 uppersolve_h2matrix_amatrix(bool unit, bool atrans, pch2matrix A,
 			    bool xtrans, pamatrix X)
 {
+  assert(!ismatrixfree_h2matrix(A));
+
   if (!atrans)
     uppersolve_h2matrix_1_amatrix(unit, A, xtrans, X);
   else
@@ -1813,6 +1885,9 @@ lowersolve_amatrix_h2matrix(bool unit, bool atrans, pcamatrix A,
 			    pclusteroperator rwf, pclusteroperator cwf,
 			    ptruncmode tm, real tol)
 {
+  assert(!ismatrixfree_h2matrix(X));
+  assert(!ismatrixfree_h2matrix(Y));
+
   if (!atrans) {
     if (!xytrans)
       lowersolve_amatrix_1_h2matrix(unit, A, X, Y, rwf, cwf, tm, tol);
@@ -1978,6 +2053,8 @@ uppersolve_amatrix_h2matrix(bool unit, bool atrans, pcamatrix A,
 			    bool ytrans, ph2matrix Y, pclusteroperator rwf,
 			    pclusteroperator cwf, ptruncmode tm, real tol)
 {
+  assert(!ismatrixfree_h2matrix(Y));
+
   if (!atrans) {
     if (!ytrans)
       uppersolve_amatrix_1_h2matrix(unit, A, Y, rwf, cwf, tm, tol);
@@ -2243,6 +2320,10 @@ lowersolve_h2matrix(bool aunit, bool atrans, pch2matrix A,
 		    pclusteroperator xcwf, ph2matrix Y, pclusteroperator yrwf,
 		    pclusteroperator ycwf, ptruncmode tm, real tol)
 {
+  assert(!ismatrixfree_h2matrix(A));
+  assert(!ismatrixfree_h2matrix(X));
+  assert(!ismatrixfree_h2matrix(Y));
+
   if (!atrans) {
     if (!xytrans)
       lowersolve_h2matrix_1_h2matrix(aunit, A, X, xrwf, xcwf, Y, yrwf, ycwf,
@@ -2463,6 +2544,9 @@ uppersolve_h2matrix(bool aunit, bool atrans, pch2matrix A,
 		    bool ytrans, ph2matrix Y, pclusteroperator yrwf,
 		    pclusteroperator ycwf, ptruncmode tm, real tol)
 {
+  assert(!ismatrixfree_h2matrix(A));
+  assert(!ismatrixfree_h2matrix(Y));
+
   if (!atrans) {
     if (!ytrans)
       uppersolve_h2matrix_1_h2matrix(aunit, A, Y, yrwf, ycwf, tm, tol);
@@ -2497,6 +2581,10 @@ lrdecomp_h2matrix(ph2matrix X, pclusteroperator rwf, pclusteroperator cwf,
   assert(t == X->cb->t);
   assert(t == L->rb->t);
   assert(t == L->cb->t);
+  assert(!ismatrixfree_h2matrix(X));
+  assert(!ismatrixfree_h2matrix(L));
+  assert(!ismatrixfree_h2matrix(R));
+
   assert(t == R->rb->t);
   assert(t == R->cb->t);
 
@@ -2562,7 +2650,7 @@ lrsolve_h2matrix_avector(pch2matrix L, pch2matrix R, pavector x)
   /*assert(x->dim == h2->cb->t->size); */
 
   /* Permutation of x */
-  xp = init_avector(&xtmp, x->dim);
+  xp = init_scratch_avector(&xtmp, x->dim);
   for (i = 0; i < xp->dim; i++) {
     ip = L->cb->t->idx[i];
     assert(ip < x->dim);
@@ -2611,6 +2699,8 @@ choldecomp_h2matrix(ph2matrix A, pclusteroperator rwf,
   uint      i, j, l;
 
   assert(t == A->cb->t);
+  assert(!ismatrixfree_h2matrix(A));
+  assert(!ismatrixfree_h2matrix(L));
 
   if (A->son != 0) {
 
@@ -2664,7 +2754,7 @@ cholsolve_h2matrix_avector(pch2matrix h2, pavector x)
   assert(x->dim == h2->cb->t->size);
 
   /* Permutation of x */
-  xp = init_avector(&xtmp, x->dim);
+  xp = init_scratch_avector(&xtmp, x->dim);
   for (i = 0; i < xp->dim; i++) {
     ip = h2->cb->t->idx[i];
     assert(ip < x->dim);
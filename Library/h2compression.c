@@ -161,7 +161,7 @@ localweights1(pccluster t, uint tname, uint pardepth,
     }
 
     /* Allocate matrix */
-    X = init_amatrix(&tmp1, n, k);
+    X = init_scratch_amatrix(&tmp1, n, k);
 
     off = 0;
     for (hl0 = hl; hl0; hl0 = hl0->next) {
@@ -227,7 +227,7 @@ localweights1(pccluster t, uint tname, uint pardepth,
     }
 
     /* Allocate matrix */
-    X = init_amatrix(&tmp1, n, k);
+    X = init_scratch_amatrix(&tmp1, n, k);
 
     off = 0;
     for (hl0 = hl; hl0; hl0 = hl0->next) {
@@ -276,7 +276,7 @@ localweights1(pccluster t, uint tname, uint pardepth,
 
   /* Compute QR factorization */
   kmax = UINT_MIN(k, n);
-  tau = init_avector(&tmp3, kmax);
+  tau = init_scratch_avector(&tmp3, kmax);
   qrdecomp_amatrix(X, tau);
 
   /* Copy R into weight matrix */
@@ -393,7 +393,7 @@ localweights2(ph2matrix G, uint bname, uint rname, uint cname,
 
   /* W combines the old row weight and the current block */
   n = (cbw ? rlw->krow + cbw->krow : rlw->krow + cb->k);
-  W = init_amatrix(&tmp1, n, rb->k);
+  W = init_scratch_amatrix(&tmp1, n, rb->k);
 
   /* Copy old row weight to upper block of W */
   if (rlw->krow > 0) {
@@ -420,7 +420,7 @@ localweights2(ph2matrix G, uint bname, uint rname, uint cname,
 
   /* Compute QR factorization */
   k = UINT_MIN(rb->k, n);
-  tau = init_avector(&tmp3, k);
+  tau = init_scratch_avector(&tmp3, k);
   qrdecomp_amatrix(W, tau);
   uninit_avector(tau);
 
@@ -435,7 +435,7 @@ localweights2(ph2matrix G, uint bname, uint rname, uint cname,
 
   /* W combines the old row weight and the current block */
   n = (rbw ? clw->krow + rbw->krow : clw->krow + rb->k);
-  W = init_amatrix(&tmp1, n, cb->k);
+  W = init_scratch_amatrix(&tmp1, n, cb->k);
 
   /* Copy old column weight to upper block of W */
   if (clw->krow > 0) {
@@ -462,7 +462,7 @@ localweights2(ph2matrix G, uint bname, uint rname, uint cname,
 
   /* Compute QR factorization */
   k = UINT_MIN(cb->k, n);
-  tau = init_avector(&tmp3, k);
+  tau = init_scratch_avector(&tmp3, k);
   qrdecomp_amatrix(W, tau);
   uninit_avector(tau);
 
@@ -524,7 +524,7 @@ accumulate(pccluster t, uint tname, void *data)
       assert(lw->son[i]->kcol == cb->son[i]->k);
 
       /* w combines the son's local weight and the father's contribution */
-      w = init_amatrix(&tmp1, lw->son[i]->krow + lw->krow, cb->son[i]->k);
+      w = init_scratch_amatrix(&tmp1, lw->son[i]->krow + lw->krow, cb->son[i]->k);
 
       /* Copy son's local weight to upper block of w */
       w1 = init_sub_amatrix(&tmp2, w, lw->son[i]->krow, 0, cb->son[i]->k, 0);
@@ -541,7 +541,7 @@ accumulate(pccluster t, uint tname, void *data)
 
       /* Compute QR factorization */
       k = UINT_MIN(w->rows, w->cols);
-      tau = init_avector(&tmp3, k);
+      tau = init_scratch_avector(&tmp3, k);
       qrdecomp_amatrix(w, tau);
       uninit_avector(tau);
 
@@ -673,7 +673,7 @@ truncate_pre(pccluster t, uint tname, void *data)
       /* Combine inherited and local weight */
       n = k + clw->krow;
 
-      W = init_amatrix(&tmp1, n, kold);
+      W = init_scratch_amatrix(&tmp1, n, kold);
 
       W1 = init_sub_amatrix(&tmp2, W, k, 0, kold, 0);
       copy_amatrix(false, Wn + tname, W1);
@@ -685,7 +685,7 @@ truncate_pre(pccluster t, uint tname, void *data)
 
       /* Find QR decomposition */
       k = UINT_MIN(kold, n);
-      tau = init_avector(&tmp3, k);
+      tau = init_scratch_avector(&tmp3, k);
       qrdecomp_amatrix(W, tau);
 
       /* Copy R factor to Wn[tname] */
@@ -765,7 +765,7 @@ truncate_post(pccluster t, uint tname, void *data)
       m += cbnew->son[i]->k;
 
     /* Allocate Vhat */
-    Vhat = init_amatrix(&tmp1, m, kold);
+    Vhat = init_scratch_amatrix(&tmp1, m, kold);
 
     /* Fill submatrices */
     off = 0;
@@ -787,7 +787,7 @@ truncate_post(pccluster t, uint tname, void *data)
     m = cbold->t->size;
 
     /* Allocate Vhat */
-    Vhat = init_amatrix(&tmp1, m, kold);
+    Vhat = init_scratch_amatrix(&tmp1, m, kold);
 
     /* Copy directly from original basis */
     copy_amatrix(false, &cbold->V, Vhat);
@@ -807,7 +807,7 @@ truncate_post(pccluster t, uint tname, void *data)
       assert(Wn[tname].cols == kold);
 
       /* Copy cw->C and Wn[tname] into a block matrix */
-      X = init_amatrix(&tmp2, cw->krow + Wn[tname].rows, kold);
+      X = init_scratch_amatrix(&tmp2, cw->krow + Wn[tname].rows, kold);
 
       X1 = init_sub_amatrix(&tmp3, X, cw->krow, 0, kold, 0);
       copy_amatrix(false, &cw->C, X1);
@@ -819,11 +819,11 @@ truncate_post(pccluster t, uint tname, void *data)
 
       /* Compute QR factorization */
       k = UINT_MIN(X->rows, X->cols);
-      tau = init_avector(&tmp5, k);
+      tau = init_scratch_avector(&tmp5, k);
       qrdecomp_amatrix(X, tau);
 
       /* R factor is the new weight */
-      Z = init_amatrix(&tmp3, k, kold);
+      Z = init_scratch_amatrix(&tmp3, k, kold);
       copy_upper_amatrix(X, false, Z);
 
       /* Clean up intermediate matrices */
@@ -831,7 +831,7 @@ truncate_post(pccluster t, uint tname, void *data)
       uninit_amatrix(X);
 
       /* Multiply Vhat by Z */
-      VhatZ = init_amatrix(&tmp2, m, k);
+      VhatZ = init_scratch_amatrix(&tmp2, m, k);
       clear_amatrix(VhatZ);
       addmul_amatrix(1.0, false, Vhat, true, Z, VhatZ);
 
@@ -840,7 +840,7 @@ truncate_post(pccluster t, uint tname, void *data)
     }
     else {
       /* Multiply Vhat by cw->C */
-      VhatZ = init_amatrix(&tmp2, m, cw->krow);
+      VhatZ = init_scratch_amatrix(&tmp2, m, cw->krow);
       clear_amatrix(VhatZ);
       addmul_amatrix(1.0, false, Vhat, true, &cw->C, VhatZ);
     }
@@ -850,13 +850,13 @@ truncate_post(pccluster t, uint tname, void *data)
       assert(Wn[tname].cols == kold);
 
       /* Multiply Vhat by Wn[tname] */
-      VhatZ = init_amatrix(&tmp2, m, Wn[tname].rows);
+      VhatZ = init_scratch_amatrix(&tmp2, m, Wn[tname].rows);
       clear_amatrix(VhatZ);
       addmul_amatrix(1.0, false, Vhat, true, Wn + tname, VhatZ);
     }
     else {
       /* No weighting, VhatZ equals Vhat */
-      VhatZ = init_amatrix(&tmp2, m, kold);
+      VhatZ = init_scratch_amatrix(&tmp2, m, kold);
       copy_amatrix(false, Vhat, VhatZ);
     }
   }
@@ -867,8 +867,8 @@ truncate_post(pccluster t, uint tname, void *data)
    */
 
   kmax = UINT_MIN(m, VhatZ->cols);
-  Q = init_amatrix(&tmp3, m, kmax);
-  sigma = init_realavector(&tmp4, kmax);
+  Q = init_scratch_amatrix(&tmp3, m, kmax);
+  sigma = init_scratch_realavector(&tmp4, kmax);
   svd_amatrix(VhatZ, sigma, Q, 0);
 
   /* Determine new rank */
@@ -1075,14 +1075,14 @@ norm2_product(bool Strans, pcamatrix S, pcamatrix R)
     if (Strans) {
       assert(S->rows == R->cols);
 
-      Z = init_amatrix(&tmp, S->cols, R->rows);
+      Z = init_scratch_amatrix(&tmp, S->cols, R->rows);
       clear_amatrix(Z);
       addmul_amatrix(1.0, true, S, true, R, Z);
     }
     else {
       assert(S->cols == R->cols);
 
-      Z = init_amatrix(&tmp, S->rows, R->rows);
+      Z = init_scratch_amatrix(&tmp, S->rows, R->rows);
       clear_amatrix(Z);
       addmul_amatrix(1.0, false, S, true, R, Z);
     }
@@ -1108,14 +1108,14 @@ normfrob_product(bool Strans, pcamatrix S, pcamatrix R)
     if (Strans) {
       assert(S->rows == R->cols);
 
-      Z = init_amatrix(&tmp, S->cols, R->rows);
+      Z = init_scratch_amatrix(&tmp, S->cols, R->rows);
       clear_amatrix(Z);
       addmul_amatrix(1.0, true, S, true, R, Z);
     }
     else {
       assert(S->cols == R->cols);
 
-      Z = init_amatrix(&tmp, S->rows, R->rows);
+      Z = init_scratch_amatrix(&tmp, S->rows, R->rows);
       clear_amatrix(Z);
       addmul_amatrix(1.0, false, S, true, R, Z);
     }
@@ -1190,7 +1190,7 @@ computebasis_pre(pccluster t, uint tname, uint pardepth,
     }
 
     /* Create Zhat */
-    Zhat = init_amatrix(&tmp1, n, cbold->k);
+    Zhat = init_scratch_amatrix(&tmp1, n, cbold->k);
 
     /* Copy inherited part */
     Zhat1 = init_sub_amatrix(&tmp2, Zhat, Z[tname].rows, 0, Z[tname].cols, 0);
@@ -1274,7 +1274,7 @@ computebasis_pre(pccluster t, uint tname, uint pardepth,
     }
 
     /* Create Zhat */
-    Zhat = init_amatrix(&tmp1, n, cbold->k);
+    Zhat = init_scratch_amatrix(&tmp1, n, cbold->k);
 
     /* Copy inherited part */
     Zhat1 = init_sub_amatrix(&tmp2, Zhat, Z[tname].rows, 0, Z[tname].cols, 0);
@@ -1338,7 +1338,7 @@ computebasis_pre(pccluster t, uint tname, uint pardepth,
 
   /* Compute QR decomposition of Zhat */
   k = UINT_MIN(n, cbold->k);
-  tau = init_avector(&tmp3, k);
+  tau = init_scratch_avector(&tmp3, k);
   qrdecomp_amatrix(Zhat, tau);
   uninit_avector(tau);
 
@@ -1421,7 +1421,7 @@ computebasis_post(pccluster t, uint tname, uint pardepth,
     for (i = 0; i < cbold->sons; i++)
       m += cbnew->son[i]->k;
 
-    Vhat = init_amatrix(&tmp1, m, cbold->k);
+    Vhat = init_scratch_amatrix(&tmp1, m, cbold->k);
 
     off = 0;
     for (i = 0; i < cbold->sons; i++) {
@@ -1441,22 +1441,22 @@ computebasis_post(pccluster t, uint tname, uint pardepth,
   else {
     m = t->size;
 
-    Vhat = init_amatrix(&tmp1, m, cbold->k);
+    Vhat = init_scratch_amatrix(&tmp1, m, cbold->k);
 
     copy_amatrix(false, &cbold->V, Vhat);
   }
 
   /* Multiply by weight matrix */
   assert(Z[tname].cols == cbold->k);
-  VhatZ = init_amatrix(&tmp2, m, Z[tname].rows);
+  VhatZ = init_scratch_amatrix(&tmp2, m, Z[tname].rows);
 
   clear_amatrix(VhatZ);
   addmul_amatrix(1.0, false, Vhat, true, Z + tname, VhatZ);
 
   /* Compute singular value decomposition */
   kmax = UINT_MIN(m, Z[tname].rows);
-  Q = init_amatrix(&tmp3, m, kmax);
-  sigma = init_realavector(&tmp5, kmax);
+  Q = init_scratch_amatrix(&tmp3, m, kmax);
+  sigma = init_scratch_realavector(&tmp5, kmax);
   svd_amatrix(VhatZ, sigma, Q, 0);
 
   /* Determine new rank */
@@ -1763,7 +1763,7 @@ orthoweight_clusterbasis(pclusterbasis cb)
     assert(m <= roff);
     assert(roff == cb->t->size);
 
-    Vhat = init_amatrix(&tmp1, m, cb->k);
+    Vhat = init_scratch_amatrix(&tmp1, m, cb->k);
 
     off = 0;
     for (i = 0; i < sons; i++) {
@@ -1782,14 +1782,14 @@ orthoweight_clusterbasis(pclusterbasis cb)
     assert(sons == 0);
     m = cb->t->size;
 
-    Vhat = init_amatrix(&tmp1, m, cb->k);
+    Vhat = init_scratch_amatrix(&tmp1, m, cb->k);
 
     copy_amatrix(false, &cb->V, Vhat);
   }
 
   refl = UINT_MIN(m, cb->k);
 
-  tau = init_avector(&tmp3, refl);
+  tau = init_scratch_avector(&tmp3, refl);
   qrdecomp_amatrix(Vhat, tau);
 
   assert(cb->Z == NULL);
@@ -1840,7 +1840,7 @@ totalweight_row_clusteroperator(pclusterbasis rb, pclusteroperator rw,
       /* cols of Yhat */
       cols = son->k;
 
-      Yhat = init_amatrix(&tmp1, rows, cols);
+      Yhat = init_scratch_amatrix(&tmp1, rows, cols);
 
       assert(rw->kcol == son->E.cols);
       Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, son->k, 0);
@@ -1876,7 +1876,7 @@ totalweight_row_clusteroperator(pclusterbasis rb, pclusteroperator rw,
 
       refl = UINT_MIN(rows, cols);
 
-      tau = init_avector(&tmp4, refl);
+      tau = init_scratch_avector(&tmp4, refl);
       qrdecomp_amatrix(Yhat, tau);
 
       resize_clusteroperator(rw->son[i], refl, cols);
@@ -1933,7 +1933,7 @@ totalweight_col_clusteroperator(pclusterbasis cb, pclusteroperator cw,
       /* cols of Yhat */
       cols = son->k;
 
-      Yhat = init_amatrix(&tmp1, rows, cols);
+      Yhat = init_scratch_amatrix(&tmp1, rows, cols);
 
       assert(cw->kcol == son->E.cols);
       Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, son->k, 0);
@@ -1969,7 +1969,7 @@ totalweight_col_clusteroperator(pclusterbasis cb, pclusteroperator cw,
 
       refl = UINT_MIN(rows, cols);
 
-      tau = init_avector(&tmp4, refl);
+      tau = init_scratch_avector(&tmp4, refl);
       qrdecomp_amatrix(Yhat, tau);
 
       resize_clusteroperator(cw->son[i], refl, cols);
@@ -2005,7 +2005,7 @@ truncate_inplace_clusterbasis(pclusterbasis cb, pclusteroperator cw,
   if (cb->sons == 0) {
     /* In son clusters, we have Vhat = (V A) */
     m = cb->t->size;
-    Vhat = init_amatrix(&tmp1, cb->t->size, cb->k);
+    Vhat = init_scratch_amatrix(&tmp1, cb->t->size, cb->k);
     copy_amatrix(false, &cb->V, Vhat);
   }
   else {
@@ -2021,7 +2021,7 @@ truncate_inplace_clusterbasis(pclusterbasis cb, pclusteroperator cw,
       m += cb->son[i]->k;
     }
 
-    Vhat = init_amatrix(&tmp1, m, cb->k);
+    Vhat = init_scratch_amatrix(&tmp1, m, cb->k);
 
     /* Blocks of Vhat are (R_{t'|...}E_{t'}   (R_{t'|...}) for sons t' */
     off = 0;
@@ -2040,14 +2040,14 @@ truncate_inplace_clusterbasis(pclusterbasis cb, pclusteroperator cw,
   VhatZ = 0;
 
   /* Multiply by weight matrix */
-  VhatZ = init_amatrix(&tmp2, Vhat->rows, cw->krow);
+  VhatZ = init_scratch_amatrix(&tmp2, Vhat->rows, cw->krow);
   clear_amatrix(VhatZ);
   addmul_amatrix(1.0, false, Vhat, true, &cw->C, VhatZ);
 
   /* Compute singular value decomposition of VhatZ */
   k = UINT_MIN(VhatZ->rows, VhatZ->cols);
-  Q = init_amatrix(&tmp3, VhatZ->rows, VhatZ->cols);
-  sigma = init_realavector(&tmp4, k);
+  Q = init_scratch_amatrix(&tmp3, VhatZ->rows, VhatZ->cols);
+  sigma = init_scratch_realavector(&tmp4, k);
   svd_amatrix(VhatZ, sigma, Q, 0);
   uninit_amatrix(VhatZ);
 
@@ -2382,7 +2382,7 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
     freemem(tb1);
 
     /* Compute Vhat */
-    Vhat = init_amatrix(&tmp1, m, n);
+    Vhat = init_scratch_amatrix(&tmp1, m, n);
     coff = 0;
     for (tb2 = tb; tb2; tb2 = tb2->next) {
       if (tb2->cb->sons == 0) {
@@ -2430,7 +2430,7 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
   else {
     /* In leaf clusters, we have Vhat = V */
     m = t->size;
-    Vhat = init_amatrix(&tmp1, m, n);
+    Vhat = init_scratch_amatrix(&tmp1, m, n);
     coff = 0;
     for (tb2 = tb; tb2; tb2 = tb2->next) {
       Vhat1 = init_sub_amatrix(&tmp2, Vhat, m, 0, tb2->cb->k, coff);
@@ -2443,7 +2443,7 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
   }
 
   /* Multiply by weight matrices */
-  VhatZ = init_amatrix(&tmp2, m, nw);
+  VhatZ = init_scratch_amatrix(&tmp2, m, nw);
   coff = coffw = 0;
   for (tb2 = tb; tb2; tb2 = tb2->next) {
     Vhat1 = init_sub_amatrix(&tmp3, Vhat, m, 0, tb2->cb->k, coff);
@@ -2477,8 +2477,8 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
 
   /* Compute singular value decomposition of VhatZ */
   k = UINT_MIN(m, nw);
-  Q = init_amatrix(&tmp3, m, k);
-  sigma = init_realavector(&tmp6, k);
+  Q = init_scratch_amatrix(&tmp3, m, k);
+  sigma = init_scratch_realavector(&tmp6, k);
   svd_amatrix(VhatZ, sigma, Q, 0);
   uninit_amatrix(VhatZ);
 
@@ -2535,7 +2535,7 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
 
   /* Compute total weight matrix */
   if (cw) {
-    W = init_amatrix(&tmp1, nw, k);
+    W = init_scratch_amatrix(&tmp1, nw, k);
     roff = 0;
     for (tb2 = tb; tb2; tb2 = tb2->next)
       if (tb2->cw) {
@@ -2554,7 +2554,7 @@ unify_parallel_clusterbasis(pccluster t, ptruncblock tb,
       }
     assert(roff == nw);
 
-    tau = init_avector(&tmp5, k);
+    tau = init_scratch_avector(&tmp5, k);
     qrdecomp_amatrix(W, tau);
 
     resize_clusteroperator(*cw, UINT_MIN(k, nw), k);
@@ -2914,11 +2914,11 @@ convert_rkmatrix_uniform(pcrkmatrix r, puniform u, pctruncmode tm,
   ref_col_uniform(u, cb);
   resize_amatrix(&u->S, k, k);
 
-  tau = init_avector(&tmp4, r->k);
+  tau = init_scratch_avector(&tmp4, r->k);
 
   if (kr <= kc) {
     /* Copy A */
-    Ac = init_amatrix(&tmp1, r->A.rows, r->A.cols);
+    Ac = init_scratch_amatrix(&tmp1, r->A.rows, r->A.cols);
     copy_amatrix(false, &r->A, Ac);
 
     /* Compute A = Q_A R_A */
@@ -2929,7 +2929,7 @@ convert_rkmatrix_uniform(pcrkmatrix r, puniform u, pctruncmode tm,
     qrexpand_amatrix(Ac, tau, &rb->V);
 
     /* Copy B */
-    Bc = init_amatrix(&tmp2, r->B.rows, r->B.cols);
+    Bc = init_scratch_amatrix(&tmp2, r->B.rows, r->B.cols);
     copy_amatrix(false, &r->B, Bc);
 
     /* Compute C^* = R_A B^*, i.e., C = B R_A^* */
@@ -2945,7 +2945,7 @@ convert_rkmatrix_uniform(pcrkmatrix r, puniform u, pctruncmode tm,
     qrexpand_amatrix(C, tau, &cb->V);
 
     /* R_C is the row weight matrix... */
-    W = init_amatrix(&tmp3, k, k);
+    W = init_scratch_amatrix(&tmp3, k, k);
     copy_upper_amatrix(C, false, W);
     if (rw) {
       *rw = new_leaf_clusteroperator(rc);
@@ -2968,7 +2968,7 @@ convert_rkmatrix_uniform(pcrkmatrix r, puniform u, pctruncmode tm,
   }
   else {
     /* Copy B */
-    Bc = init_amatrix(&tmp1, r->B.rows, r->B.cols);
+    Bc = init_scratch_amatrix(&tmp1, r->B.rows, r->B.cols);
     copy_amatrix(false, &r->B, Bc);
 
     /* Compute B = Q_B R_B */
@@ -2979,7 +2979,7 @@ convert_rkmatrix_uniform(pcrkmatrix r, puniform u, pctruncmode tm,
     qrexpand_amatrix(Bc, tau, &cb->V);
 
     /* Copy A */
-    Ac = init_amatrix(&tmp2, r->A.rows, r->A.cols);
+    Ac = init_scratch_amatrix(&tmp2, r->A.rows, r->A.cols);
     copy_amatrix(false, &r->A, Ac);
 
     /* Compute C^* = R_B A^*, i.e., C = A R_B^* */
@@ -3122,18 +3122,18 @@ addrow_hcomp(pccluster rc, pchmatrix hm, pctruncmode tm,
     assert(hm->r->B.cols == hm->r->k);
 
     /* Copy B part of the rkmatrix */
-    R = init_amatrix(&tmp1, hm->cc->size, hm->r->k);
+    R = init_scratch_amatrix(&tmp1, hm->cc->size, hm->r->k);
     copy_amatrix(false, &hm->r->B, R);
 
     /* Compute QR factorization B=QR */
     k = UINT_MIN(hm->cc->size, hm->r->k);
-    tau = init_avector(&tmp4, k);
+    tau = init_scratch_avector(&tmp4, k);
     qrdecomp_amatrix(R, tau);
     uninit_avector(tau);
 
     /* Multiply A by R^* */
     R1 = init_sub_amatrix(&tmp2, R, k, 0, hm->r->k, 0);
-    Ahat = init_amatrix(&tmp3, hm->rc->size, hm->r->k);
+    Ahat = init_scratch_amatrix(&tmp3, hm->rc->size, hm->r->k);
     copy_amatrix(false, &hm->r->A, Ahat);
     triangulareval_amatrix(false, false, false, R1, true, Ahat);
     uninit_amatrix(R1);
@@ -3203,18 +3203,18 @@ addcol_hcomp(pccluster cc, pchmatrix hm, pctruncmode tm,
     assert(hm->r->B.cols == hm->r->k);
 
     /* Copy A part of the rkmatrix */
-    R = init_amatrix(&tmp1, hm->rc->size, hm->r->k);
+    R = init_scratch_amatrix(&tmp1, hm->rc->size, hm->r->k);
     copy_amatrix(false, &hm->r->A, R);
 
     /* Compute QR factorization A=QR */
     k = UINT_MIN(hm->rc->size, hm->r->k);
-    tau = init_avector(&tmp4, k);
+    tau = init_scratch_avector(&tmp4, k);
     qrdecomp_amatrix(R, tau);
     uninit_avector(tau);
 
     /* Multiply B by R^* */
     R1 = init_sub_amatrix(&tmp2, R, k, 0, hm->r->k, 0);
-    Bhat = init_amatrix(&tmp3, hm->cc->size, hm->r->k);
+    Bhat = init_scratch_amatrix(&tmp3, hm->cc->size, hm->r->k);
     copy_amatrix(false, &hm->r->B, Bhat);
     triangulareval_amatrix(false, false, false, R1, true, Bhat);
     uninit_amatrix(R1);
@@ -3306,7 +3306,7 @@ buildbasis_hcomp(pccluster t, bool colbasis,
     assert(off == t->size);
 
     for (ha = active; ha; ha = ha->next) {
-      Ahat = init_amatrix(&tmp1, m, ha->A.cols);
+      Ahat = init_scratch_amatrix(&tmp1, m, ha->A.cols);
 
       /* Combine projections of son's submatrices */
       off = 0;
@@ -3351,7 +3351,7 @@ buildbasis_hcomp(pccluster t, bool colbasis,
   }
 
   /* Combine submatrices */
-  Ahat = init_amatrix(&tmp1, m, n);
+  Ahat = init_scratch_amatrix(&tmp1, m, n);
   n = 0;
   for (ha = active; ha; ha = ha->next) {
     Ahat0 = init_sub_amatrix(&tmp2, Ahat, m, 0, ha->A.cols, n);
@@ -3367,8 +3367,8 @@ buildbasis_hcomp(pccluster t, bool colbasis,
 
   /* Compute singular value decomposition */
   k = UINT_MIN(m, n);
-  Q = init_amatrix(&tmp2, m, n);
-  sigma = init_realavector(&tmp5, k);
+  Q = init_scratch_amatrix(&tmp2, m, n);
+  sigma = init_scratch_realavector(&tmp5, k);
   svd_amatrix(Ahat, sigma, Q, 0);
   uninit_amatrix(Ahat);
 
@@ -3408,7 +3408,7 @@ buildbasis_hcomp(pccluster t, bool colbasis,
   Q1 = init_sub_amatrix(&tmp1, Q, m, 0, k, 0);
   for (ha = active; ha; ha = ha->next) {
     /* Copy original matrix */
-    Ahat = init_amatrix(&tmp3, m, ha->A.cols);
+    Ahat = init_scratch_amatrix(&tmp3, m, ha->A.cols);
     copy_sub_amatrix(false, &ha->A, Ahat);
 
     /* Pick submatrix for result */
@@ -3784,7 +3784,7 @@ buildbasis_comp(pccluster t, bool colbasis,
     assert(off == t->size);
 
     for (ca = active; ca; ca = ca->next) {
-      Ahat = init_amatrix(&tmp1, m, ca->A.cols);
+      Ahat = init_scratch_amatrix(&tmp1, m, ca->A.cols);
 
       /* Combine projections of son's submatrices */
       off = 0;
@@ -3829,7 +3829,7 @@ buildbasis_comp(pccluster t, bool colbasis,
   }
 
   /* Combine submatrices */
-  Ahat = init_amatrix(&tmp1, m, n);
+  Ahat = init_scratch_amatrix(&tmp1, m, n);
   n = 0;
   for (ca = active; ca; ca = ca->next) {
     Ahat0 = init_sub_amatrix(&tmp2, Ahat, m, 0, ca->A.cols, n);
@@ -3845,8 +3845,8 @@ buildbasis_comp(pccluster t, bool colbasis,
 
   /* Compute singular value decomposition */
   k = UINT_MIN(m, n);
-  Q = init_amatrix(&tmp2, m, n);
-  sigma = init_realavector(&tmp5, k);
+  Q = init_scratch_amatrix(&tmp2, m, n);
+  sigma = init_scratch_realavector(&tmp5, k);
   svd_amatrix(Ahat, sigma, Q, 0);
   uninit_amatrix(Ahat);
 
@@ -3886,7 +3886,7 @@ buildbasis_comp(pccluster t, bool colbasis,
   Q1 = init_sub_amatrix(&tmp3, Q, m, 0, k, 0);
   for (ca = active; ca; ca = ca->next) {
     /* Copy original matrix */
-    Ahat = init_amatrix(&tmp1, m, ca->A.cols);
+    Ahat = init_scratch_amatrix(&tmp1, m, ca->A.cols);
     copy_sub_amatrix(false, &ca->A, Ahat);
 
     /* Pick submatrix for result */
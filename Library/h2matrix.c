@@ -31,6 +31,8 @@ new_h2matrix(pclusterbasis rb, pclusterbasis cb)
   ref_clusterbasis(&h2->cb, cb);
   h2->u = NULL;
   h2->f = NULL;
+  h2->fill = NULL;
+  h2->filldata = NULL;
 
   h2->son = NULL;
   h2->rsons = 0;
@@ -39,6 +41,8 @@ new_h2matrix(pclusterbasis rb, pclusterbasis cb)
   h2->refs = 0;
   h2->desc = 0;
 
+  h2->arena = NULL;
+
   return h2;
 }
 
@@ -70,6 +74,22 @@ new_full_h2matrix(pclusterbasis rb, pclusterbasis cb)
   return h2;
 }
 
+ph2matrix
+new_matrixfree_h2matrix(pclusterbasis rb, pclusterbasis cb, fillblock_t fill,
+			void *data)
+{
+  ph2matrix h2;
+
+  h2 = new_h2matrix(rb, cb);
+
+  h2->fill = fill;
+  h2->filldata = data;
+
+  h2->desc = 1;
+
+  return h2;
+}
+
 ph2matrix
 new_super_h2matrix(pclusterbasis rb, pclusterbasis cb, uint rsons, uint csons)
 {
@@ -152,6 +172,8 @@ clonestructure_h2matrix(pch2matrix h2, pclusterbasis rb, pclusterbasis cb)
     h = new_full_h2matrix(rb, cb);
     clear_amatrix(h->f);
   }
+  else if (h2->fill)
+    h = new_matrixfree_h2matrix(rb, cb, h2->fill, h2->filldata);
   else
     h = new_zero_h2matrix(rb, cb);
 
@@ -204,6 +226,9 @@ clone_h2matrix(pch2matrix h2, pclusterbasis rb, pclusterbasis cb)
     h2clone = new_full_h2matrix(rb, cb);
     copy_amatrix(false, h2->f, h2clone->f);
   }
+  else if (h2->fill != NULL) {
+    h2clone = new_matrixfree_h2matrix(rb, cb, h2->fill, h2->filldata);
+  }
   else {
     h2clone = new_zero_h2matrix(rb, cb);
   }
@@ -237,6 +262,7 @@ update_h2matrix(ph2matrix h2)
 void
 del_h2matrix(ph2matrix h2)
 {
+  parena    a;
   uint      rsons = h2->rsons;
   uint      csons = h2->csons;
   uint      i, j;
@@ -259,7 +285,12 @@ del_h2matrix(ph2matrix h2)
   unref_clusterbasis(h2->cb);
   unref_clusterbasis(h2->rb);
 
+  a = h2->arena;
+
   freemem(h2);
+
+  if (a)
+    del_arena(a);
 }
 
 /* ------------------------------------------------------------
@@ -356,6 +387,21 @@ getfarsize_h2matrix(pch2matrix h2)
   return sz;
 }
 
+bool
+ismatrixfree_h2matrix(pch2matrix h2)
+{
+  uint      i;
+
+  if (h2->fill)
+    return true;
+
+  for (i = 0; i < h2->rsons * h2->csons; i++)
+    if (ismatrixfree_h2matrix(h2->son[i]))
+      return true;
+
+  return false;
+}
+
 /* ------------------------------------------------------------
  * Simple utility functions
  * ------------------------------------------------------------ */
@@ -375,11 +421,37 @@ clear_h2matrix(ph2matrix h2)
 	clear_h2matrix(h2->son[i + j * rsons]);
   }
   else if (h2->u)
-    clear_amatrix(&h2->u->S);
+    clear_uniform(h2->u);
   else if (h2->f)
     clear_amatrix(h2->f);
 }
 
+void
+compress_h2matrix(pctruncmode tm, real eps, ph2matrix h2)
+{
+  uint      i;
+
+  if (h2->son) {
+    for (i = 0; i < h2->rsons * h2->csons; i++)
+      compress_h2matrix(tm, eps, h2->son[i]);
+  }
+  else if (h2->u && h2->u->CS == NULL)
+    compress_uniform(tm, eps, h2->u);
+}
+
+void
+decompress_h2matrix(ph2matrix h2)
+{
+  uint      i;
+
+  if (h2->son) {
+    for (i = 0; i < h2->rsons * h2->csons; i++)
+      decompress_h2matrix(h2->son[i]);
+  }
+  else if (h2->u)
+    decompress_uniform(h2->u);
+}
+
 /* ------------------------------------------------------------
  * Build H^2-matrix based on block tree
  * ------------------------------------------------------------ */
@@ -432,6 +504,126 @@ build_from_block_h2matrix(pcblock b, pclusterbasis rb, pclusterbasis cb)
   return h;
 }
 
+ph2matrix
+build_from_block_arena_h2matrix(pcblock b, pclusterbasis rb,
+				pclusterbasis cb)
+{
+  ph2matrix h;
+  parena    a, old;
+
+  a = new_arena(0);
+  old = select_arena(a);
+
+  h = build_from_block_h2matrix(b, rb, cb);
+
+  (void) select_arena(old);
+
+  h->arena = a;
+
+  return h;
+}
+
+ph2matrix
+build_from_block_matrixfree_h2matrix(pcblock b, pclusterbasis rb,
+				     pclusterbasis cb, fillblock_t fill,
+				     void *data)
+{
+  ph2matrix h, h1;
+  pcblock   b1;
+  pclusterbasis rb1, cb1;
+  uint      rsons, csons;
+  uint      i, j;
+
+  h = NULL;
+
+  if (b->son) {
+    rsons = b->rsons;
+    csons = b->csons;
+
+    h = new_super_h2matrix(rb, cb, rsons, csons);
+
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++) {
+	b1 = b->son[i + j * rsons];
+
+	rb1 = rb;
+	if (b1->rc != b->rc) {
+	  assert(rb->sons == rsons);
+	  rb1 = rb->son[i];
+	}
+
+	cb1 = cb;
+	if (b1->cc != b->cc) {
+	  assert(cb->sons == csons);
+	  cb1 = cb->son[j];
+	}
+
+	h1 = build_from_block_matrixfree_h2matrix(b1, rb1, cb1, fill, data);
+
+	ref_h2matrix(h->son + i + j * rsons, h1);
+      }
+  }
+  else if (b->a > 0)
+    h = new_uniform_h2matrix(rb, cb);
+  else
+    h = new_matrixfree_h2matrix(rb, cb, fill, data);
+
+  update_h2matrix(h);
+
+  return h;
+}
+
+ph2matrix
+build_from_block_cutoff_h2matrix(pcblock b, pclusterbasis rb,
+				 pclusterbasis cb, real cutoff)
+{
+  ph2matrix h, h1;
+  pcblock   b1;
+  pclusterbasis rb1, cb1;
+  uint      rsons, csons;
+  uint      i, j;
+
+  h = NULL;
+
+  if (b->son) {
+    rsons = b->rsons;
+    csons = b->csons;
+
+    h = new_super_h2matrix(rb, cb, rsons, csons);
+
+    for (j = 0; j < csons; j++)
+      for (i = 0; i < rsons; i++) {
+	b1 = b->son[i + j * rsons];
+
+	rb1 = rb;
+	if (b1->rc != b->rc) {
+	  assert(rb->sons == rsons);
+	  rb1 = rb->son[i];
+	}
+
+	cb1 = cb;
+	if (b1->cc != b->cc) {
+	  assert(cb->sons == csons);
+	  cb1 = cb->son[j];
+	}
+
+	h1 = build_from_block_cutoff_h2matrix(b1, rb1, cb1, cutoff);
+
+	ref_h2matrix(h->son + i + j * rsons, h1);
+      }
+  }
+  else if (getdist_max_cluster(b->rc, b->cc) >= cutoff)
+    h = new_zero_h2matrix(rb, cb);
+  else if (b->a > 0)
+    h = new_uniform_h2matrix(rb, cb);
+  else
+    h = new_full_h2matrix(rb, cb);
+
+  update_h2matrix(h);
+
+  return h;
+}
+
 /* ------------------------------------------------------------
  * Build block tree from H^2-matrix
  * ------------------------------------------------------------ */
@@ -1181,11 +1373,13 @@ fastaddeval_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   pcclusterbasis cb = h2->cb;
   uint      rsons = h2->rsons;
   uint      csons = h2->csons;
+  pamatrix  N;
+  amatrix   tmp;
   uint      xtoff, ytoff;
   uint      i, j;
 
   if (h2->u) {
-    addeval_amatrix_avector(alpha, &h2->u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, false, h2->u, xt, yt);
   }
   else if (h2->f) {
     xp = init_sub_avector(&loc1, xt, cb->t->size, cb->k);
@@ -1196,6 +1390,19 @@ fastaddeval_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
     uninit_avector(yp);
     uninit_avector(xp);
   }
+  else if (h2->fill) {
+    xp = init_sub_avector(&loc1, xt, cb->t->size, cb->k);
+    yp = init_sub_avector(&loc2, yt, rb->t->size, rb->k);
+
+    N = init_amatrix(&tmp, rb->t->size, cb->t->size);
+    h2->fill(rb->t->idx, cb->t->idx, h2->filldata, N);
+
+    addeval_amatrix_avector(alpha, N, xp, yp);
+
+    uninit_amatrix(N);
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
   else if (h2->son) {
     xtoff = cb->k;
     for (j = 0; j < csons; j++) {
@@ -1259,11 +1466,13 @@ fastaddevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
   pcclusterbasis cb = h2->cb;
   uint      rsons = h2->rsons;
   uint      csons = h2->csons;
+  pamatrix  N;
+  amatrix   tmp;
   uint      xtoff, ytoff;
   uint      i, j;
 
   if (h2->u) {
-    addevaltrans_amatrix_avector(alpha, &h2->u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, h2->u, xt, yt);
   }
   else if (h2->f) {
     xp = init_sub_avector(&loc1, xt, rb->t->size, rb->k);
@@ -1274,6 +1483,19 @@ fastaddevaltrans_h2matrix_avector(field alpha, pch2matrix h2, pavector xt,
     uninit_avector(yp);
     uninit_avector(xp);
   }
+  else if (h2->fill) {
+    xp = init_sub_avector(&loc1, xt, rb->t->size, rb->k);
+    yp = init_sub_avector(&loc2, yt, cb->t->size, cb->k);
+
+    N = init_amatrix(&tmp, rb->t->size, cb->t->size);
+    h2->fill(rb->t->idx, cb->t->idx, h2->filldata, N);
+
+    addevaltrans_amatrix_avector(alpha, N, xp, yp);
+
+    uninit_amatrix(N);
+    uninit_avector(yp);
+    uninit_avector(xp);
+  }
   else if (h2->son) {
     ytoff = cb->k;
     for (j = 0; j < csons; j++) {
@@ -1332,8 +1554,10 @@ addevalsymm_offdiag(field alpha, pch2matrix h2, pavector xt,
 		    pavector xta, pavector yt, pavector yta)
 {
   avector   tmp1, tmp2, tmp3, tmp4;
+  amatrix   tmp5;
   pavector  xp, yp;
   pavector  xt1, xta1, yt1, yta1;
+  pamatrix  f;
   pcclusterbasis rb = h2->rb;
   pcclusterbasis cb = h2->cb;
   uint      rsons, csons;
@@ -1345,11 +1569,18 @@ addevalsymm_offdiag(field alpha, pch2matrix h2, pavector xt,
   assert(yt->dim == h2->rb->ktree);
   assert(yta->dim == h2->cb->ktree);
 
-  if (h2->f) {
+  if (h2->f || h2->fill) {
+    /* Matrix-free leaves are computed once for both products */
+    f = h2->f;
+    if (f == NULL) {
+      f = init_amatrix(&tmp5, rb->t->size, cb->t->size);
+      h2->fill(rb->t->idx, cb->t->idx, h2->filldata, f);
+    }
+
     xp = init_sub_avector(&tmp1, xt, cb->t->size, cb->k);
     yp = init_sub_avector(&tmp2, yt, rb->t->size, rb->k);
 
-    addeval_amatrix_avector(alpha, h2->f, xp, yp);
+    addeval_amatrix_avector(alpha, f, xp, yp);
 
     uninit_avector(yp);
     uninit_avector(xp);
@@ -1357,14 +1588,17 @@ addevalsymm_offdiag(field alpha, pch2matrix h2, pavector xt,
     xp = init_sub_avector(&tmp1, xta, rb->t->size, rb->k);
     yp = init_sub_avector(&tmp2, yta, cb->t->size, cb->k);
 
-    addevaltrans_amatrix_avector(alpha, h2->f, xp, yp);
+    addevaltrans_amatrix_avector(alpha, f, xp, yp);
 
     uninit_avector(yp);
     uninit_avector(xp);
+
+    if (f != h2->f)
+      uninit_amatrix(f);
   }
   else if (h2->u) {
-    addeval_amatrix_avector(alpha, &h2->u->S, xt, yt);
-    addevaltrans_amatrix_avector(alpha, &h2->u->S, xta, yta);
+    mvm_coupling_uniform_avector(alpha, false, h2->u, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, h2->u, xta, yta);
   }
   else {
     assert(h2->son != 0);
@@ -1426,8 +1660,10 @@ addevalsymm_diag(field alpha, pch2matrix h2, pavector xt,
 		 pavector xta, pavector yt, pavector yta)
 {
   avector   tmp1, tmp2, tmp3, tmp4;
+  amatrix   tmp5;
   pavector  xt1, xta1, yt1, yta1;
   pavector  xp, yp;
+  pamatrix  f;
   pcclusterbasis rb = h2->rb;
   pcclusterbasis cb = h2->cb;
   pfield    aa;
@@ -1442,9 +1678,15 @@ addevalsymm_diag(field alpha, pch2matrix h2, pavector xt,
   assert(yt->dim == h2->rb->ktree);
   assert(yta->dim == h2->cb->ktree);
 
-  if (h2->f) {
-    aa = h2->f->a;
-    lda = h2->f->ld;
+  if (h2->f || h2->fill) {
+    f = h2->f;
+    if (f == NULL) {
+      f = init_amatrix(&tmp5, rb->t->size, cb->t->size);
+      h2->fill(rb->t->idx, cb->t->idx, h2->filldata, f);
+    }
+
+    aa = f->a;
+    lda = f->ld;
 
     n = rb->t->size;
     xp = init_sub_avector(&tmp1, xt, n, cb->k);
@@ -1460,6 +1702,9 @@ addevalsymm_diag(field alpha, pch2matrix h2, pavector xt,
 
     uninit_avector(yp);
     uninit_avector(xp);
+
+    if (f != h2->f)
+      uninit_amatrix(f);
   }
   else {
     assert(h2->son != 0);
@@ -1575,8 +1820,8 @@ void
 fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
 				    pch2matrix h2, pcamatrix Xt, pamatrix Yt)
 {
-  amatrix   loc1, loc2;
-  pamatrix  Xp, Yp, Xt1, Yt1;
+  amatrix   loc1, loc2, tmp;
+  pamatrix  Xp, Yp, Xt1, Yt1, N;
   pcclusterbasis rb = (h2trans ? h2->cb : h2->rb);
   pcclusterbasis cb = (h2trans ? h2->rb : h2->cb);
   uint      rsons = (h2trans ? h2->csons : h2->rsons);
@@ -1588,7 +1833,14 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
   if (h2->u) {
     Xt1 = init_sub_amatrix(&loc1, (pamatrix) Xt, cb->k, 0, Xt->cols, 0);
     Yt1 = init_sub_amatrix(&loc2, Yt, rb->k, 0, Yt->cols, 0);
-    addmul_amatrix(alpha, h2trans, &h2->u->S, false, Xt1, Yt1);
+    if (h2->u->CS) {
+      N = init_amatrix(&tmp, h2->u->CS->rows, h2->u->CS->cols);
+      decompress_qmatrix(h2->u->CS, N);
+      addmul_amatrix(alpha, h2trans, N, false, Xt1, Yt1);
+      uninit_amatrix(N);
+    }
+    else
+      addmul_amatrix(alpha, h2trans, &h2->u->S, false, Xt1, Yt1);
     uninit_amatrix(Yt1);
     uninit_amatrix(Xt1);
   }
@@ -1600,6 +1852,17 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
     uninit_amatrix(Yp);
     uninit_amatrix(Xp);
   }
+  else if (h2->fill) {
+    Xp = init_sub_amatrix(&loc1, (pamatrix) Xt, cb->t->size, cb->k, Xt->cols,
+			  0);
+    Yp = init_sub_amatrix(&loc2, Yt, rb->t->size, rb->k, Yt->cols, 0);
+    N = init_amatrix(&tmp, h2->rb->t->size, h2->cb->t->size);
+    h2->fill(h2->rb->t->idx, h2->cb->t->idx, h2->filldata, N);
+    addmul_amatrix(alpha, h2trans, N, false, Xp, Yp);
+    uninit_amatrix(N);
+    uninit_amatrix(Yp);
+    uninit_amatrix(Xp);
+  }
   else if (h2->son) {
     xtoff = cb->k;
     for (j = 0; j < csons; j++) {
@@ -1632,6 +1895,53 @@ fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans,
   }
 }
 
+void
+addeval_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X, pamatrix Y)
+{
+  pamatrix  Xt, Yt;
+
+  assert(X->rows == h2->cb->t->size);
+  assert(Y->rows == h2->rb->t->size);
+  assert(X->cols == Y->cols);
+
+  Xt = new_amatrix(h2->cb->ktree, X->cols);
+  Yt = new_amatrix(h2->rb->ktree, Y->cols);
+  clear_amatrix(Yt);
+
+  forward_permutation_clusterbasis_amatrix(h2->cb, X, Xt);
+
+  fastaddmul_h2matrix_amatrix_amatrix(alpha, false, h2, Xt, Yt);
+
+  backward_permutation_clusterbasis_amatrix(h2->rb, Yt, Y);
+
+  del_amatrix(Yt);
+  del_amatrix(Xt);
+}
+
+void
+addevaltrans_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X,
+			      pamatrix Y)
+{
+  pamatrix  Xt, Yt;
+
+  assert(X->rows == h2->rb->t->size);
+  assert(Y->rows == h2->cb->t->size);
+  assert(X->cols == Y->cols);
+
+  Xt = new_amatrix(h2->rb->ktree, X->cols);
+  Yt = new_amatrix(h2->cb->ktree, Y->cols);
+  clear_amatrix(Yt);
+
+  forward_permutation_clusterbasis_amatrix(h2->rb, X, Xt);
+
+  fastaddmul_h2matrix_amatrix_amatrix(alpha, true, h2, Xt, Yt);
+
+  backward_permutation_clusterbasis_amatrix(h2->cb, Yt, Y);
+
+  del_amatrix(Yt);
+  del_amatrix(Xt);
+}
+
 void
 addmul_h2matrix_amatrix_amatrix(field alpha, bool h2trans, pch2matrix h2,
 				bool xtrans, pcamatrix X, pamatrix Y)
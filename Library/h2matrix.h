@@ -56,6 +56,12 @@ struct _h2matrix {
   /** @brief Standard matrix, for inadmissible leaves. */
   pamatrix f;
 
+  /** @brief Callback computing the entries of a matrix-free
+   *  inadmissible leaf on demand, <tt>NULL</tt> for all other blocks. */
+  fillblock_t fill;
+  /** @brief Additional data for <tt>fill</tt>. */
+  void *filldata;
+
   /** @brief Submatrices. */
   ph2matrix *son;
   /** @brief Number of block rows. */
@@ -67,6 +73,11 @@ struct _h2matrix {
   uint refs;
   /** @brief Number of descendants in matrix tree. */
   uint desc;
+
+  /** @brief Arena containing the storage of the entire tree, only set
+   *  for the root of a matrix created by
+   *  @ref build_from_block_arena_h2matrix. */
+  parena arena;
 };
 
 /* ------------------------------------------------------------
@@ -120,6 +131,31 @@ new_uniform_h2matrix(pclusterbasis rb, pclusterbasis cb);
 HEADER_PREFIX ph2matrix
 new_full_h2matrix(pclusterbasis rb, pclusterbasis cb);
 
+/** @brief Create a new @ref h2matrix object representing a
+ *  matrix-free dense matrix.
+ *
+ *  No coefficients are stored, instead <tt>fill</tt> is called
+ *  to compute the block whenever it is multiplied by a vector
+ *  in @ref fastaddeval_h2matrix_avector or
+ *  @ref fastaddevaltrans_h2matrix_avector.
+ *
+ *  @remark Matrix-free leaves are only supported by the
+ *  matrix-vector multiplication routines, including the symmetric
+ *  variants, and by @ref convert_h2matrix_amatrix and
+ *  @ref convert_h2matrix_hmatrix, not by the matrix arithmetic,
+ *  see @ref ismatrixfree_h2matrix.
+ *
+ *  @remark Should always be matched by a call to @ref del_h2matrix.
+ *
+ *  @param rb Row cluster basis.
+ *  @param cb Column cluster basis.
+ *  @param fill Callback computing the coefficients.
+ *  @param data Additional data for <tt>fill</tt>.
+ *  @returns New matrix-free @ref h2matrix object. */
+HEADER_PREFIX ph2matrix
+new_matrixfree_h2matrix(pclusterbasis rb, pclusterbasis cb, fillblock_t fill,
+			void *data);
+
 /** @brief Create a new @ref hmatrix object representing a
  *  subdivided matrix.
  *
@@ -254,6 +290,14 @@ getnearsize_h2matrix(pch2matrix h2);
 HEADER_PREFIX size_t
 getfarsize_h2matrix(pch2matrix h2);
 
+/** @brief Check whether an @ref h2matrix contains matrix-free leaves,
+ *  see @ref new_matrixfree_h2matrix.
+ *
+ *  @param h2 @f$\mathcal{H}^2@f$-matrix object.
+ *  @returns <tt>true</tt> if at least one leaf is matrix-free. */
+HEADER_PREFIX bool
+ismatrixfree_h2matrix(pch2matrix h2);
+
 /* ------------------------------------------------------------
  Simple utility functions
  ------------------------------------------------------------ */
@@ -265,6 +309,26 @@ getfarsize_h2matrix(pch2matrix h2);
 HEADER_PREFIX void
 clear_h2matrix(ph2matrix h2);
 
+/** @brief Store the coupling matrices of all admissible leaves in a
+ *  lossy compressed format by @ref compress_uniform.
+ *
+ *  The cluster bases and nearfield matrices are not changed.
+ *  The compressed matrix can only be multiplied by vectors, other
+ *  operations require @ref decompress_h2matrix.
+ *
+ *  @param tm Truncation mode.
+ *  @param eps Accuracy @f$\epsilon@f$ for every coupling matrix.
+ *  @param h2 Target matrix. */
+HEADER_PREFIX void
+compress_h2matrix(pctruncmode tm, real eps, ph2matrix h2);
+
+/** @brief Restore all coupling matrices compressed by
+ *  @ref compress_h2matrix.
+ *
+ *  @param h2 Target matrix. */
+HEADER_PREFIX void
+decompress_h2matrix(ph2matrix h2);
+
 /* ------------------------------------------------------------
  Build H^2-matrix based on block tree
  ------------------------------------------------------------ */
@@ -282,6 +346,61 @@ clear_h2matrix(ph2matrix h2);
 HEADER_PREFIX ph2matrix
 build_from_block_h2matrix(pcblock b, pclusterbasis rb, pclusterbasis cb);
 
+/** @brief Build an @ref h2matrix object from a @ref block tree using
+ *  given cluster bases, taking the storage from an @ref arena.
+ *
+ *  The matrix is constructed like in @ref build_from_block_h2matrix,
+ *  but all nodes, coupling matrices and nearfield matrices are placed
+ *  in a few large slabs of one @ref arena that is released at once
+ *  when the root is deleted. The cluster bases are not affected.
+ *
+ *  @remark Submatrices must not be referenced from outside the tree,
+ *  since they do not survive the deletion of the root.
+ *
+ *  @param b Block tree.
+ *  @param rb Row cluster basis.
+ *  @param cb Column cluster basis.
+ *  @returns New @ref h2matrix object. */
+HEADER_PREFIX ph2matrix
+build_from_block_arena_h2matrix(pcblock b, pclusterbasis rb,
+				pclusterbasis cb);
+
+/** @brief Build an @ref h2matrix object from a @ref block tree using
+ *  given cluster bases and matrix-free nearfield leaves.
+ *
+ *  @remark Submatrices for farfield leaves are created, but their
+ *  coefficients are not initialized. Nearfield leaves are created
+ *  by @ref new_matrixfree_h2matrix and store no coefficients.
+ *
+ *  @param b Block tree.
+ *  @param rb Row cluster basis.
+ *  @param cb Column cluster basis.
+ *  @param fill Callback computing nearfield blocks.
+ *  @param data Additional data for <tt>fill</tt>.
+ *  @returns New @ref h2matrix object. */
+HEADER_PREFIX ph2matrix
+build_from_block_matrixfree_h2matrix(pcblock b, pclusterbasis rb,
+				     pclusterbasis cb, fillblock_t fill,
+				     void *data);
+
+/** @brief Build an @ref h2matrix object from a @ref block tree for a
+ *  kernel function that vanishes beyond a cutoff distance.
+ *
+ *  Leaves whose clusters are at least <tt>cutoff</tt> apart in the
+ *  maximum norm, see @ref getdist_max_cluster, are structural zeros and
+ *  are created by @ref new_zero_h2matrix without a @ref uniform matrix.
+ *  All other leaves are created as in @ref build_from_block_h2matrix.
+ *
+ *  @param b Block tree, ideally built with
+ *         @ref admissible_max_cutoff_cluster.
+ *  @param rb Row cluster basis.
+ *  @param cb Column cluster basis.
+ *  @param cutoff Cutoff distance of the kernel function.
+ *  @returns New @ref h2matrix object. */
+HEADER_PREFIX ph2matrix
+build_from_block_cutoff_h2matrix(pcblock b, pclusterbasis rb,
+				 pclusterbasis cb, real cutoff);
+
 /* ------------------------------------------------------------
  Build block tree from H^2-matrix
  ------------------------------------------------------------ */
@@ -617,6 +736,32 @@ HEADER_PREFIX void
 fastaddmul_h2matrix_amatrix_amatrix(field alpha, bool atrans, pch2matrix A,
     pcamatrix Bt, pamatrix Ct);
 
+/** @brief Multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  All columns of @f$X@f$ are handled at once by the forward
+ *  transformation, the coupling matrices, the nearfield leaves and
+ *  the backward transformation, so that the product is carried out
+ *  by matrix-matrix instead of matrix-vector operations.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$ in original numbering.
+ *  @param Y Target matrix @f$Y@f$ in original numbering. */
+HEADER_PREFIX void
+addeval_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X, pamatrix Y);
+
+/** @brief Adjoint multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param h2 Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$ in original numbering.
+ *  @param Y Target matrix @f$Y@f$ in original numbering. */
+HEADER_PREFIX void
+addevaltrans_h2matrix_amatrix(field alpha, pch2matrix h2, pcamatrix X,
+    pamatrix Y);
+
 /** @brief Matrix multiplication @f$ C \gets C + \alpha A B @f$,
  *  @f$ C \gets C + \alpha A^* B @f$, @f$ C \gets C + \alpha A B^* @f$ or
  *  @f$ C \gets C + \alpha A^* B^* @f$.
@@ -2,8 +2,13 @@
 
 #include <stdio.h>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 #include "factorizations.h"
 #include "h2compression.h"
+#include "harith.h"
 #include "basic.h"
 
 #include "laplacebem2d.h"
@@ -108,7 +113,8 @@ normfrob_rkupdate_uniform(puniform u, uint k)
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
 /* compute the R of QR decomposition of the extended clusterbasis (V A) */
 static void
-orthoweight_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A)
+orthoweight_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A,
+				  uint pardepth)
 {
   uint      sons = cb->sons;
   pclusterbasis *son = cb->son;
@@ -116,25 +122,42 @@ orthoweight_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A)
 
   amatrix   tmp1, tmp2, tmp4;
   avector   tmp3;
-  pamatrix  Vhat, Vhat1, A1, R;
+  pamatrix  Vhat, Vhat1, R;
+  pamatrix *A1;
   uint      m, off, roff;
   pavector  tau;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
   uint      i, refl;
 
   assert(cb->t->size == A->rows);
 
   if (sons > 0) {
     /* compute weights for sons */
-    m = 0;
+    A1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * sons);
     roff = 0;
     for (i = 0; i < sons; i++) {
-      A1 = init_sub_amatrix(&tmp2, A, son[i]->t->size, roff, k, 0);
-      orthoweight_rkupdate_clusterbasis(son[i], A1);
-      m += son[i]->Z->rows;
+      A1[i] = new_sub_amatrix(A, son[i]->t->size, roff, k, 0);
       roff += son[i]->t->size;
+    }
+
+#ifdef USE_OPENMP
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < sons; i++)
+      orthoweight_rkupdate_clusterbasis(son[i], A1[i],
+					(pardepth > 0 ? pardepth - 1 : 0));
 
-      uninit_amatrix(A1);
+    m = 0;
+    for (i = 0; i < sons; i++) {
+      m += son[i]->Z->rows;
+
+      del_amatrix(A1[i]);
     }
+    freemem(A1);
     assert(m <= roff);
     assert(roff == cb->t->size);
 
@@ -191,275 +214,307 @@ orthoweight_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A)
 }
 
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
-/* computes the totalweights for all sons of the extended row clusterbasis */
 static void
-rowweight_rkupdate_clusteroperator(pclusterbasis rb,
-				   pclusteroperator rw, int k, ptruncmode tm)
-{
-  uint      sons = rw->sons;
+rowweight_rkupdate_clusteroperator(pclusterbasis rb, pclusteroperator rw,
+				   int k, ptruncmode tm, uint pardepth);
 
+/* computes the totalweight for one son of the extended row clusterbasis */
+static void
+rowweight_son_rkupdate_clusteroperator(pclusterbasis son, pclusteroperator rw,
+				       pclusteroperator rw1, int k,
+				       ptruncmode tm, uint pardepth)
+{
   pamatrix  Yhat, Yhat1;
   pamatrix  Z, Z1;		/* Z = Z or Z = R_{si} */
   amatrix   tmp1, tmp2, tmp3;
   pavector  tau;
   avector   tmp4;
-  pclusterbasis son;
   puniform  u;
   real      zeta_age, norm, alpha;
   uint      rows, cols, refl;	/* size of Yhat */
   uint      off;
-  uint      i;
-
-  assert(rb->t == rw->t);
 
   zeta_age = (tm ? tm->zeta_age : 1.0);
 
-  if (sons > 0) {
-    for (i = 0; i < sons; i++) {
-      son = rb->son[i];
-
-      /* rows of Yhat */
-      rows = rw->krow;
-      u = son->rlist;
-      while (u != NULL) {
-	Z = u->cb->Z;
-	/* u is a subblock of AB* */
-	if (Z != NULL) {
-	  rows += Z->rows;
-	}
-	/* u is no subblock of AB* */
-	else {
-	  rows += u->S.cols;
-	}
-	u = u->rnext;
-      }
-      /* cols of Yhat */
-      cols = son->k + k;
-      Yhat = init_amatrix(&tmp1, rows, cols);
-      /* compute Yhat */
-      assert(rw->kcol == son->E.cols + k);
+  /* rows of Yhat */
+  rows = rw->krow;
+  u = son->rlist;
+  while (u != NULL) {
+    Z = u->cb->Z;
+    /* u is a subblock of AB* */
+    if (Z != NULL) {
+      rows += Z->rows;
+    }
+    /* u is no subblock of AB* */
+    else {
+      rows += u->S.cols;
+    }
+    u = u->rnext;
+  }
+  /* cols of Yhat */
+  cols = son->k + k;
+  Yhat = init_amatrix(&tmp1, rows, cols);
+  /* compute Yhat */
+  assert(rw->kcol == son->E.cols + k);
+  /* columns associated with V */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, son->k, 0);
+  Z1 = init_sub_amatrix(&tmp3, &rw->C, rw->krow, 0, son->E.cols, 0);
+  clear_amatrix(Yhat1);
+  addmul_amatrix(zeta_age, false, Z1, true, &son->E, Yhat1);
+  uninit_amatrix(Yhat1);
+  uninit_amatrix(Z1);
+
+  /* columns associated with A */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, k, son->k);
+  Z1 = init_sub_amatrix(&tmp3, &rw->C, rw->krow, 0, k, son->E.cols);
+  copy_amatrix(false, Z1, Yhat1);
+  scale_amatrix(zeta_age, Yhat1);
+  uninit_amatrix(Yhat1);
+  uninit_amatrix(Z1);
+
+  off = rw->krow;
+  u = son->rlist;
+  while (u) {
+    /* Compute block weight if required */
+    alpha = 1.0;
+    if (tm && tm->blocks) {
+      if (tm->frobenius)
+	norm = normfrob_rkupdate_uniform(u, k);
+      else
+	norm = norm2_rkupdate_uniform(u, k);
+
+      alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
+    }
+    Z = u->cb->Z;
+    /* u is a subblock of AB* */
+    if (Z != NULL) {
+      assert(Z->cols == u->S.cols + k);
       /* columns associated with V */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, son->k, 0);
-      Z1 = init_sub_amatrix(&tmp3, &rw->C, rw->krow, 0, son->E.cols, 0);
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, son->k, 0);
+      Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, u->S.cols, 0);
       clear_amatrix(Yhat1);
-      addmul_amatrix(zeta_age, false, Z1, true, &son->E, Yhat1);
+      addmul_amatrix(alpha, false, Z1, true, &u->S, Yhat1);
       uninit_amatrix(Yhat1);
       uninit_amatrix(Z1);
 
       /* columns associated with A */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, k, son->k);
-      Z1 = init_sub_amatrix(&tmp3, &rw->C, rw->krow, 0, k, son->E.cols);
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, k, son->k);
+      Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, k, u->S.cols);
       copy_amatrix(false, Z1, Yhat1);
-      scale_amatrix(zeta_age, Yhat1);
+      scale_amatrix(alpha, Yhat1);
       uninit_amatrix(Yhat1);
       uninit_amatrix(Z1);
 
-      off = rw->krow;
-      u = son->rlist;
-      while (u) {
-	/* Compute block weight if required */
-	alpha = 1.0;
-	if (tm && tm->blocks) {
-	  if (tm->frobenius)
-	    norm = normfrob_rkupdate_uniform(u, k);
-	  else
-	    norm = norm2_rkupdate_uniform(u, k);
-
-	  alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
-	}
-	Z = u->cb->Z;
-	/* u is a subblock of AB* */
-	if (Z != NULL) {
-	  assert(Z->cols == u->S.cols + k);
-	  /* columns associated with V */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, son->k, 0);
-	  Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, u->S.cols, 0);
-	  clear_amatrix(Yhat1);
-	  addmul_amatrix(alpha, false, Z1, true, &u->S, Yhat1);
-	  uninit_amatrix(Yhat1);
-	  uninit_amatrix(Z1);
-
-	  /* columns associated with A */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, k, son->k);
-	  Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, k, u->S.cols);
-	  copy_amatrix(false, Z1, Yhat1);
-	  scale_amatrix(alpha, Yhat1);
-	  uninit_amatrix(Yhat1);
-	  uninit_amatrix(Z1);
-
-	  off += Z->rows;
-	}
-	/* u is no subblock of AB* */
-	else {
-	  /* columns associated with V */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, son->k, 0);
-	  copy_amatrix(true, &u->S, Yhat1);
-	  scale_amatrix(alpha, Yhat1);
-	  uninit_amatrix(Yhat1);
-
-	  /* columns associated with A */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, k, son->k);
-	  clear_amatrix(Yhat1);
-	  uninit_amatrix(Yhat1);
-
-	  off += u->S.cols;
-	}
-	u = u->rnext;
-      }
-      assert(off == rows);
-
-      /* compute the weight */
-      refl = UINT_MIN(rows, cols);
-      tau = init_avector(&tmp4, refl);
-      qrdecomp_amatrix(Yhat, tau);
-      resize_clusteroperator(rw->son[i], refl, cols);
-      copy_upper_amatrix(Yhat, false, &rw->son[i]->C);
-      uninit_avector(tau);
-      uninit_amatrix(Yhat);
-
-      /* compute the weight for the son */
-      rowweight_rkupdate_clusteroperator(son, rw->son[i], k, tm);
+      off += Z->rows;
+    }
+    /* u is no subblock of AB* */
+    else {
+      /* columns associated with V */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, son->k, 0);
+      copy_amatrix(true, &u->S, Yhat1);
+      scale_amatrix(alpha, Yhat1);
+      uninit_amatrix(Yhat1);
+
+      /* columns associated with A */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, k, son->k);
+      clear_amatrix(Yhat1);
+      uninit_amatrix(Yhat1);
+
+      off += u->S.cols;
     }
+    u = u->rnext;
   }
-  else {
-    assert(sons == 0);
+  assert(off == rows);
+
+  /* compute the weight */
+  refl = UINT_MIN(rows, cols);
+  tau = init_avector(&tmp4, refl);
+  qrdecomp_amatrix(Yhat, tau);
+  resize_clusteroperator(rw1, refl, cols);
+  copy_upper_amatrix(Yhat, false, &rw1->C);
+  uninit_avector(tau);
+  uninit_amatrix(Yhat);
+
+  /* compute the weights for the son recursively */
+  rowweight_rkupdate_clusteroperator(son, rw1, k, tm, pardepth);
+}
+
+/* computes the totalweights for all sons of the extended row clusterbasis */
+static void
+rowweight_rkupdate_clusteroperator(pclusterbasis rb, pclusteroperator rw,
+				   int k, ptruncmode tm, uint pardepth)
+{
+  uint      sons = rw->sons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i;
+
+  assert(rb->t == rw->t);
+
+  if (sons > 0) {
+#ifdef USE_OPENMP
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < sons; i++)
+      rowweight_son_rkupdate_clusteroperator(rb->son[i], rw, rw->son[i],
+					     k, tm,
+					     (pardepth > 0 ? pardepth - 1 : 0));
   }
 }
 
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
-/* computes the totalweights for all sons of the extended col clusterbasis */
 static void
-colweight_rkupdate_clusteroperator(pclusterbasis cb,
-				   pclusteroperator cw, int k, ptruncmode tm)
-{
-  uint      sons = cw->sons;
+colweight_rkupdate_clusteroperator(pclusterbasis cb, pclusteroperator cw,
+				   int k, ptruncmode tm, uint pardepth);
 
+/* computes the totalweight for one son of the extended col clusterbasis */
+static void
+colweight_son_rkupdate_clusteroperator(pclusterbasis son, pclusteroperator cw,
+				       pclusteroperator cw1, int k,
+				       ptruncmode tm, uint pardepth)
+{
   pamatrix  Yhat, Yhat1;
   pamatrix  Z, Z1;		/* Z = Z or Z = R_{si} */
   amatrix   tmp1, tmp2, tmp3;
   pavector  tau;
   avector   tmp4;
-  pclusterbasis son;
   puniform  u;
   real      zeta_age, norm, alpha;
   uint      rows, cols, refl;	/* size of Yhat */
   uint      off;
-  uint      i;
-
-  assert(cb->t == cw->t);
 
   zeta_age = (tm ? tm->zeta_age : 1.0);
 
-  if (sons > 0) {
-    for (i = 0; i < sons; i++) {
-      son = cb->son[i];
-
-      /* rows of Yhat */
-      rows = cw->krow;
-      u = son->clist;
-      while (u != NULL) {
-	Z = u->rb->Z;
-	/* u is a subblock of AB* */
-	if (Z != NULL) {
-	  rows += Z->rows;
-	}
-	/* u is no subblock of AB* */
-	else {
-	  rows += u->S.rows;
-	}
-	u = u->cnext;
-      }
-      /* cols of Yhat */
-      cols = son->k + k;
-      Yhat = init_amatrix(&tmp1, rows, cols);
-
-      /* compute Yhat */
-      assert(cw->kcol == son->E.cols + k);
-      /* columns associated with W */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, son->k, 0);
-      Z1 = init_sub_amatrix(&tmp3, &cw->C, cw->krow, 0, son->E.cols, 0);
+  /* rows of Yhat */
+  rows = cw->krow;
+  u = son->clist;
+  while (u != NULL) {
+    Z = u->rb->Z;
+    /* u is a subblock of AB* */
+    if (Z != NULL) {
+      rows += Z->rows;
+    }
+    /* u is no subblock of AB* */
+    else {
+      rows += u->S.rows;
+    }
+    u = u->cnext;
+  }
+  /* cols of Yhat */
+  cols = son->k + k;
+  Yhat = init_amatrix(&tmp1, rows, cols);
+
+  /* compute Yhat */
+  assert(cw->kcol == son->E.cols + k);
+  /* columns associated with W */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, son->k, 0);
+  Z1 = init_sub_amatrix(&tmp3, &cw->C, cw->krow, 0, son->E.cols, 0);
+  clear_amatrix(Yhat1);
+  addmul_amatrix(zeta_age, false, Z1, true, &son->E, Yhat1);
+  uninit_amatrix(Yhat1);
+  uninit_amatrix(Z1);
+
+  /* columns associated with B */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, k, son->k);
+  Z1 = init_sub_amatrix(&tmp3, &cw->C, cw->krow, 0, k, son->E.cols);
+  copy_amatrix(false, Z1, Yhat1);
+  scale_amatrix(zeta_age, Yhat1);
+  uninit_amatrix(Yhat1);
+  uninit_amatrix(Z1);
+
+  off = cw->krow;
+  u = son->clist;
+  while (u != NULL) {
+    /* Compute block weight if required */
+    alpha = 1.0;
+    if (tm && tm->blocks) {
+      if (tm->frobenius)
+	norm = normfrob_rkupdate_uniform(u, k);
+      else
+	norm = norm2_rkupdate_uniform(u, k);
+
+      alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
+    }
+    Z = u->rb->Z;
+    /* u is a subblock of AB* */
+    if (Z != NULL) {
+      assert(Z->cols == u->S.rows + k);
+      /* columns associated with V */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, son->k, 0);
+      Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, u->S.rows, 0);
       clear_amatrix(Yhat1);
-      addmul_amatrix(zeta_age, false, Z1, true, &son->E, Yhat1);
+      addmul_amatrix(alpha, false, Z1, false, &u->S, Yhat1);
       uninit_amatrix(Yhat1);
       uninit_amatrix(Z1);
 
-      /* columns associated with B */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, k, son->k);
-      Z1 = init_sub_amatrix(&tmp3, &cw->C, cw->krow, 0, k, son->E.cols);
+      /* columns associated with A */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, k, son->k);
+      Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, k, u->S.rows);
       copy_amatrix(false, Z1, Yhat1);
-      scale_amatrix(zeta_age, Yhat1);
+      scale_amatrix(alpha, Yhat1);
       uninit_amatrix(Yhat1);
       uninit_amatrix(Z1);
 
-      off = cw->krow;
-      u = son->clist;
-      while (u != NULL) {
-	/* Compute block weight if required */
-	alpha = 1.0;
-	if (tm && tm->blocks) {
-	  if (tm->frobenius)
-	    norm = normfrob_rkupdate_uniform(u, k);
-	  else
-	    norm = norm2_rkupdate_uniform(u, k);
-
-	  alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
-	}
-	Z = u->rb->Z;
-	/* u is a subblock of AB* */
-	if (Z != NULL) {
-	  assert(Z->cols == u->S.rows + k);
-	  /* columns associated with V */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, son->k, 0);
-	  Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, u->S.rows, 0);
-	  clear_amatrix(Yhat1);
-	  addmul_amatrix(alpha, false, Z1, false, &u->S, Yhat1);
-	  uninit_amatrix(Yhat1);
-	  uninit_amatrix(Z1);
-
-	  /* columns associated with A */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, Z->rows, off, k, son->k);
-	  Z1 = init_sub_amatrix(&tmp3, Z, Z->rows, 0, k, u->S.rows);
-	  copy_amatrix(false, Z1, Yhat1);
-	  scale_amatrix(alpha, Yhat1);
-	  uninit_amatrix(Yhat1);
-	  uninit_amatrix(Z1);
-
-	  off += Z->rows;
-	}
-	/* u is no subblock of AB* */
-	else {
-	  /* columns associated with V */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, son->k, 0);
-	  copy_amatrix(false, &u->S, Yhat1);
-	  scale_amatrix(alpha, Yhat1);
-	  uninit_amatrix(Yhat1);
-
-	  /* columns associated with A */
-	  Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, k, son->k);
-	  clear_amatrix(Yhat1);
-	  uninit_amatrix(Yhat1);
-
-	  off += u->S.rows;
-	}
-	u = u->cnext;
-      }
-      assert(off == rows);
-
-      /* compute the weight */
-      refl = UINT_MIN(rows, cols);
-      tau = init_avector(&tmp4, refl);
-      qrdecomp_amatrix(Yhat, tau);
-      resize_clusteroperator(cw->son[i], refl, cols);
-      copy_upper_amatrix(Yhat, false, &cw->son[i]->C);
-      uninit_avector(tau);
-      uninit_amatrix(Yhat);
-
-      /* compute the weight for the son */
-      colweight_rkupdate_clusteroperator(son, cw->son[i], k, tm);
+      off += Z->rows;
+    }
+    /* u is no subblock of AB* */
+    else {
+      /* columns associated with V */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, son->k, 0);
+      copy_amatrix(false, &u->S, Yhat1);
+      scale_amatrix(alpha, Yhat1);
+      uninit_amatrix(Yhat1);
+
+      /* columns associated with A */
+      Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, k, son->k);
+      clear_amatrix(Yhat1);
+      uninit_amatrix(Yhat1);
+
+      off += u->S.rows;
     }
+    u = u->cnext;
   }
-  else {
-    assert(sons == 0);
+  assert(off == rows);
+
+  /* compute the weight */
+  refl = UINT_MIN(rows, cols);
+  tau = init_avector(&tmp4, refl);
+  qrdecomp_amatrix(Yhat, tau);
+  resize_clusteroperator(cw1, refl, cols);
+  copy_upper_amatrix(Yhat, false, &cw1->C);
+  uninit_avector(tau);
+  uninit_amatrix(Yhat);
+
+  /* compute the weights for the son recursively */
+  colweight_rkupdate_clusteroperator(son, cw1, k, tm, pardepth);
+}
+
+/* computes the totalweights for all sons of the extended col clusterbasis */
+static void
+colweight_rkupdate_clusteroperator(pclusterbasis cb, pclusteroperator cw,
+				   int k, ptruncmode tm, uint pardepth)
+{
+  uint      sons = cw->sons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i;
+
+  assert(cb->t == cw->t);
+
+  if (sons > 0) {
+#ifdef USE_OPENMP
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < sons; i++)
+      colweight_son_rkupdate_clusteroperator(cb->son[i], cw, cw->son[i],
+					     k, tm,
+					     (pardepth > 0 ? pardepth - 1 : 0));
   }
 }
 
@@ -467,14 +522,18 @@ colweight_rkupdate_clusteroperator(pclusterbasis cb,
 /* compute adaptive clusterbasis for extended clusterbasis (V A) */
 static void
 truncate_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A,
-			       pclusteroperator cw, pctruncmode tm, real eps)
+			       pclusteroperator cw, pctruncmode tm, real eps,
+			       uint pardepth)
 {
   amatrix   tmp1, tmp2, tmp3;
   realavector tmp4;
-  pamatrix  Vhat, Vhat1, VhatZ, Q, Q1, A1, C1;
+  pamatrix  Vhat, Vhat1, VhatZ, Q, Q1, C1;
+  pamatrix *A1;
   prealavector sigma;
-  pclusteroperator cw1;
   real      zeta_level;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
   uint      i, off, m, k;
 
   zeta_level = (tm ? tm->zeta_level : 1.0);
@@ -494,21 +553,32 @@ truncate_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A,
   }
   else {
     /* Compute cluster bases for son clusters recursively */
-    m = 0;
-    off = 0;
     assert(cb->sons == cw->sons);
+    A1 = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * cb->sons);
+    off = 0;
     for (i = 0; i < cb->sons; i++) {
-      cw1 = cw->son[i];
+      A1[i] = new_sub_amatrix(A, cb->son[i]->t->size, off, A->cols, 0);
+      off += cb->son[i]->t->size;
+    }
+    assert(off == A->rows);
 
-      A1 = init_sub_amatrix(&tmp2, A, cb->son[i]->t->size, off, A->cols, 0);
-      truncate_rkupdate_clusterbasis(cb->son[i], A1, cw1, tm,
-				     eps * zeta_level);
-      uninit_amatrix(A1);
+#ifdef USE_OPENMP
+    nthreads = cb->sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < cb->sons; i++)
+      truncate_rkupdate_clusterbasis(cb->son[i], A1[i], cw->son[i], tm,
+				     eps * zeta_level,
+				     (pardepth > 0 ? pardepth - 1 : 0));
 
-      off += cb->son[i]->t->size;
+    m = 0;
+    for (i = 0; i < cb->sons; i++) {
       m += cb->son[i]->k;
+
+      del_amatrix(A1[i]);
     }
-    assert(off == A->rows);
+    freemem(A1);
 
     /* compute Vhat */
     Vhat = init_amatrix(&tmp1, m, cb->k + A->cols);
@@ -599,16 +669,20 @@ truncate_rkupdate_clusterbasis(pclusterbasis cb, pamatrix A,
 /* adapts the coupling matrices of subblocks */
 static void
 rkupdate_inside_h2matrix(ph2matrix Gh2, pamatrix A, pamatrix B,
-			 pclusteroperator rw, pclusteroperator cw)
+			 pclusteroperator rw, pclusteroperator cw, uint pardepth)
 {
   uint      rsons = Gh2->rsons;
   uint      csons = Gh2->csons;
 
-  pclusteroperator rw1, cw1;
+  pclusteroperator *rw1, *cw1;
   amatrix   tmp1, tmp2, tmp3, tmp4;
   pamatrix  A1, B1, S, S1, S2;
+  pamatrix *Ai, *Bj;
   uint      roff, coff;
-  uint      k, rsize, csize;
+  uint      k;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
   uint      i, j;
 
   assert(rw->t == Gh2->rb->t);
@@ -619,36 +693,51 @@ rkupdate_inside_h2matrix(ph2matrix Gh2, pamatrix A, pamatrix B,
   k = A->cols;
   assert(k == B->cols);
 
-  /* update the sons recursively */
+  /* update the sons recursively, all zero admissible blocks have been
+   * replaced by rkupdate_adduniform_h2matrix, so the sons only modify
+   * their own coupling and nearfield matrices and can be handled
+   * in parallel */
   if (Gh2->son) {
+    rw1 = (pclusteroperator *) allocmem((size_t) sizeof(pclusteroperator) *
+					rsons);
+    Ai = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * rsons);
     roff = 0;
     for (i = 0; i < rsons; i++) {
-      if (rw->sons == 0)
-	rw1 = rw;
-      else
-	rw1 = rw->son[i];
-      rsize = rw1->t->size;
-      A1 = init_sub_amatrix(&tmp1, A, rsize, roff, k, 0);
-
-      coff = 0;
-      for (j = 0; j < csons; j++) {
-	if (cw->sons == 0)
-	  cw1 = cw;
-	else
-	  cw1 = cw->son[j];
-	csize = cw1->t->size;
-	B1 = init_sub_amatrix(&tmp2, B, csize, coff, k, 0);
-	rkupdate_inside_h2matrix(Gh2->son[i + j * rsons], A1, B1, rw1, cw1);
-
-	coff += csize;
-	uninit_amatrix(B1);
-      }
-      assert(coff == cw->t->size);
-
-      roff += rsize;
-      uninit_amatrix(A1);
+      rw1[i] = (rw->sons == 0 ? rw : rw->son[i]);
+      Ai[i] = new_sub_amatrix(A, rw1[i]->t->size, roff, k, 0);
+      roff += rw1[i]->t->size;
     }
     assert(roff == rw->t->size);
+
+    cw1 = (pclusteroperator *) allocmem((size_t) sizeof(pclusteroperator) *
+					csons);
+    Bj = (pamatrix *) allocmem((size_t) sizeof(pamatrix) * csons);
+    coff = 0;
+    for (j = 0; j < csons; j++) {
+      cw1[j] = (cw->sons == 0 ? cw : cw->son[j]);
+      Bj[j] = new_sub_amatrix(B, cw1[j]->t->size, coff, k, 0);
+      coff += cw1[j]->t->size;
+    }
+    assert(coff == cw->t->size);
+
+#ifdef USE_OPENMP
+    nthreads = rsons * csons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < rsons * csons; i++)
+      rkupdate_inside_h2matrix(Gh2->son[i], Ai[i % rsons], Bj[i / rsons],
+			       rw1[i % rsons], cw1[i / rsons],
+			       (pardepth > 0 ? pardepth - 1 : 0));
+
+    for (j = 0; j < csons; j++)
+      del_amatrix(Bj[j]);
+    freemem(Bj);
+    freemem(cw1);
+    for (i = 0; i < rsons; i++)
+      del_amatrix(Ai[i]);
+    freemem(Ai);
+    freemem(rw1);
   }
   /* in inadmissible leafs just add AB^T */
   else if (Gh2->f) {
@@ -700,11 +789,15 @@ rkupdate_inside_h2matrix(ph2matrix Gh2, pamatrix A, pamatrix B,
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
 /* adapts the coupling matrices outside the block of AB* to new row clusterbasis */
 static void
-rkupdate_rowout_h2matrix(pclusterbasis rb, pclusteroperator rw)
+rkupdate_rowout_h2matrix(pclusterbasis rb, pclusteroperator rw,
+			 uint pardepth)
 {
   puniform  u;
   amatrix   tmp1, tmp2;
   pamatrix  S, S1, R1;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
   uint      i;
 
   assert(rb->t == rw->t);
@@ -732,19 +825,28 @@ rkupdate_rowout_h2matrix(pclusterbasis rb, pclusteroperator rw)
   }
 
   /* update the sons recursively */
-  for (i = 0; i < rb->sons; i++) {
-    rkupdate_rowout_h2matrix(rb->son[i], rw->son[i]);
-  }
+#ifdef USE_OPENMP
+  nthreads = rb->sons;
+  (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+  for (i = 0; i < rb->sons; i++)
+    rkupdate_rowout_h2matrix(rb->son[i], rw->son[i],
+			     (pardepth > 0 ? pardepth - 1 : 0));
 }
 
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
 /* adapts the coupling matrices outside the block of AB* to new col clusterbasis */
 static void
-rkupdate_colout_h2matrix(pclusterbasis cb, pclusteroperator cw)
+rkupdate_colout_h2matrix(pclusterbasis cb, pclusteroperator cw,
+			 uint pardepth)
 {
   puniform  u;
   amatrix   tmp1, tmp2;
   pamatrix  S, S1, R1;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
   uint      i;
 
   assert(cb->t == cw->t);
@@ -772,169 +874,212 @@ rkupdate_colout_h2matrix(pclusterbasis cb, pclusteroperator cw)
   }
 
   /* update the sons recursively */
-  for (i = 0; i < cb->sons; i++) {
-    rkupdate_colout_h2matrix(cb->son[i], cw->son[i]);
-  }
+#ifdef USE_OPENMP
+  nthreads = cb->sons;
+  (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+  for (i = 0; i < cb->sons; i++)
+    rkupdate_colout_h2matrix(cb->son[i], cw->son[i],
+			     (pardepth > 0 ? pardepth - 1 : 0));
 }
 
 /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
-/* compute the new total weights for the row cluster */
 static void
-totalweights_row_clusteroperator(pclusterbasis rb,
-				 pclusteroperator rw, ptruncmode tm)
-{
-  uint      sons = rw->sons;
+totalweights_row_clusteroperator(pclusterbasis rb, pclusteroperator rw,
+				 ptruncmode tm, uint pardepth);
 
+/* compute the new total weight for one son of the row cluster */
+static void
+totalweights_son_row_clusteroperator(pclusterbasis son, pclusteroperator rw,
+				     pclusteroperator rw1, ptruncmode tm,
+				     uint pardepth)
+{
   pamatrix  Yhat, Yhat1;
   amatrix   tmp1, tmp2;
   pavector  tau;
   avector   tmp3;
-  pclusterbasis son;
   puniform  u;
   real      zeta_age, norm, alpha;
   uint      rows, cols, refl;	/* size of Yhat */
   uint      off;
-  uint      i;
 
   zeta_age = (tm ? tm->zeta_age : 1.0);
 
-  if (rw->son != NULL) {
-    for (i = 0; i < sons; i++) {
-      son = rb->son[i];
-
-      /* rows of Yhat */
-      rows = rw->krow;
-      u = son->rlist;
-      while (u != NULL) {
-	rows += u->S.cols;
-	u = u->rnext;
-      }
-      /* cols of Yhat */
-      cols = son->k;
-      Yhat = init_amatrix(&tmp1, rows, cols);
-
-      /* transfer the weight of the father */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, son->k, 0);
-      clear_amatrix(Yhat1);
-      addmul_amatrix(zeta_age, false, &rw->C, true, &son->E, Yhat1);
-      uninit_amatrix(Yhat1);
+  /* rows of Yhat */
+  rows = rw->krow;
+  u = son->rlist;
+  while (u != NULL) {
+    rows += u->S.cols;
+    u = u->rnext;
+  }
+  /* cols of Yhat */
+  cols = son->k;
+  Yhat = init_amatrix(&tmp1, rows, cols);
 
-      off = rw->krow;
-      u = son->rlist;
-      while (u) {
-	/* Compute block weight if required */
-	alpha = 1.0;
-	if (tm && tm->blocks) {
-	  if (tm->frobenius)
-	    norm = normfrob_rkupdate_uniform(u, 0);
-	  else
-	    norm = norm2_rkupdate_uniform(u, 0);
-
-	  alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
-	}
-	/* coupling matrices for admissible blocks */
-	Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, son->k, 0);
-	copy_amatrix(true, &u->S, Yhat1);
-	scale_amatrix(alpha, Yhat1);
-	uninit_amatrix(Yhat1);
-
-	off += u->S.cols;
-	u = u->rnext;
-      }
-      assert(off == rows);
-
-      /* compute the weight for current cluster */
-      refl = UINT_MIN(rows, cols);
-      tau = init_avector(&tmp3, refl);
-      qrdecomp_amatrix(Yhat, tau);
-      resize_clusteroperator(rw->son[i], refl, cols);
-      copy_upper_amatrix(Yhat, false, &rw->son[i]->C);
-      uninit_avector(tau);
-      uninit_amatrix(Yhat);
-
-      /* compute the weights for the son recursively */
-      totalweights_row_clusteroperator(son, rw->son[i], tm);
+  /* transfer the weight of the father */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, rw->krow, 0, son->k, 0);
+  clear_amatrix(Yhat1);
+  addmul_amatrix(zeta_age, false, &rw->C, true, &son->E, Yhat1);
+  uninit_amatrix(Yhat1);
+
+  off = rw->krow;
+  u = son->rlist;
+  while (u) {
+    /* Compute block weight if required */
+    alpha = 1.0;
+    if (tm && tm->blocks) {
+      if (tm->frobenius)
+	norm = normfrob_rkupdate_uniform(u, 0);
+      else
+	norm = norm2_rkupdate_uniform(u, 0);
+
+      alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
     }
+    /* coupling matrices for admissible blocks */
+    Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.cols, off, son->k, 0);
+    copy_amatrix(true, &u->S, Yhat1);
+    scale_amatrix(alpha, Yhat1);
+    uninit_amatrix(Yhat1);
+
+    off += u->S.cols;
+    u = u->rnext;
   }
+  assert(off == rows);
+
+  /* compute the weight for current cluster */
+  refl = UINT_MIN(rows, cols);
+  tau = init_avector(&tmp3, refl);
+  qrdecomp_amatrix(Yhat, tau);
+  resize_clusteroperator(rw1, refl, cols);
+  copy_upper_amatrix(Yhat, false, &rw1->C);
+  uninit_avector(tau);
+  uninit_amatrix(Yhat);
+
+  /* compute the weights for the son recursively */
+  totalweights_row_clusteroperator(son, rw1, tm, pardepth);
 }
 
-/* compute the new total weights for the column cluster */
+/* compute the new total weights for the row cluster */
 static void
-totalweights_col_clusteroperator(pclusterbasis cb,
-				 pclusteroperator cw, ptruncmode tm)
+totalweights_row_clusteroperator(pclusterbasis rb, pclusteroperator rw,
+				 ptruncmode tm, uint pardepth)
 {
-  uint      sons = cw->sons;
+  uint      sons = rw->sons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i;
+
+  if (rw->son != NULL) {
+#ifdef USE_OPENMP
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < sons; i++)
+      totalweights_son_row_clusteroperator(rb->son[i], rw, rw->son[i],
+					     tm,
+					     (pardepth > 0 ? pardepth - 1 : 0));
+  }
+}
+
+static void
+totalweights_col_clusteroperator(pclusterbasis cb, pclusteroperator cw,
+				 ptruncmode tm, uint pardepth);
 
+/* compute the new total weight for one son of the column cluster */
+static void
+totalweights_son_col_clusteroperator(pclusterbasis son, pclusteroperator cw,
+				     pclusteroperator cw1, ptruncmode tm,
+				     uint pardepth)
+{
   pamatrix  Yhat, Yhat1;
   amatrix   tmp1, tmp2;
   pavector  tau;
   avector   tmp3;
-  pclusterbasis son;
   puniform  u;
   real      zeta_age, norm, alpha;
   uint      rows, cols, refl;	/* size of Yhat */
   uint      off;
-  uint      i;
 
   zeta_age = (tm ? tm->zeta_age : 1.0);
 
-  if (cw->son != NULL) {
-    for (i = 0; i < sons; i++) {
-      son = cb->son[i];
-
-      /* rows of Yhat */
-      rows = cw->krow;
-      u = son->clist;
-      while (u != NULL) {
-	rows += u->S.rows;
-	u = u->cnext;
-      }
-      /* cols of Yhat */
-      cols = son->k;
-      Yhat = init_amatrix(&tmp1, rows, cols);
-
-      /* transfer the weight of the father */
-      Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, son->k, 0);
-      clear_amatrix(Yhat1);
-      addmul_amatrix(zeta_age, false, &cw->C, true, &son->E, Yhat1);
-      uninit_amatrix(Yhat1);
+  /* rows of Yhat */
+  rows = cw->krow;
+  u = son->clist;
+  while (u != NULL) {
+    rows += u->S.rows;
+    u = u->cnext;
+  }
+  /* cols of Yhat */
+  cols = son->k;
+  Yhat = init_amatrix(&tmp1, rows, cols);
+
+  /* transfer the weight of the father */
+  Yhat1 = init_sub_amatrix(&tmp2, Yhat, cw->krow, 0, son->k, 0);
+  clear_amatrix(Yhat1);
+  addmul_amatrix(zeta_age, false, &cw->C, true, &son->E, Yhat1);
+  uninit_amatrix(Yhat1);
 
-      off = cw->krow;
-      u = son->clist;
-      while (u) {
-	/* Compute block weight if required */
-	alpha = 1.0;
-	if (tm && tm->blocks) {
-	  if (tm->frobenius)
-	    norm = normfrob_rkupdate_uniform(u, 0);
-	  else
-	    norm = norm2_rkupdate_uniform(u, 0);
-
-	  alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
-	}
-	/* coupling matrices for admissible blocks */
-	Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, son->k, 0);
-	scale_amatrix(alpha, Yhat1);
-	copy_amatrix(false, &u->S, Yhat1);
-	uninit_amatrix(Yhat1);
-
-	off += u->S.rows;
-	u = u->cnext;
-      }
-      assert(off == rows);
-
-      /* compute the weight current cluster */
-      refl = UINT_MIN(rows, cols);
-      tau = init_avector(&tmp3, refl);
-      qrdecomp_amatrix(Yhat, tau);
-      resize_clusteroperator(cw->son[i], refl, cols);
-      copy_upper_amatrix(Yhat, false, &cw->son[i]->C);
-      uninit_avector(tau);
-      uninit_amatrix(Yhat);
-
-      /* compute the weights for the son recursively */
-      totalweights_col_clusteroperator(son, cw->son[i], tm);
+  off = cw->krow;
+  u = son->clist;
+  while (u) {
+    /* Compute block weight if required */
+    alpha = 1.0;
+    if (tm && tm->blocks) {
+      if (tm->frobenius)
+	norm = normfrob_rkupdate_uniform(u, 0);
+      else
+	norm = norm2_rkupdate_uniform(u, 0);
+
+      alpha = (norm > 0.0 ? 1.0 / norm : 1.0);
     }
+    /* coupling matrices for admissible blocks */
+    Yhat1 = init_sub_amatrix(&tmp2, Yhat, u->S.rows, off, son->k, 0);
+    scale_amatrix(alpha, Yhat1);
+    copy_amatrix(false, &u->S, Yhat1);
+    uninit_amatrix(Yhat1);
+
+    off += u->S.rows;
+    u = u->cnext;
+  }
+  assert(off == rows);
+
+  /* compute the weight current cluster */
+  refl = UINT_MIN(rows, cols);
+  tau = init_avector(&tmp3, refl);
+  qrdecomp_amatrix(Yhat, tau);
+  resize_clusteroperator(cw1, refl, cols);
+  copy_upper_amatrix(Yhat, false, &cw1->C);
+  uninit_avector(tau);
+  uninit_amatrix(Yhat);
+
+  /* compute the weights for the son recursively */
+  totalweights_col_clusteroperator(son, cw1, tm, pardepth);
+}
+
+/* compute the new total weights for the column cluster */
+static void
+totalweights_col_clusteroperator(pclusterbasis cb, pclusteroperator cw,
+				 ptruncmode tm, uint pardepth)
+{
+  uint      sons = cw->sons;
+#ifdef USE_OPENMP
+  uint      nthreads;		/* HACK: Solaris workaround */
+#endif
+  uint      i;
+
+  if (cw->son != NULL) {
+#ifdef USE_OPENMP
+    nthreads = sons;
+    (void) nthreads;
+#pragma omp parallel for if(pardepth > 0), num_threads(nthreads)
+#endif
+    for (i = 0; i < sons; i++)
+      totalweights_son_col_clusteroperator(cb->son[i], cw, cw->son[i],
+					     tm,
+					     (pardepth > 0 ? pardepth - 1 : 0));
   }
 }
 
@@ -960,6 +1105,21 @@ rkupdate_adduniform_h2matrix(ph2matrix h2)
 void
 rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
 		  pclusteroperator cwf, ptruncmode tm, real eps)
+{
+#ifdef USE_OPENMP
+  rkupdate_parallel_h2matrix(R, Gh2, rwf, cwf, tm, eps,
+			     (omp_get_max_threads() > 1 ? max_pardepth : 0));
+#else
+  rkupdate_parallel_h2matrix(R, Gh2, rwf, cwf, tm, eps, 0);
+#endif
+}
+
+/* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
+/* Gh2 = Gh2 + R, subtrees of the cluster bases are handled in parallel */
+void
+rkupdate_parallel_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
+			   pclusteroperator cwf, ptruncmode tm, real eps,
+			   uint pardepth)
 {
   pclusterbasis rb = Gh2->rb;
   pclusterbasis cb = Gh2->cb;
@@ -984,10 +1144,10 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   rkupdate_adduniform_h2matrix(Gh2);
 
   /* calculate orthogonal weights for (V_t A) */
-  orthoweight_rkupdate_clusterbasis(rb, &R->A);
+  orthoweight_rkupdate_clusterbasis(rb, &R->A, pardepth);
 
   /* calculate orthogonal weights for (W_s B) */
-  orthoweight_rkupdate_clusterbasis(cb, &R->B);
+  orthoweight_rkupdate_clusterbasis(cb, &R->B, pardepth);
 
   /* search for row weight of the active block */
   rw = NULL;
@@ -1107,7 +1267,7 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   uninit_amatrix(Yhat);
 
   /* compute total weight for son cluster of (V A) */
-  rowweight_rkupdate_clusteroperator(rb, rw, R->k, tm);
+  rowweight_rkupdate_clusteroperator(rb, rw, R->k, tm, pardepth);
 
   /* -------------------------------------------------- */
   /* compute total weight for current column cluster (W B) */
@@ -1207,12 +1367,12 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   uninit_amatrix(Yhat);
 
   /* compute total weight for son cluster of (W B) */
-  colweight_rkupdate_clusteroperator(cb, cw, R->k, tm);
+  colweight_rkupdate_clusteroperator(cb, cw, R->k, tm, pardepth);
 
   /* -------------------------------------------------- */
   /* truncate the row clusterbasis (V A) */
   k = rb->k;
-  truncate_rkupdate_clusterbasis(rb, &R->A, rw, tm, eps);
+  truncate_rkupdate_clusterbasis(rb, &R->A, rw, tm, eps, pardepth);
   E1 = init_amatrix(&tmp2, rb->k, rb->E.cols);
   clear_amatrix(E1);
   Z1 = init_sub_amatrix(&tmp3, &rw->C, rb->k, 0, k, 0);
@@ -1224,7 +1384,7 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   /* -------------------------------------------------- */
   /* truncate the col clusterbasis (W B) */
   k = cb->k;
-  truncate_rkupdate_clusterbasis(cb, &R->B, cw, tm, eps);
+  truncate_rkupdate_clusterbasis(cb, &R->B, cw, tm, eps, pardepth);
   E1 = init_amatrix(&tmp2, cb->k, cb->E.cols);
   clear_amatrix(E1);
   Z1 = init_sub_amatrix(&tmp3, &cw->C, cb->k, 0, k, 0);
@@ -1235,11 +1395,11 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
 
   /* -------------------------------------------------- */
   /* update the subblocks of Gh2 */
-  rkupdate_inside_h2matrix(Gh2, &R->A, &R->B, rw, cw);
+  rkupdate_inside_h2matrix(Gh2, &R->A, &R->B, rw, cw, pardepth);
 
   /* update the blocks outside of Gh2 */
-  rkupdate_rowout_h2matrix(rb, rw);
-  rkupdate_colout_h2matrix(cb, cw);
+  rkupdate_rowout_h2matrix(rb, rw, pardepth);
+  rkupdate_colout_h2matrix(cb, cw, pardepth);
 
   /* -------------------------------------------------- */
   /* update the totalweights of current row clusterbasis */
@@ -1295,7 +1455,7 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   uninit_amatrix(Yhat);
 
   /* update the totalweights of sons of current row clusterbasis */
-  totalweights_row_clusteroperator(rb, rw, tm);
+  totalweights_row_clusteroperator(rb, rw, tm, pardepth);
 
   /* -------------------------------------------------- */
   /* update the totalweights of current col clusterbasis */
@@ -1351,7 +1511,7 @@ rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
   uninit_amatrix(Yhat);
 
   /* update the totalweights of sons of current row clusterbasis */
-  totalweights_col_clusteroperator(cb, cw, tm);
+  totalweights_col_clusteroperator(cb, cw, tm, pardepth);
 
   /* clean up weights in clusterbasis */
   clear_weight_clusterbasis(rb);
@@ -1403,3 +1563,83 @@ prepare_col_clusteroperator(pclusterbasis rb, pclusterbasis cb, ptruncmode tm)
 
   return cwf;
 }
+
+/* ------------------------------------------------------------
+ * Accumulated low-rank updates
+ * ------------------------------------------------------------ */
+
+prkaccum
+new_rkaccum(ph2matrix Gh2, pclusteroperator rwf, pclusteroperator cwf,
+	    ptruncmode tm, real eps, uint maxrank)
+{
+  prkaccum  ra;
+
+  ra = (prkaccum) allocmem(sizeof(rkaccum));
+
+  ra->Gh2 = Gh2;
+  ra->rwf = rwf;
+  ra->cwf = cwf;
+  ra->tm = tm;
+  ra->eps = eps;
+  ra->maxrank = maxrank;
+  ra->r = new_rkmatrix(Gh2->rb->t->size, Gh2->cb->t->size, 0);
+
+  return ra;
+}
+
+void
+del_rkaccum(prkaccum ra)
+{
+  flush_rkaccum(ra);
+
+  del_rkmatrix(ra->r);
+  freemem(ra);
+}
+
+void
+add_rkaccum(pcrkmatrix R, prkaccum ra)
+{
+  prkmatrix r = ra->r;
+  amatrix   tmp;
+  pamatrix  X;
+  uint      k;
+
+  assert(R->A.rows == r->A.rows);
+  assert(R->B.rows == r->B.rows);
+
+  if (R->k == 0)
+    return;
+
+  /* Append the factors of R */
+  k = r->k;
+  resizecopy_amatrix(&r->A, r->A.rows, k + R->k);
+  resizecopy_amatrix(&r->B, r->B.rows, k + R->k);
+  r->k = k + R->k;
+
+  X = init_sub_amatrix(&tmp, &r->A, r->A.rows, 0, R->k, k);
+  copy_amatrix(false, &R->A, X);
+  uninit_amatrix(X);
+
+  X = init_sub_amatrix(&tmp, &r->B, r->B.rows, 0, R->k, k);
+  copy_amatrix(false, &R->B, X);
+  uninit_amatrix(X);
+
+  /* Recompress the accumulated updates, apply them if this does not
+   * reduce the rank sufficiently */
+  if (r->k > ra->maxrank) {
+    trunc_rkmatrix(ra->tm, ra->eps, r);
+
+    if (r->k > ra->maxrank)
+      flush_rkaccum(ra);
+  }
+}
+
+void
+flush_rkaccum(prkaccum ra)
+{
+  if (ra->r->k > 0) {
+    rkupdate_h2matrix(ra->r, ra->Gh2, ra->rwf, ra->cwf, ra->tm, ra->eps);
+
+    setrank_rkmatrix(ra->r, 0);
+  }
+}
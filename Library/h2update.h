@@ -25,6 +25,49 @@
 #include "h2matrix.h"
 #include "h2compression.h"
 
+/** @brief Accumulator for low-rank updates of an @ref h2matrix. */
+typedef struct _rkaccum rkaccum;
+
+/** @brief Pointer to @ref rkaccum object. */
+typedef rkaccum *prkaccum;
+
+/** @brief Pointer to constant @ref rkaccum object. */
+typedef const rkaccum *pcrkaccum;
+
+/** @brief Accumulator for low-rank updates of an @ref h2matrix.
+ *
+ *  Every call to @ref rkupdate_h2matrix recompresses the row and column
+ *  cluster bases of the target.
+ *  If many low-rank updates are added to the same matrix, it is more
+ *  efficient to collect them in one @ref rkmatrix and apply their
+ *  sum with one recompression of the cluster bases.
+ *  The accumulated updates are applied once their rank exceeds
+ *  <tt>maxrank</tt> even after truncation, or when the accumulator is
+ *  flushed or deleted. */
+struct _rkaccum {
+  /** @brief Target matrix. */
+  ph2matrix Gh2;
+
+  /** @brief Father of the total weights of the row cluster basis. */
+  pclusteroperator rwf;
+
+  /** @brief Father of the total weights of the column cluster basis. */
+  pclusteroperator cwf;
+
+  /** @brief Truncation mode. */
+  ptruncmode tm;
+
+  /** @brief Truncation accuracy. */
+  real eps;
+
+  /** @brief Rank that triggers a recompression of the accumulated
+   *  updates. */
+  uint maxrank;
+
+  /** @brief Accumulated low-rank updates. */
+  prkmatrix r;
+};
+
 
 /**
  *  @brief Computes the Euclidean norm of the extended coupling matrix of the low
@@ -91,6 +134,33 @@ HEADER_PREFIX void
 rkupdate_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf, pclusteroperator cwf,
                    ptruncmode tm, real eps);
 
+/**
+ *  @brief Computes the low rank update @f$ G \gets G + R @f$ in parallel
+ *
+ *  All steps of the update, i.e., the weights of the extended cluster
+ *  bases, their truncation and the transformation of the coupling
+ *  matrices, recurse into the son clusters independently, so the
+ *  subtrees of the row and column cluster bases are handled in
+ *  parallel up to the given depth.
+ *  @ref rkupdate_h2matrix uses this function with @ref max_pardepth
+ *  if OpenMP is enabled, so the H2-matrix arithmetic and the
+ *  factorizations in @ref h2arith benefit automatically.
+ *
+ *  @param R Low-rank matrix @f$R@f$.
+ *  @param Gh2 Target matrix @f$G@f$.
+ *  @param rwf has to be the father of the total weights of the row clusterbasis of C,\n
+ *    e.g. initialised by prepare_row_clusteroperator
+ *  @param cwf has to be the father of the total weights of the col clusterbasis of C,\n
+ *    e.g. initialised by prepare_col_clusteroperator
+ *  @param tm options of truncation
+ *  @param eps tolerance of truncation
+ *  @param pardepth Parallelization depth
+ */
+HEADER_PREFIX void
+rkupdate_parallel_h2matrix(prkmatrix R, ph2matrix Gh2, pclusteroperator rwf,
+			   pclusteroperator cwf, ptruncmode tm, real eps,
+			   uint pardepth);
+
 /**
  * @brief Prepares the weights of the row clusterbasis used by @ref rkupdate_h2matrix and the arithmetic functions in @ref h2arith  
  * 
@@ -112,6 +182,52 @@ prepare_row_clusteroperator(pclusterbasis rb, pclusterbasis cb, ptruncmode tm);
 HEADER_PREFIX pclusteroperator
 prepare_col_clusteroperator(pclusterbasis rb, pclusterbasis cb, ptruncmode tm);
 
+/* ------------------------------------------------------------
+ * Accumulated low-rank updates
+ * ------------------------------------------------------------ */
+
+/** @brief Create an accumulator for low-rank updates of an
+ *  @ref h2matrix.
+ *
+ *  @param Gh2 Target matrix @f$G@f$.
+ *  @param rwf has to be the father of the total weights of the row
+ *    clusterbasis of @f$G@f$, see @ref rkupdate_h2matrix.
+ *  @param cwf has to be the father of the total weights of the column
+ *    clusterbasis of @f$G@f$, see @ref rkupdate_h2matrix.
+ *  @param tm options of truncation
+ *  @param eps tolerance of truncation
+ *  @param maxrank If the accumulated rank exceeds this value, the
+ *    accumulated updates are truncated, and if the rank still exceeds
+ *    it, they are applied to @f$G@f$.
+ *  @returns New accumulator. */
+HEADER_PREFIX prkaccum
+new_rkaccum(ph2matrix Gh2, pclusteroperator rwf, pclusteroperator cwf,
+	    ptruncmode tm, real eps, uint maxrank);
+
+/** @brief Apply all remaining updates and delete an accumulator.
+ *
+ *  @param ra Accumulator to be deleted. */
+HEADER_PREFIX void
+del_rkaccum(prkaccum ra);
+
+/** @brief Add a low-rank update @f$R@f$ to an accumulator.
+ *
+ *  The factors of @f$R@f$ are appended to the accumulated updates,
+ *  @f$G@f$ is only changed if the accumulated rank exceeds
+ *  <tt>ra->maxrank</tt>.
+ *
+ *  @param R Low-rank matrix @f$R@f$, not changed.
+ *  @param ra Accumulator. */
+HEADER_PREFIX void
+add_rkaccum(pcrkmatrix R, prkaccum ra);
+
+/** @brief Apply all accumulated updates, @f$G \gets G + \sum_i R_i@f$,
+ *  with one call to @ref rkupdate_h2matrix.
+ *
+ *  @param ra Accumulator, empty afterwards. */
+HEADER_PREFIX void
+flush_rkaccum(prkaccum ra);
+
 /** @} */
 
 #endif
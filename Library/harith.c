@@ -3,8 +3,14 @@
  * All rights reserved, Steffen Boerm 2014
  * ------------------------------------------------------------ */
 
+#include <stdint.h>
+
 #include "harith.h"
 #include "basic.h"
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
 #include "eigensolvers.h"
 #include "factorizations.h"
 
@@ -40,15 +46,15 @@ trunc_ab_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   b = &r->B;
 
   /* Compute C = A B^* */
-  c = init_amatrix(&tmp1, rows, cols);
+  c = init_scratch_amatrix(&tmp1, rows, cols);
   clear_amatrix(c);
   addmul_amatrix(1.0, false, a, true, b, c);
   k1 = UINT_MIN(rows, cols);
 
   /* Compute singular value decomposition */
-  u = init_amatrix(&tmp2, rows, k1);
-  vt = init_amatrix(&tmp3, k1, cols);
-  sigma = init_realavector(&tmp4, k1);
+  u = init_scratch_amatrix(&tmp2, rows, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, cols);
+  sigma = init_scratch_realavector(&tmp4, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -96,11 +102,11 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   b = &r->B;
 
   /* Copy factor A */
-  a = init_amatrix(&tmp1, rows, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
   copy_amatrix(false, &r->A, a);
 
   /* Compute QR factorization of A */
-  tau = init_avector(&tmp5, k);
+  tau = init_scratch_avector(&tmp5, k);
   qrdecomp_amatrix(a, tau);
 
   /* Overwrite B by C = B A^* (C^* = A B^*) */
@@ -112,9 +118,9 @@ trunc_qb_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(cols, kr);
-  u = init_amatrix(&tmp2, cols, k1);
-  vt = init_amatrix(&tmp3, k1, kr);
-  sigma = init_realavector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp2, cols, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, kr);
+  sigma = init_scratch_realavector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -166,11 +172,11 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   a = &r->A;
 
   /* Copy factor B */
-  b = init_amatrix(&tmp1, cols, k);
+  b = init_scratch_amatrix(&tmp1, cols, k);
   copy_amatrix(false, &r->B, b);
 
   /* Compute QR factorization of B */
-  tau = init_avector(&tmp5, k);
+  tau = init_scratch_avector(&tmp5, k);
   qrdecomp_amatrix(b, tau);
 
   /* Overwrite A by C = A B^* (C^* = B A^*) */
@@ -182,9 +188,9 @@ trunc_aq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(rows, kc);
-  u = init_amatrix(&tmp2, rows, k1);
-  vt = init_amatrix(&tmp3, k1, kc);
-  sigma = init_realavector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp2, rows, k1);
+  vt = init_scratch_amatrix(&tmp3, k1, kc);
+  sigma = init_scratch_realavector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -235,23 +241,23 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   k = r->k;
 
   /* Copy factor A and B */
-  a = init_amatrix(&tmp1, rows, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
   copy_amatrix(false, &r->A, a);
-  b = init_amatrix(&tmp2, cols, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
   copy_amatrix(false, &r->B, b);
 
   /* Compute QR factorization Q_A R_A = A */
-  atau = init_avector(&tmp6, k);
+  atau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, atau);
   ak = UINT_MIN(k, rows);
 
   /* Compute QR factorization Q_B R_B = B */
-  btau = init_avector(&tmp7, k);
+  btau = init_scratch_avector(&tmp7, k);
   qrdecomp_amatrix(b, btau);
   bk = UINT_MIN(k, cols);
 
   /* Compute condensed matrix C = R_A R_B^* */
-  c = init_amatrix(&tmp3, ak, bk);
+  c = init_scratch_amatrix(&tmp3, ak, bk);
   clear_amatrix(c);
   a1 = init_sub_amatrix(&tmp4, a, ak, 0, k, 0);
   b1 = init_sub_amatrix(&tmp5, b, bk, 0, k, 0);
@@ -261,9 +267,9 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 
   /* Find singular value decomposition of Z */
   k1 = UINT_MIN(ak, bk);
-  u = init_amatrix(&tmp4, ak, k1);
-  vt = init_amatrix(&tmp5, k1, bk);
-  sigma = init_realavector(&tmp8, k1);
+  u = init_scratch_amatrix(&tmp4, ak, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, bk);
+  sigma = init_scratch_realavector(&tmp8, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -296,19 +302,11 @@ trunc_qq_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   uninit_amatrix(a);
 }
 
-void
-trunc_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
+static void
+trunc_svd_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
 {
   uint      rows, cols, k;
 
-  assert(r->A.cols == r->k);
-  assert(r->B.cols == r->k);
-
-#ifdef HARITH_RKMATRIX_QUICK_EXIT
-  if (r->k == 0)
-    return;
-#endif
-
   rows = r->A.rows;
   cols = r->B.rows;
   k = r->k;
@@ -332,6 +330,322 @@ trunc_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
   }
 }
 
+void
+trunc_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
+{
+  assert(r->A.cols == r->k);
+  assert(r->B.cols == r->k);
+
+#ifdef HARITH_RKMATRIX_QUICK_EXIT
+  if (r->k == 0)
+    return;
+#endif
+
+  /* A randomized range finder only pays off if the rank is high */
+  if (tm && tm->randomized && r->k >= 2 * HARITH_RANDOM_BLOCK)
+    trunc_random_rkmatrix(tm, eps, r);
+  else
+    trunc_svd_rkmatrix(tm, eps, r);
+}
+
+/* ------------------------------------------------------------
+ * Randomized low-rank approximation
+ * ------------------------------------------------------------ */
+
+/* Uniformly distributed number in (0,1), taken from a private xorshift
+ * generator so that concurrent calls neither share nor disturb the state
+ * of rand() */
+static real
+uniform_random(uint64_t * state)
+{
+  uint64_t  x = *state;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+
+  return (((x * UINT64_C(2685821657736338717)) >> 11) + 0.5)
+    / 9007199254740992.0;
+}
+
+/* Fill a matrix with standard normally distributed entries using the
+ * Box-Muller transformation */
+static void
+gaussian_amatrix(uint64_t * state, pamatrix a)
+{
+  longindex lda = a->ld;
+  real      rho, phi;
+  uint      i, j;
+
+  for (j = 0; j < a->cols; j++) {
+    for (i = 0; i < a->rows; i++) {
+      rho = REAL_SQRT(-2.0 * REAL_LOG(uniform_random(state)));
+      phi = 2.0 * M_PI * uniform_random(state);
+#ifdef USE_COMPLEX
+      a->a[i + j * lda] = rho * REAL_SQRT(0.5)
+	* (REAL_COS(phi) + I * REAL_SIN(phi));
+#else
+      a->a[i + j * lda] = rho * REAL_COS(phi);
+#endif
+    }
+  }
+}
+
+void
+rangefinder_rkmatrix(uint rows, uint cols, sampleoperator_t sample,
+		     void *data, uint kmax, pctruncmode tm, real eps,
+		     prkmatrix r)
+{
+  amatrix   tmp1, tmp2, tmp3, tmp4;
+  avector   tmp5;
+  pamatrix  Q, Q1, X, Y, C;
+  pavector  tau;
+  uint64_t  state;
+  real      norm, xnorm, ynorm, sum, error;
+  uint      k, p, i, j, l;
+
+  assert(r->A.rows == rows);
+  assert(r->B.rows == cols);
+
+  kmax = UINT_MIN(kmax, UINT_MIN(rows, cols));
+
+  /* Fixed seed, the result does not depend on earlier calls or on
+   * the order of calls in parallel algorithms */
+  state = UINT64_C(88172645463325252) ^ ((uint64_t) rows << 32) ^ cols;
+
+  /* The basis grows by one block per step, so its storage is
+   * proportional to the rank that is actually found */
+  Q = init_amatrix(&tmp1, rows, 0);
+
+  norm = 0.0;
+  k = 0;
+  while (k < kmax) {
+    p = UINT_MIN(HARITH_RANDOM_BLOCK, kmax - k);
+
+    /* Sample the range with Gaussian test vectors */
+    X = init_amatrix(&tmp2, cols, p);
+    gaussian_amatrix(&state, X);
+
+    Y = init_amatrix(&tmp3, rows, p);
+    clear_amatrix(Y);
+    sample(1.0, false, X, data, Y);
+
+    /* Estimate the norm of the matrix from the first sample, a lower
+     * bound for the spectral and an unbiased estimate for the Frobenius
+     * norm */
+    if (k == 0) {
+      sum = 0.0;
+      for (l = 0; l < p; l++) {
+	xnorm = 0.0;
+	for (j = 0; j < cols; j++)
+	  xnorm += ABSSQR(X->a[j + l * X->ld]);
+	ynorm = 0.0;
+	for (i = 0; i < rows; i++)
+	  ynorm += ABSSQR(Y->a[i + l * Y->ld]);
+
+	sum += ynorm;
+	if (ynorm > norm * norm * xnorm)
+	  norm = REAL_SQRT(ynorm / xnorm);
+      }
+      if (tm && tm->frobenius)
+	norm = REAL_SQRT(sum / p);
+    }
+
+    /* Project out the current basis, twice for stability */
+    if (k > 0) {
+      Q1 = init_sub_amatrix(&tmp4, Q, rows, 0, k, 0);
+      C = new_amatrix(k, p);
+      for (l = 0; l < 2; l++) {
+	clear_amatrix(C);
+	addmul_amatrix(1.0, true, Q1, false, Y, C);
+	addmul_amatrix(-1.0, false, Q1, false, C, Y);
+      }
+      del_amatrix(C);
+      uninit_amatrix(Q1);
+    }
+
+    /* A posteriori error estimate: the mean squared norm of the
+     * projected samples is an unbiased estimate for the squared
+     * Frobenius norm of the remainder, which bounds its spectral norm */
+    sum = 0.0;
+    for (l = 0; l < p; l++)
+      for (i = 0; i < rows; i++)
+	sum += ABSSQR(Y->a[i + l * Y->ld]);
+    error = REAL_SQRT(sum / p);
+
+    uninit_amatrix(X);
+
+    if (error <= (tm && tm->absolute ? eps : eps * norm)) {
+      uninit_amatrix(Y);
+      break;
+    }
+
+    /* Orthonormalize the new samples and extend the basis */
+    tau = init_avector(&tmp5, p);
+    qrdecomp_amatrix(Y, tau);
+    resizecopy_amatrix(Q, rows, k + p);
+    Q1 = init_sub_amatrix(&tmp4, Q, rows, 0, p, k);
+    qrexpand_amatrix(Y, tau, Q1);
+    uninit_amatrix(Q1);
+    uninit_avector(tau);
+    uninit_amatrix(Y);
+
+    k += p;
+  }
+
+  /* Project the matrix into the range, R = Q (M^* Q)^* */
+  setrank_rkmatrix(r, k);
+  if (k > 0) {
+    Q1 = init_sub_amatrix(&tmp4, Q, rows, 0, k, 0);
+    copy_amatrix(false, Q1, &r->A);
+    clear_amatrix(&r->B);
+    sample(1.0, true, Q1, data, &r->B);
+    uninit_amatrix(Q1);
+
+    /* The basis may be slightly too large, truncate the small factors */
+    trunc_svd_rkmatrix(tm, eps, r);
+  }
+
+  uninit_amatrix(Q);
+}
+
+static void
+sample_amatrix(field alpha, bool trans, pcamatrix x, void *data, pamatrix y)
+{
+  pcamatrix a = (pcamatrix) data;
+
+  addmul_amatrix(alpha, trans, a, false, x, y);
+}
+
+void
+decomp_random_rkmatrix(pcamatrix a, pctruncmode tm, real eps, prkmatrix r)
+{
+  rangefinder_rkmatrix(a->rows, a->cols, sample_amatrix, (void *) a,
+		       UINT_MIN(a->rows, a->cols), tm, eps, r);
+}
+
+static void
+sample_rkmatrix(field alpha, bool trans, pcamatrix x, void *data,
+		pamatrix y)
+{
+  pcrkmatrix a = (pcrkmatrix) data;
+  amatrix   tmp;
+  pamatrix  c;
+
+  c = init_amatrix(&tmp, a->k, x->cols);
+  clear_amatrix(c);
+  if (trans) {
+    addmul_amatrix(1.0, true, &a->A, false, x, c);
+    addmul_amatrix(alpha, false, &a->B, false, c, y);
+  }
+  else {
+    addmul_amatrix(1.0, true, &a->B, false, x, c);
+    addmul_amatrix(alpha, false, &a->A, false, c, y);
+  }
+  uninit_amatrix(c);
+}
+
+void
+trunc_random_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
+{
+  prkmatrix a;
+
+  a = clone_rkmatrix(r);
+
+  rangefinder_rkmatrix(r->A.rows, r->B.rows, sample_rkmatrix, (void *) a,
+		       r->k, tm, eps, r);
+
+  del_rkmatrix(a);
+}
+
+/* ------------------------------------------------------------
+ * Lossy compression
+ * ------------------------------------------------------------ */
+
+void
+compress_rkmatrix(pctruncmode tm, real eps, prkmatrix r)
+{
+  avector   tmp;
+  pavector  a;
+  real     *sigma, *tola, *tolb;
+  real      rho;
+  uint      k, nu;
+
+  assert(r->CA == NULL);
+
+  /* Bring into the form A = U Sigma, B = V */
+  trunc_rkmatrix(tm, eps, r);
+  k = r->k;
+
+  sigma = allocreal(k);
+  tola = allocreal(k);
+  tolb = allocreal(k);
+
+  for (nu = 0; nu < k; nu++) {
+    a = init_column_avector(&tmp, &r->A, nu);
+    sigma[nu] = norm2_avector(a);
+    uninit_avector(a);
+  }
+
+  /* Reference norm matching the truncation mode */
+  rho = 1.0;
+  if (tm == NULL || !tm->absolute) {
+    rho = 0.0;
+    if (tm && tm->frobenius) {
+      for (nu = 0; nu < k; nu++)
+	rho += REAL_SQR(sigma[nu]);
+      rho = REAL_SQRT(rho);
+    }
+    else
+      for (nu = 0; nu < k; nu++)
+	rho = REAL_MAX(rho, sigma[nu]);
+  }
+
+  /* Error in A is at most sqrt(k) eps rho / (2k), error in A B^* due to
+   * B is at most sum_nu sigma_nu eps rho / (2k sigma_nu) */
+  for (nu = 0; nu < k; nu++) {
+    tola[nu] = eps * rho / (2.0 * k);
+    tolb[nu] = (sigma[nu] > 0.0 ? tola[nu] / sigma[nu] : 2.0);
+  }
+
+  r->CA = new_qmatrix(&r->A, tola);
+  r->CB = new_qmatrix(&r->B, tolb);
+
+  resize_amatrix(&r->A, r->A.rows, 0);
+  resize_amatrix(&r->B, r->B.rows, 0);
+
+  freemem(tolb);
+  freemem(tola);
+  freemem(sigma);
+}
+
+void
+compress_hmatrix(pctruncmode tm, real eps, phmatrix hm)
+{
+  uint      i;
+
+  if (hm->son) {
+    for (i = 0; i < hm->rsons * hm->csons; i++)
+      compress_hmatrix(tm, eps, hm->son[i]);
+  }
+  else if (hm->r && hm->r->CA == NULL)
+    compress_rkmatrix(tm, eps, hm->r);
+}
+
+void
+decompress_hmatrix(phmatrix hm)
+{
+  uint      i;
+
+  if (hm->son) {
+    for (i = 0; i < hm->rsons * hm->csons; i++)
+      decompress_hmatrix(hm->son[i]);
+  }
+  else if (hm->r)
+    decompress_rkmatrix(hm->r);
+}
+
 /* ------------------------------------------------------------
  * Truncated addition of an amatrix to an rkmatrix.
  * ------------------------------------------------------------ */
@@ -363,7 +677,7 @@ add_amatrix_rkmatrix(field alpha, bool atrans, pcamatrix a, pctruncmode tm,
   rows = b->A.rows;
   cols = b->B.rows;
 
-  z = init_amatrix(&tmp1, rows, cols);
+  z = init_scratch_amatrix(&tmp1, rows, cols);
 
   /* Compute sum */
   if (atrans)
@@ -374,9 +688,9 @@ add_amatrix_rkmatrix(field alpha, bool atrans, pcamatrix a, pctruncmode tm,
 
   /* Find singular value decomposition of Z */
   k = UINT_MIN(rows, cols);
-  u = init_amatrix(&tmp2, rows, k);
-  vt = init_amatrix(&tmp3, k, cols);
-  sigma = init_realavector(&tmp4, k);
+  u = init_scratch_amatrix(&tmp2, rows, k);
+  vt = init_scratch_amatrix(&tmp3, k, cols);
+  sigma = init_scratch_realavector(&tmp4, k);
   svd_amatrix(z, sigma, u, vt);
 
   /* Determine rank */
@@ -509,8 +823,8 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->B.rows == cols);
 
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -532,15 +846,15 @@ add_ab_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute C = A B^* */
-  c = init_amatrix(&tmp3, rows, cols);
+  c = init_scratch_amatrix(&tmp3, rows, cols);
   clear_amatrix(c);
   addmul_amatrix(1.0, false, a, true, b, c);
   k1 = UINT_MIN(rows, cols);
 
   /* Compute singular value decomposition */
-  u = init_amatrix(&tmp4, rows, k1);
-  vt = init_amatrix(&tmp5, k1, cols);
-  sigma = init_realavector(&tmp6, k1);
+  u = init_scratch_amatrix(&tmp4, rows, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, cols);
+  sigma = init_scratch_realavector(&tmp6, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -590,8 +904,8 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->B.rows == cols);
 
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -612,7 +926,7 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization of A */
-  tau = init_avector(&tmp6, k);
+  tau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, tau);
 
   /* Overwrite B by C = B A^* (C^* = A B^*) */
@@ -624,9 +938,9 @@ add_qb_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(cols, kr);
-  u = init_amatrix(&tmp3, cols, k1);
-  vt = init_amatrix(&tmp4, k1, kr);
-  sigma = init_realavector(&tmp7, k1);
+  u = init_scratch_amatrix(&tmp3, cols, k1);
+  vt = init_scratch_amatrix(&tmp4, k1, kr);
+  sigma = init_scratch_realavector(&tmp7, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -679,8 +993,8 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->B.rows == cols);
 
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -701,7 +1015,7 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization of B */
-  tau = init_avector(&tmp6, k);
+  tau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(b, tau);
 
   /* Overwrite A by C = A B^* (C^* = B A^*) */
@@ -713,9 +1027,9 @@ add_aq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Compute singular value decomposition */
   k1 = UINT_MIN(rows, kc);
-  u = init_amatrix(&tmp3, rows, k1);
-  vt = init_amatrix(&tmp4, k1, kc);
-  sigma = init_realavector(&tmp7, k1);
+  u = init_scratch_amatrix(&tmp3, rows, k1);
+  vt = init_scratch_amatrix(&tmp4, k1, kc);
+  sigma = init_scratch_realavector(&tmp7, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -768,8 +1082,8 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   assert(src->B.rows == cols);
 
   /* Create matrices A = (alpha Asrc, Atrg) and B = (Bsrc, Btrg) */
-  a = init_amatrix(&tmp1, rows, k);
-  b = init_amatrix(&tmp2, cols, k);
+  a = init_scratch_amatrix(&tmp1, rows, k);
+  b = init_scratch_amatrix(&tmp2, cols, k);
 
   a1 = init_sub_amatrix(&tmp3, a, rows, 0, src->k, 0);
   copy_amatrix(false, &src->A, a1);
@@ -790,17 +1104,17 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(b1);
 
   /* Compute QR factorization Q_A R_A = A */
-  atau = init_avector(&tmp6, k);
+  atau = init_scratch_avector(&tmp6, k);
   qrdecomp_amatrix(a, atau);
   ak = UINT_MIN(k, a->rows);
 
   /* Compute QR factorization Q_B R_B = B */
-  btau = init_avector(&tmp7, k);
+  btau = init_scratch_avector(&tmp7, k);
   qrdecomp_amatrix(b, btau);
   bk = UINT_MIN(k, b->rows);
 
   /* Compute condensed matrix C = R_A R_B^* */
-  c = init_amatrix(&tmp3, ak, bk);
+  c = init_scratch_amatrix(&tmp3, ak, bk);
   clear_amatrix(c);
   a1 = init_sub_amatrix(&tmp4, a, ak, 0, k, 0);
   b1 = init_sub_amatrix(&tmp5, b, bk, 0, k, 0);
@@ -810,9 +1124,9 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
 
   /* Find singular value decomposition of C */
   k1 = UINT_MIN(ak, bk);
-  u = init_amatrix(&tmp4, ak, k1);
-  vt = init_amatrix(&tmp5, k1, bk);
-  sigma = init_realavector(&tmp8, k1);
+  u = init_scratch_amatrix(&tmp4, ak, k1);
+  vt = init_scratch_amatrix(&tmp5, k1, bk);
+  sigma = init_scratch_realavector(&tmp8, k1);
   svd_amatrix(c, sigma, u, vt);
 
   /* Determine rank */
@@ -845,6 +1159,36 @@ add_qq_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm,
   uninit_amatrix(a);
 }
 
+/* Randomized version: append the factors of the source and truncate
+ * the result by the range finder. */
+static void
+add_random_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm, real eps,
+		    prkmatrix trg)
+{
+  amatrix   tmp;
+  pamatrix  x;
+  uint      rows, cols, k;
+
+  rows = trg->A.rows;
+  cols = trg->B.rows;
+  k = trg->k;
+
+  resizecopy_amatrix(&trg->A, rows, k + src->k);
+  resizecopy_amatrix(&trg->B, cols, k + src->k);
+  trg->k = k + src->k;
+
+  x = init_sub_amatrix(&tmp, &trg->A, rows, 0, src->k, k);
+  copy_amatrix(false, &src->A, x);
+  scale_amatrix(alpha, x);
+  uninit_amatrix(x);
+
+  x = init_sub_amatrix(&tmp, &trg->B, cols, 0, src->k, k);
+  copy_amatrix(false, &src->B, x);
+  uninit_amatrix(x);
+
+  trunc_random_rkmatrix(tm, eps, trg);
+}
+
 /* User-visible function, chooses appropriate truncation function by
  * considering the rank, number of rows and number of columns. */
 void
@@ -862,6 +1206,12 @@ add_rkmatrix(field alpha, pcrkmatrix src, pctruncmode tm, real eps,
   cols = trg->B.rows;
   k = src->k + trg->k;
 
+  /* Randomized truncation only pays off if the rank is high */
+  if (tm && tm->randomized && k >= 2 * HARITH_RANDOM_BLOCK) {
+    add_random_rkmatrix(alpha, src, tm, eps, trg);
+    return;
+  }
+
   /* Choose most efficient truncation algorithm */
   if (k < rows) {
     if (k < cols) {
@@ -1543,7 +1893,7 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
     k = trg->k + src->k;
 
     /* Set up matrix B = (B1 B2) */
-    b = init_amatrix(&tmp1, cols, k);
+    b = init_scratch_amatrix(&tmp1, cols, k);
 
     b1 = init_sub_amatrix(&tmp2, b, cols, 0, trg->k, 0);
     copy_amatrix(false, &trg->B, b1);
@@ -1555,20 +1905,20 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
 
     /* Compute factorization A1 = Q1 R1 */
     k1 = UINT_MIN(trg->A.rows, trg->k);
-    a1 = init_amatrix(&tmp3, trg->A.rows, trg->k);
+    a1 = init_scratch_amatrix(&tmp3, trg->A.rows, trg->k);
     copy_amatrix(false, &trg->A, a1);
-    tau1 = init_avector(&tmp7, k1);
+    tau1 = init_scratch_avector(&tmp7, k1);
     qrdecomp_amatrix(a1, tau1);
 
     /* Compute factorization A2 = Q2 R2 */
     k2 = UINT_MIN(src->A.rows, src->k);
-    a2 = init_amatrix(&tmp4, src->A.rows, src->k);
+    a2 = init_scratch_amatrix(&tmp4, src->A.rows, src->k);
     copy_amatrix(false, &src->A, a2);
-    tau2 = init_avector(&tmp8, k2);
+    tau2 = init_scratch_avector(&tmp8, k2);
     qrdecomp_amatrix(a2, tau2);
 
     kk = k1 + k2;
-    c = init_amatrix(&tmp5, cols, kk);
+    c = init_scratch_amatrix(&tmp5, cols, kk);
 
     /* Compute B1 R1^* */
     b1 = init_sub_amatrix(&tmp2, b, cols, 0, trg->k, 0);
@@ -1599,9 +1949,9 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
 
     /* Compute SVD */
     kmax = UINT_MIN(kk, cols);
-    u = init_amatrix(&tmp1, cols, kmax);
-    vt = init_amatrix(&tmp2, kmax, kk);
-    sigma = init_realavector(&tmp9, kmax);
+    u = init_scratch_amatrix(&tmp1, cols, kmax);
+    vt = init_scratch_amatrix(&tmp2, kmax, kk);
+    sigma = init_scratch_realavector(&tmp9, kmax);
     svd_amatrix(c, sigma, u, vt);
 
     /* Determine rank */
@@ -1665,7 +2015,7 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
     k = trg->k + src->k;
 
     /* Set up matrix A = (A1 A2) */
-    a = init_amatrix(&tmp1, rows, k);
+    a = init_scratch_amatrix(&tmp1, rows, k);
 
     a1 = init_sub_amatrix(&tmp2, a, rows, 0, trg->k, 0);
     copy_amatrix(false, &trg->A, a1);
@@ -1677,20 +2027,20 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
 
     /* Compute factorization B1 = Q1 R1 */
     k1 = UINT_MIN(trg->B.rows, trg->k);
-    b1 = init_amatrix(&tmp3, trg->B.rows, trg->k);
+    b1 = init_scratch_amatrix(&tmp3, trg->B.rows, trg->k);
     copy_amatrix(false, &trg->B, b1);
-    tau1 = init_avector(&tmp7, k1);
+    tau1 = init_scratch_avector(&tmp7, k1);
     qrdecomp_amatrix(b1, tau1);
 
     /* Compute factorization B2 = Q2 R2 */
     k2 = UINT_MIN(src->B.rows, src->k);
-    b2 = init_amatrix(&tmp4, src->B.rows, src->k);
+    b2 = init_scratch_amatrix(&tmp4, src->B.rows, src->k);
     copy_amatrix(false, &src->B, b2);
-    tau2 = init_avector(&tmp8, k2);
+    tau2 = init_scratch_avector(&tmp8, k2);
     qrdecomp_amatrix(b2, tau2);
 
     kk = k1 + k2;
-    c = init_amatrix(&tmp5, rows, kk);
+    c = init_scratch_amatrix(&tmp5, rows, kk);
 
     /* Compute A1 R1^* */
     a1 = init_sub_amatrix(&tmp2, a, rows, 0, trg->k, 0);
@@ -1721,9 +2071,9 @@ merge_aq_rkmatrix(bool colmerge, pcrkmatrix src, pctruncmode tm,
 
     /* Compute SVD */
     kmax = UINT_MIN(kk, rows);
-    u = init_amatrix(&tmp1, rows, kmax);
-    vt = init_amatrix(&tmp2, kmax, kk);
-    sigma = init_realavector(&tmp9, kmax);
+    u = init_scratch_amatrix(&tmp1, rows, kmax);
+    vt = init_scratch_amatrix(&tmp2, kmax, kk);
+    sigma = init_scratch_realavector(&tmp9, kmax);
     svd_amatrix(c, sigma, u, vt);
 
     /* Determine rank */
@@ -1811,7 +2161,7 @@ merge_hmatrix_rkmatrix(pchmatrix s, pctruncmode tm, real eps)
 	assert(s->son[j * rsons]->r != 0);
 	s1 = s->son[j * rsons]->r;
 
-	r1 = init_rkmatrix(&tmp1, s1->A.rows, s1->B.rows, s1->k);
+	r1 = init_scratch_rkmatrix(&tmp1, s1->A.rows, s1->B.rows, s1->k);
 	copy_rkmatrix(false, s1, r1);
 
 	for (i = 1; i < rsons; i++) {
@@ -1899,7 +2249,7 @@ addmul_rkmatrix_amatrix_amatrix(field alpha, bool xtrans, pcrkmatrix x,
       assert(y->rows == rows);
     }
 
-    ay = init_amatrix(&tmp1, k, (ytrans ? y->rows : y->cols));
+    ay = init_scratch_amatrix(&tmp1, k, (ytrans ? y->rows : y->cols));
     clear_amatrix(ay);
     addmul_amatrix(1.0, true, &x->A, ytrans, y, ay);
 
@@ -1933,7 +2283,7 @@ addmul_rkmatrix_amatrix_amatrix(field alpha, bool xtrans, pcrkmatrix x,
       assert(y->rows == cols);
     }
 
-    by = init_amatrix(&tmp1, k, (ytrans ? y->rows : y->cols));
+    by = init_scratch_amatrix(&tmp1, k, (ytrans ? y->rows : y->cols));
     clear_amatrix(by);
     addmul_amatrix(1.0, true, &x->B, ytrans, y, by);
 
@@ -2169,9 +2519,9 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     else {
       if (xf->rows > xf->cols) {
 	/* Compute rkmatrix X Y = X (Y^* I^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
 	copy_amatrix(false, xf, &xy->A);
-	id = init_amatrix(&tmp2, xf->cols, xf->cols);
+	id = init_scratch_amatrix(&tmp2, xf->cols, xf->cols);
 	identity_amatrix(id);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, true, id, false,
@@ -2186,7 +2536,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       }
       else {
 	/* Compute rkmatrix X Y = I (Y^* X^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
 	identity_amatrix(&xy->A);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, true, xf, false,
@@ -2202,7 +2552,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   }
   else if (x->r) {
     /* Compute rkmatrix X Y = A (Y^* B)^* */
-    xy = init_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
+    xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
     copy_amatrix(false, &x->r->A, &xy->A);
     clear_amatrix(&xy->B);
     addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, false, &x->r->B,
@@ -2225,9 +2575,9 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else {
 	if (yf->cols > yf->rows) {
 	  /* Compute rkmatrix X Y = (X I) (Y^*)^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
 	  copy_amatrix(true, yf, &xy->B);
-	  id = init_amatrix(&tmp2, yf->rows, yf->rows);
+	  id = init_scratch_amatrix(&tmp2, yf->rows, yf->rows);
 	  identity_amatrix(id);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, false, x, false, id, false,
@@ -2241,7 +2591,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	}
 	else {
 	  /* Compute rkmatrix X Y = (X Y) I^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
 	  identity_amatrix(&xy->B);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, false, x, false, yf, false,
@@ -2257,7 +2607,7 @@ addmul_nn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     }
     else if (y->r) {
       /* Compute rkmatrix X Y = (X A) B^* */
-      xy = init_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
+      xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
       copy_amatrix(false, &y->r->B, &xy->B);
       clear_amatrix(&xy->A);
       addmul_hmatrix_amatrix_amatrix(alpha, false, x, false, &y->r->A, false,
@@ -2438,9 +2788,9 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     else {
       if (xf->rows > xf->cols) {
 	/* Compute rkmatrix X Y^* = X (Y I^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
 	copy_amatrix(false, xf, &xy->A);
-	id = init_amatrix(&tmp2, xf->cols, xf->cols);
+	id = init_scratch_amatrix(&tmp2, xf->cols, xf->cols);
 	identity_amatrix(id);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, true, id, false,
@@ -2455,7 +2805,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       }
       else {
 	/* Compute rkmatrix X Y^* = I (Y X^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
 	identity_amatrix(&xy->A);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, true, xf, false,
@@ -2471,7 +2821,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   }
   else if (x->r) {
     /* Compute rkmatrix X Y^* = A (Y B)^* */
-    xy = init_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
+    xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
     copy_amatrix(false, &x->r->A, &xy->A);
     clear_amatrix(&xy->B);
     addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, false, &x->r->B,
@@ -2494,9 +2844,9 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else {
 	if (yf->cols < yf->rows) {
 	  /* Compute rkmatrix X Y^* = (X I) Y^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
 	  copy_amatrix(false, yf, &xy->B);
-	  id = init_amatrix(&tmp2, yf->cols, yf->cols);
+	  id = init_scratch_amatrix(&tmp2, yf->cols, yf->cols);
 	  identity_amatrix(id);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, false, x, false, id, false,
@@ -2510,7 +2860,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	}
 	else {
 	  /* Compute rkmatrix X Y^* = (X Y^*) I^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
 	  identity_amatrix(&xy->B);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, false, x, true, yf, false,
@@ -2526,7 +2876,7 @@ addmul_nt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     }
     else if (y->r) {
       /* Compute rkmatrix X Y^* = (X B) A^* */
-      xy = init_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
+      xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
       copy_amatrix(false, &y->r->A, &xy->B);
       clear_amatrix(&xy->A);
       addmul_hmatrix_amatrix_amatrix(alpha, false, x, false, &y->r->B, false,
@@ -2707,9 +3057,9 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     else {
       if (xf->rows < xf->cols) {
 	/* Compute rkmatrix X^* Y = X^* (Y^* I^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
 	copy_amatrix(true, xf, &xy->A);
-	id = init_amatrix(&tmp2, xf->rows, xf->rows);
+	id = init_scratch_amatrix(&tmp2, xf->rows, xf->rows);
 	identity_amatrix(id);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, true, id, false,
@@ -2724,7 +3074,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       }
       else {
 	/* Compute rkmatrix X^* Y = I (Y^* X)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
 	identity_amatrix(&xy->A);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, false, xf, false,
@@ -2740,7 +3090,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   }
   else if (x->r) {
     /* Compute rkmatrix X^* Y = B (Y^* A)^* */
-    xy = init_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
+    xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
     copy_amatrix(false, &x->r->B, &xy->A);
     clear_amatrix(&xy->B);
     addmul_hmatrix_amatrix_amatrix(CONJ(alpha), true, y, false, &x->r->A,
@@ -2763,9 +3113,9 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else {
 	if (yf->cols > yf->rows) {
 	  /* Compute rkmatrix X^* Y = (X^* I) (Y^*)^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
 	  copy_amatrix(true, yf, &xy->B);
-	  id = init_amatrix(&tmp2, yf->rows, yf->rows);
+	  id = init_scratch_amatrix(&tmp2, yf->rows, yf->rows);
 	  identity_amatrix(id);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, true, x, false, id, false,
@@ -2779,7 +3129,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	}
 	else {
 	  /* Compute rkmatrix X^* Y = (X^* Y) I^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
 	  identity_amatrix(&xy->B);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, true, x, false, yf, false,
@@ -2795,7 +3145,7 @@ addmul_tn_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     }
     else if (y->r) {
       /* Compute rkmatrix X^* Y = (X^* A) B^* */
-      xy = init_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
+      xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
       copy_amatrix(false, &y->r->B, &xy->B);
       clear_amatrix(&xy->A);
       addmul_hmatrix_amatrix_amatrix(alpha, true, x, false, &y->r->A, false,
@@ -2976,9 +3326,9 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     else {
       if (xf->rows < xf->cols) {
 	/* Compute rkmatrix X^* Y^* = X^* (Y I^*)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->rows);
 	copy_amatrix(true, xf, &xy->A);
-	id = init_amatrix(&tmp2, xf->rows, xf->rows);
+	id = init_scratch_amatrix(&tmp2, xf->rows, xf->rows);
 	identity_amatrix(id);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, true, id, false,
@@ -2993,7 +3343,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       }
       else {
 	/* Compute rkmatrix X^* Y^* = I (Y X)^* */
-	xy = init_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
+	xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, xf->cols);
 	identity_amatrix(&xy->A);
 	clear_amatrix(&xy->B);
 	addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, false, xf,
@@ -3009,7 +3359,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
   }
   else if (x->r) {
     /* Compute rkmatrix X^* Y^* = B (Y A)^* */
-    xy = init_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
+    xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, x->r->k);
     copy_amatrix(false, &x->r->B, &xy->A);
     clear_amatrix(&xy->B);
     addmul_hmatrix_amatrix_amatrix(CONJ(alpha), false, y, false, &x->r->A,
@@ -3031,9 +3381,9 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
       else {
 	if (yf->cols < yf->rows) {
 	  /* Compute rkmatrix X^* Y^* = (X^* I) Y^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->cols);
 	  copy_amatrix(false, yf, &xy->B);
-	  id = init_amatrix(&tmp2, yf->cols, yf->cols);
+	  id = init_scratch_amatrix(&tmp2, yf->cols, yf->cols);
 	  identity_amatrix(id);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, true, x, false, id, false,
@@ -3047,7 +3397,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
 	}
 	else {
 	  /* Compute rkmatrix X^* Y^* = (X^* Y^*) I^* */
-	  xy = init_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
+	  xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, yf->rows);
 	  identity_amatrix(&xy->B);
 	  clear_amatrix(&xy->A);
 	  addmul_hmatrix_amatrix_amatrix(alpha, true, x, true, yf, false,
@@ -3063,7 +3413,7 @@ addmul_tt_hmatrix(field alpha, pchmatrix x, pchmatrix y,
     }
     else if (y->r) {
       /* Compute rkmatrix X^* Y^* = (X^* B) A^* */
-      xy = init_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
+      xy = init_scratch_rkmatrix(&tmp1, rc->size, cc->size, y->r->k);
       copy_amatrix(false, &y->r->A, &xy->B);
       clear_amatrix(&xy->A);
       addmul_hmatrix_amatrix_amatrix(alpha, true, x, false, &y->r->B, false,
@@ -3249,7 +3599,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     if (xtrans) {
       if (xf->cols <= xf->rows) {
 	/* Compute M = X^* Y = (Y^* X)^* */
-	mf = init_amatrix(&tmp1, xf->cols,
+	mf = init_scratch_amatrix(&tmp1, xf->cols,
 			  (ytrans ? y->rc->size : y->cc->size));
 	clear_amatrix(mf);
 	addmul_hmatrix_amatrix_amatrix(1.0, !ytrans, y, !xtrans, xf, true,
@@ -3259,7 +3609,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
       }
       else {
 	/* Compute M = X^* Y = X^* (Y^*)^* */
-	mr = init_rkmatrix(&tmp2, xf->cols,
+	mr = init_scratch_rkmatrix(&tmp2, xf->cols,
 			   (ytrans ? y->rc->size : y->cc->size), xf->rows);
 	copy_amatrix(true, xf, &mr->A);
 	clear_amatrix(&mr->B);
@@ -3271,7 +3621,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     else {
       if (xf->rows <= xf->cols) {
 	/* Compute M = X Y = (Y^* X^*)^* */
-	mf = init_amatrix(&tmp1, xf->rows,
+	mf = init_scratch_amatrix(&tmp1, xf->rows,
 			  (ytrans ? y->rc->size : y->cc->size));
 	clear_amatrix(mf);
 	addmul_hmatrix_amatrix_amatrix(1.0, !ytrans, y, !xtrans, xf, true,
@@ -3281,7 +3631,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
       }
       else {
 	/* Compute M = X Y = X (Y^*)^* */
-	mr = init_rkmatrix(&tmp2, xf->rows,
+	mr = init_scratch_rkmatrix(&tmp2, xf->rows,
 			   (ytrans ? y->rc->size : y->cc->size), xf->cols);
 	copy_amatrix(false, xf, &mr->A);
 	clear_amatrix(&mr->B);
@@ -3296,7 +3646,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     if (ytrans) {
       if (yf->rows <= yf->cols) {
 	/* Compute M = X Y^* */
-	mf = init_amatrix(&tmp1, (xtrans ? x->cc->size : x->rc->size),
+	mf = init_scratch_amatrix(&tmp1, (xtrans ? x->cc->size : x->rc->size),
 			  yf->rows);
 	clear_amatrix(mf);
 	addmul_hmatrix_amatrix_amatrix(1.0, xtrans, x, ytrans, yf, false, mf);
@@ -3305,7 +3655,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
       }
       else {
 	/* Compute M = X Y^* */
-	mr = init_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
+	mr = init_scratch_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
 			   yf->rows, yf->cols);
 	clear_amatrix(&mr->A);
 	add_hmatrix_amatrix(1.0, xtrans, x, &mr->A);
@@ -3317,7 +3667,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     else {
       if (yf->cols <= yf->rows) {
 	/* Compute M = X Y */
-	mf = init_amatrix(&tmp1, (xtrans ? x->cc->size : x->rc->size),
+	mf = init_scratch_amatrix(&tmp1, (xtrans ? x->cc->size : x->rc->size),
 			  yf->cols);
 	clear_amatrix(mf);
 	addmul_hmatrix_amatrix_amatrix(1.0, xtrans, x, ytrans, yf, false, mf);
@@ -3326,7 +3676,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
       }
       else {
 	/* Compute M = X Y = X (Y^*)^* */
-	mr = init_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
+	mr = init_scratch_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
 			   yf->cols, yf->rows);
 	clear_amatrix(&mr->A);
 	add_hmatrix_amatrix(1.0, xtrans, x, &mr->A);
@@ -3340,7 +3690,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     xr = x->r;
     if (xtrans) {
       /* Compute M = B A^* Y = B (Y^* A)^*, where X = A B^* */
-      mr = init_rkmatrix(&tmp2, x->cc->size,
+      mr = init_scratch_rkmatrix(&tmp2, x->cc->size,
 			 (ytrans ? y->rc->size : y->cc->size), xr->k);
       copy_amatrix(false, &xr->B, &mr->A);
       clear_amatrix(&mr->B);
@@ -3351,7 +3701,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     }
     else {
       /* Compute M = A B^* Y = A (Y^* B)^*, where X = A B^* */
-      mr = init_rkmatrix(&tmp2, x->rc->size,
+      mr = init_scratch_rkmatrix(&tmp2, x->rc->size,
 			 (ytrans ? y->rc->size : y->cc->size), xr->k);
       copy_amatrix(false, &xr->A, &mr->A);
       clear_amatrix(&mr->B);
@@ -3365,7 +3715,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     yr = y->r;
     if (ytrans) {
       /* Compute M = X B A^* = (X B) A^*, where Y = A B^* */
-      mr = init_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
+      mr = init_scratch_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
 			 y->rc->size, yr->k);
       clear_amatrix(&mr->A);
       addmul_hmatrix_amatrix_amatrix(1.0, xtrans, x, false, &yr->B, false,
@@ -3376,7 +3726,7 @@ addmul_lower_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
     }
     else {
       /* Compute M = X A B^* = (X A) B^*, where Y = A B^* */
-      mr = init_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
+      mr = init_scratch_rkmatrix(&tmp2, (xtrans ? x->cc->size : x->rc->size),
 			 y->cc->size, yr->k);
       clear_amatrix(&mr->A);
       addmul_hmatrix_amatrix_amatrix(1.0, xtrans, x, false, &yr->A, false,
@@ -3891,7 +4241,7 @@ triangularsolve_hmatrix_avector(bool alower, bool aunit, bool atrans,
   n = a->rc->size;
   idx = a->rc->idx;
 
-  xp = init_avector(&tmp, n);
+  xp = init_scratch_avector(&tmp, n);
   for (i = 0; i < n; i++)
     xp->v[i] = x->v[idx[i]];
 
@@ -5221,7 +5571,7 @@ triangulareval_hmatrix_avector(bool alower, bool aunit, bool atrans,
   n = a->rc->size;
   idx = a->rc->idx;
 
-  xp = init_avector(&tmp, n);
+  xp = init_scratch_avector(&tmp, n);
   for (i = 0; i < n; i++)
     xp->v[i] = x->v[idx[i]];
 
@@ -6051,7 +6401,7 @@ lrsolve_hmatrix_avector(bool atrans, pchmatrix a, pavector x)
   n = a->rc->size;
   idx = a->rc->idx;
 
-  xp = init_avector(&tmp, n);
+  xp = init_scratch_avector(&tmp, n);
   for (i = 0; i < n; i++)
     xp->v[i] = x->v[idx[i]];
 
@@ -6120,7 +6470,7 @@ cholsolve_hmatrix_avector(pchmatrix a, pavector x)
   n = a->rc->size;
   idx = a->rc->idx;
 
-  xp = init_avector(&tmp, n);
+  xp = init_scratch_avector(&tmp, n);
   for (i = 0; i < n; i++)
     xp->v[i] = x->v[idx[i]];
 
@@ -6131,3 +6481,332 @@ cholsolve_hmatrix_avector(pchmatrix a, pavector x)
     x->v[idx[i]] = xp->v[i];
   uninit_avector(xp);
 }
+
+/* ------------------------------------------------------------
+ * Parallel triangular factorizations
+ * ------------------------------------------------------------ */
+
+#ifdef USE_OPENMP
+/* The factorizations are expressed as directed acyclic graphs of
+ * OpenMP tasks on every level of the hierarchy: each task works on one
+ * submatrix, the dependencies are declared by the addresses of the
+ * pointers in the son arrays, so that every submatrix is written by
+ * only one task at a time, while independent updates, solves and
+ * factorizations proceed concurrently. Up to pardepth levels are
+ * split into tasks, below that the sequential algorithms are used. */
+
+/* Submatrix (i,j) of X or X^* */
+static    pchmatrix
+opson_hmatrix(bool trans, pchmatrix x, uint i, uint j)
+{
+  return (trans ? x->son[j + i * x->rsons] : x->son[i + j * x->rsons]);
+}
+
+/* Check whether the submatrices of Z, op(X) and op(Y) match, so that
+ * Z_{ik} = Z_{ik} + sum_j op(X)_{ij} op(Y)_{jk} */
+static    bool
+conforming_hmatrix(bool xtrans, pchmatrix x, bool ytrans, pchmatrix y,
+		   pchmatrix z)
+{
+  uint      xrsons, xcsons, yrsons, ycsons;
+  uint      i, j;
+
+  if (z->son == NULL || x->son == NULL || y->son == NULL)
+    return false;
+
+  xrsons = (xtrans ? x->csons : x->rsons);
+  xcsons = (xtrans ? x->rsons : x->csons);
+  yrsons = (ytrans ? y->csons : y->rsons);
+  ycsons = (ytrans ? y->rsons : y->csons);
+
+  if (xrsons != z->rsons || ycsons != z->csons || xcsons != yrsons)
+    return false;
+
+  for (i = 0; i < z->rsons; i++)
+    if ((xtrans ? opson_hmatrix(xtrans, x, i, 0)->cc :
+	 opson_hmatrix(xtrans, x, i, 0)->rc) != z->son[i]->rc)
+      return false;
+
+  for (j = 0; j < z->csons; j++)
+    if ((ytrans ? opson_hmatrix(ytrans, y, 0, j)->rc :
+	 opson_hmatrix(ytrans, y, 0, j)->cc) != z->son[j * z->rsons]->cc)
+      return false;
+
+  for (j = 0; j < xcsons; j++)
+    if ((xtrans ? opson_hmatrix(xtrans, x, 0, j)->rc :
+	 opson_hmatrix(xtrans, x, 0, j)->cc) !=
+	(ytrans ? opson_hmatrix(ytrans, y, j, 0)->cc :
+	 opson_hmatrix(ytrans, y, j, 0)->rc))
+      return false;
+
+  return true;
+}
+
+/* Z = Z + alpha op(X) op(Y), one task per submatrix of Z */
+static void
+addmul_task_hmatrix(field alpha, bool xtrans, pchmatrix x, bool ytrans,
+		    pchmatrix y, pctruncmode tm, real eps, phmatrix z,
+		    uint pardepth)
+{
+  uint      rsons, msons, csons;
+  uint      i, k;
+
+  if (pardepth == 0 || !conforming_hmatrix(xtrans, x, ytrans, y, z)) {
+    addmul_hmatrix(alpha, xtrans, x, ytrans, y, tm, eps, z);
+    return;
+  }
+
+  rsons = z->rsons;
+  msons = (xtrans ? x->rsons : x->csons);
+  csons = z->csons;
+
+  for (k = 0; k < csons; k++)
+    for (i = 0; i < rsons; i++) {
+#pragma omp task
+      {
+	uint      j;
+
+	for (j = 0; j < msons; j++)
+	  addmul_task_hmatrix(alpha, xtrans, opson_hmatrix(xtrans, x, i, j),
+			      ytrans, opson_hmatrix(ytrans, y, j, k), tm, eps,
+			      z->son[i + k * rsons], pardepth - 1);
+      }
+    }
+
+#pragma omp taskwait
+}
+
+/* Solve L X = B */
+static void
+lowersolve_nn_task_hmatrix(bool aunit, pchmatrix a, pctruncmode tm,
+			   real eps, phmatrix xp, uint pardepth)
+{
+  phmatrix *xs;
+  uint      sons, rsons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->son == NULL || xp->son == NULL) {
+    lowersolve_nn_hmatrix(aunit, a, tm, eps, xp);
+    return;
+  }
+
+  assert(a->rsons == a->csons);
+  assert(xp->rsons == a->rsons);
+
+  sons = a->rsons;
+  rsons = xp->rsons;
+  xs = xp->son;
+
+  for (k = 0; k < xp->csons; k++)
+    for (i = 0; i < sons; i++) {
+#pragma omp task depend(inout: xs[i + k * rsons])
+      lowersolve_nn_task_hmatrix(aunit, a->son[i + i * sons], tm, eps,
+				 xs[i + k * rsons], pardepth - 1);
+
+      for (j = i + 1; j < sons; j++) {
+#pragma omp task depend(in: xs[i + k * rsons]) depend(inout: xs[j + k * rsons])
+	addmul_task_hmatrix(-1.0, false, a->son[j + i * sons], false,
+			    xs[i + k * rsons], tm, eps, xs[j + k * rsons],
+			    pardepth - 1);
+      }
+    }
+
+#pragma omp taskwait
+}
+
+/* Solve X L^* = B */
+static void
+lowersolve_nt_task_hmatrix(bool aunit, pchmatrix a, pctruncmode tm,
+			   real eps, phmatrix xp, uint pardepth)
+{
+  phmatrix *xs;
+  uint      sons, rsons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->son == NULL || xp->son == NULL) {
+    lowersolve_nt_hmatrix(aunit, a, tm, eps, xp);
+    return;
+  }
+
+  assert(a->rsons == a->csons);
+  assert(xp->csons == a->rsons);
+
+  sons = a->rsons;
+  rsons = xp->rsons;
+  xs = xp->son;
+
+  for (k = 0; k < rsons; k++)
+    for (i = 0; i < sons; i++) {
+#pragma omp task depend(inout: xs[k + i * rsons])
+      lowersolve_nt_task_hmatrix(aunit, a->son[i + i * sons], tm, eps,
+				 xs[k + i * rsons], pardepth - 1);
+
+      for (j = i + 1; j < sons; j++) {
+#pragma omp task depend(in: xs[k + i * rsons]) depend(inout: xs[k + j * rsons])
+	addmul_task_hmatrix(-1.0, false, xs[k + i * rsons], true,
+			    a->son[j + i * sons], tm, eps, xs[k + j * rsons],
+			    pardepth - 1);
+      }
+    }
+
+#pragma omp taskwait
+}
+
+/* Solve X R = B */
+static void
+uppersolve_tt_task_hmatrix(bool aunit, pchmatrix a, pctruncmode tm,
+			   real eps, phmatrix xp, uint pardepth)
+{
+  phmatrix *xs;
+  uint      sons, rsons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->son == NULL || xp->son == NULL) {
+    uppersolve_tt_hmatrix(aunit, a, tm, eps, xp);
+    return;
+  }
+
+  assert(a->rsons == a->csons);
+  assert(xp->csons == a->rsons);
+
+  sons = a->rsons;
+  rsons = xp->rsons;
+  xs = xp->son;
+
+  for (k = 0; k < rsons; k++)
+    for (i = 0; i < sons; i++) {
+#pragma omp task depend(inout: xs[k + i * rsons])
+      uppersolve_tt_task_hmatrix(aunit, a->son[i + i * sons], tm, eps,
+				 xs[k + i * rsons], pardepth - 1);
+
+      for (j = i + 1; j < sons; j++) {
+#pragma omp task depend(in: xs[k + i * rsons]) depend(inout: xs[k + j * rsons])
+	addmul_task_hmatrix(-1.0, false, xs[k + i * rsons], false,
+			    a->son[i + j * sons], tm, eps, xs[k + j * rsons],
+			    pardepth - 1);
+      }
+    }
+
+#pragma omp taskwait
+}
+
+static void
+lrdecomp_task_hmatrix(phmatrix a, pctruncmode tm, real eps, uint pardepth)
+{
+  phmatrix *s;
+  uint      sons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->son == NULL) {
+    lrdecomp_hmatrix(a, tm, eps);
+    return;
+  }
+
+  assert(a->rc == a->cc);
+  assert(a->rsons == a->csons);
+
+  sons = a->rsons;
+  s = a->son;
+
+  for (k = 0; k < sons; k++) {
+#pragma omp task depend(inout: s[k + k * sons])
+    lrdecomp_task_hmatrix(s[k + k * sons], tm, eps, pardepth - 1);
+
+    for (j = k + 1; j < sons; j++) {
+#pragma omp task depend(in: s[k + k * sons]) depend(inout: s[k + j * sons])
+      lowersolve_nn_task_hmatrix(true, s[k + k * sons], tm, eps,
+				 s[k + j * sons], pardepth - 1);
+    }
+
+    for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: s[k + k * sons]) depend(inout: s[i + k * sons])
+      uppersolve_tt_task_hmatrix(false, s[k + k * sons], tm, eps,
+				 s[i + k * sons], pardepth - 1);
+    }
+
+    for (j = k + 1; j < sons; j++)
+      for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: s[i + k * sons], s[k + j * sons]) depend(inout: s[i + j * sons])
+	addmul_task_hmatrix(-1.0, false, s[i + k * sons], false,
+			    s[k + j * sons], tm, eps, s[i + j * sons],
+			    pardepth - 1);
+      }
+  }
+
+#pragma omp taskwait
+}
+
+static void
+choldecomp_task_hmatrix(phmatrix a, pctruncmode tm, real eps,
+			uint pardepth)
+{
+  phmatrix *s;
+  uint      sons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->son == NULL) {
+    choldecomp_hmatrix(a, tm, eps);
+    return;
+  }
+
+  assert(a->rc == a->cc);
+  assert(a->rsons == a->csons);
+
+  sons = a->rsons;
+  s = a->son;
+
+  for (k = 0; k < sons; k++) {
+#pragma omp task depend(inout: s[k + k * sons])
+    choldecomp_task_hmatrix(s[k + k * sons], tm, eps, pardepth - 1);
+
+    for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: s[k + k * sons]) depend(inout: s[i + k * sons])
+      lowersolve_nt_task_hmatrix(false, s[k + k * sons], tm, eps,
+				 s[i + k * sons], pardepth - 1);
+    }
+
+    for (j = k + 1; j < sons; j++) {
+#pragma omp task depend(in: s[j + k * sons]) depend(inout: s[j + j * sons])
+      addmul_lower_hmatrix(-1.0, false, s[j + k * sons], true,
+			   s[j + k * sons], tm, eps, s[j + j * sons]);
+
+      for (i = j + 1; i < sons; i++) {
+#pragma omp task depend(in: s[i + k * sons], s[j + k * sons]) depend(inout: s[i + j * sons])
+	addmul_task_hmatrix(-1.0, false, s[i + k * sons], true,
+			    s[j + k * sons], tm, eps, s[i + j * sons],
+			    pardepth - 1);
+      }
+    }
+  }
+
+#pragma omp taskwait
+}
+#endif
+
+void
+lrdecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps)
+{
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+#pragma omp parallel
+#pragma omp single
+    lrdecomp_task_hmatrix(a, tm, eps, max_pardepth);
+  }
+  else
+#endif
+    lrdecomp_hmatrix(a, tm, eps);
+}
+
+void
+choldecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps)
+{
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+#pragma omp parallel
+#pragma omp single
+    choldecomp_task_hmatrix(a, tm, eps, max_pardepth);
+  }
+  else
+#endif
+    choldecomp_hmatrix(a, tm, eps);
+}
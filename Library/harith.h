@@ -31,6 +31,125 @@
 HEADER_PREFIX void
 trunc_rkmatrix(pctruncmode tm, real eps, prkmatrix r);
 
+/* ------------------------------------------------------------
+ * Randomized low-rank approximation
+ * ------------------------------------------------------------ */
+
+/** @brief Number of random test vectors used in every step of
+ *  @ref rangefinder_rkmatrix. */
+#define HARITH_RANDOM_BLOCK 8
+
+/** @brief Callback applying an implicitly given matrix @f$M@f$ to a
+ *  block of vectors.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param trans Set if @f$M^*@f$ is to be used instead of @f$M@f$.
+ *  @param x Source matrix @f$X@f$.
+ *  @param data Arbitrary data describing @f$M@f$.
+ *  @param y Target matrix, overwritten by @f$Y + \alpha M X@f$ or
+ *         @f$Y + \alpha M^* X@f$. */
+typedef void (*sampleoperator_t)(field alpha, bool trans, pcamatrix x,
+				 void *data, pamatrix y);
+
+/** @brief Approximate an implicitly given matrix by a randomized
+ *  range finder.
+ *
+ *  In every step, @ref HARITH_RANDOM_BLOCK Gaussian test vectors are
+ *  multiplied by @f$M@f$, the current basis @f$Q@f$ is projected out
+ *  of the samples, and the remainder is orthonormalized by one QR
+ *  decomposition and added to @f$Q@f$.
+ *  The mean norm of the projected samples serves as an a posteriori
+ *  estimate of the error @f$\|M - Q Q^* M\|@f$, the iteration stops
+ *  if it is below the tolerance given by <tt>tm</tt> and <tt>eps</tt>.
+ *  Finally @f$R = Q (M^* Q)^*@f$ is truncated to the minimal rank.
+ *
+ *  All products with @f$M@f$ are block products, so the algorithm
+ *  relies on BLAS-3 operations only.
+ *
+ *  @param rows Number of rows of @f$M@f$.
+ *  @param cols Number of columns of @f$M@f$.
+ *  @param sample Callback applying @f$M@f$ and @f$M^*@f$.
+ *  @param data Data passed to <tt>sample</tt>.
+ *  @param kmax Upper bound for the rank of @f$M@f$, the basis
+ *         @f$Q@f$ never has more columns.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy @f$\epsilon@f$.
+ *  @param r Target matrix, overwritten by the approximation. */
+HEADER_PREFIX void
+rangefinder_rkmatrix(uint rows, uint cols, sampleoperator_t sample,
+		     void *data, uint kmax, pctruncmode tm, real eps,
+		     prkmatrix r);
+
+/** @brief Approximate a dense matrix by a randomized range finder,
+ *  see @ref rangefinder_rkmatrix.
+ *
+ *  @param a Source matrix.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy @f$\epsilon@f$.
+ *  @param r Target matrix, overwritten by the approximation. */
+HEADER_PREFIX void
+decomp_random_rkmatrix(pcamatrix a, pctruncmode tm, real eps, prkmatrix r);
+
+/** @brief Truncate an rkmatrix by a randomized range finder,
+ *  see @ref rangefinder_rkmatrix.
+ *
+ *  Only the low-rank factors are multiplied by the test vectors, so the
+ *  cost is linear instead of quadratic in the current rank.
+ *  @ref trunc_rkmatrix and @ref add_rkmatrix use this function if
+ *  <tt>tm->randomized</tt> is set and the rank is at least
+ *  <tt>2*HARITH_RANDOM_BLOCK</tt>.
+ *
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy @f$\epsilon@f$.
+ *  @param r Source matrix, will be overwritten by truncated matrix. */
+HEADER_PREFIX void
+trunc_random_rkmatrix(pctruncmode tm, real eps, prkmatrix r);
+
+/* ------------------------------------------------------------
+ * Lossy compression
+ * ------------------------------------------------------------ */
+
+/** @brief Truncate an rkmatrix and store its factors in a lossy
+ *  compressed format with adaptive precision.
+ *
+ *  After truncation, @f$A = U \Sigma@f$ and @f$B = V@f$ hold the
+ *  singular value decomposition. Columns @f$u_\nu \sigma_\nu@f$ and
+ *  @f$v_\nu@f$ are stored with the number of bits required for an
+ *  error of @f$\epsilon \rho / (2k)@f$ and
+ *  @f$\epsilon \rho / (2k \sigma_\nu)@f$, respectively, where
+ *  @f$\rho@f$ is one for absolute, @f$\sigma_1@f$ for relative spectral
+ *  and @f$\|\Sigma\|_F@f$ for relative Frobenius errors according
+ *  to <tt>tm</tt>.
+ *  The compression therefore adds at most @f$\epsilon \rho@f$ to the
+ *  truncation error, and columns belonging to small singular values
+ *  need fewer bits.
+ *
+ *  The compressed matrix can only be multiplied by vectors, e.g.,
+ *  by @ref addeval_rkmatrix_avector, other operations require
+ *  @ref decompress_rkmatrix.
+ *
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy @f$\epsilon@f$.
+ *  @param r Source matrix, will be overwritten by the compressed matrix. */
+HEADER_PREFIX void
+compress_rkmatrix(pctruncmode tm, real eps, prkmatrix r);
+
+/** @brief Compress all low-rank leaves of an @ref hmatrix by
+ *  @ref compress_rkmatrix.
+ *
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy @f$\epsilon@f$ for every leaf.
+ *  @param hm Target matrix. */
+HEADER_PREFIX void
+compress_hmatrix(pctruncmode tm, real eps, phmatrix hm);
+
+/** @brief Restore all low-rank leaves of an @ref hmatrix compressed by
+ *  @ref compress_hmatrix.
+ *
+ *  @param hm Target matrix. */
+HEADER_PREFIX void
+decompress_hmatrix(phmatrix hm);
+
 /* ------------------------------------------------------------
  * Matrix addition
  * ------------------------------------------------------------ */
@@ -640,6 +759,41 @@ choldecomp_hmatrix(phmatrix a, pctruncmode tm, real eps);
 HEADER_PREFIX void
 cholsolve_hmatrix_avector(pchmatrix a, pavector x);
 
+/* ------------------------------------------------------------
+ * Parallel triangular factorizations
+ * ------------------------------------------------------------ */
+
+/** @brief Compute the LR factorization @f$A \approx L R@f$ in parallel.
+ *
+ *  The block operations of @ref lrdecomp_hmatrix are scheduled as a
+ *  directed acyclic graph of OpenMP tasks, so that factorizations,
+ *  triangular solves and updates of independent submatrices are
+ *  carried out concurrently.
+ *  The upper @ref max_pardepth levels of the block tree are split
+ *  into tasks.
+ *  Without OpenMP, or if only one thread is available, this is
+ *  equivalent to @ref lrdecomp_hmatrix.
+ *
+ *  @param a Source matrix @f$A@f$, will be overwritten
+ *     by @f$L@f$ and @f$R@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy. */
+HEADER_PREFIX void
+lrdecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps);
+
+/** @brief Compute the Cholesky factorization @f$A \approx L L^*@f$
+ *  in parallel.
+ *
+ *  Task-parallel counterpart of @ref choldecomp_hmatrix, see
+ *  @ref lrdecomp_parallel_hmatrix.
+ *
+ *  @param a Source matrix @f$A@f$, lower triangular part will be
+ *    overwritten by @f$L@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy. */
+HEADER_PREFIX void
+choldecomp_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps);
+
 /** @} */
 
 #endif
@@ -6,6 +6,10 @@
 
 #include "harith2.h"
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 /* ------------------------------------------------------------
  * Representation of structured matrix products
  * ------------------------------------------------------------ */
@@ -1408,3 +1412,150 @@ choldecomp2_hmatrix(phmatrix a, pctruncmode tm, real eps)
 
   del_haccum(aa);
 }
+
+/* ------------------------------------------------------------
+ * Parallel triangular factorizations
+ * ------------------------------------------------------------ */
+
+#ifdef USE_OPENMP
+/* Every accumulator is owned by exactly one task at a time, the
+ * dependencies are declared by the addresses of the entries of the
+ * array returned by split_haccum.  Updates of a submatrix are collected
+ * in its accumulator and merged only by the task that solves or
+ * factorizes this submatrix, so there are no write conflicts. */
+
+static void
+lrdecomp_task_haccum(phaccum aa, uint pardepth)
+{
+  phmatrix  a = aa->z;
+  phaccum  *aa1;
+  uint      sons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->f) {
+    lrdecomp_haccum(aa);
+    return;
+  }
+
+  assert(a->son != 0);
+  assert(a->rsons == a->csons);
+
+  sons = a->rsons;
+
+  aa1 = split_haccum(a, aa);
+
+  for (k = 0; k < sons; k++) {
+#pragma omp task depend(inout: aa1[k + k * sons])
+    lrdecomp_task_haccum(aa1[k + k * sons], pardepth - 1);
+
+    for (j = k + 1; j < sons; j++) {
+#pragma omp task depend(in: aa1[k + k * sons]) depend(inout: aa1[k + j * sons])
+      lowersolve_nn_haccum(true, a->son[k + k * sons], aa1[k + j * sons]);
+    }
+
+    for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: aa1[k + k * sons]) depend(inout: aa1[i + k * sons])
+      uppersolve_tt_haccum(false, a->son[k + k * sons], aa1[i + k * sons]);
+    }
+
+    for (j = k + 1; j < sons; j++)
+      for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: aa1[i + k * sons], aa1[k + j * sons]) depend(inout: aa1[i + j * sons])
+	addproduct_haccum(-1.0, false, a->son[i + k * sons], false,
+			  a->son[k + j * sons], aa1[i + j * sons]);
+      }
+  }
+
+#pragma omp taskwait
+
+  for (k = 0; k < sons; k++)
+    for (i = 0; i < sons; i++)
+      del_haccum(aa1[i + k * sons]);
+  freemem(aa1);
+}
+
+static void
+choldecomp_task_haccum(phaccum aa, uint pardepth)
+{
+  phmatrix  a = aa->z;
+  phaccum  *aa1;
+  uint      sons;
+  uint      i, j, k;
+
+  if (pardepth == 0 || a->f) {
+    choldecomp_haccum(aa);
+    return;
+  }
+
+  assert(a->son != 0);
+  assert(a->rsons == a->csons);
+
+  sons = a->rsons;
+
+  aa1 = split_haccum(a, aa);
+
+  for (k = 0; k < sons; k++) {
+#pragma omp task depend(inout: aa1[k + k * sons])
+    choldecomp_task_haccum(aa1[k + k * sons], pardepth - 1);
+
+    for (i = k + 1; i < sons; i++) {
+#pragma omp task depend(in: aa1[k + k * sons]) depend(inout: aa1[i + k * sons])
+      lowersolve_nt_haccum(false, a->son[k + k * sons], aa1[i + k * sons]);
+    }
+
+    for (j = k + 1; j < sons; j++)
+      for (i = j; i < sons; i++) {
+#pragma omp task depend(in: aa1[i + k * sons], aa1[j + k * sons]) depend(inout: aa1[i + j * sons])
+	addproduct_haccum(-1.0, false, a->son[i + k * sons], true,
+			  a->son[j + k * sons], aa1[i + j * sons]);
+      }
+  }
+
+#pragma omp taskwait
+
+  for (k = 0; k < sons; k++)
+    for (i = 0; i < sons; i++)
+      del_haccum(aa1[i + k * sons]);
+  freemem(aa1);
+}
+#endif
+
+void
+lrdecomp2_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps)
+{
+  phaccum   aa;
+
+  aa = new_haccum(a, tm, eps);
+
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+#pragma omp parallel
+#pragma omp single
+    lrdecomp_task_haccum(aa, max_pardepth);
+  }
+  else
+#endif
+    lrdecomp_haccum(aa);
+
+  del_haccum(aa);
+}
+
+void
+choldecomp2_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps)
+{
+  phaccum   aa;
+
+  aa = new_haccum(a, tm, eps);
+
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+#pragma omp parallel
+#pragma omp single
+    choldecomp_task_haccum(aa, max_pardepth);
+  }
+  else
+#endif
+    choldecomp_haccum(aa);
+
+  del_haccum(aa);
+}
@@ -285,6 +285,33 @@ choldecomp_haccum(phaccum aa);
 HEADER_PREFIX void
 choldecomp2_hmatrix(phmatrix a, pctruncmode tm, real eps);
 
+/** @brief Compute the LR factorization using accumulators in parallel.
+ *
+ *  Task-parallel counterpart of @ref lrdecomp2_hmatrix, see
+ *  @ref lrdecomp_parallel_hmatrix.
+ *  Every submatrix keeps its own accumulator, updates are merged only
+ *  by the task that solves or factorizes the submatrix.
+ *
+ *  @param a Source matrix @f$A@f$,
+ *     will be overwritten with @f$L@f$ and @f$R@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy. */
+HEADER_PREFIX void
+lrdecomp2_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps);
+
+/** @brief Compute the Cholesky factorization using accumulators
+ *  in parallel.
+ *
+ *  Task-parallel counterpart of @ref choldecomp2_hmatrix, see
+ *  @ref lrdecomp2_parallel_hmatrix.
+ *
+ *  @param a Source matrix @f$A@f$, lower triangular part will be overwritten
+ *    by @f$L@f$.
+ *  @param tm Truncation mode.
+ *  @param eps Truncation accuracy. */
+HEADER_PREFIX void
+choldecomp2_parallel_hmatrix(phmatrix a, pctruncmode tm, real eps);
+
 /** @} */
 
 #endif
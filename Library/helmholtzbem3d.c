@@ -23,6 +23,100 @@
 
 #define KERNEL_CONST_HELMHOLTZBEM3D 0.0795774715459476679
 
+/* Number of pairs of points processed at once by the batched kernels */
+#define BATCH_HELMHOLTZBEM3D 64
+
+/* Splitting of pi/2 into three parts with 33 significant bits each, see
+ * fdlibm. The products j * PIO2_x_HELMHOLTZBEM3D are exact for |j| < 2^20,
+ * i.e. for arguments up to about 10^6. */
+#define PIO2_1_HELMHOLTZBEM3D 1.57079632673412561417e+00
+#define PIO2_2_HELMHOLTZBEM3D 6.07710050630396597660e-11
+#define PIO2_3_HELMHOLTZBEM3D 2.02226624871116645580e-21
+#define TWOOPI_HELMHOLTZBEM3D 6.36619772367581382433e-01
+
+/* Compute s = sin(x) and c = cos(x) with the requested accuracy for
+ * x >= 0. For reduced accuracies the argument is reduced to r = x - j pi/2
+ * with |r| <= pi/4 and the truncated Taylor series of sine and cosine are
+ * evaluated, followed by a branch-free correction for the quadrant j.
+ * Since no library functions are called, loops over this function can be
+ * vectorized by the compiler. */
+static inline void
+sincos_helmholtzbem3d(real x, accuracybem3d accuracy, real * s, real * c)
+{
+  real      j, r, r2, ps, pc, t;
+  int       q;
+
+  if (accuracy == ACCURACY_FULL_BEM3D) {
+    *s = sin(x);
+    *c = cos(x);
+    return;
+  }
+
+  q = (int) (x * TWOOPI_HELMHOLTZBEM3D + 0.5);
+  j = q;
+  r = ((x - j * PIO2_1_HELMHOLTZBEM3D) - j * PIO2_2_HELMHOLTZBEM3D)
+    - j * PIO2_3_HELMHOLTZBEM3D;
+  r2 = r * r;
+
+  if (accuracy == ACCURACY_LOW_BEM3D) {
+    /* Error below 3.2e-7 */
+    ps = r * (1.0 + r2 * (-1.66666666666666666667e-01
+			  + r2 * (8.33333333333333333333e-03
+				  + r2 * -1.98412698412698412698e-04)));
+    pc = 1.0 + r2 * (-0.5 + r2 * (4.16666666666666666667e-02
+				  + r2 * (-1.38888888888888888889e-03
+					  + r2 * 2.48015873015873015873e-05)));
+  }
+  else {
+    /* Error below 7e-12 */
+    ps = r * (1.0 + r2 * (-1.66666666666666666667e-01
+			  + r2 * (8.33333333333333333333e-03
+				  + r2 * (-1.98412698412698412698e-04
+					  + r2 * (2.75573192239858906526e-06
+						  + r2 *
+						  -2.50521083854417187751e-08)))));
+    pc = 1.0 + r2 * (-0.5 + r2 * (4.16666666666666666667e-02
+				  + r2 * (-1.38888888888888888889e-03
+					  + r2 * (2.48015873015873015873e-05
+						  + r2 *
+						  (-2.75573192239858906526e-07
+						   + r2 *
+						   2.08767569878680989792e-09)))));
+  }
+
+  t = (q & 1) ? pc : ps;
+  pc = (q & 1) ? ps : pc;
+  *s = (q & 2) ? -t : t;
+  *c = ((q + 1) & 2) ? -pc : pc;
+}
+
+/* Compute s[i] = sin(x[i]) and c[i] = cos(x[i]) for a whole array.
+ * A separate loop is used for every accuracy to allow the compiler to
+ * vectorize the polynomial approximations. */
+static void
+sincos_batch_helmholtzbem3d(uint n, const real * x, accuracybem3d accuracy,
+			    real * s, real * c)
+{
+  uint      i;
+
+  switch (accuracy) {
+  case ACCURACY_LOW_BEM3D:
+    for (i = 0; i < n; ++i) {
+      sincos_helmholtzbem3d(x[i], ACCURACY_LOW_BEM3D, s + i, c + i);
+    }
+    break;
+  case ACCURACY_HIGH_BEM3D:
+    for (i = 0; i < n; ++i) {
+      sincos_helmholtzbem3d(x[i], ACCURACY_HIGH_BEM3D, s + i, c + i);
+    }
+    break;
+  default:
+    for (i = 0; i < n; ++i) {
+      sincos_helmholtzbem3d(x[i], ACCURACY_FULL_BEM3D, s + i, c + i);
+    }
+  }
+}
+
 static inline field
 slp_kernel_helmholtzbem3d(const real * x, const real * y,
 			  const real * nx, const real * ny, void *data)
@@ -30,7 +124,7 @@ slp_kernel_helmholtzbem3d(const real * x, const real * y,
   pcbem3d   bem = (pcbem3d) data;
   real      k = bem->k;
   real      dist[3];
-  real      norm, norm2, rnorm;
+  real      norm, norm2, rnorm, s, c;
 
   field     res;
 
@@ -44,7 +138,8 @@ slp_kernel_helmholtzbem3d(const real * x, const real * y,
   rnorm = REAL_RSQRT(norm2);
 
   norm = k * norm2 * rnorm;
-  res = (cos(norm) + I * sin(norm)) * rnorm;
+  sincos_helmholtzbem3d(norm, bem->accuracy, &s, &c);
+  res = (c + I * s) * rnorm;
 
   return res;
 }
@@ -69,8 +164,7 @@ dlp_kernel_helmholtzbem3d(const real * x, const real * y,
   rnorm = REAL_RSQRT(norm2);
 
   norm = k * norm2 * rnorm;
-  s = sin(norm);
-  c = cos(norm);
+  sincos_helmholtzbem3d(norm, bem->accuracy, &s, &c);
   res = (c + norm * s + (s - c * norm) * I);
   res *= (rnorm * rnorm * rnorm) * DOT3(dist, ny);
 
@@ -96,8 +190,7 @@ hs_kernel_helmholtzbem3d(const real * x, const real * y,
 
   norm = k * norm2 * rnorm;
   rnorm = (rnorm * rnorm) * (rnorm * rnorm) * rnorm;
-  s = sin(norm);
-  c = cos(norm);
+  sincos_helmholtzbem3d(norm, bem->accuracy, &s, &c);
 
   dot = REAL_DOT3(dist, nx) * REAL_DOT3(dist, ny);
   dotxy = REAL_DOT3(nx, ny);
@@ -110,21 +203,381 @@ hs_kernel_helmholtzbem3d(const real * x, const real * y,
   return res;
 }
 
+/* Kernel of the combined operator K + beta V, the double layer and the
+ * single layer part share the evaluation of the exponential. */
+static inline field
+combined_kernel_helmholtzbem3d(const real * x, const real * y,
+			       const real * nx, const real * ny, void *data)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  real      k = bem->k;
+  real      dist[3];
+  real      norm, norm2, rnorm, s, c, fac;
+
+  (void) nx;
+
+  dist[0] = x[0] - y[0];
+  dist[1] = x[1] - y[1];
+  dist[2] = x[2] - y[2];
+  norm2 = REAL_NORMSQR3(dist[0], dist[1], dist[2]);
+  rnorm = REAL_RSQRT(norm2);
+
+  norm = k * norm2 * rnorm;
+  sincos_helmholtzbem3d(norm, bem->accuracy, &s, &c);
+  fac = (rnorm * rnorm * rnorm) * REAL_DOT3(dist, ny);
+
+  return (c + I * s) * (fac - I * norm * fac + bem->beta * rnorm);
+}
+
+/* Smooth window of the compressed kernels, equal to one up to
+ * bem->window_a and zero beyond bem->window_b. All derivatives vanish at
+ * both ends of the transition zone. */
+static inline real
+window_helmholtzbem3d(pcbem3d bem, real r)
+{
+  real      a = bem->window_a;
+  real      b = bem->window_b;
+  real      t;
+
+  if (r <= a) {
+    return 1.0;
+  }
+  if (r >= b) {
+    return 0.0;
+  }
+
+  t = (r - a) / (b - a);
+
+  return REAL_EXP(2.0 * REAL_EXP(-1.0 / t) / (t - 1.0));
+}
+
+/* Single layer kernel multiplied by the window */
+static inline field
+slp_window_kernel_helmholtzbem3d(const real * x, const real * y,
+				 const real * nx, const real * ny, void *data)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  real      dist[3];
+
+  dist[0] = x[0] - y[0];
+  dist[1] = x[1] - y[1];
+  dist[2] = x[2] - y[2];
+
+  return slp_kernel_helmholtzbem3d(x, y, nx, ny, data)
+    * window_helmholtzbem3d(bem, REAL_NORM3(dist[0], dist[1], dist[2]));
+}
+
+/* Normal derivative of the combined kernel with respect to x */
+static inline field
+dnx_combined_kernel_helmholtzbem3d(const real * x, const real * y,
+				   const real * nx, const real * ny,
+				   void *data)
+{
+  pcbem3d   bem = (pcbem3d) data;
+
+  return hs_kernel_helmholtzbem3d(x, y, nx, ny, data)
+    + bem->beta * dlp_kernel_helmholtzbem3d(y, x, NULL, nx, data);
+}
+
+/* Batched versions of the kernel functions, the points are given in
+ * structure-of-arrays layout, see kernel_batch_func3d. The geometric part
+ * and the trigonometric part are evaluated in separate loops over chunks of
+ * BATCH_HELMHOLTZBEM3D pairs of points. */
+
+static void
+slp_kernel_batch_helmholtzbem3d(uint n, const real * x, const real * y,
+				const real * nx, const real * ny, void *data,
+				field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  real      k = bem->k;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      kr[BATCH_HELMHOLTZBEM3D], rn[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  uint      i, i0, m;
+
+  (void) nx;
+  (void) ny;
+
+  for (i0 = 0; i0 < n; i0 += m) {
+    m = UINT_MIN(BATCH_HELMHOLTZBEM3D, n - i0);
+
+    for (i = 0; i < m; ++i) {
+      d0 = x0[i0 + i] - y0[i0 + i];
+      d1 = x1[i0 + i] - y1[i0 + i];
+      d2 = x2[i0 + i] - y2[i0 + i];
+      norm2 = REAL_NORMSQR3(d0, d1, d2);
+      rnorm = REAL_RSQRT(norm2);
+
+      kr[i] = k * norm2 * rnorm;
+      rn[i] = rnorm;
+    }
+
+    sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+    for (i = 0; i < m; ++i) {
+      res[i0 + i] = (c[i] + I * s[i]) * rn[i];
+    }
+  }
+}
+
+static void
+slp_window_kernel_batch_helmholtzbem3d(uint n, const real * x,
+				       const real * y, const real * nx,
+				       const real * ny, void *data,
+				       field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      d0, d1, d2;
+  uint      i;
+
+  slp_kernel_batch_helmholtzbem3d(n, x, y, nx, ny, data, res);
+
+  for (i = 0; i < n; ++i) {
+    d0 = x0[i] - y0[i];
+    d1 = x1[i] - y1[i];
+    d2 = x2[i] - y2[i];
+    res[i] *= window_helmholtzbem3d(bem, REAL_NORM3(d0, d1, d2));
+  }
+}
+
+static void
+dlp_kernel_batch_helmholtzbem3d(uint n, const real * x, const real * y,
+				const real * nx, const real * ny, void *data,
+				field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  real      k = bem->k;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      n0 = ny[0], n1 = ny[1], n2 = ny[2];
+  real      kr[BATCH_HELMHOLTZBEM3D], fac[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  uint      i, i0, m;
+
+  (void) nx;
+
+  for (i0 = 0; i0 < n; i0 += m) {
+    m = UINT_MIN(BATCH_HELMHOLTZBEM3D, n - i0);
+
+    for (i = 0; i < m; ++i) {
+      d0 = x0[i0 + i] - y0[i0 + i];
+      d1 = x1[i0 + i] - y1[i0 + i];
+      d2 = x2[i0 + i] - y2[i0 + i];
+      norm2 = REAL_NORMSQR3(d0, d1, d2);
+      rnorm = REAL_RSQRT(norm2);
+
+      kr[i] = k * norm2 * rnorm;
+      fac[i] = (rnorm * rnorm * rnorm) * (d0 * n0 + d1 * n1 + d2 * n2);
+    }
+
+    sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+    for (i = 0; i < m; ++i) {
+      res[i0 + i] = (c[i] + kr[i] * s[i] + (s[i] - c[i] * kr[i]) * I)
+	* fac[i];
+    }
+  }
+}
+
+/* Versions of the batched kernels for several wavenumbers, the geometric
+ * part is evaluated once for every chunk of pairs of points and only the
+ * exponential is evaluated for every wavenumber. */
+
+static void
+slp_kernel_wave_helmholtzbem3d(uint n, const real * x, const real * y,
+			       const real * nx, const real * ny, void *data,
+			       uint nk, const real * k, field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      r[BATCH_HELMHOLTZBEM3D], rn[BATCH_HELMHOLTZBEM3D];
+  real      kr[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  field    *resj;
+  uint      i, i0, j, m;
+
+  (void) nx;
+  (void) ny;
+
+  for (i0 = 0; i0 < n; i0 += m) {
+    m = UINT_MIN(BATCH_HELMHOLTZBEM3D, n - i0);
+
+    for (i = 0; i < m; ++i) {
+      d0 = x0[i0 + i] - y0[i0 + i];
+      d1 = x1[i0 + i] - y1[i0 + i];
+      d2 = x2[i0 + i] - y2[i0 + i];
+      norm2 = REAL_NORMSQR3(d0, d1, d2);
+      rnorm = REAL_RSQRT(norm2);
+
+      r[i] = norm2 * rnorm;
+      rn[i] = rnorm;
+    }
+
+    for (j = 0; j < nk; ++j) {
+      for (i = 0; i < m; ++i) {
+	kr[i] = k[j] * r[i];
+      }
+
+      sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+      resj = res + j * n + i0;
+      for (i = 0; i < m; ++i) {
+	resj[i] = (c[i] + I * s[i]) * rn[i];
+      }
+    }
+  }
+}
+
+static void
+dlp_kernel_wave_helmholtzbem3d(uint n, const real * x, const real * y,
+			       const real * nx, const real * ny, void *data,
+			       uint nk, const real * k, field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      n0 = ny[0], n1 = ny[1], n2 = ny[2];
+  real      r[BATCH_HELMHOLTZBEM3D], fac[BATCH_HELMHOLTZBEM3D];
+  real      kr[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  field    *resj;
+  uint      i, i0, j, m;
+
+  (void) nx;
+
+  for (i0 = 0; i0 < n; i0 += m) {
+    m = UINT_MIN(BATCH_HELMHOLTZBEM3D, n - i0);
+
+    for (i = 0; i < m; ++i) {
+      d0 = x0[i0 + i] - y0[i0 + i];
+      d1 = x1[i0 + i] - y1[i0 + i];
+      d2 = x2[i0 + i] - y2[i0 + i];
+      norm2 = REAL_NORMSQR3(d0, d1, d2);
+      rnorm = REAL_RSQRT(norm2);
+
+      r[i] = norm2 * rnorm;
+      fac[i] = (rnorm * rnorm * rnorm) * (d0 * n0 + d1 * n1 + d2 * n2);
+    }
+
+    for (j = 0; j < nk; ++j) {
+      for (i = 0; i < m; ++i) {
+	kr[i] = k[j] * r[i];
+      }
+
+      sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+      resj = res + j * n + i0;
+      for (i = 0; i < m; ++i) {
+	resj[i] = (c[i] + kr[i] * s[i] + (s[i] - c[i] * kr[i]) * I)
+	  * fac[i];
+      }
+    }
+  }
+}
+
+static void
+combined_kernel_batch_helmholtzbem3d(uint n, const real * x, const real * y,
+				     const real * nx, const real * ny,
+				     void *data, field * res)
+{
+  pcbem3d   bem = (pcbem3d) data;
+  real      k = bem->k;
+  field     beta = bem->beta;
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      n0 = ny[0], n1 = ny[1], n2 = ny[2];
+  real      kr[BATCH_HELMHOLTZBEM3D], rn[BATCH_HELMHOLTZBEM3D];
+  real      fac[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  uint      i, i0, m;
+
+  (void) nx;
+
+  for (i0 = 0; i0 < n; i0 += m) {
+    m = UINT_MIN(BATCH_HELMHOLTZBEM3D, n - i0);
+
+    for (i = 0; i < m; ++i) {
+      d0 = x0[i0 + i] - y0[i0 + i];
+      d1 = x1[i0 + i] - y1[i0 + i];
+      d2 = x2[i0 + i] - y2[i0 + i];
+      norm2 = REAL_NORMSQR3(d0, d1, d2);
+      rnorm = REAL_RSQRT(norm2);
+
+      kr[i] = k * norm2 * rnorm;
+      rn[i] = rnorm;
+      fac[i] = (rnorm * rnorm * rnorm) * (d0 * n0 + d1 * n1 + d2 * n2);
+    }
+
+    sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+    for (i = 0; i < m; ++i) {
+      res[i0 + i] = (c[i] + I * s[i])
+	* (fac[i] - I * kr[i] * fac[i] + beta * rn[i]);
+    }
+  }
+}
+
 static void
 fill_slp_cc_near_helmholtzbem3d(const uint * ridx,
 				const uint * cidx, pcbem3d bem, bool ntrans,
 				pamatrix N)
 {
-  assemble_cc_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 (kernel_func3d) slp_kernel_helmholtzbem3d);
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_kernel_batch_helmholtzbem3d);
 }
 
 static void
 fill_slp_cc_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
 			       pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_far_bem3d(ridx, cidx, bem, ntrans, N,
-			(kernel_func3d) slp_kernel_helmholtzbem3d);
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_slp_window_cc_near_helmholtzbem3d(const uint * ridx,
+				       const uint * cidx, pcbem3d bem,
+				       bool ntrans, pamatrix N)
+{
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_window_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_slp_window_cc_far_helmholtzbem3d(const uint * ridx,
+				      const uint * cidx, pcbem3d bem,
+				      bool ntrans, pamatrix N)
+{
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_window_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_slp_window_ll_near_helmholtzbem3d(const uint * ridx,
+				       const uint * cidx, pcbem3d bem,
+				       bool ntrans, pamatrix N)
+{
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_window_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_slp_window_ll_far_helmholtzbem3d(const uint * ridx,
+				      const uint * cidx, pcbem3d bem,
+				      bool ntrans, pamatrix N)
+{
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_window_kernel_batch_helmholtzbem3d);
 }
 
 static void
@@ -132,16 +585,16 @@ fill_dlp_cc_near_helmholtzbem3d(const uint * ridx,
 				const uint * cidx, pcbem3d bem, bool ntrans,
 				pamatrix N)
 {
-  assemble_cc_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 (kernel_func3d) dlp_kernel_helmholtzbem3d);
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_helmholtzbem3d);
 }
 
 static void
 fill_dlp_cc_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
 			       pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_far_bem3d(ridx, cidx, bem, ntrans, N,
-			(kernel_func3d) dlp_kernel_helmholtzbem3d);
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_helmholtzbem3d);
 }
 
 static void
@@ -149,16 +602,16 @@ fill_dlp_cl_near_helmholtzbem3d(const uint * ridx,
 				const uint * cidx, pcbem3d bem, bool ntrans,
 				pamatrix N)
 {
-  assemble_cl_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 dlp_kernel_helmholtzbem3d);
+  assemble_cl_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_helmholtzbem3d);
 }
 
 static void
 fill_dlp_cl_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
 			       pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cl_far_bem3d(ridx, cidx, bem, ntrans, N,
-			dlp_kernel_helmholtzbem3d);
+  assemble_cl_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_helmholtzbem3d);
 }
 
 static void
@@ -166,16 +619,16 @@ fill_slp_ll_near_helmholtzbem3d(const uint * ridx,
 				const uint * cidx, pcbem3d bem, bool ntrans,
 				pamatrix N)
 {
-  assemble_ll_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 slp_kernel_helmholtzbem3d);
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_kernel_batch_helmholtzbem3d);
 }
 
 static void
 fill_slp_ll_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
 			       pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_far_bem3d(ridx, cidx, bem, ntrans, N,
-			slp_kernel_helmholtzbem3d);
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_kernel_batch_helmholtzbem3d);
 }
 
 static void
@@ -183,23 +636,160 @@ fill_dlp_ll_near_helmholtzbem3d(const uint * ridx,
 				const uint * cidx, pcbem3d bem, bool ntrans,
 				pamatrix N)
 {
-  assemble_ll_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 dlp_kernel_helmholtzbem3d);
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_helmholtzbem3d);
 }
 
 static void
 fill_dlp_ll_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
 			       pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_far_bem3d(ridx, cidx, bem, ntrans, N,
-			dlp_kernel_helmholtzbem3d);
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_helmholtzbem3d);
 }
 
+static void
+fill_combined_cc_near_helmholtzbem3d(const uint * ridx,
+				     const uint * cidx, pcbem3d bem,
+				     bool ntrans, pamatrix N)
+{
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       combined_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_combined_cc_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				    pcbem3d bem, bool ntrans, pamatrix N)
+{
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      combined_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_combined_ll_near_helmholtzbem3d(const uint * ridx,
+				     const uint * cidx, pcbem3d bem,
+				     bool ntrans, pamatrix N)
+{
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       combined_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_combined_ll_far_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				    pcbem3d bem, bool ntrans, pamatrix N)
+{
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      combined_kernel_batch_helmholtzbem3d);
+}
+
+static void
+fill_slp_cc_wave_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				pcbem3d bem, bool ntrans, uint nk,
+				const real * k, pamatrix * N)
+{
+  assemble_cc_near_wave_bem3d(ridx, cidx, bem, ntrans, nk, k, N,
+			      slp_kernel_wave_helmholtzbem3d);
+}
+
+static void
+fill_slp_ll_wave_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				pcbem3d bem, bool ntrans, uint nk,
+				const real * k, pamatrix * N)
+{
+  assemble_ll_near_wave_bem3d(ridx, cidx, bem, ntrans, nk, k, N,
+			      slp_kernel_wave_helmholtzbem3d);
+}
+
+static void
+fill_dlp_cc_wave_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				pcbem3d bem, bool ntrans, uint nk,
+				const real * k, pamatrix * N)
+{
+  assemble_cc_near_wave_bem3d(ridx, cidx, bem, ntrans, nk, k, N,
+			      dlp_kernel_wave_helmholtzbem3d);
+}
+
+static void
+fill_dlp_cl_wave_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				pcbem3d bem, bool ntrans, uint nk,
+				const real * k, pamatrix * N)
+{
+  assemble_cl_near_wave_bem3d(ridx, cidx, bem, ntrans, nk, k, N,
+			      dlp_kernel_wave_helmholtzbem3d);
+}
+
+static void
+fill_dlp_ll_wave_helmholtzbem3d(const uint * ridx, const uint * cidx,
+				pcbem3d bem, bool ntrans, uint nk,
+				const real * k, pamatrix * N)
+{
+  assemble_ll_near_wave_bem3d(ridx, cidx, bem, ntrans, nk, k, N,
+			      dlp_kernel_wave_helmholtzbem3d);
+}
+
+/* Evaluate the fundamental solution and its normal derivatives for
+ * all pairs of points in X and Y. This is used by the interpolation and
+ * Green based approximation schemes, the rows of every column are processed
+ * in chunks, just like in the batched kernels. */
+
 static void
 fill_kernel_helmholtzbem3d(pcbem3d bem, const real(*X)[3],
 			   const real(*Y)[3], pamatrix V)
 {
-  fill_bem3d(bem, X, Y, NULL, NULL, V, slp_kernel_helmholtzbem3d);
+  uint      rows = V->rows;
+  uint      cols = V->cols;
+  longindex ld = V->ld;
+  field     kc = bem->kernel_const;
+  real      k = bem->k;
+  real      kr[BATCH_HELMHOLTZBEM3D], rn[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  uint      i, i0, j, m;
+
+  for (j = 0; j < cols; ++j) {
+    for (i0 = 0; i0 < rows; i0 += m) {
+      m = UINT_MIN(BATCH_HELMHOLTZBEM3D, rows - i0);
+
+      for (i = 0; i < m; ++i) {
+	d0 = X[i0 + i][0] - Y[j][0];
+	d1 = X[i0 + i][1] - Y[j][1];
+	d2 = X[i0 + i][2] - Y[j][2];
+	norm2 = REAL_NORMSQR3(d0, d1, d2);
+	rnorm = REAL_RSQRT(norm2);
+
+	kr[i] = k * norm2 * rnorm;
+	rn[i] = rnorm;
+      }
+
+      sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+      for (i = 0; i < m; ++i) {
+	V->a[i0 + i + j * ld] = kc * ((c[i] + I * s[i]) * rn[i]);
+      }
+    }
+  }
+}
+
+static void
+fill_window_kernel_helmholtzbem3d(pcbem3d bem, const real(*X)[3],
+				  const real(*Y)[3], pamatrix V)
+{
+  uint      rows = V->rows;
+  uint      cols = V->cols;
+  longindex ld = V->ld;
+  real      d0, d1, d2;
+  uint      i, j;
+
+  fill_kernel_helmholtzbem3d(bem, X, Y, V);
+
+  for (j = 0; j < cols; ++j) {
+    for (i = 0; i < rows; ++i) {
+      d0 = X[i][0] - Y[j][0];
+      d1 = X[i][1] - Y[j][1];
+      d2 = X[i][2] - Y[j][2];
+      V->a[i + j * ld] *= window_helmholtzbem3d(bem, REAL_NORM3(d0, d1, d2));
+    }
+  }
 }
 
 static void
@@ -207,7 +797,40 @@ fill_dny_kernel_helmholtzbem3d(pcbem3d bem, const real(*X)[3],
 			       const real(*Y)[3], const real(*NY)[3],
 			       pamatrix V)
 {
-  fill_bem3d(bem, X, Y, NULL, NY, V, dlp_kernel_helmholtzbem3d);
+  uint      rows = V->rows;
+  uint      cols = V->cols;
+  longindex ld = V->ld;
+  field     kc = bem->kernel_const;
+  real      k = bem->k;
+  real      kr[BATCH_HELMHOLTZBEM3D], fac[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm2, rnorm;
+  uint      i, i0, j, m;
+
+  for (j = 0; j < cols; ++j) {
+    for (i0 = 0; i0 < rows; i0 += m) {
+      m = UINT_MIN(BATCH_HELMHOLTZBEM3D, rows - i0);
+
+      for (i = 0; i < m; ++i) {
+	d0 = X[i0 + i][0] - Y[j][0];
+	d1 = X[i0 + i][1] - Y[j][1];
+	d2 = X[i0 + i][2] - Y[j][2];
+	norm2 = REAL_NORMSQR3(d0, d1, d2);
+	rnorm = REAL_RSQRT(norm2);
+
+	kr[i] = k * norm2 * rnorm;
+	fac[i] = (rnorm * rnorm * rnorm)
+	  * (d0 * NY[j][0] + d1 * NY[j][1] + d2 * NY[j][2]);
+      }
+
+      sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+      for (i = 0; i < m; ++i) {
+	V->a[i0 + i + j * ld] =
+	  kc * ((c[i] + kr[i] * s[i] + (s[i] - c[i] * kr[i]) * I) * fac[i]);
+      }
+    }
+  }
 }
 
 static void
@@ -215,7 +838,48 @@ fill_dnx_dny_kernel_helmholtzbem3d(pcbem3d bem, const real(*X)[3],
 				   const real(*NX)[3], const real(*Y)[3],
 				   const real(*NY)[3], pamatrix V)
 {
-  fill_bem3d(bem, X, Y, NX, NY, V, hs_kernel_helmholtzbem3d);
+  uint      rows = V->rows;
+  uint      cols = V->cols;
+  longindex ld = V->ld;
+  field     kc = bem->kernel_const;
+  real      k = bem->k;
+  real      kr[BATCH_HELMHOLTZBEM3D], hr[BATCH_HELMHOLTZBEM3D];
+  real      hi[BATCH_HELMHOLTZBEM3D], fac[BATCH_HELMHOLTZBEM3D];
+  real      s[BATCH_HELMHOLTZBEM3D], c[BATCH_HELMHOLTZBEM3D];
+  real      d0, d1, d2, norm, norm2, rnorm, dot, dotxy;
+  uint      i, i0, j, m;
+
+  for (j = 0; j < cols; ++j) {
+    for (i0 = 0; i0 < rows; i0 += m) {
+      m = UINT_MIN(BATCH_HELMHOLTZBEM3D, rows - i0);
+
+      for (i = 0; i < m; ++i) {
+	d0 = X[i0 + i][0] - Y[j][0];
+	d1 = X[i0 + i][1] - Y[j][1];
+	d2 = X[i0 + i][2] - Y[j][2];
+	norm2 = REAL_NORMSQR3(d0, d1, d2);
+	rnorm = REAL_RSQRT(norm2);
+
+	norm = k * norm2 * rnorm;
+	dot = (d0 * NX[i0 + i][0] + d1 * NX[i0 + i][1] + d2 * NX[i0 + i][2])
+	  * (d0 * NY[j][0] + d1 * NY[j][1] + d2 * NY[j][2]);
+	dotxy = REAL_DOT3(NX[i0 + i], NY[j]);
+
+	kr[i] = norm;
+	fac[i] = (rnorm * rnorm) * (rnorm * rnorm) * rnorm;
+	hr[i] = (norm * norm - 3.0) * dot + norm2 * dotxy;
+	hi[i] = 3.0 * norm * dot - norm * norm2 * dotxy;
+      }
+
+      sincos_batch_helmholtzbem3d(m, kr, bem->accuracy, s, c);
+
+      for (i = 0; i < m; ++i) {
+	V->a[i0 + i + j * ld] = kc * (fac[i] * (c[i] * hr[i] - s[i] * hi[i]
+						+ (c[i] * hi[i]
+						   + s[i] * hr[i]) * I));
+      }
+    }
+  }
 }
 
 static void
@@ -232,6 +896,20 @@ fill_kernel_l_helmholtzbem3d(const uint * idx, const real(*Z)[3],
   fill_row_l_bem3d(idx, Z, bem, V, slp_kernel_helmholtzbem3d);
 }
 
+static void
+fill_window_kernel_c_helmholtzbem3d(const uint * idx, const real(*Z)[3],
+				    pcbem3d bem, pamatrix V)
+{
+  fill_row_c_bem3d(idx, Z, bem, V, slp_window_kernel_helmholtzbem3d);
+}
+
+static void
+fill_window_kernel_l_helmholtzbem3d(const uint * idx, const real(*Z)[3],
+				    pcbem3d bem, pamatrix V)
+{
+  fill_row_l_bem3d(idx, Z, bem, V, slp_window_kernel_helmholtzbem3d);
+}
+
 static void
 fill_dnz_kernel_c_helmholtzbem3d(const uint * idx,
 				 const real(*Z)[3], const real(*N)[3],
@@ -280,6 +958,81 @@ fill_dcol_kernel_col_l_helmholtzbem3d(const uint * idx,
   fill_col_l_bem3d(idx, Z, bem, V, dlp_kernel_helmholtzbem3d);
 }
 
+static void
+fill_combined_kernel_col_c_helmholtzbem3d(const uint * idx,
+					  const real(*Z)[3], pcbem3d bem,
+					  pamatrix V)
+{
+  fill_col_c_bem3d(idx, Z, bem, V, combined_kernel_helmholtzbem3d);
+}
+
+static void
+fill_combined_kernel_col_l_helmholtzbem3d(const uint * idx,
+					  const real(*Z)[3], pcbem3d bem,
+					  pamatrix V)
+{
+  fill_col_l_bem3d(idx, Z, bem, V, combined_kernel_helmholtzbem3d);
+}
+
+static void
+fill_dnz_combined_kernel_col_c_helmholtzbem3d(const uint * idx,
+					      const real(*Z)[3],
+					      const real(*N)[3], pcbem3d bem,
+					      pamatrix V)
+{
+  fill_dnz_col_c_bem3d(idx, Z, N, bem, V,
+		       dnx_combined_kernel_helmholtzbem3d);
+}
+
+static void
+fill_dnz_combined_kernel_col_l_helmholtzbem3d(const uint * idx,
+					      const real(*Z)[3],
+					      const real(*N)[3], pcbem3d bem,
+					      pamatrix V)
+{
+  fill_dnz_col_l_bem3d(idx, Z, N, bem, V,
+		       dnx_combined_kernel_helmholtzbem3d);
+}
+
+/* The Lagrange polynomials are integrated separately for the double and the
+ * single layer part, since the quadrature is cheap compared to the
+ * evaluation of the kernel function. The column matrix enters the
+ * approximation as its adjoint, therefore the coefficient is conjugated. */
+
+static void
+assemble_combined_lagrange_c_helmholtzbem3d(const uint * idx,
+					    pcavector px, pcavector py,
+					    pcavector pz, pcbem3d bem,
+					    pamatrix V)
+{
+  amatrix   tmp;
+  pamatrix  W;
+
+  assemble_bem3d_dn_lagrange_const_amatrix(idx, px, py, pz, bem, V);
+
+  W = init_amatrix(&tmp, V->rows, V->cols);
+  assemble_bem3d_lagrange_const_amatrix(idx, px, py, pz, bem, W);
+  add_amatrix(CONJ(bem->beta), false, W, V);
+  uninit_amatrix(W);
+}
+
+static void
+assemble_combined_lagrange_l_helmholtzbem3d(const uint * idx,
+					    pcavector px, pcavector py,
+					    pcavector pz, pcbem3d bem,
+					    pamatrix V)
+{
+  amatrix   tmp;
+  pamatrix  W;
+
+  assemble_bem3d_dn_lagrange_linear_amatrix(idx, px, py, pz, bem, V);
+
+  W = init_amatrix(&tmp, V->rows, V->cols);
+  assemble_bem3d_lagrange_linear_amatrix(idx, px, py, pz, bem, W);
+  add_amatrix(CONJ(bem->beta), false, W, V);
+  uninit_amatrix(W);
+}
+
 pbem3d
 new_slp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 			uint q_singular, basisfunctionbem3d basis)
@@ -313,9 +1066,12 @@ new_slp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 
     bem->nearfield = fill_slp_cc_near_helmholtzbem3d;
     bem->nearfield_far = fill_slp_cc_far_helmholtzbem3d;
+    bem->nearfield_wave = fill_slp_cc_wave_helmholtzbem3d;
 
     kernels->lagrange_row = assemble_bem3d_lagrange_const_amatrix;
     kernels->lagrange_col = assemble_bem3d_lagrange_const_amatrix;
+    kernels->dlagrange_row = assemble_bem3d_dlagrange_const_amatrix;
+    kernels->dlagrange_col = assemble_bem3d_dlagrange_const_amatrix;
 
     kernels->fundamental_row = fill_kernel_c_helmholtzbem3d;
     kernels->fundamental_col = fill_kernel_c_helmholtzbem3d;
@@ -345,9 +1101,12 @@ new_slp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 
     bem->nearfield = fill_slp_ll_near_helmholtzbem3d;
     bem->nearfield_far = fill_slp_ll_far_helmholtzbem3d;
+    bem->nearfield_wave = fill_slp_ll_wave_helmholtzbem3d;
 
     kernels->lagrange_row = assemble_bem3d_lagrange_linear_amatrix;
     kernels->lagrange_col = assemble_bem3d_lagrange_linear_amatrix;
+    kernels->dlagrange_row = assemble_bem3d_dlagrange_linear_amatrix;
+    kernels->dlagrange_col = assemble_bem3d_dlagrange_linear_amatrix;
 
     kernels->fundamental_row = fill_kernel_l_helmholtzbem3d;
     kernels->fundamental_col = fill_kernel_l_helmholtzbem3d;
@@ -363,6 +1122,58 @@ new_slp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
   return bem;
 }
 
+pbem3d
+new_slp_window_helmholtz_bem3d(field * kvec, pcsurface3d gr,
+			       uint q_regular, uint q_singular,
+			       basisfunctionbem3d basis, real a, real b)
+{
+  pkernelbem3d kernels;
+
+  pbem3d    bem;
+
+  assert(0.0 <= a && a < b);
+
+  bem = new_slp_helmholtz_bem3d(kvec, gr, q_regular, q_singular, basis);
+  kernels = bem->kernels;
+
+  bem->window_a = a;
+  bem->window_b = b;
+
+  kernels->fundamental = fill_window_kernel_helmholtzbem3d;
+
+  /* The windowed kernel is no fundamental solution, so there is no Green
+   * representation formula for it */
+  kernels->dny_fundamental = NULL;
+  kernels->dnx_dny_fundamental = NULL;
+  kernels->fundamental_row = NULL;
+  kernels->fundamental_col = NULL;
+  kernels->dnz_fundamental_row = NULL;
+  kernels->dnz_fundamental_col = NULL;
+  kernels->dnz_kernel_row = NULL;
+  kernels->dnz_kernel_col = NULL;
+
+  if (basis == BASIS_CONSTANT_BEM3D) {
+    bem->nearfield = fill_slp_window_cc_near_helmholtzbem3d;
+    bem->nearfield_far = fill_slp_window_cc_far_helmholtzbem3d;
+    bem->nearfield_wave = NULL;
+
+    kernels->kernel_row = fill_window_kernel_c_helmholtzbem3d;
+    kernels->kernel_col = fill_window_kernel_c_helmholtzbem3d;
+  }
+  else {
+    assert(basis == BASIS_LINEAR_BEM3D);
+
+    bem->nearfield = fill_slp_window_ll_near_helmholtzbem3d;
+    bem->nearfield_far = fill_slp_window_ll_far_helmholtzbem3d;
+    bem->nearfield_wave = NULL;
+
+    kernels->kernel_row = fill_window_kernel_l_helmholtzbem3d;
+    kernels->kernel_col = fill_window_kernel_l_helmholtzbem3d;
+  }
+
+  return bem;
+}
+
 pbem3d
 new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 			uint q_singular, basisfunctionbem3d basis_neumann,
@@ -413,9 +1224,12 @@ new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
       == BASIS_CONSTANT_BEM3D) {
     bem->nearfield = fill_dlp_cc_near_helmholtzbem3d;
     bem->nearfield_far = fill_dlp_cc_far_helmholtzbem3d;
+    bem->nearfield_wave = fill_dlp_cc_wave_helmholtzbem3d;
 
     kernels->lagrange_row = assemble_bem3d_lagrange_const_amatrix;
     kernels->lagrange_col = assemble_bem3d_dn_lagrange_const_amatrix;
+    kernels->dlagrange_row = assemble_bem3d_dlagrange_const_amatrix;
+    kernels->dlagrange_col = assemble_bem3d_dn_dlagrange_const_amatrix;
 
     kernels->fundamental_row = fill_kernel_c_helmholtzbem3d;
     kernels->fundamental_col = fill_kernel_c_helmholtzbem3d;
@@ -449,9 +1263,12 @@ new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 
     bem->nearfield = fill_dlp_cl_near_helmholtzbem3d;
     bem->nearfield_far = fill_dlp_cl_far_helmholtzbem3d;
+    bem->nearfield_wave = fill_dlp_cl_wave_helmholtzbem3d;
 
     kernels->lagrange_row = assemble_bem3d_lagrange_const_amatrix;
     kernels->lagrange_col = assemble_bem3d_dn_lagrange_linear_amatrix;
+    kernels->dlagrange_row = assemble_bem3d_dlagrange_const_amatrix;
+    kernels->dlagrange_col = assemble_bem3d_dn_dlagrange_linear_amatrix;
 
     kernels->fundamental_row = fill_kernel_c_helmholtzbem3d;
     kernels->fundamental_col = fill_kernel_l_helmholtzbem3d;
@@ -486,9 +1303,12 @@ new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
 
     bem->nearfield = fill_dlp_ll_near_helmholtzbem3d;
     bem->nearfield_far = fill_dlp_ll_far_helmholtzbem3d;
+    bem->nearfield_wave = fill_dlp_ll_wave_helmholtzbem3d;
 
     kernels->lagrange_row = assemble_bem3d_lagrange_linear_amatrix;
     kernels->lagrange_col = assemble_bem3d_dn_lagrange_linear_amatrix;
+    kernels->dlagrange_row = assemble_bem3d_dlagrange_linear_amatrix;
+    kernels->dlagrange_col = assemble_bem3d_dn_dlagrange_linear_amatrix;
 
     kernels->fundamental_row = fill_kernel_l_helmholtzbem3d;
     kernels->fundamental_col = fill_kernel_l_helmholtzbem3d;
@@ -514,6 +1334,103 @@ new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
   return bem;
 }
 
+pbem3d
+new_combined_helmholtz_bem3d(field * kvec, pcsurface3d gr, uint q_regular,
+			     uint q_singular, basisfunctionbem3d basis,
+			     field alpha, field beta)
+{
+  pkernelbem3d kernels;
+
+  pbem3d    bem;
+
+  bem = new_bem3d(gr);
+  kernels = bem->kernels;
+
+  bem->sq = build_singquad2d(gr, q_regular, q_singular);
+
+  if (basis == BASIS_LINEAR_BEM3D) {
+    setup_vertex_to_triangle_map_bem3d(bem);
+  }
+
+  bem->basis_neumann = basis;
+  bem->basis_dirichlet = basis;
+
+  bem->kernel_const = KERNEL_CONST_HELMHOLTZBEM3D;
+  bem->kvec = kvec;
+  bem->k = NORM3(kvec[0], kvec[1], kvec[2]);
+  bem->alpha = alpha;
+  bem->beta = beta;
+
+  kernels->fundamental = fill_kernel_helmholtzbem3d;
+  kernels->dny_fundamental = fill_dny_kernel_helmholtzbem3d;
+  kernels->dnx_dny_fundamental = fill_dnx_dny_kernel_helmholtzbem3d;
+
+  if (basis == BASIS_CONSTANT_BEM3D) {
+    bem->N_neumann = gr->triangles;
+    bem->N_dirichlet = gr->triangles;
+
+    bem->nearfield = fill_combined_cc_near_helmholtzbem3d;
+    bem->nearfield_far = fill_combined_cc_far_helmholtzbem3d;
+
+    kernels->lagrange_row = assemble_bem3d_lagrange_const_amatrix;
+    kernels->lagrange_col = assemble_combined_lagrange_c_helmholtzbem3d;
+
+    kernels->fundamental_row = fill_kernel_c_helmholtzbem3d;
+    kernels->fundamental_col = fill_kernel_c_helmholtzbem3d;
+    kernels->dnz_fundamental_row = fill_dnz_kernel_c_helmholtzbem3d;
+    kernels->dnz_fundamental_col = fill_dnz_kernel_c_helmholtzbem3d;
+
+    kernels->kernel_row = fill_kernel_c_helmholtzbem3d;
+    kernels->kernel_col = fill_combined_kernel_col_c_helmholtzbem3d;
+    kernels->dnz_kernel_row = fill_dnz_kernel_c_helmholtzbem3d;
+    kernels->dnz_kernel_col = fill_dnz_combined_kernel_col_c_helmholtzbem3d;
+  }
+  else {
+    assert(basis == BASIS_LINEAR_BEM3D);
+    bem->N_neumann = gr->vertices;
+    bem->N_dirichlet = gr->vertices;
+
+    weight_basisfunc_ll_singquad2d(bem->sq->x_id, bem->sq->y_id,
+				   bem->sq->w_id, bem->sq->n_id);
+    weight_basisfunc_ll_singquad2d(bem->sq->x_edge, bem->sq->y_edge,
+				   bem->sq->w_edge, bem->sq->n_edge);
+    weight_basisfunc_ll_singquad2d(bem->sq->x_vert, bem->sq->y_vert,
+				   bem->sq->w_vert, bem->sq->n_vert);
+    weight_basisfunc_ll_singquad2d(bem->sq->x_dist, bem->sq->y_dist,
+				   bem->sq->w_dist, bem->sq->n_dist);
+    weight_basisfunc_l_singquad2d(bem->sq->x_single, bem->sq->y_single,
+				  bem->sq->w_single, bem->sq->n_single);
+
+    bem->nearfield = fill_combined_ll_near_helmholtzbem3d;
+    bem->nearfield_far = fill_combined_ll_far_helmholtzbem3d;
+
+    kernels->lagrange_row = assemble_bem3d_lagrange_linear_amatrix;
+    kernels->lagrange_col = assemble_combined_lagrange_l_helmholtzbem3d;
+
+    kernels->fundamental_row = fill_kernel_l_helmholtzbem3d;
+    kernels->fundamental_col = fill_kernel_l_helmholtzbem3d;
+    kernels->dnz_fundamental_row = fill_dnz_kernel_l_helmholtzbem3d;
+    kernels->dnz_fundamental_col = fill_dnz_kernel_l_helmholtzbem3d;
+
+    kernels->kernel_row = fill_kernel_l_helmholtzbem3d;
+    kernels->kernel_col = fill_combined_kernel_col_l_helmholtzbem3d;
+    kernels->dnz_kernel_row = NULL;
+    kernels->dnz_kernel_col = fill_dnz_combined_kernel_col_l_helmholtzbem3d;
+    bem->mass = allocreal(9);
+    bem->mass[0] = 1.0 / 12.0;
+    bem->mass[1] = 1.0 / 24.0;
+    bem->mass[2] = 1.0 / 24.0;
+    bem->mass[3] = 1.0 / 24.0;
+    bem->mass[4] = 1.0 / 12.0;
+    bem->mass[5] = 1.0 / 24.0;
+    bem->mass[6] = 1.0 / 24.0;
+    bem->mass[7] = 1.0 / 24.0;
+    bem->mass[8] = 1.0 / 12.0;
+  }
+
+  return bem;
+}
+
 void
 del_helmholtz_bem3d(pbem3d bem)
 {
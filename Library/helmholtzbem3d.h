@@ -77,6 +77,48 @@ HEADER_PREFIX pbem3d
 new_slp_helmholtz_bem3d(field *kvec, pcsurface3d gr, uint q_regular,
     uint q_singular, basisfunctionbem3d basis);
 
+/**
+ * @brief Creates a new @ref _bem3d "bem3d"-object for computation of
+ * the single layer potential matrix of the Helmholtz equation with a
+ * smoothly truncated kernel function.
+ *
+ * The kernel function is multiplied by the window
+ * @f[
+ * w(r) = \begin{cases}
+ * 1 & \text{if } r \leq a,\\
+ * \exp\left(\frac{2 \exp(-(b-a)/(r-a))}{(r-a)/(b-a) - 1}\right)
+ *   & \text{if } a < r < b,\\
+ * 0 & \text{if } r \geq b,
+ * \end{cases}
+ * @f]
+ * of the distance @f$ r = \|x-y\|_2 @f$. Blocks whose clusters are at
+ * least @f$ b @f$ apart are skipped by the assembly routines, see
+ * @ref beyond_window_bem3d. They do not need any storage if the matrix is
+ * built by @ref build_from_block_cutoff_hmatrix or
+ * @ref build_from_block_cutoff_h2matrix with cutoff @f$ b @f$.
+ *
+ * Since the windowed kernel is no fundamental solution, only the
+ * approximation schemes based on interpolation and ACA can be used.
+ *
+ * @param kvec Three-dimensional vector of field representing the wavevector
+ *   @f$\vec \kappa@f$.
+ * @param gr Surface mesh
+ * @param q_regular Order of gaussian quadrature used within computation of matrix
+ *        entries for single integrals and regular double integrals.
+ * @param q_singular Order of gaussian quadrature used within computation of matrix
+ *        entries singular double integrals.
+ * @param basis Type of basis functions used for neumann data.
+ * @param a Distance at which the cutoff starts.
+ * @param b Distance beyond which the kernel vanishes, has to be larger than
+ *        <tt>a</tt>.
+ *
+ * @return Returns a @ref _bem3d "bem"-object that can compute windowed
+ * slp matrices for the helmholtz equation.
+ */
+HEADER_PREFIX pbem3d
+new_slp_window_helmholtz_bem3d(field *kvec, pcsurface3d gr, uint q_regular,
+    uint q_singular, basisfunctionbem3d basis, real a, real b);
+
 /**
  * @brief Creates a new @ref _bem3d "bem3d"-object for computation of
  * double layer potential matrix plus a scalar times the mass matrix
@@ -108,6 +150,39 @@ new_dlp_helmholtz_bem3d(field * kvec, pcsurface3d gr,
     uint q_regular, uint q_singular, basisfunctionbem3d basis_neumann,
     basisfunctionbem3d basis_dirichlet, field alpha);
 
+/**
+ * @brief Creates a new @ref _bem3d "bem3d"-object for computation of
+ * the combined operator @f$ K + \alpha M + \beta V @f$ of the Helmholtz
+ * equation, e.g. the Brakhage-Werner formulation with
+ * @f$ \beta = -i \eta @f$.
+ *
+ * The double layer and the single layer part are evaluated together, i.e.
+ * every triangle pair, quadrature point and exponential is only computed
+ * once for both operators. The resulting fully populated matrix,
+ * @ref _hmatrix "hmatrix" or @ref _h2matrix "h2matrix" holds the linear
+ * combination, so a single matrix-vector multiplication suffices to apply
+ * the combined operator.
+ *
+ * @param kvec Three-dimensional vector of field representing the wavevector
+ *   @f$\vec \kappa@f$.
+ * @param gr Surface mesh.
+ * @param q_regular Order of gaussian quadrature used within computation of matrix
+ *        entries for single integrals and regular double integrals.
+ * @param q_singular Order of gaussian quadrature used within computation of matrix
+ *        entries singular double integrals.
+ * @param basis Type of basis functions used for both the neumann and the
+ *        dirichlet data.
+ * @param alpha Coefficient @f$\alpha@f$ of the mass matrix.
+ * @param beta Coefficient @f$\beta@f$ of the single layer operator.
+ *
+ * @return Returns a @ref _bem3d "bem"-object that can compute fully populated
+ * matrices @f$ K + \alpha M + \beta V @f$ for the Helmholtz equation.
+ */
+HEADER_PREFIX pbem3d
+new_combined_helmholtz_bem3d(field * kvec, pcsurface3d gr,
+    uint q_regular, uint q_singular, basisfunctionbem3d basis, field alpha,
+    field beta);
+
 /**
  * @brief Delete a @ref _bem3d "bem3d" object for the Helmholtz equation
  *
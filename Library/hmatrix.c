@@ -4,6 +4,7 @@
  * ------------------------------------------------------------ */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #ifdef USE_NETCDF
 #include <string.h>
@@ -13,6 +14,10 @@
 #include "hmatrix.h"
 #include "basic.h"
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
 /* ------------------------------------------------------------
  Constructors and destructors
  ------------------------------------------------------------ */
@@ -25,6 +30,8 @@ init_hmatrix(phmatrix hm, pccluster rc, pccluster cc)
 
   hm->r = NULL;
   hm->f = NULL;
+  hm->fill = NULL;
+  hm->filldata = NULL;
 
   hm->son = NULL;
   hm->rsons = 0;
@@ -33,6 +40,8 @@ init_hmatrix(phmatrix hm, pccluster rc, pccluster cc)
   hm->refs = 0;
   hm->desc = 0;
 
+  hm->arena = NULL;
+
   return hm;
 }
 
@@ -99,6 +108,22 @@ new_full_hmatrix(pccluster rc, pccluster cc)
   return hm;
 }
 
+phmatrix
+new_matrixfree_hmatrix(pccluster rc, pccluster cc, fillblock_t fill,
+		       void *data)
+{
+  phmatrix  hm;
+
+  hm = new_hmatrix(rc, cc);
+
+  hm->fill = fill;
+  hm->filldata = data;
+
+  hm->desc = 1;
+
+  return hm;
+}
+
 phmatrix
 new_super_hmatrix(pccluster rc, pccluster cc, uint rsons, uint csons)
 {
@@ -141,6 +166,9 @@ clonestructure_hmatrix(pchmatrix src)
   else if (src->r != NULL) {
     hm = new_rk_hmatrix(src->rc, src->cc, src->r->k);
   }
+  else if (src->fill != NULL) {
+    hm = new_matrixfree_hmatrix(src->rc, src->cc, src->fill, src->filldata);
+  }
   else {
     assert(src->f != NULL);
     hm = new_full_hmatrix(src->rc, src->cc);
@@ -177,6 +205,9 @@ clone_hmatrix(pchmatrix src)
     copy_amatrix(false, &src->r->A, &hm->r->A);
     copy_amatrix(false, &src->r->B, &hm->r->B);
   }
+  else if (src->fill != NULL) {
+    hm = new_matrixfree_hmatrix(src->rc, src->cc, src->fill, src->filldata);
+  }
   else {
     assert(src->f != NULL);
     hm = new_full_hmatrix(src->rc, src->cc);
@@ -212,9 +243,14 @@ update_hmatrix(phmatrix hm)
 void
 del_hmatrix(phmatrix hm)
 {
+  parena    a = hm->arena;
+
   uninit_hmatrix(hm);
 
   freemem(hm);
+
+  if (a)
+    del_arena(a);
 }
 
 /* ------------------------------------------------------------
@@ -495,6 +531,99 @@ build_from_block_hmatrix(pcblock b, uint k)
   return h;
 }
 
+phmatrix
+build_from_block_arena_hmatrix(pcblock b, uint k)
+{
+  phmatrix  h;
+  parena    a, old;
+
+  a = new_arena(0);
+  old = select_arena(a);
+
+  h = build_from_block_hmatrix(b, k);
+
+  (void) select_arena(old);
+
+  h->arena = a;
+
+  return h;
+}
+
+phmatrix
+build_from_block_matrixfree_hmatrix(pcblock b, uint k, fillblock_t fill,
+				    void *data)
+{
+  phmatrix  h, h1;
+  pcblock   b1;
+  int       rsons, csons;
+  int       i, j;
+
+  h = NULL;
+
+  if (b->son) {
+    rsons = b->rsons;
+    csons = b->csons;
+
+    h = new_super_hmatrix(b->rc, b->cc, rsons, csons);
+
+    for (j = 0; j < csons; j++) {
+      for (i = 0; i < rsons; i++) {
+	b1 = b->son[i + j * rsons];
+
+	h1 = build_from_block_matrixfree_hmatrix(b1, k, fill, data);
+
+	ref_hmatrix(h->son + i + j * rsons, h1);
+      }
+    }
+  }
+  else if (b->a > 0)
+    h = new_rk_hmatrix(b->rc, b->cc, k);
+  else
+    h = new_matrixfree_hmatrix(b->rc, b->cc, fill, data);
+
+  update_hmatrix(h);
+
+  return h;
+}
+
+phmatrix
+build_from_block_cutoff_hmatrix(pcblock b, uint k, real cutoff)
+{
+  phmatrix  h, h1;
+  pcblock   b1;
+  int       rsons, csons;
+  int       i, j;
+
+  h = NULL;
+
+  if (b->son) {
+    rsons = b->rsons;
+    csons = b->csons;
+
+    h = new_super_hmatrix(b->rc, b->cc, rsons, csons);
+
+    for (j = 0; j < csons; j++) {
+      for (i = 0; i < rsons; i++) {
+	b1 = b->son[i + j * rsons];
+
+	h1 = build_from_block_cutoff_hmatrix(b1, k, cutoff);
+
+	ref_hmatrix(h->son + i + j * rsons, h1);
+      }
+    }
+  }
+  else if (getdist_max_cluster(b->rc, b->cc) >= cutoff)
+    h = new_rk_hmatrix(b->rc, b->cc, 0);
+  else if (b->a > 0)
+    h = new_rk_hmatrix(b->rc, b->cc, k);
+  else
+    h = new_full_hmatrix(b->rc, b->cc);
+
+  update_hmatrix(h);
+
+  return h;
+}
+
 /* ------------------------------------------------------------
  * Build block tree from H-matrix
  * ------------------------------------------------------------ */
@@ -553,6 +682,8 @@ fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   pavector  x1, y1;
   avector   xtmp, ytmp;
   uint      rsons, csons;
+  pamatrix  N;
+  amatrix   tmp;
   uint      xoff, yoff, i, j;
 
   assert(x->dim == hm->cc->size);
@@ -564,6 +695,12 @@ fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   else if (hm->f) {
     mvm_amatrix_avector(alpha, false, hm->f, x, y);
   }
+  else if (hm->fill) {
+    N = init_amatrix(&tmp, hm->rc->size, hm->cc->size);
+    hm->fill(hm->rc->idx, hm->cc->idx, hm->filldata, N);
+    mvm_amatrix_avector(alpha, false, N, x, y);
+    uninit_amatrix(N);
+  }
   else {
     rsons = hm->rsons;
     csons = hm->csons;
@@ -593,6 +730,286 @@ fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 }
 
+#ifdef USE_OPENMP
+/* Part of the target vector owned by one thread in a parallel
+ * matrix-vector multiplication: the cluster t starting at offset off
+ * and the estimated number of operations for its rows */
+typedef struct {
+  pccluster t;
+  uint      off;
+  size_t    cost;
+} mvmtask;
+
+/* Sort tasks by decreasing cost, so that the dynamic schedule of OpenMP
+ * treats the expensive ones first */
+static int
+compare_mvmtask(const void *a, const void *b)
+{
+  size_t    ca = ((const mvmtask *) a)->cost;
+  size_t    cb = ((const mvmtask *) b)->cost;
+
+  return (ca < cb) - (ca > cb);
+}
+
+/* Number of operations for the rows [a,a+n) of hm, or the columns if
+ * trans is set, if the first row (or column) of hm is off */
+static size_t
+getcost_part_hmatrix(pchmatrix hm, bool trans, uint off, uint a, uint n)
+{
+  uint      size = (trans ? hm->cc->size : hm->rc->size);
+  uint      other = (trans ? hm->rc->size : hm->cc->size);
+  uint      lo = UINT_MAX(off, a);
+  uint      hi = UINT_MIN(off + size, a + n);
+  size_t    cost;
+  uint      off1, i, j;
+
+  if (lo >= hi)
+    return 0;
+
+  cost = 0;
+
+  if (hm->r) {
+    cost = (size_t) hm->r->k * (hi - lo + other);
+  }
+  else if (hm->f || hm->fill) {
+    cost = (size_t) (hi - lo) * other;
+  }
+  else if (trans) {
+    off1 = off;
+    for (j = 0; j < hm->csons; j++) {
+      for (i = 0; i < hm->rsons; i++)
+	cost += getcost_part_hmatrix(hm->son[i + j * hm->rsons], trans, off1,
+				     a, n);
+
+      off1 += hm->son[j * hm->rsons]->cc->size;
+    }
+  }
+  else {
+    off1 = off;
+    for (i = 0; i < hm->rsons; i++) {
+      for (j = 0; j < hm->csons; j++)
+	cost += getcost_part_hmatrix(hm->son[i + j * hm->rsons], trans, off1,
+				     a, n);
+
+      off1 += hm->son[i]->rc->size;
+    }
+  }
+
+  return cost;
+}
+
+/* Split the cluster t into tasks with at most limit operations each */
+static void
+collect_mvmtasks(pchmatrix hm, bool trans, pccluster t, uint off,
+		 size_t limit, mvmtask * tasks, uint * ntasks)
+{
+  size_t    cost;
+  uint      off1, i;
+
+  cost = getcost_part_hmatrix(hm, trans, 0, off, t->size);
+
+  if (cost > limit && t->sons > 0) {
+    off1 = off;
+    for (i = 0; i < t->sons; i++) {
+      collect_mvmtasks(hm, trans, t->son[i], off1, limit, tasks, ntasks);
+
+      off1 += t->son[i]->size;
+    }
+    assert(off1 == off + t->size);
+  }
+  else {
+    tasks[*ntasks].t = t;
+    tasks[*ntasks].off = off;
+    tasks[*ntasks].cost = cost;
+    (*ntasks)++;
+  }
+}
+
+/* Compute the rows [a,a+n) of y + alpha A x, where the submatrix hm
+ * starts in row roff and column coff of A */
+static void
+addeval_part_hmatrix(field alpha, pchmatrix hm, uint roff, uint coff,
+		     uint a, uint n, pcavector xp, pavector yp)
+{
+  avector   tmp1, tmp2, tmp3;
+  amatrix   tmp4;
+  pavector  x1, y1, z;
+  pamatrix  N;
+  uint      lo = UINT_MAX(roff, a);
+  uint      hi = UINT_MIN(roff + hm->rc->size, a + n);
+  uint      roff1, coff1, i, j;
+
+  if (lo >= hi)
+    return;
+
+  if (hm->son == NULL) {
+    x1 = init_sub_avector(&tmp1, (pavector) xp, hm->cc->size, coff);
+    y1 = init_sub_avector(&tmp2, yp, hi - lo, lo);
+
+    if (hm->r && hm->r->CA) {
+      /* Compressed factors are only available column by column */
+      z = init_avector(&tmp3, hm->rc->size);
+      clear_avector(z);
+      addeval_rkmatrix_avector(alpha, hm->r, x1, z);
+      for (i = lo; i < hi; i++)
+	y1->v[i - lo] += z->v[i - roff];
+      uninit_avector(z);
+    }
+    else if (hm->r) {
+      z = init_avector(&tmp3, hm->r->k);
+      clear_avector(z);
+      mvm_amatrix_avector(1.0, true, &hm->r->B, x1, z);
+      N = init_sub_amatrix(&tmp4, &hm->r->A, hi - lo, lo - roff, hm->r->k,
+			   0);
+      mvm_amatrix_avector(alpha, false, N, z, y1);
+      uninit_amatrix(N);
+      uninit_avector(z);
+    }
+    else if (hm->f) {
+      N = init_sub_amatrix(&tmp4, hm->f, hi - lo, lo - roff, hm->cc->size,
+			   0);
+      mvm_amatrix_avector(alpha, false, N, x1, y1);
+      uninit_amatrix(N);
+    }
+    else if (hm->fill) {
+      N = init_amatrix(&tmp4, hi - lo, hm->cc->size);
+      hm->fill(hm->rc->idx + (lo - roff), hm->cc->idx, hm->filldata, N);
+      mvm_amatrix_avector(alpha, false, N, x1, y1);
+      uninit_amatrix(N);
+    }
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+  else {
+    coff1 = coff;
+    for (j = 0; j < hm->csons; j++) {
+      roff1 = roff;
+      for (i = 0; i < hm->rsons; i++) {
+	addeval_part_hmatrix(alpha, hm->son[i + j * hm->rsons], roff1, coff1,
+			     a, n, xp, yp);
+
+	roff1 += hm->son[i]->rc->size;
+      }
+      assert(roff1 == roff + hm->rc->size);
+
+      coff1 += hm->son[j * hm->rsons]->cc->size;
+    }
+    assert(coff1 == coff + hm->cc->size);
+  }
+}
+
+/* Compute the rows [a,a+n) of y + alpha A^* x, where the submatrix hm
+ * starts in row roff and column coff of A */
+static void
+addevaltrans_part_hmatrix(field alpha, pchmatrix hm, uint roff, uint coff,
+			  uint a, uint n, pcavector xp, pavector yp)
+{
+  avector   tmp1, tmp2, tmp3;
+  amatrix   tmp4;
+  pavector  x1, y1, z;
+  pamatrix  N;
+  uint      lo = UINT_MAX(coff, a);
+  uint      hi = UINT_MIN(coff + hm->cc->size, a + n);
+  uint      roff1, coff1, i, j;
+
+  if (lo >= hi)
+    return;
+
+  if (hm->son == NULL) {
+    x1 = init_sub_avector(&tmp1, (pavector) xp, hm->rc->size, roff);
+    y1 = init_sub_avector(&tmp2, yp, hi - lo, lo);
+
+    if (hm->r && hm->r->CA) {
+      /* Compressed factors are only available column by column */
+      z = init_avector(&tmp3, hm->cc->size);
+      clear_avector(z);
+      addevaltrans_rkmatrix_avector(alpha, hm->r, x1, z);
+      for (i = lo; i < hi; i++)
+	y1->v[i - lo] += z->v[i - coff];
+      uninit_avector(z);
+    }
+    else if (hm->r) {
+      z = init_avector(&tmp3, hm->r->k);
+      clear_avector(z);
+      mvm_amatrix_avector(1.0, true, &hm->r->A, x1, z);
+      N = init_sub_amatrix(&tmp4, &hm->r->B, hi - lo, lo - coff, hm->r->k,
+			   0);
+      mvm_amatrix_avector(alpha, false, N, z, y1);
+      uninit_amatrix(N);
+      uninit_avector(z);
+    }
+    else if (hm->f) {
+      N = init_sub_amatrix(&tmp4, hm->f, hm->rc->size, 0, hi - lo,
+			   lo - coff);
+      mvm_amatrix_avector(alpha, true, N, x1, y1);
+      uninit_amatrix(N);
+    }
+    else if (hm->fill) {
+      N = init_amatrix(&tmp4, hm->rc->size, hi - lo);
+      hm->fill(hm->rc->idx, hm->cc->idx + (lo - coff), hm->filldata, N);
+      mvm_amatrix_avector(alpha, true, N, x1, y1);
+      uninit_amatrix(N);
+    }
+
+    uninit_avector(y1);
+    uninit_avector(x1);
+  }
+  else {
+    coff1 = coff;
+    for (j = 0; j < hm->csons; j++) {
+      roff1 = roff;
+      for (i = 0; i < hm->rsons; i++) {
+	addevaltrans_part_hmatrix(alpha, hm->son[i + j * hm->rsons], roff1,
+				  coff1, a, n, xp, yp);
+
+	roff1 += hm->son[i]->rc->size;
+      }
+      assert(roff1 == roff + hm->rc->size);
+
+      coff1 += hm->son[j * hm->rsons]->cc->size;
+    }
+    assert(coff1 == coff + hm->cc->size);
+  }
+}
+
+/* Parallel version of fastaddeval_hmatrix_avector and
+ * fastaddevaltrans_hmatrix_avector. The target vector is split into
+ * clusters of roughly equal cost, every cluster is owned by exactly one
+ * thread, so no synchronization is required. */
+static void
+paraddeval_hmatrix_avector(field alpha, pchmatrix hm, bool trans,
+			   pcavector xp, pavector yp)
+{
+  pccluster t = (trans ? hm->cc : hm->rc);
+  mvmtask  *tasks;
+  size_t    limit;
+  uint      ntasks;
+  int       i;
+
+  limit = getcost_part_hmatrix(hm, trans, 0, 0, t->size)
+    / (4 * omp_get_max_threads()) + 1;
+
+  tasks = (mvmtask *) allocmem(sizeof(mvmtask) * t->desc);
+  ntasks = 0;
+  collect_mvmtasks(hm, trans, t, 0, limit, tasks, &ntasks);
+
+  qsort(tasks, ntasks, sizeof(mvmtask), compare_mvmtask);
+
+#pragma omp parallel for schedule(dynamic,1)
+  for (i = 0; i < (int) ntasks; i++) {
+    if (trans)
+      addevaltrans_part_hmatrix(alpha, hm, 0, 0, tasks[i].off,
+				tasks[i].t->size, xp, yp);
+    else
+      addeval_part_hmatrix(alpha, hm, 0, 0, tasks[i].off, tasks[i].t->size,
+			   xp, yp);
+  }
+
+  freemem(tasks);
+}
+#endif
+
 void
 addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
 {
@@ -620,7 +1037,13 @@ addeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y)
   }
 
   /* Matrix-vector multiplication */
-  fastaddeval_hmatrix_avector(alpha, hm, xp, yp);
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1
+      && !omp_in_parallel())
+    paraddeval_hmatrix_avector(alpha, hm, false, xp, yp);
+  else
+#endif
+    fastaddeval_hmatrix_avector(alpha, hm, xp, yp);
 
   /* Reverse permutation of y */
   for (i = 0; i < yp->dim; i++) {
@@ -640,6 +1063,8 @@ fastaddevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   pavector  x1, y1;
   avector   xtmp, ytmp;
   uint      rsons, csons;
+  pamatrix  N;
+  amatrix   tmp;
   uint      xoff, yoff, i, j;
 
   assert(x->dim == hm->rc->size);
@@ -651,6 +1076,12 @@ fastaddevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   else if (hm->f) {
     mvm_amatrix_avector(alpha, true, hm->f, x, y);
   }
+  else if (hm->fill) {
+    N = init_amatrix(&tmp, hm->rc->size, hm->cc->size);
+    hm->fill(hm->rc->idx, hm->cc->idx, hm->filldata, N);
+    mvm_amatrix_avector(alpha, true, N, x, y);
+    uninit_amatrix(N);
+  }
   else {
     rsons = hm->rsons;
     csons = hm->csons;
@@ -709,7 +1140,13 @@ addevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 
   /* Matrix-vector multiplication */
-  fastaddevaltrans_hmatrix_avector(alpha, hm, xp, yp);
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1
+      && !omp_in_parallel())
+    paraddeval_hmatrix_avector(alpha, hm, true, xp, yp);
+  else
+#endif
+    fastaddevaltrans_hmatrix_avector(alpha, hm, xp, yp);
 
   /* Reverse permutation of y */
   for (i = 0; i < yp->dim; i++) {
@@ -727,16 +1164,25 @@ addevalsymm_offdiag(field alpha, pchmatrix hm, uint roff, uint coff,
 		    pcavector xp, pavector yp)
 {
   avector   tmp1, tmp2;
+  amatrix   tmp3;
   pavector  xp1, yp1;
+  pamatrix  f;
   uint      rsons, csons;
   uint      roff1, coff1;
   uint      i, j;
 
-  if (hm->f) {
+  if (hm->f || hm->fill) {
+    /* Matrix-free leaves are computed once for both products */
+    f = hm->f;
+    if (f == NULL) {
+      f = init_amatrix(&tmp3, hm->rc->size, hm->cc->size);
+      hm->fill(hm->rc->idx, hm->cc->idx, hm->filldata, f);
+    }
+
     xp1 = init_sub_avector(&tmp1, (pavector) xp, hm->cc->size, coff);
     yp1 = init_sub_avector(&tmp2, yp, hm->rc->size, roff);
 
-    addeval_amatrix_avector(alpha, hm->f, xp1, yp1);
+    addeval_amatrix_avector(alpha, f, xp1, yp1);
 
     uninit_avector(yp1);
     uninit_avector(xp1);
@@ -744,10 +1190,13 @@ addevalsymm_offdiag(field alpha, pchmatrix hm, uint roff, uint coff,
     xp1 = init_sub_avector(&tmp1, (pavector) xp, hm->rc->size, roff);
     yp1 = init_sub_avector(&tmp2, yp, hm->cc->size, coff);
 
-    addevaltrans_amatrix_avector(alpha, hm->f, xp1, yp1);
+    addevaltrans_amatrix_avector(alpha, f, xp1, yp1);
 
     uninit_avector(yp1);
     uninit_avector(xp1);
+
+    if (f != hm->f)
+      uninit_amatrix(f);
   }
   else if (hm->r) {
     xp1 = init_sub_avector(&tmp1, (pavector) xp, hm->cc->size, coff);
@@ -795,7 +1244,9 @@ addevalsymm_diag(field alpha, pchmatrix hm, uint off, pcavector xp,
 		 pavector yp)
 {
   avector   tmp1, tmp2;
+  amatrix   tmp3;
   pavector  xp1, yp1;
+  pamatrix  f;
   pfield    aa;
   uint      lda, sons;
   uint      roff, coff;
@@ -804,12 +1255,18 @@ addevalsymm_diag(field alpha, pchmatrix hm, uint off, pcavector xp,
 
   assert(hm->rc == hm->cc);
 
-  if (hm->f) {
-    assert(hm->rc->size == hm->f->rows);
-    assert(hm->cc->size == hm->f->cols);
+  if (hm->f || hm->fill) {
+    f = hm->f;
+    if (f == NULL) {
+      f = init_amatrix(&tmp3, hm->rc->size, hm->cc->size);
+      hm->fill(hm->rc->idx, hm->cc->idx, hm->filldata, f);
+    }
+
+    assert(hm->rc->size == f->rows);
+    assert(hm->cc->size == f->cols);
 
-    aa = hm->f->a;
-    lda = hm->f->ld;
+    aa = f->a;
+    lda = f->ld;
 
     n = hm->rc->size;
     xp1 = init_sub_avector(&tmp1, (pavector) xp, n, off);
@@ -825,6 +1282,9 @@ addevalsymm_diag(field alpha, pchmatrix hm, uint off, pcavector xp,
 
     uninit_avector(yp1);
     uninit_avector(xp1);
+
+    if (f != hm->f)
+      uninit_amatrix(f);
   }
   else {
     assert(hm->son != 0);
@@ -861,6 +1321,112 @@ fastaddevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
   addevalsymm_diag(alpha, hm, 0, xp, yp);
 }
 
+#ifdef USE_OPENMP
+/* Leaf of the lower triangular part of a symmetric matrix for the
+ * parallel matrix-vector multiplication */
+typedef struct {
+  pchmatrix hm;
+  uint      roff;
+  uint      coff;
+  bool      diag;
+  size_t    cost;
+} symmtask;
+
+static int
+compare_symmtask(const void *a, const void *b)
+{
+  size_t    ca = ((const symmtask *) a)->cost;
+  size_t    cb = ((const symmtask *) b)->cost;
+
+  return (ca < cb) - (ca > cb);
+}
+
+static void
+collect_symmtasks(pchmatrix hm, uint roff, uint coff, bool diag,
+		  symmtask * tasks, uint * ntasks)
+{
+  uint      roff1, coff1, i, j;
+
+  if (hm->son == NULL) {
+    tasks[*ntasks].hm = hm;
+    tasks[*ntasks].roff = roff;
+    tasks[*ntasks].coff = coff;
+    tasks[*ntasks].diag = diag;
+    tasks[*ntasks].cost = (hm->r ?
+			   (size_t) 2 * hm->r->k * (hm->rc->size +
+						    hm->cc->size) :
+			   (size_t) 2 * hm->rc->size * hm->cc->size);
+    (*ntasks)++;
+  }
+  else {
+    coff1 = coff;
+    for (j = 0; j < hm->csons; j++) {
+      roff1 = roff;
+      for (i = 0; i < hm->rsons; i++) {
+	/* Only the lower triangular part of diagonal blocks is used */
+	if (!diag || i >= j)
+	  collect_symmtasks(hm->son[i + j * hm->rsons], roff1, coff1,
+			    diag && i == j, tasks, ntasks);
+
+	roff1 += hm->son[i]->rc->size;
+      }
+
+      coff1 += hm->son[j * hm->rsons]->cc->size;
+    }
+  }
+}
+
+/* Parallel version of fastaddevalsymm_hmatrix_avector. Every leaf
+ * contributes to two parts of the target vector, so every thread
+ * accumulates its results in a private buffer and the buffers are
+ * added afterwards. */
+static void
+paraddevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
+			       pavector yp)
+{
+  symmtask *tasks;
+  pavector *ybuf;
+  uint      ntasks, nthreads, n;
+  int       i, j;
+
+  n = hm->rc->size;
+  nthreads = omp_get_max_threads();
+
+  tasks = (symmtask *) allocmem(sizeof(symmtask) * hm->desc);
+  ntasks = 0;
+  collect_symmtasks(hm, 0, 0, true, tasks, &ntasks);
+
+  qsort(tasks, ntasks, sizeof(symmtask), compare_symmtask);
+
+  ybuf = (pavector *) allocmem(sizeof(pavector) * nthreads);
+  for (j = 0; j < (int) nthreads; j++) {
+    ybuf[j] = new_avector(n);
+    clear_avector(ybuf[j]);
+  }
+
+#pragma omp parallel for schedule(dynamic,1) num_threads(nthreads)
+  for (i = 0; i < (int) ntasks; i++) {
+    if (tasks[i].diag)
+      addevalsymm_diag(alpha, tasks[i].hm, tasks[i].roff, xp,
+		       ybuf[omp_get_thread_num()]);
+    else
+      addevalsymm_offdiag(alpha, tasks[i].hm, tasks[i].roff, tasks[i].coff,
+			  xp, ybuf[omp_get_thread_num()]);
+  }
+
+  /* Add the buffers in parallel, every thread handles a range of rows */
+#pragma omp parallel for num_threads(nthreads)
+  for (i = 0; i < (int) n; i++)
+    for (j = 0; j < (int) nthreads; j++)
+      yp->v[i] += ybuf[j]->v[i];
+
+  for (j = 0; j < (int) nthreads; j++)
+    del_avector(ybuf[j]);
+  freemem(ybuf);
+  freemem(tasks);
+}
+#endif
+
 void
 addevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
 			    pavector y)
@@ -895,7 +1461,13 @@ addevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   }
 
   /* Matrix-vector multiplication */
-  fastaddevalsymm_hmatrix_avector(alpha, hm, xp, yp);
+#ifdef USE_OPENMP
+  if (max_pardepth > 0 && omp_get_max_threads() > 1
+      && !omp_in_parallel())
+    paraddevalsymm_hmatrix_avector(alpha, hm, xp, yp);
+  else
+#endif
+    fastaddevalsymm_hmatrix_avector(alpha, hm, xp, yp);
 
   /* Reverse permutation of y */
   for (i = 0; i < n; i++) {
@@ -909,6 +1481,177 @@ addevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector x,
   uninit_avector(xp);
 }
 
+/* ------------------------------------------------------------
+ Multiplication with blocks of vectors
+ ------------------------------------------------------------ */
+
+/* Yp += alpha A Xp or Yp += alpha A^* Xp, every leaf is applied to all
+ * columns of Xp by matrix-matrix products */
+static void
+addmul_leaves_hmatrix_amatrix(field alpha, bool trans, pchmatrix hm,
+			      pcamatrix Xp, pamatrix Yp)
+{
+  amatrix   tmp1, tmp2, tmp3;
+  pamatrix  X1, Y1, Z, N;
+  pcamatrix A, B;
+  uint      rsons, csons;
+  avector   tmp4, tmp5;
+  pavector  x, y;
+  uint      roff, coff, i, j;
+
+  if (hm->r && hm->r->CA) {
+    /* Compressed factors are only available column by column */
+    for (j = 0; j < Xp->cols; j++) {
+      x = init_column_avector(&tmp4, (pamatrix) Xp, j);
+      y = init_column_avector(&tmp5, Yp, j);
+      mvm_rkmatrix_avector(alpha, trans, hm->r, x, y);
+      uninit_avector(y);
+      uninit_avector(x);
+    }
+  }
+  else if (hm->r) {
+    A = (trans ? &hm->r->B : &hm->r->A);
+    B = (trans ? &hm->r->A : &hm->r->B);
+
+    if (hm->r->k > 0) {
+      Z = init_amatrix(&tmp1, hm->r->k, Xp->cols);
+      clear_amatrix(Z);
+      addmul_amatrix(1.0, true, B, false, Xp, Z);
+      addmul_amatrix(alpha, false, A, false, Z, Yp);
+      uninit_amatrix(Z);
+    }
+  }
+  else if (hm->f) {
+    addmul_amatrix(alpha, trans, hm->f, false, Xp, Yp);
+  }
+  else if (hm->fill) {
+    N = init_amatrix(&tmp1, hm->rc->size, hm->cc->size);
+    hm->fill(hm->rc->idx, hm->cc->idx, hm->filldata, N);
+    addmul_amatrix(alpha, trans, N, false, Xp, Yp);
+    uninit_amatrix(N);
+  }
+  else {
+    rsons = hm->rsons;
+    csons = hm->csons;
+
+    coff = 0;
+    for (j = 0; j < csons; j++) {
+      roff = 0;
+      for (i = 0; i < rsons; i++) {
+	if (trans) {
+	  X1 = init_sub_amatrix(&tmp2, (pamatrix) Xp, hm->son[i]->rc->size,
+				roff, Xp->cols, 0);
+	  Y1 = init_sub_amatrix(&tmp3, Yp, hm->son[j * rsons]->cc->size,
+				coff, Yp->cols, 0);
+	}
+	else {
+	  X1 = init_sub_amatrix(&tmp2, (pamatrix) Xp,
+				hm->son[j * rsons]->cc->size, coff, Xp->cols,
+				0);
+	  Y1 = init_sub_amatrix(&tmp3, Yp, hm->son[i]->rc->size, roff,
+				Yp->cols, 0);
+	}
+
+	addmul_leaves_hmatrix_amatrix(alpha, trans, hm->son[i + j * rsons],
+				      X1, Y1);
+
+	uninit_amatrix(Y1);
+	uninit_amatrix(X1);
+
+	roff += hm->son[i]->rc->size;
+      }
+      assert(roff == hm->rc->size);
+
+      coff += hm->son[j * rsons]->cc->size;
+    }
+    assert(coff == hm->cc->size);
+  }
+}
+
+void
+fastaddeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix Xp,
+			    pamatrix Yp)
+{
+  assert(Xp->rows == hm->cc->size);
+  assert(Yp->rows == hm->rc->size);
+  assert(Xp->cols == Yp->cols);
+
+  addmul_leaves_hmatrix_amatrix(alpha, false, hm, Xp, Yp);
+}
+
+void
+fastaddevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix Xp,
+				 pamatrix Yp)
+{
+  assert(Xp->rows == hm->rc->size);
+  assert(Yp->rows == hm->cc->size);
+  assert(Xp->cols == Yp->cols);
+
+  addmul_leaves_hmatrix_amatrix(alpha, true, hm, Xp, Yp);
+}
+
+/* Multiply in original numbering, xc and yc are the clusters
+ * describing the rows of X and Y */
+static void
+addmul_permuted_hmatrix_amatrix(field alpha, bool trans, pchmatrix hm,
+				pccluster xc, pccluster yc, pcamatrix X,
+				pamatrix Y)
+{
+  amatrix   xtmp, ytmp;
+  pamatrix  Xp, Yp;
+  uint      cols = X->cols;
+  uint      i, ip, j;
+
+  assert(X->rows == xc->size);
+  assert(Y->rows == yc->size);
+  assert(Y->cols == cols);
+
+  /* Permutation of X */
+  Xp = init_amatrix(&xtmp, X->rows, cols);
+  for (j = 0; j < cols; j++)
+    for (i = 0; i < X->rows; i++) {
+      ip = xc->idx[i];
+      assert(ip < X->rows);
+      Xp->a[i + j * Xp->ld] = X->a[ip + j * X->ld];
+    }
+
+  /* Permutation of Y */
+  Yp = init_amatrix(&ytmp, Y->rows, cols);
+  for (j = 0; j < cols; j++)
+    for (i = 0; i < Y->rows; i++) {
+      ip = yc->idx[i];
+      assert(ip < Y->rows);
+      Yp->a[i + j * Yp->ld] = Y->a[ip + j * Y->ld];
+    }
+
+  /* Matrix-matrix multiplication */
+  addmul_leaves_hmatrix_amatrix(alpha, trans, hm, Xp, Yp);
+
+  /* Reverse permutation of Y */
+  for (j = 0; j < cols; j++)
+    for (i = 0; i < Y->rows; i++) {
+      ip = yc->idx[i];
+      Y->a[ip + j * Y->ld] = Yp->a[i + j * Yp->ld];
+    }
+
+  /* Clean up */
+  uninit_amatrix(Yp);
+  uninit_amatrix(Xp);
+}
+
+void
+addeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X, pamatrix Y)
+{
+  addmul_permuted_hmatrix_amatrix(alpha, false, hm, hm->cc, hm->rc, X, Y);
+}
+
+void
+addevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X,
+			     pamatrix Y)
+{
+  addmul_permuted_hmatrix_amatrix(alpha, true, hm, hm->rc, hm->cc, X, Y);
+}
+
 /* ------------------------------------------------------------
  Enumeration
  ------------------------------------------------------------ */
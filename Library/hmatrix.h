@@ -38,6 +38,17 @@ typedef const hmatrix *pchmatrix;
 #include "eigensolvers.h"
 #include "sparsematrix.h"
 
+/** @brief Callback function computing the entries of a matrix block
+ *  on demand.
+ *
+ *  @param ridx Row indices of the block.
+ *  @param cidx Column indices of the block.
+ *  @param data Additional data, e.g., a boundary element object.
+ *  @param N Target matrix, its entries are overwritten by the
+ *         block's coefficients. */
+typedef void (*fillblock_t)(const uint *ridx, const uint *cidx, void *data,
+			    pamatrix N);
+
 /** @brief Representation of @f$\mathcal{H}@f$-matrices.
  *
  *  @f$\mathcal{H}@f$-matrices are represented recursively:
@@ -56,6 +67,12 @@ struct _hmatrix {
   /** @brief Standard matrix, for inadmissible leaves. */
   pamatrix f;
 
+  /** @brief Callback computing the entries of a matrix-free
+   *  inadmissible leaf on demand, <tt>NULL</tt> for all other blocks. */
+  fillblock_t fill;
+  /** @brief Additional data for <tt>fill</tt>. */
+  void *filldata;
+
   /** @brief Submatrices. */
   phmatrix *son;
   /** @brief Number of block rows. */
@@ -67,6 +84,11 @@ struct _hmatrix {
   uint refs;
   /** @brief Number of descendants in matrix tree. */
   uint desc;
+
+  /** @brief Arena containing the storage of the entire tree, only set
+   *  for the root of a matrix created by
+   *  @ref build_from_block_arena_hmatrix. */
+  parena arena;
 };
 
 /* ------------------------------------------------------------
@@ -141,6 +163,35 @@ new_rk_hmatrix(pccluster rc, pccluster cc, uint k);
 HEADER_PREFIX phmatrix
 new_full_hmatrix(pccluster rc, pccluster cc);
 
+/** @brief Create a new @ref hmatrix object representing a
+ *  matrix-free dense matrix.
+ *
+ *  No coefficients are stored, instead <tt>fill</tt> is called
+ *  to compute the block whenever it is multiplied by a vector,
+ *  e.g., in @ref fastaddeval_hmatrix_avector.
+ *  This trades repeated computation for the storage of the
+ *  nearfield.
+ *
+ *  @remark Matrix-free leaves are only supported by the
+ *  multiplication routines
+ *  @ref fastaddeval_hmatrix_avector,
+ *  @ref fastaddevaltrans_hmatrix_avector,
+ *  @ref fastaddevalsymm_hmatrix_avector,
+ *  @ref fastaddeval_hmatrix_amatrix,
+ *  @ref fastaddevaltrans_hmatrix_amatrix and their wrappers,
+ *  not by the matrix arithmetic.
+ *
+ *  @remark Should always be matched by a call to @ref del_hmatrix.
+ *
+ *  @param rc Row cluster.
+ *  @param cc Column cluster.
+ *  @param fill Callback computing the coefficients.
+ *  @param data Additional data for <tt>fill</tt>.
+ *  @returns New matrix-free @ref hmatrix object. */
+HEADER_PREFIX phmatrix
+new_matrixfree_hmatrix(pccluster rc, pccluster cc, fillblock_t fill,
+		       void *data);
+
 /** @brief Create a new @ref hmatrix object representing a
  *  subdivided matrix.
  *
@@ -354,6 +405,55 @@ random_hmatrix(phmatrix hm, uint kmax);
 HEADER_PREFIX phmatrix
 build_from_block_hmatrix(pcblock b, uint k);
 
+/** @brief Build an @ref hmatrix object from a @ref block tree using
+ *  a given local rank, taking the storage from an @ref arena.
+ *
+ *  The matrix is constructed like in @ref build_from_block_hmatrix,
+ *  but all nodes, low-rank factors and nearfield matrices are placed
+ *  in a few large slabs of one @ref arena that is released at once
+ *  when the root is deleted.
+ *
+ *  @remark Submatrices must not be referenced from outside the tree,
+ *  since they do not survive the deletion of the root.
+ *
+ *  @param b Block tree.
+ *  @param k Local rank.
+ *  @returns New @ref hmatrix object. */
+HEADER_PREFIX phmatrix
+build_from_block_arena_hmatrix(pcblock b, uint k);
+
+/** @brief Build an @ref hmatrix object from a @ref block tree using
+ *  a given local rank and matrix-free nearfield leaves.
+ *
+ *  @remark Submatrices for farfield leaves are created, but their
+ *  coefficients are not initialized. Nearfield leaves are created
+ *  by @ref new_matrixfree_hmatrix and store no coefficients.
+ *
+ *  @param b Block tree.
+ *  @param k Local rank.
+ *  @param fill Callback computing nearfield blocks.
+ *  @param data Additional data for <tt>fill</tt>.
+ *  @returns New @ref hmatrix object. */
+HEADER_PREFIX phmatrix
+build_from_block_matrixfree_hmatrix(pcblock b, uint k, fillblock_t fill,
+				    void *data);
+
+/** @brief Build an @ref hmatrix object from a @ref block tree for a kernel
+ *  function that vanishes beyond a cutoff distance.
+ *
+ *  Leaves whose clusters are at least <tt>cutoff</tt> apart in the
+ *  maximum norm, see @ref getdist_max_cluster, are structural zeros and
+ *  become @ref rkmatrix objects of rank zero that store no coefficients.
+ *  All other leaves are created as in @ref build_from_block_hmatrix.
+ *
+ *  @param b Block tree, ideally built with
+ *         @ref admissible_max_cutoff_cluster.
+ *  @param k Local rank.
+ *  @param cutoff Cutoff distance of the kernel function.
+ *  @returns New @ref hmatrix object. */
+HEADER_PREFIX phmatrix
+build_from_block_cutoff_hmatrix(pcblock b, uint k, real cutoff);
+
 /* ------------------------------------------------------------
  Build block tree from H-matrix
  ------------------------------------------------------------ */
@@ -408,6 +508,10 @@ fastaddeval_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
  *  The matrix is multiplied by the source vector @f$x@f$, the result
  *  is scaled by @f$\alpha@f$ and added to the target vector @f$y@f$.
  *
+ *  If OpenMP is enabled, the target vector is split into clusters
+ *  with similar numbers of operations, and every cluster is handled
+ *  by a single thread.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param hm Matrix @f$A@f$.
  *  @param x Source vector @f$x@f$.
@@ -437,6 +541,10 @@ fastaddevaltrans_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
  *  The matrix is multiplied by the source vector @f$x@f$, the result
  *  is scaled by @f$\alpha@f$ and added to the target vector @f$y@f$.
  *
+ *  If OpenMP is enabled, the target vector is split into clusters
+ *  with similar numbers of operations, and every cluster is handled
+ *  by a single thread.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param hm Matrix @f$A@f$.
  *  @param x Source vector @f$x@f$.
@@ -468,6 +576,9 @@ fastaddevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
  *  is scaled by @f$\alpha@f$ and added to the target vector @f$y@f$.
  *  Only the lower triangular part of @f$A@f$ is used.
  *
+ *  If OpenMP is enabled, the leaves are distributed among the threads
+ *  and every thread accumulates its contributions in a private vector.
+ *
  *  @param alpha Scaling factor @f$\alpha@f$.
  *  @param hm Matrix @f$A@f$.
  *  @param x Source vector @f$x@f$.
@@ -475,6 +586,61 @@ fastaddevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector xp,
 HEADER_PREFIX void
 addevalsymm_hmatrix_avector(field alpha, pchmatrix hm, pcavector x, pavector y);
 
+/* ------------------------------------------------------------
+ Multiplication with blocks of vectors
+ ------------------------------------------------------------ */
+
+/** @brief Multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A X@f$ in cluster numbering.
+ *
+ *  Every leaf is applied to all columns of @f$X@f$ at once, so that
+ *  the product is carried out by matrix-matrix instead of
+ *  matrix-vector operations.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param Xp Source matrix @f$X@f$, rows in cluster numbering
+ *            with respect to <tt>hm->cc</tt>.
+ *  @param Yp Target matrix @f$Y@f$, rows in cluster numbering
+ *            with respect to <tt>hm->rc</tt>. */
+HEADER_PREFIX void
+fastaddeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix Xp,
+    pamatrix Yp);
+
+/** @brief Multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addeval_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X, pamatrix Y);
+
+/** @brief Adjoint multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A^* X@f$ in cluster numbering.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param Xp Source matrix @f$X@f$, rows in cluster numbering
+ *            with respect to <tt>hm->rc</tt>.
+ *  @param Yp Target matrix @f$Y@f$, rows in cluster numbering
+ *            with respect to <tt>hm->cc</tt>. */
+HEADER_PREFIX void
+fastaddevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix Xp,
+    pamatrix Yp);
+
+/** @brief Adjoint multiplication with a block of vectors
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param hm Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addevaltrans_hmatrix_amatrix(field alpha, pchmatrix hm, pcamatrix X,
+    pamatrix Y);
+
 /* ------------------------------------------------------------
  Enumeration by block number
  ------------------------------------------------------------ */
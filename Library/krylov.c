@@ -5,6 +5,7 @@
 
 #include "krylov.h"
 #include "factorizations.h"
+#include "basic.h"
 
 /* ------------------------------------------------------------
  Standard conjugate gradient method
@@ -500,3 +501,301 @@ residualnorm_pgmres(pcavector rhat, uint k)
 {
   return REAL_ABS(rhat->v[k]);
 }
+
+/* ------------------------------------------------------------
+ Block conjugate gradient method
+ ------------------------------------------------------------ */
+
+void
+init_blockcg(addevalblock_t addeval, void *matrix, pcamatrix B, pamatrix X,
+	     pamatrix R, pamatrix P, pamatrix A)
+{
+  (void) A;
+
+  assert(B->cols == X->cols);
+
+  copy_amatrix(false, B, R);	/* R = B - A X */
+  addeval(-1.0, matrix, X, R);
+
+  copy_amatrix(false, R, P);	/* P = R */
+}
+
+void
+step_blockcg(addevalblock_t addeval, void *matrix, pcamatrix B, pamatrix X,
+	     pamatrix R, pamatrix P, pamatrix A)
+{
+  amatrix   tmp1, tmp2, tmp3;
+  pamatrix  G, L, T;
+  uint      s = P->cols;
+
+  (void) B;
+
+  clear_amatrix(A);		/* A = A P */
+  addeval(1.0, matrix, P, A);
+
+  G = init_zero_amatrix(&tmp1, s, s);	/* G = P^* A P */
+  addmul_amatrix(1.0, true, P, false, A, G);
+  choldecomp_amatrix(G);
+
+  L = init_zero_amatrix(&tmp2, s, s);	/* Lambda = G^{-1} P^* R */
+  addmul_amatrix(1.0, true, P, false, R, L);
+  cholsolve_amatrix(G, L);
+
+  addmul_amatrix(1.0, false, P, false, L, X);	/* X = X + P Lambda */
+
+  addmul_amatrix(-1.0, false, A, false, L, R);	/* R = R - A Lambda */
+
+  clear_amatrix(L);		/* Mu = G^{-1} A^* R */
+  addmul_amatrix(1.0, true, A, false, R, L);
+  cholsolve_amatrix(G, L);
+
+  T = init_amatrix(&tmp3, P->rows, s);	/* P = R - P Mu */
+  copy_amatrix(false, P, T);
+  copy_amatrix(false, R, P);
+  addmul_amatrix(-1.0, false, T, false, L, P);
+
+  uninit_amatrix(T);
+  uninit_amatrix(L);
+  uninit_amatrix(G);
+}
+
+/* ------------------------------------------------------------
+ Block GMRES method with deflation
+ ------------------------------------------------------------ */
+
+/* Orthonormalize W against the blocks V_0, ..., V_j, store the
+ * coefficients in column block j of H and replace W by an orthonormal
+ * basis of the remainder */
+static void
+orthonormalize_blockgmres(pamatrix V, uint j, uint s, pamatrix W,
+			  pamatrix H, pavector tau)
+{
+  amatrix   tmp1, tmp2, tmp3, tmp4;
+  pamatrix  Vi, Hij, C, Wt;
+  uint      pass, i, k, l;
+
+  /* Block Gram-Schmidt, applied twice for stability */
+  C = init_amatrix(&tmp3, s, s);
+  for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i <= j; i++) {
+      Vi = init_sub_amatrix(&tmp1, V, V->rows, 0, s, i * s);
+      Hij = init_sub_amatrix(&tmp2, H, s, i * s, s, j * s);
+
+      clear_amatrix(C);
+      addmul_amatrix(1.0, true, Vi, false, W, C);
+      add_amatrix(1.0, false, C, Hij);
+      addmul_amatrix(-1.0, false, Vi, false, C, W);
+
+      uninit_amatrix(Hij);
+      uninit_amatrix(Vi);
+    }
+  }
+  uninit_amatrix(C);
+
+  /* Householder QR of the remainder */
+  Wt = init_amatrix(&tmp4, W->rows, s);
+  copy_amatrix(false, W, Wt);
+  qrdecomp_amatrix(Wt, tau);
+
+  Hij = init_sub_amatrix(&tmp2, H, s, (j + 1) * s, s, j * s);
+  for (l = 0; l < s; l++)
+    for (k = 0; k <= l; k++)
+      Hij->a[k + l * Hij->ld] = Wt->a[k + l * Wt->ld];
+  uninit_amatrix(Hij);
+
+  qrexpand_amatrix(Wt, tau, W);
+  uninit_amatrix(Wt);
+}
+
+/* Solve the least-squares problem min |E_1 S - H Y| for the first k
+ * columns of H, return the coefficients in the first k rows of G and
+ * the residual norms in res */
+static void
+leastsquares_blockgmres(pcamatrix H, uint k, uint s, pcamatrix S,
+			pamatrix G, preal res)
+{
+  amatrix   tmp1, tmp2, tmp3;
+  avector   tmp4, tmp5;
+  pamatrix  Hc, Hk, G1;
+  pavector  tau, g;
+  uint      j;
+
+  Hc = init_amatrix(&tmp1, k + s, k);
+  Hk = init_sub_amatrix(&tmp2, (pamatrix) H, k + s, 0, k, 0);
+  copy_amatrix(false, Hk, Hc);
+  uninit_amatrix(Hk);
+
+  tau = init_avector(&tmp4, k);
+  qrdecomp_amatrix(Hc, tau);
+
+  clear_amatrix(G);
+  G1 = init_sub_amatrix(&tmp2, G, s, 0, s, 0);
+  copy_amatrix(false, S, G1);
+  uninit_amatrix(G1);
+
+  G1 = init_sub_amatrix(&tmp2, G, k + s, 0, s, 0);
+  qreval_amatrix(true, Hc, tau, G1);
+  uninit_amatrix(G1);
+
+  /* Residual norms in the last s rows */
+  G1 = init_sub_amatrix(&tmp2, G, s, k, s, 0);
+  for (j = 0; j < s; j++) {
+    g = init_column_avector(&tmp5, G1, j);
+    res[j] = norm2_avector(g);
+    uninit_avector(g);
+  }
+  uninit_amatrix(G1);
+
+  /* Coefficients in the first k rows */
+  Hk = init_sub_amatrix(&tmp2, Hc, k, 0, k, 0);
+  G1 = init_sub_amatrix(&tmp3, G, k, 0, s, 0);
+  triangularsolve_amatrix(false, false, false, Hk, false, G1);
+  uninit_amatrix(G1);
+  uninit_amatrix(Hk);
+
+  uninit_avector(tau);
+  uninit_amatrix(Hc);
+}
+
+uint
+solve_blockgmres(addevalblock_t addeval, void *matrix, pcamatrix B,
+		 pamatrix X, real eps, uint m, uint maxsteps)
+{
+  amatrix   tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7, tmp8, tmp11, tmp12;
+  avector   tmp9, tmp10;
+  pamatrix  Xa, Ra, Xs, Rs, V, H, S, G, W, Vj;
+  pavector  tau, r;
+  uint     *active;
+  preal     bnorm, res;
+  uint      n = B->rows;
+  uint      cols = B->cols;
+  uint      s, snew, steps, i, j, l;
+  bool      finished;
+
+  assert(X->rows == n);
+  assert(X->cols == cols);
+  assert(m > 0);
+
+  active = allocuint(cols);
+  bnorm = allocreal(cols);
+  res = allocreal(cols);
+
+  s = 0;
+  for (j = 0; j < cols; j++) {
+    r = init_column_avector(&tmp9, (pamatrix) B, j);
+    bnorm[j] = norm2_avector(r);
+    if (bnorm[j] <= 0.0)
+      bnorm[j] = 1.0;
+    uninit_avector(r);
+
+    active[s++] = j;
+  }
+
+  steps = 0;
+  while (s > 0 && steps < maxsteps) {
+    /* Residuals of the active columns */
+    Xa = init_amatrix(&tmp1, n, s);
+    Ra = init_amatrix(&tmp2, n, s);
+    for (j = 0; j < s; j++)
+      for (i = 0; i < n; i++) {
+	Xa->a[i + j * Xa->ld] = X->a[i + active[j] * X->ld];
+	Ra->a[i + j * Ra->ld] = B->a[i + active[j] * B->ld];
+      }
+    addeval(-1.0, matrix, Xa, Ra);
+
+    /* Deflation: remove converged columns */
+    snew = 0;
+    for (j = 0; j < s; j++) {
+      r = init_column_avector(&tmp9, Ra, j);
+      if (norm2_avector(r) > eps * bnorm[active[j]]) {
+	if (snew < j)
+	  for (i = 0; i < n; i++) {
+	    Xa->a[i + snew * Xa->ld] = Xa->a[i + j * Xa->ld];
+	    Ra->a[i + snew * Ra->ld] = Ra->a[i + j * Ra->ld];
+	  }
+	active[snew++] = active[j];
+      }
+      uninit_avector(r);
+    }
+
+    if (snew == 0) {
+      uninit_amatrix(Ra);
+      uninit_amatrix(Xa);
+      s = 0;
+      break;
+    }
+
+    s = snew;
+    Xs = init_sub_amatrix(&tmp11, Xa, n, 0, s, 0);
+    Rs = init_sub_amatrix(&tmp12, Ra, n, 0, s, 0);
+
+    V = init_amatrix(&tmp3, n, (m + 1) * s);
+    H = init_zero_amatrix(&tmp4, (m + 1) * s, m * s);
+    S = init_zero_amatrix(&tmp5, s, s);
+    G = init_amatrix(&tmp6, (m + 1) * s, s);
+    tau = init_avector(&tmp10, s);
+
+    /* First block of the Krylov basis, R = V_0 S */
+    qrdecomp_amatrix(Rs, tau);
+    for (l = 0; l < s; l++)
+      for (i = 0; i <= l; i++)
+	S->a[i + l * S->ld] = Rs->a[i + l * Rs->ld];
+    Vj = init_sub_amatrix(&tmp7, V, n, 0, s, 0);
+    qrexpand_amatrix(Rs, tau, Vj);
+    uninit_amatrix(Vj);
+
+    /* Block Arnoldi iteration */
+    finished = false;
+    for (j = 0; j < m && !finished; j++) {
+      Vj = init_sub_amatrix(&tmp7, V, n, 0, s, j * s);
+      W = init_sub_amatrix(&tmp8, V, n, 0, s, (j + 1) * s);
+      clear_amatrix(W);
+      addeval(1.0, matrix, Vj, W);
+      steps++;
+
+      orthonormalize_blockgmres(V, j, s, W, H, tau);
+
+      uninit_amatrix(W);
+      uninit_amatrix(Vj);
+
+      leastsquares_blockgmres(H, (j + 1) * s, s, S, G, res);
+
+      /* Restart with a smaller block as soon as a column has
+       * converged */
+      for (l = 0; l < s; l++)
+	if (res[l] <= eps * bnorm[active[l]])
+	  finished = true;
+      if (j + 1 == m || steps >= maxsteps)
+	finished = true;
+
+      if (finished) {
+	Vj = init_sub_amatrix(&tmp7, V, n, 0, (j + 1) * s, 0);
+	W = init_sub_amatrix(&tmp8, G, (j + 1) * s, 0, s, 0);
+	addmul_amatrix(1.0, false, Vj, false, W, Xs);
+	uninit_amatrix(W);
+	uninit_amatrix(Vj);
+      }
+    }
+
+    /* Copy improved solutions */
+    for (l = 0; l < s; l++)
+      for (i = 0; i < n; i++)
+	X->a[i + active[l] * X->ld] = Xs->a[i + l * Xs->ld];
+
+    uninit_avector(tau);
+    uninit_amatrix(G);
+    uninit_amatrix(S);
+    uninit_amatrix(H);
+    uninit_amatrix(V);
+    uninit_amatrix(Rs);
+    uninit_amatrix(Xs);
+    uninit_amatrix(Ra);
+    uninit_amatrix(Xa);
+  }
+
+  freemem(res);
+  freemem(bnorm);
+  freemem(active);
+
+  return steps;
+}
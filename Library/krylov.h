@@ -58,6 +58,22 @@ typedef void (*addeval_t)(field alpha, void *matrix,
 typedef void (*mvm_t)(field alpha, bool trans, void *matrix,
 		      pcavector x, pavector y);
 
+/** @brief Matrix callback for blocks of vectors.
+ *
+ *  Used to evaluate the system matrix @f$A@f$ for several vectors
+ *  at once, i.e., to perform @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  Functions like @ref addeval_hmatrix_amatrix,
+ *  @ref addeval_h2matrix_amatrix or @ref addeval_sparsematrix_amatrix
+ *  can be cast to <tt>addevalblock_t</tt>.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param matrix Matrix data describing @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+typedef void (*addevalblock_t)(field alpha, void *matrix,
+			       pcamatrix X, pamatrix Y);
+
 /** @brief Preconditioner callback.
  *
  *  Used to apply a precondtioner to a vector, i.e., to perform
@@ -430,6 +446,76 @@ finish_pgmres(addeval_t addeval,
 HEADER_PREFIX real
 residualnorm_pgmres(pcavector rhat, uint k);
 
+/* ------------------------------------------------------------
+ * Block conjugate gradients method (block cg)
+ * ------------------------------------------------------------ */
+
+/** @brief Initialize a block conjugate gradient method to
+ *  solve @f$A X = B@f$ for several right-hand sides at once.
+ *
+ *  The matrix @f$A@f$ has to be self-adjoint and positive definite.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param R Residuals @f$B-AX@f$.
+ *  @param P Search directions.
+ *  @param A Auxiliary matrix. */
+HEADER_PREFIX void
+init_blockcg(addevalblock_t addeval, void *matrix,
+	     pcamatrix B, pamatrix X, pamatrix R, pamatrix P, pamatrix A);
+
+/** @brief One step of a block conjugate gradient method.
+ *
+ *  The matrix is applied once to all search directions, the step
+ *  sizes are obtained by solving small systems with the Gram matrix
+ *  @f$P^* A P@f$.
+ *
+ *  @remark The columns of @f$P@f$ have to stay linearly independent.
+ *  Once some of the residuals have converged, the iteration should be
+ *  restarted with the remaining columns.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param B Right-hand sides.
+ *  @param X Approximate solutions.
+ *  @param R Residuals @f$B-AX@f$.
+ *  @param P Search directions.
+ *  @param A Auxiliary matrix. */
+HEADER_PREFIX void
+step_blockcg(addevalblock_t addeval, void *matrix,
+	     pcamatrix B, pamatrix X, pamatrix R, pamatrix P, pamatrix A);
+
+/* ------------------------------------------------------------
+ * Block generalized minimal residual method (block GMRES)
+ * ------------------------------------------------------------ */
+
+/** @brief Solve @f$A X = B@f$ for several right-hand sides by the
+ *  restarted block GMRES method.
+ *
+ *  A block Krylov space is constructed for all active columns, so
+ *  that every step requires only one call of <tt>addeval</tt> for
+ *  a block of vectors.
+ *  Columns are deflated, i.e., removed from the block, once their
+ *  residual satisfies @f$\|b_j - A x_j\|_2 \leq \epsilon \|b_j\|_2@f$.
+ *  The iteration is restarted after <tt>m</tt> steps or as soon as
+ *  a column has converged.
+ *
+ *  @param addeval Callback function representing the matrix @f$A@f$.
+ *  @param matrix Data for the <tt>addeval</tt> callback.
+ *  @param B Right-hand sides.
+ *  @param X Initial guesses, will be replaced by improved
+ *         approximations.
+ *  @param eps Relative accuracy for every column.
+ *  @param m Maximal number of steps before a restart.
+ *  @param maxsteps Maximal total number of steps.
+ *  @returns Number of steps, i.e., of block matrix multiplications
+ *         used to build Krylov spaces. */
+HEADER_PREFIX uint
+solve_blockgmres(addevalblock_t addeval, void *matrix,
+		 pcamatrix B, pamatrix X, real eps, uint m, uint maxsteps);
+
 /** @} */
 
 #endif
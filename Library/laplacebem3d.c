@@ -106,78 +106,137 @@ hs_kernel_laplacebem3d(const real * x, const real * y,
   return res;
 }
 
+/* Batched versions of the kernel functions, the points are given in
+ * structure-of-arrays layout, see kernel_batch_func3d. The loops contain
+ * no function calls and no branches, so the compiler is able to vectorize
+ * them. */
+
+static void
+slp_kernel_batch_laplacebem3d(uint n, const real * x, const real * y,
+			      const real * nx, const real * ny, void *data,
+			      field * res)
+{
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      d0, d1, d2;
+  uint      i;
+
+  (void) nx;
+  (void) ny;
+  (void) data;
+
+  for (i = 0; i < n; ++i) {
+    d0 = x0[i] - y0[i];
+    d1 = x1[i] - y1[i];
+    d2 = x2[i] - y2[i];
+
+    res[i] = REAL_RSQRT(REAL_NORMSQR3(d0, d1, d2));
+  }
+}
+
+static void
+dlp_kernel_batch_laplacebem3d(uint n, const real * x, const real * y,
+			      const real * nx, const real * ny, void *data,
+			      field * res)
+{
+  const real *x0 = x, *x1 = x + n, *x2 = x + 2 * n;
+  const real *y0 = y, *y1 = y + n, *y2 = y + 2 * n;
+  real      n0 = ny[0], n1 = ny[1], n2 = ny[2];
+  real      d0, d1, d2, norm;
+  uint      i;
+
+  (void) nx;
+  (void) data;
+
+  for (i = 0; i < n; ++i) {
+    d0 = x0[i] - y0[i];
+    d1 = x1[i] - y1[i];
+    d2 = x2[i] - y2[i];
+    norm = REAL_RSQRT(REAL_NORMSQR3(d0, d1, d2));
+    norm *= norm * norm;
+
+    res[i] = (d0 * n0 + d1 * n1 + d2 * n2) * norm;
+  }
+}
+
 static void
 fill_slp_cc_near_laplacebem3d(const uint * ridx, const uint * cidx,
 			      pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 (kernel_func3d) slp_kernel_laplacebem3d);
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_slp_cc_far_laplacebem3d(const uint * ridx, const uint * cidx,
 			     pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_far_bem3d(ridx, cidx, bem, ntrans, N,
-			(kernel_func3d) slp_kernel_laplacebem3d);
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_cc_near_laplacebem3d(const uint * ridx, const uint * cidx,
 			      pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_near_bem3d(ridx, cidx, bem, ntrans, N,
-			 (kernel_func3d) dlp_kernel_laplacebem3d);
+  assemble_cc_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_cc_far_laplacebem3d(const uint * ridx, const uint * cidx,
 			     pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cc_far_bem3d(ridx, cidx, bem, ntrans, N,
-			(kernel_func3d) dlp_kernel_laplacebem3d);
+  assemble_cc_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_cl_near_laplacebem3d(const uint * ridx, const uint * cidx,
 			      pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cl_near_bem3d(ridx, cidx, bem, ntrans, N, dlp_kernel_laplacebem3d);
+  assemble_cl_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_cl_far_laplacebem3d(const uint * ridx, const uint * cidx,
 			     pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_cl_far_bem3d(ridx, cidx, bem, ntrans, N, dlp_kernel_laplacebem3d);
+  assemble_cl_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_slp_ll_near_laplacebem3d(const uint * ridx, const uint * cidx,
 			      pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_near_bem3d(ridx, cidx, bem, ntrans, N, slp_kernel_laplacebem3d);
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       slp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_slp_ll_far_laplacebem3d(const uint * ridx, const uint * cidx,
 			     pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_far_bem3d(ridx, cidx, bem, ntrans, N, slp_kernel_laplacebem3d);
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      slp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_ll_near_laplacebem3d(const uint * ridx, const uint * cidx,
 			      pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_near_bem3d(ridx, cidx, bem, ntrans, N, dlp_kernel_laplacebem3d);
+  assemble_ll_near_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			       dlp_kernel_batch_laplacebem3d);
 }
 
 static void
 fill_dlp_ll_far_laplacebem3d(const uint * ridx, const uint * cidx,
 			     pcbem3d bem, bool ntrans, pamatrix N)
 {
-  assemble_ll_far_bem3d(ridx, cidx, bem, ntrans, N, dlp_kernel_laplacebem3d);
+  assemble_ll_far_batch_bem3d(ridx, cidx, bem, ntrans, N,
+			      dlp_kernel_batch_laplacebem3d);
 }
 
 static void
@@ -0,0 +1,302 @@
+/* ------------------------------------------------------------
+ This is the file "qmatrix.c" of the H2Lib package.
+ All rights reserved, 2016
+ ------------------------------------------------------------ */
+
+#include <math.h>
+
+#include "qmatrix.h"
+#include "basic.h"
+
+/* Number of real components per coefficient */
+#ifdef USE_COMPLEX
+#define QMATRIX_PARTS 2
+#else
+#define QMATRIX_PARTS 1
+#endif
+
+/* ------------------------------------------------------------
+ Bit streams
+ ------------------------------------------------------------ */
+
+static void
+putbits(uint64_t * data, size_t pos, uint bits, uint64_t u)
+{
+  size_t    w = pos >> 6;
+  uint      s = pos & 63;
+
+  data[w] |= u << s;
+  if (s + bits > 64)
+    data[w + 1] |= u >> (64 - s);
+}
+
+static uint64_t
+getbits(const uint64_t * data, size_t pos, uint bits)
+{
+  size_t    w = pos >> 6;
+  uint      s = pos & 63;
+  uint64_t  u;
+
+  u = data[w] >> s;
+  if (s + bits > 64)
+    u |= data[w + 1] << (64 - s);
+
+  return u & ((((uint64_t) 1) << bits) - 1);
+}
+
+/* Largest integer that can be stored with the given number of bits */
+static int64_t
+levels(uint bits)
+{
+  return (((int64_t) 1) << (bits - 1)) - 1;
+}
+
+/* ------------------------------------------------------------
+ Constructors and destructors
+ ------------------------------------------------------------ */
+
+static void
+encode(pqmatrix q, size_t *pos, uint bits, int64_t l, real scale, real v)
+{
+  int64_t   i;
+
+  i = (int64_t) llround(v / scale);
+  if (i > l)
+    i = l;
+  else if (i < -l)
+    i = -l;
+
+  putbits(q->data, *pos, bits, (uint64_t) (i + l));
+  (*pos) += bits;
+}
+
+pqmatrix
+new_qmatrix(pcamatrix a, const real * tol)
+{
+  pqmatrix  q;
+  field     aij;
+  real      smax, norm, need;
+  size_t    pos;
+  int64_t   l;
+  uint      rows = a->rows;
+  uint      cols = a->cols;
+  uint      bits, i, j;
+
+  q = (pqmatrix) allocmem(sizeof(qmatrix));
+
+  q->rows = rows;
+  q->cols = cols;
+  q->bits = allocuint(cols);
+  q->scale = allocreal(cols);
+  q->off = (size_t *) allocmem(sizeof(size_t) * (cols + 1));
+
+  /* Choose the number of bits for every column */
+  pos = 0;
+  for (j = 0; j < cols; j++) {
+    smax = 0.0;
+    norm = 0.0;
+    for (i = 0; i < rows; i++) {
+      aij = a->a[i + (size_t) j * a->ld];
+      smax = REAL_MAX(smax, REAL_ABS(REAL(aij)));
+      smax = REAL_MAX(smax, REAL_ABS(IMAG(aij)));
+      norm += ABSSQR(aij);
+    }
+    norm = REAL_SQRT(norm);
+
+    q->off[j] = pos;
+
+    if (smax == 0.0 || norm <= tol[j]) {
+      q->bits[j] = 0;
+      q->scale[j] = 0.0;
+      continue;
+    }
+
+    /* Rounding to the nearest multiple of smax / l gives an error of
+     * at most smax / (2 l) per component */
+    need = REAL_SQRT((real) rows * QMATRIX_PARTS) * smax / (2.0 * tol[j]);
+    bits = 2;
+    while (bits < QMATRIX_MAXBITS && (tol[j] <= 0.0 || levels(bits) < need))
+      bits++;
+
+    q->bits[j] = bits;
+    q->scale[j] = smax / levels(bits);
+    pos += (size_t) bits * rows * QMATRIX_PARTS;
+  }
+  q->off[cols] = pos;
+
+  /* One additional word, so that reading never leaves the array */
+  q->words = pos / 64 + 2;
+  q->data = (uint64_t *) allocmem(sizeof(uint64_t) * q->words);
+  for (i = 0; i < q->words; i++)
+    q->data[i] = 0;
+
+  /* Fill the bit stream */
+  for (j = 0; j < cols; j++) {
+    bits = q->bits[j];
+    if (bits == 0)
+      continue;
+
+    l = levels(bits);
+    pos = q->off[j];
+    for (i = 0; i < rows; i++) {
+      aij = a->a[i + (size_t) j * a->ld];
+      encode(q, &pos, bits, l, q->scale[j], REAL(aij));
+#ifdef USE_COMPLEX
+      encode(q, &pos, bits, l, q->scale[j], IMAG(aij));
+#endif
+    }
+    assert(pos == q->off[j] + (size_t) bits * rows * QMATRIX_PARTS);
+  }
+
+  return q;
+}
+
+void
+del_qmatrix(pqmatrix q)
+{
+  freemem(q->data);
+  freemem(q->off);
+  freemem(q->scale);
+  freemem(q->bits);
+  freemem(q);
+}
+
+/* ------------------------------------------------------------
+ Statistics
+ ------------------------------------------------------------ */
+
+size_t
+getsize_qmatrix(pcqmatrix q)
+{
+  size_t    sz;
+
+  sz = sizeof(qmatrix);
+  sz += (sizeof(uint) + sizeof(real) + sizeof(size_t)) * q->cols;
+  sz += sizeof(size_t);
+  sz += sizeof(uint64_t) * q->words;
+
+  return sz;
+}
+
+/* ------------------------------------------------------------
+ Decompression
+ ------------------------------------------------------------ */
+
+/* Decode the next coefficient of a column */
+static field
+decode(pcqmatrix q, size_t *pos, uint bits, int64_t l, real scale)
+{
+  field     v;
+
+  v = ((int64_t) getbits(q->data, *pos, bits) - l) * scale;
+  (*pos) += bits;
+#ifdef USE_COMPLEX
+  v += ((int64_t) getbits(q->data, *pos, bits) - l) * scale * I;
+  (*pos) += bits;
+#endif
+
+  return v;
+}
+
+void
+decompress_qmatrix(pcqmatrix q, pamatrix a)
+{
+  size_t    pos;
+  int64_t   l;
+  uint      bits, i, j;
+
+  assert(a->rows == q->rows);
+  assert(a->cols == q->cols);
+
+  for (j = 0; j < q->cols; j++) {
+    bits = q->bits[j];
+
+    if (bits == 0) {
+      for (i = 0; i < q->rows; i++)
+	a->a[i + (size_t) j * a->ld] = 0.0;
+      continue;
+    }
+
+    l = levels(bits);
+    pos = q->off[j];
+    for (i = 0; i < q->rows; i++)
+      a->a[i + (size_t) j * a->ld] = decode(q, &pos, bits, l, q->scale[j]);
+  }
+}
+
+/* ------------------------------------------------------------
+ Operations with single columns
+ ------------------------------------------------------------ */
+
+field
+dotprod_column_qmatrix(pcqmatrix q, uint j, pcavector x)
+{
+  field     sum;
+  size_t    pos;
+  int64_t   l;
+  uint      bits = q->bits[j];
+  uint      i;
+
+  assert(j < q->cols);
+  assert(x->dim >= q->rows);
+
+  if (bits == 0)
+    return 0.0;
+
+  l = levels(bits);
+  pos = q->off[j];
+  sum = 0.0;
+  for (i = 0; i < q->rows; i++)
+    sum += CONJ(decode(q, &pos, bits, l, q->scale[j])) * x->v[i];
+
+  return sum;
+}
+
+void
+add_column_qmatrix(field alpha, pcqmatrix q, uint j, pavector y)
+{
+  size_t    pos;
+  int64_t   l;
+  uint      bits = q->bits[j];
+  uint      i;
+
+  assert(j < q->cols);
+  assert(y->dim >= q->rows);
+
+  if (bits == 0 || alpha == 0.0)
+    return;
+
+  l = levels(bits);
+  pos = q->off[j];
+  for (i = 0; i < q->rows; i++)
+    y->v[i] += alpha * decode(q, &pos, bits, l, q->scale[j]);
+}
+
+/* ------------------------------------------------------------
+ Matrix-vector multiplication
+ ------------------------------------------------------------ */
+
+void
+addeval_qmatrix_avector(field alpha, pcqmatrix q, pcavector x, pavector y)
+{
+  uint      j;
+
+  assert(x->dim >= q->cols);
+  assert(y->dim >= q->rows);
+
+  for (j = 0; j < q->cols; j++)
+    add_column_qmatrix(alpha * x->v[j], q, j, y);
+}
+
+void
+addevaltrans_qmatrix_avector(field alpha, pcqmatrix q, pcavector x,
+			     pavector y)
+{
+  uint      j;
+
+  assert(x->dim >= q->rows);
+  assert(y->dim >= q->cols);
+
+  for (j = 0; j < q->cols; j++)
+    y->v[j] += alpha * dotprod_column_qmatrix(q, j, x);
+}
@@ -0,0 +1,163 @@
+/* ------------------------------------------------------------
+ This is the file "qmatrix.h" of the H2Lib package.
+ All rights reserved, 2016
+ ------------------------------------------------------------ */
+
+/** @file qmatrix.h
+ */
+
+#ifndef QMATRIX_H
+#define QMATRIX_H
+
+/** @defgroup qmatrix qmatrix
+ *  @brief Lossy column-wise compressed storage of a matrix with
+ *  guaranteed accuracy.
+ *
+ *  Every column @f$a_j@f$ is scaled by the maximal absolute value
+ *  @f$s_j@f$ of its real components, and these components are rounded
+ *  to signed integers with @f$b_j@f$ bits that are packed into one
+ *  bit stream.
+ *  The number of bits is chosen for every column separately such that
+ *  the Euclidean norm of the error of the column is bounded by a
+ *  given tolerance @f$\tau_j@f$.
+ *  Columns with a norm below @f$\tau_j@f$ are not stored at all.
+ *
+ *  Matrix-vector products decode the columns on the fly, no
+ *  decompressed copy of the matrix is created.
+ *  @{ */
+
+/** @brief Lossy compressed representation of a matrix. */
+typedef struct _qmatrix qmatrix;
+
+/** @brief Pointer to @ref qmatrix object. */
+typedef qmatrix *pqmatrix;
+
+/** @brief Pointer to constant @ref qmatrix object. */
+typedef const qmatrix *pcqmatrix;
+
+#include <stdint.h>
+
+#include "amatrix.h"
+#include "avector.h"
+#include "settings.h"
+
+/** @brief Maximal number of bits per real component. */
+#define QMATRIX_MAXBITS 53
+
+/** @brief Lossy compressed representation of a matrix. */
+struct _qmatrix {
+  /** @brief Number of rows. */
+  uint rows;
+  /** @brief Number of columns. */
+  uint cols;
+
+  /** @brief Number of bits per real component for each column,
+   *  zero if the column is not stored. */
+  uint *bits;
+  /** @brief Scaling factor for each column, a stored integer
+   *  @f$q@f$ corresponds to <tt>q*scale[j]</tt>. */
+  real *scale;
+  /** @brief Position of the first bit of each column in
+   *  <tt>data</tt>. */
+  size_t *off;
+
+  /** @brief Packed bit stream. */
+  uint64_t *data;
+  /** @brief Number of words in <tt>data</tt>. */
+  size_t words;
+};
+
+/* ------------------------------------------------------------
+ Constructors and destructors
+ ------------------------------------------------------------ */
+
+/** @brief Create a compressed copy of a matrix.
+ *
+ *  @param a Source matrix.
+ *  @param tol Array of length <tt>a->cols</tt>, the Euclidean norm
+ *         of the error in column @f$j@f$ is bounded by <tt>tol[j]</tt>.
+ *  @returns New @ref qmatrix object. */
+HEADER_PREFIX pqmatrix
+new_qmatrix(pcamatrix a, const real * tol);
+
+/** @brief Delete a @ref qmatrix object.
+ *
+ *  @param q Object to be deleted. */
+HEADER_PREFIX void
+del_qmatrix(pqmatrix q);
+
+/* ------------------------------------------------------------
+ Statistics
+ ------------------------------------------------------------ */
+
+/** @brief Compute the size of a @ref qmatrix.
+ *
+ *  @param q Compressed matrix.
+ *  @returns Size of the object and its storage in bytes. */
+HEADER_PREFIX size_t
+getsize_qmatrix(pcqmatrix q);
+
+/* ------------------------------------------------------------
+ Decompression
+ ------------------------------------------------------------ */
+
+/** @brief Decompress a matrix.
+ *
+ *  @param q Compressed matrix.
+ *  @param a Target matrix, needs <tt>q->rows</tt> rows and
+ *         <tt>q->cols</tt> columns. */
+HEADER_PREFIX void
+decompress_qmatrix(pcqmatrix q, pamatrix a);
+
+/* ------------------------------------------------------------
+ Operations with single columns
+ ------------------------------------------------------------ */
+
+/** @brief Compute @f$\langle a_j, x\rangle = a_j^* x@f$ for
+ *  a column @f$a_j@f$ of a compressed matrix.
+ *
+ *  @param q Compressed matrix.
+ *  @param j Column index.
+ *  @param x Vector @f$x@f$.
+ *  @returns @f$a_j^* x@f$. */
+HEADER_PREFIX field
+dotprod_column_qmatrix(pcqmatrix q, uint j, pcavector x);
+
+/** @brief Add a column @f$a_j@f$ of a compressed matrix to a vector,
+ *  @f$y \gets y + \alpha a_j@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param q Compressed matrix.
+ *  @param j Column index.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+add_column_qmatrix(field alpha, pcqmatrix q, uint j, pavector y);
+
+/* ------------------------------------------------------------
+ Matrix-vector multiplication
+ ------------------------------------------------------------ */
+
+/** @brief Matrix-vector multiplication
+ *  @f$y \gets y + \alpha A x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param q Compressed matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addeval_qmatrix_avector(field alpha, pcqmatrix q, pcavector x, pavector y);
+
+/** @brief Adjoint matrix-vector multiplication
+ *  @f$y \gets y + \alpha A^* x@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param q Compressed matrix @f$A@f$.
+ *  @param x Source vector @f$x@f$.
+ *  @param y Target vector @f$y@f$. */
+HEADER_PREFIX void
+addevaltrans_qmatrix_avector(field alpha, pcqmatrix q, pcavector x,
+			     pavector y);
+
+/** @} */
+
+#endif
@@ -42,6 +42,23 @@ init_realavector(prealavector v, uint dim)
   return v;
 }
 
+prealavector
+init_scratch_realavector(prealavector v, uint dim)
+{
+  assert(v != NULL);
+
+  v->v = (real *) allocscratch(sizeof(real) * dim);
+  v->dim = dim;
+  v->owner = NULL;
+
+#ifdef USE_OPENMP
+#pragma omp atomic
+#endif
+  active_realavector++;
+
+  return v;
+}
+
 prealavector
 init_sub_realavector(prealavector v, prealavector src, uint dim, uint off)
 {
@@ -73,6 +73,21 @@ struct _realavector {
 HEADER_PREFIX prealavector
 init_realavector(prealavector v, uint dim);
 
+/** @brief Initialize an @ref realavector object for a temporary vector.
+ *
+ *  Like @ref init_realavector, but the coefficient array is taken from
+ *  the scratch stack of the calling thread, see @ref allocscratch.
+ *
+ *  @remark Should always be matched by a call to
+ *  @ref uninit_realavector in the same thread, preferably in reverse
+ *  order of initialization.
+ *
+ *  @param v Object to be initialized.
+ *  @param dim Dimension of the new vector.
+ *  @returns Initialized @ref realavector object. */
+HEADER_PREFIX prealavector
+init_scratch_realavector(prealavector v, uint dim);
+
 /** @brief Initialize an @ref realavector object to represent a subvector.
  *
  *  Sets up the components of the object and uses part of the storage
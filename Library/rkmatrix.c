@@ -17,6 +17,20 @@ init_rkmatrix(prkmatrix r, uint rows, uint cols, uint k)
   init_amatrix(&r->A, rows, k);
   init_amatrix(&r->B, cols, k);
   r->k = k;
+  r->CA = NULL;
+  r->CB = NULL;
+
+  return r;
+}
+
+prkmatrix
+init_scratch_rkmatrix(prkmatrix r, uint rows, uint cols, uint k)
+{
+  init_scratch_amatrix(&r->A, rows, k);
+  init_scratch_amatrix(&r->B, cols, k);
+  r->k = k;
+  r->CA = NULL;
+  r->CB = NULL;
 
   return r;
 }
@@ -28,9 +42,13 @@ init_sub_rkmatrix(prkmatrix r, pcrkmatrix src, uint rows, uint roff,
   prkmatrix wsrc = (prkmatrix) src;
   uint      k = src->k;
 
+  assert(src->CA == NULL);
+
   init_sub_amatrix(&r->A, &wsrc->A, rows, roff, k, 0);
   init_sub_amatrix(&r->B, &wsrc->B, cols, coff, k, 0);
   r->k = k;
+  r->CA = NULL;
+  r->CB = NULL;
 
   return r;
 }
@@ -38,6 +56,10 @@ init_sub_rkmatrix(prkmatrix r, pcrkmatrix src, uint rows, uint roff,
 void
 uninit_rkmatrix(prkmatrix r)
 {
+  if (r->CA) {
+    del_qmatrix(r->CB);
+    del_qmatrix(r->CA);
+  }
   uninit_amatrix(&r->B);
   uninit_amatrix(&r->A);
 }
@@ -77,6 +99,8 @@ del_rkmatrix(prkmatrix r)
 void
 setrank_rkmatrix(prkmatrix r, uint k)
 {
+  assert(r->CA == NULL);
+
   resize_amatrix(&r->A, r->A.rows, k);
   resize_amatrix(&r->B, r->B.rows, k);
   r->k = k;
@@ -85,6 +109,8 @@ setrank_rkmatrix(prkmatrix r, uint k)
 void
 resize_rkmatrix(prkmatrix r, uint rows, uint cols, uint k)
 {
+  assert(r->CA == NULL);
+
   resize_amatrix(&r->A, rows, k);
   resize_amatrix(&r->B, cols, k);
   r->k = k;
@@ -102,6 +128,10 @@ getsize_rkmatrix(pcrkmatrix r)
   sz = sizeof(rkmatrix);
   sz += getsize_heap_amatrix(&r->A);
   sz += getsize_heap_amatrix(&r->B);
+  if (r->CA) {
+    sz += getsize_qmatrix(r->CA);
+    sz += getsize_qmatrix(r->CB);
+  }
 
   return sz;
 }
@@ -113,6 +143,10 @@ getsize_heap_rkmatrix(pcrkmatrix r)
 
   sz = getsize_heap_amatrix(&r->A);
   sz += getsize_heap_amatrix(&r->B);
+  if (r->CA) {
+    sz += getsize_qmatrix(r->CA);
+    sz += getsize_qmatrix(r->CB);
+  }
 
   return sz;
 }
@@ -136,6 +170,8 @@ clone_rkmatrix(pcrkmatrix r)
 void
 copy_rkmatrix(bool atrans, pcrkmatrix a, prkmatrix b)
 {
+  assert(a->CA == NULL);
+
   if (atrans) {
     assert(a->A.rows == b->B.rows);
     assert(a->B.rows == b->A.rows);
@@ -158,6 +194,28 @@ copy_rkmatrix(bool atrans, pcrkmatrix a, prkmatrix b)
   }
 }
 
+/* ------------------------------------------------------------
+ Lossy compression
+ ------------------------------------------------------------ */
+
+void
+decompress_rkmatrix(prkmatrix r)
+{
+  if (r->CA == NULL)
+    return;
+
+  resize_amatrix(&r->A, r->A.rows, r->k);
+  resize_amatrix(&r->B, r->B.rows, r->k);
+
+  decompress_qmatrix(r->CA, &r->A);
+  decompress_qmatrix(r->CB, &r->B);
+
+  del_qmatrix(r->CB);
+  del_qmatrix(r->CA);
+  r->CA = NULL;
+  r->CB = NULL;
+}
+
 /* ------------------------------------------------------------
  Matrix-vector multiplication
  ------------------------------------------------------------ */
@@ -172,6 +230,16 @@ addeval_rkmatrix_avector(field alpha, pcrkmatrix r, pcavector x, pavector y)
 
   assert(y->dim == r->A.rows);
   assert(x->dim == r->B.rows);
+
+  if (r->CA) {
+    /* Decompression fused with the products */
+    for (nu = 0; nu < r->k; nu++) {
+      beta = dotprod_column_qmatrix(r->CB, nu, x);
+      add_column_qmatrix(alpha * beta, r->CA, nu, y);
+    }
+    return;
+  }
+
   assert(r->k <= r->A.cols);
   assert(r->k <= r->B.cols);
 
@@ -198,6 +266,16 @@ addevaltrans_rkmatrix_avector(field alpha, pcrkmatrix r, pcavector x,
 
   assert(x->dim == r->A.rows);
   assert(y->dim == r->B.rows);
+
+  if (r->CA) {
+    /* Decompression fused with the products */
+    for (nu = 0; nu < r->k; nu++) {
+      beta = dotprod_column_qmatrix(r->CA, nu, x);
+      add_column_qmatrix(alpha * beta, r->CB, nu, y);
+    }
+    return;
+  }
+
   assert(r->k <= r->A.cols);
   assert(r->k <= r->B.cols);
 
@@ -28,6 +28,7 @@ typedef rkmatrix *prkmatrix;
 typedef const rkmatrix *pcrkmatrix;
 
 #include "amatrix.h"
+#include "qmatrix.h"
 #include "settings.h"
 
 /** @brief Representation of a low-rank matrix in factorized form
@@ -40,6 +41,13 @@ struct _rkmatrix {
 
   /** Maximal rank, i.e., number of columns of @f$A@f$ and @f$B@f$. */
   uint k;
+
+  /** Compressed row factor, see @ref compress_rkmatrix. If set,
+   *  <tt>A</tt> and <tt>B</tt> have no columns and the matrix can only
+   *  be multiplied by vectors until @ref decompress_rkmatrix is called. */
+  pqmatrix CA;
+  /** Compressed column factor, set together with <tt>CA</tt>. */
+  pqmatrix CB;
 };
 
 /* ------------------------------------------------------------
@@ -61,6 +69,23 @@ struct _rkmatrix {
 HEADER_PREFIX prkmatrix
 init_rkmatrix(prkmatrix r, uint rows, uint cols, uint k);
 
+/** @brief Initialize an @ref rkmatrix object for a temporary matrix.
+ *
+ *  Like @ref init_rkmatrix, but the storage for @f$A@f$ and @f$B@f$
+ *  is taken from the scratch stack of the calling thread, see
+ *  @ref allocscratch.
+ *
+ *  @remark Should always be matched by a call to @ref uninit_rkmatrix
+ *  in the same thread.
+ *
+ *  @param r Object to be initialized.
+ *  @param rows Number of rows.
+ *  @param cols Number of columns.
+ *  @param k Rank.
+ *  @returns Initialized @ref rkmatrix object. */
+HEADER_PREFIX prkmatrix
+init_scratch_rkmatrix(prkmatrix r, uint rows, uint cols, uint k);
+
 /** @brief Initialize an @ref rkmatrix object to represent a submatrix.
  *
  *  Sets up the components of the object and uses part of the storage
@@ -267,6 +292,19 @@ clone_rkmatrix(pcrkmatrix r);
 HEADER_PREFIX void
 copy_rkmatrix(bool atrans, pcrkmatrix a, prkmatrix b);
 
+/* ------------------------------------------------------------
+ Lossy compression
+ ------------------------------------------------------------ */
+
+/** @brief Restore the factors @f$A@f$ and @f$B@f$ of an @ref rkmatrix
+ *  compressed by @ref compress_rkmatrix.
+ *
+ *  Does nothing if the matrix is not compressed.
+ *
+ *  @param r Target matrix. */
+HEADER_PREFIX void
+decompress_rkmatrix(prkmatrix r);
+
 /* ------------------------------------------------------------
  Matrix-vector multiplication
  ------------------------------------------------------------ */
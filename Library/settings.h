@@ -140,6 +140,22 @@ typedef field *pfield;
 /** @brief Pointer to constant @ref field array. */
 typedef const field *pcfield;
 
+/** @brief Single precision field type.
+ *
+ *  This type is used to store coefficients in single precision
+ *  if @ref field uses double precision, e.g., in @ref flathmatrix. */
+#ifdef USE_COMPLEX
+typedef float _Complex sfield;
+#else
+typedef float sfield;
+#endif
+
+/** @brief Pointer to @ref sfield array. */
+typedef sfield *psfield;
+
+/** @brief Pointer to constant @ref sfield array. */
+typedef const sfield *pcsfield;
+
 /** @brief @ref field constant zero */
 extern const field f_zero;
 
@@ -361,6 +361,21 @@ build_singquad2d(pcsurface3d gr, uint q, uint q2)
 
   sq->q2 = q2;
 
+  sq->pair_rows = 0;
+  sq->pair_ptr = NULL;
+  sq->pair_col = NULL;
+  sq->pair_info = NULL;
+
+  sq->adapt_qmin = 0;
+  sq->adapt_off = NULL;
+  sq->x_adapt = NULL;
+  sq->y_adapt = NULL;
+  sq->w_adapt = NULL;
+  sq->adapt_ratio = NULL;
+  sq->adapt_triangles = 0;
+  sq->adapt_center = NULL;
+  sq->adapt_radius = NULL;
+
   sq->n_id = 6 * nq2;
   sq->x_id = (real *) allocmem((size_t) 2 * sq->n_id * sizeof(real));
   sq->y_id = (real *) allocmem((size_t) 2 * sq->n_id * sizeof(real));
@@ -403,7 +418,7 @@ build_singquad2d(pcsurface3d gr, uint q, uint q2)
 
   build_triangle_singquad2d(sq, x, w);
 
-  sq->nmax = 6 * nq2;
+  sq->nmax = UINT_MAX(6 * nq2, nq);
 
 
 #ifdef USE_TRIQUADPOINTS
@@ -456,6 +471,9 @@ del_singquad2d(psingquad2d sq)
   if (sq->y_single != NULL)
     freemem(sq->y_single);
 
+  del_pairs_singquad2d(sq);
+  del_adaptive_singquad2d(sq);
+
 #ifdef USE_TRIQUADPOINTS
   if (sq->tri_x != NULL) {
     freemem(sq->tri_x);
@@ -545,22 +563,10 @@ fast_select_quadrature(uint(*geo_t)[3], uint t, uint s)
   return p;
 }
 
-uint
-select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
-			     const uint * sv, uint * tp, uint * sp, real ** x,
-			     real ** y, real ** w, uint * n, field * base)
+static void
+get_rule_singquad2d(pcsingquad2d sq, uint p, real ** x, real ** y,
+		    real ** w, uint * n, field * base)
 {
-
-  uint      p, q, i, j;
-
-  p =
-    (tv[0] == sv[0]) + (tv[0] == sv[1]) + (tv[0] == sv[2]) + (tv[1] == sv[0])
-    + (tv[1] == sv[1]) + (tv[1] == sv[2]) + (tv[2] == sv[0])
-    + (tv[2] == sv[1]) + (tv[2] == sv[2]);
-
-  tp[0] = 0, tp[1] = 1, tp[2] = 2;
-  sp[0] = 0, sp[1] = 1, sp[2] = 2;
-
   switch (p) {
   case 0:			/* DISTANT */
     *x = sq->x_dist;
@@ -568,7 +574,6 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
     *w = sq->w_dist;
     *n = sq->n_dist;
     *base = sq->base_dist;
-    return p;
     break;
   case 1:			/* VERTEX */
     *x = sq->x_vert;
@@ -590,13 +595,35 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
     *w = sq->w_id;
     *n = sq->n_id;
     *base = sq->base_id;
-    return p;
     break;
   default:
     printf("ERROR: Unknown quadrature situation!\n");
     abort();
     break;
   }
+}
+
+uint
+select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
+			     const uint * sv, uint * tp, uint * sp, real ** x,
+			     real ** y, real ** w, uint * n, field * base)
+{
+
+  uint      p, q, i, j;
+
+  p =
+    (tv[0] == sv[0]) + (tv[0] == sv[1]) + (tv[0] == sv[2]) + (tv[1] == sv[0])
+    + (tv[1] == sv[1]) + (tv[1] == sv[2]) + (tv[2] == sv[0])
+    + (tv[2] == sv[1]) + (tv[2] == sv[2]);
+
+  tp[0] = 0, tp[1] = 1, tp[2] = 2;
+  sp[0] = 0, sp[1] = 1, sp[2] = 2;
+
+  get_rule_singquad2d(sq, p, x, y, w, n, base);
+
+  if (p == 0 || p == 3) {
+    return p;
+  }
 
   p = 0;
   for (i = 0; i < 3; ++i) {
@@ -631,3 +658,250 @@ select_quadrature_singquad2d(pcsingquad2d sq, const uint * tv,
   return p;
 
 }
+
+void
+setup_pairs_singquad2d(psingquad2d sq, const uint(*t)[3], uint rows,
+		       uint * ptr, uint * col)
+{
+  uint      tp[3], sp[3];
+  real     *x, *y, *w;
+  field     base;
+  uint      i, k, n, p;
+
+  del_pairs_singquad2d(sq);
+
+  sq->pair_rows = rows;
+  sq->pair_ptr = ptr;
+  sq->pair_col = col;
+  sq->pair_info = allocuint(ptr[rows]);
+
+  for (i = 0; i < rows; ++i) {
+    for (k = ptr[i]; k < ptr[i + 1]; ++k) {
+      assert(k == ptr[i] || col[k - 1] < col[k]);
+
+      p = select_quadrature_singquad2d(sq, t[i], t[col[k]], tp, sp, &x, &y,
+				       &w, &n, &base);
+
+      sq->pair_info[k] = p + (tp[0] << 2) + (tp[1] << 4) + (tp[2] << 6)
+	+ (sp[0] << 8) + (sp[1] << 10) + (sp[2] << 12);
+    }
+  }
+}
+
+void
+del_pairs_singquad2d(psingquad2d sq)
+{
+  if (sq->pair_ptr != NULL) {
+    freemem(sq->pair_ptr);
+    freemem(sq->pair_col);
+    freemem(sq->pair_info);
+  }
+
+  sq->pair_rows = 0;
+  sq->pair_ptr = NULL;
+  sq->pair_col = NULL;
+  sq->pair_info = NULL;
+}
+
+uint
+lookup_quadrature_singquad2d(pcsingquad2d sq, uint t, uint s,
+			     const uint * tv, const uint * sv, uint * tp,
+			     uint * sp, real ** x, real ** y, real ** w,
+			     uint * n, field * base)
+{
+  const uint *col;
+  uint      info, p, i, lo, hi, mid;
+
+  if (t < sq->pair_rows) {
+    col = sq->pair_col;
+
+    /* Binary search for s in the row t */
+    lo = sq->pair_ptr[t];
+    hi = sq->pair_ptr[t + 1];
+    while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      if (col[mid] < s) {
+	lo = mid + 1;
+      }
+      else {
+	hi = mid;
+      }
+    }
+
+    if (lo < sq->pair_ptr[t + 1] && col[lo] == s) {
+      info = sq->pair_info[lo];
+
+      p = info & 3;
+      for (i = 0; i < 3; ++i) {
+	tp[i] = (info >> (2 + 2 * i)) & 3;
+	sp[i] = (info >> (8 + 2 * i)) & 3;
+      }
+
+      get_rule_singquad2d(sq, p, x, y, w, n, base);
+
+      return p;
+    }
+  }
+
+  return select_quadrature_singquad2d(sq, tv, sv, tp, sp, x, y, w, n, base);
+}
+
+/* ------------------------------------------------------------
+ Distance-adaptive regular quadrature
+ ------------------------------------------------------------ */
+
+void
+setup_adaptive_singquad2d(psingquad2d sq, pcsurface3d gr, uint qmin)
+{
+  const     real(*gr_x)[3] = (const real(*)[3]) gr->x;
+  const     uint(*gr_t)[3] = (const uint(*)[3]) gr->t;
+  uint      q = sq->q;
+  real     *x, *w, *xx, *yy, *ww, *c;
+  real      r, d;
+  uint      i, j, k, l, o, p, nq;
+
+  assert(1 <= qmin && qmin <= q);
+
+  del_adaptive_singquad2d(sq);
+
+  sq->adapt_qmin = qmin;
+
+  /* Tensor Gauss rules for all orders up to q */
+  sq->adapt_off = allocuint(q + 2);
+  sq->adapt_off[0] = sq->adapt_off[1] = 0;
+  for (o = 1; o <= q; ++o) {
+    sq->adapt_off[o + 1] = sq->adapt_off[o] + o * o * o * o;
+  }
+  nq = sq->adapt_off[q + 1];
+  sq->x_adapt = allocreal(2 * nq);
+  sq->y_adapt = allocreal(2 * nq);
+  sq->w_adapt = allocreal(10 * nq);
+
+  x = allocreal(q);
+  w = allocreal(q);
+
+  for (o = 1; o <= q; ++o) {
+    assemble_gauss(o, x, w);
+    for (i = 0; i < o; ++i) {
+      x[i] = 0.5 + 0.5 * x[i];
+      w[i] = w[i] * 0.5;
+    }
+
+    nq = o * o * o * o;
+    xx = sq->x_adapt + 2 * sq->adapt_off[o];
+    yy = sq->y_adapt + 2 * sq->adapt_off[o];
+    ww = sq->w_adapt + 10 * sq->adapt_off[o];
+    for (p = 0; p < 10 * nq; ++p) {
+      ww[p] = 0.0;
+    }
+    ww += 9 * nq;
+
+    p = 0;
+    for (i = 0; i < o; ++i) {
+      for (j = 0; j < o; ++j) {
+	for (k = 0; k < o; ++k) {
+	  for (l = 0; l < o; ++l) {
+	    ww[p] = w[i] * w[j] * w[k] * w[l] * x[i] * x[k];
+	    xx[p] = x[i];
+	    xx[p + nq] = x[i] * x[j];
+	    yy[p] = x[k];
+	    yy[p + nq] = x[k] * x[l];
+	    p++;
+	  }
+	}
+      }
+    }
+    assert(p == nq);
+  }
+
+  freemem(w);
+  freemem(x);
+
+  /* Order o is sufficient if (5 (1 + ratio))^(2o) >= 100 * 5^(2q) */
+  sq->adapt_ratio = allocreal(q + 1);
+  sq->adapt_ratio[0] = 0.0;
+  for (o = 1; o <= q; ++o) {
+    sq->adapt_ratio[o] = REAL_POW(10.0, 1.0 / o)
+      * REAL_POW(5.0, (real) q / o - 1.0) - 1.0;
+  }
+
+  /* Centers and radii of all triangles */
+  sq->adapt_triangles = gr->triangles;
+  sq->adapt_center = allocreal(3 * gr->triangles);
+  sq->adapt_radius = allocreal(gr->triangles);
+  for (i = 0; i < gr->triangles; ++i) {
+    c = sq->adapt_center + 3 * i;
+    for (k = 0; k < 3; ++k) {
+      c[k] = (gr_x[gr_t[i][0]][k] + gr_x[gr_t[i][1]][k]
+	      + gr_x[gr_t[i][2]][k]) / 3.0;
+    }
+
+    r = 0.0;
+    for (j = 0; j < 3; ++j) {
+      d = REAL_NORMSQR3(gr_x[gr_t[i][j]][0] - c[0],
+			gr_x[gr_t[i][j]][1] - c[1],
+			gr_x[gr_t[i][j]][2] - c[2]);
+      r = REAL_MAX(r, d);
+    }
+    sq->adapt_radius[i] = REAL_SQRT(r);
+  }
+}
+
+void
+del_adaptive_singquad2d(psingquad2d sq)
+{
+  if (sq->adapt_off != NULL) {
+    freemem(sq->adapt_off);
+    freemem(sq->x_adapt);
+    freemem(sq->y_adapt);
+    freemem(sq->w_adapt);
+    freemem(sq->adapt_ratio);
+    freemem(sq->adapt_center);
+    freemem(sq->adapt_radius);
+  }
+
+  sq->adapt_qmin = 0;
+  sq->adapt_off = NULL;
+  sq->x_adapt = NULL;
+  sq->y_adapt = NULL;
+  sq->w_adapt = NULL;
+  sq->adapt_ratio = NULL;
+  sq->adapt_triangles = 0;
+  sq->adapt_center = NULL;
+  sq->adapt_radius = NULL;
+}
+
+uint
+select_adaptive_singquad2d(pcsingquad2d sq, uint t, uint s, real ** x,
+			   real ** y, real ** w, uint * n, field * base)
+{
+  const real *ct, *cs;
+  real      h, delta, ratio;
+  uint      o;
+
+  assert(sq->adapt_qmin > 0);
+  assert(t < sq->adapt_triangles && s < sq->adapt_triangles);
+
+  ct = sq->adapt_center + 3 * t;
+  cs = sq->adapt_center + 3 * s;
+  h = 2.0 * REAL_MAX(sq->adapt_radius[t], sq->adapt_radius[s]);
+  delta = REAL_NORM3(ct[0] - cs[0], ct[1] - cs[1], ct[2] - cs[2])
+    - sq->adapt_radius[t] - sq->adapt_radius[s];
+
+  o = sq->q;
+  if (delta > h) {
+    ratio = delta / h;
+    o = sq->adapt_qmin;
+    while (o < sq->q && ratio < sq->adapt_ratio[o]) {
+      o++;
+    }
+  }
+
+  *x = sq->x_adapt + 2 * sq->adapt_off[o];
+  *y = sq->y_adapt + 2 * sq->adapt_off[o];
+  *w = sq->w_adapt + 10 * sq->adapt_off[o];
+  *n = sq->adapt_off[o + 1] - sq->adapt_off[o];
+  *base = 0.0;
+
+  return o;
+}
@@ -138,6 +138,78 @@ struct _singquad2d {
   uint q2;
   /** @brief maximal number of quadrature points.*/
   uint nmax;
+
+  /**
+   * @brief Number of triangles covered by the near-field pair table, zero if
+   * no table has been set up.
+   *
+   * \see setup_pairs_singquad2d.
+   */
+  uint pair_rows;
+  /**
+   * @brief Offsets of the rows of the near-field pair table, the pairs
+   * belonging to the triangle @f$t@f$ are stored at the positions
+   * <tt>pair_ptr[t], ..., pair_ptr[t+1]-1</tt>.
+   */
+  uint *pair_ptr;
+  /**
+   * @brief Second triangles of all near-field pairs, sorted in increasing
+   * order within every row.
+   */
+  uint *pair_col;
+  /**
+   * @brief Quadrature case and vertex permutations of all near-field pairs.
+   *
+   * Bits 0-1 contain the number of common vertices, bits 2-7 the
+   * permutation <tt>tp</tt> and bits 8-13 the permutation <tt>sp</tt>
+   * as returned by @ref select_quadrature_singquad2d.
+   */
+  uint *pair_info;
+
+  /**
+   * @brief Minimal order of the distance-adaptive regular quadrature, zero
+   * if the adaptive mode is switched off.
+   *
+   * \see setup_adaptive_singquad2d.
+   */
+  uint adapt_qmin;
+  /**
+   * @brief Offsets of the cached regular rules, the rule of order
+   * @f$o \in \{1,\ldots,q\}@f$ consists of the points
+   * <tt>adapt_off[o], ..., adapt_off[o+1]-1</tt>.
+   */
+  uint *adapt_off;
+  /**
+   * @brief Quadrature points of the cached regular rules for the first
+   * triangle, the rule of order @f$o@f$ starts at
+   * <tt>x_adapt + 2 * adapt_off[o]</tt>.
+   */
+  real *x_adapt;
+  /**
+   * @brief Quadrature points of the cached regular rules for the second
+   * triangle, the rule of order @f$o@f$ starts at
+   * <tt>y_adapt + 2 * adapt_off[o]</tt>.
+   */
+  real *y_adapt;
+  /**
+   * @brief Quadrature weights of the cached regular rules, the rule of order
+   * @f$o@f$ starts at <tt>w_adapt + 10 * adapt_off[o]</tt>.
+   */
+  real *w_adapt;
+  /**
+   * @brief Minimal ratio of distance and diameter for which the rule of
+   * order @f$o@f$ is used, stored in <tt>adapt_ratio[o]</tt>.
+   */
+  real *adapt_ratio;
+  /** @brief Number of triangles covered by <tt>adapt_center</tt>.*/
+  uint adapt_triangles;
+  /** @brief Centers of the triangles.*/
+  real *adapt_center;
+  /**
+   * @brief Radii of the triangles, i.e. the maximal distance of a vertex to
+   * the center.
+   */
+  real *adapt_radius;
 };
 
 /**
@@ -281,6 +353,133 @@ HEADER_PREFIX uint
 select_quadrature_singquad2d(pcsingquad2d sq, const uint *tv, const uint *sv,
     uint *tp, uint *sp, real **x, real **y, real **w, uint *n, field *base);
 
+/* ------------------------------------------------------------
+ Near-field pair table
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Set up a table containing the quadrature case and the vertex
+ * permutations for a fixed set of pairs of triangles.
+ *
+ * The pairs are given in compressed row format, i.e. triangle @f$t@f$ is
+ * paired with the triangles <tt>col[ptr[t]], ..., col[ptr[t+1]-1]</tt>,
+ * which have to be sorted in increasing order. Afterwards
+ * @ref lookup_quadrature_singquad2d will simply look up these pairs instead
+ * of classifying them again. An existing table will be replaced.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object.
+ * @param t Array of all triangles in the geometry.
+ * @param rows Number of rows of the table, usually the number of triangles.
+ * @param ptr Row offsets, an array of length <tt>rows+1</tt>. The table
+ *        takes over the ownership of this array.
+ * @param col Column indices, an array of length <tt>ptr[rows]</tt>. The table
+ *        takes over the ownership of this array.
+ */
+HEADER_PREFIX void
+setup_pairs_singquad2d(psingquad2d sq, const uint (*t)[3], uint rows,
+    uint *ptr, uint *col);
+
+/**
+ * @brief Delete the near-field pair table of a
+ * @ref _singquad2d "singquad2d" object, if there is one.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object.
+ */
+HEADER_PREFIX void
+del_pairs_singquad2d(psingquad2d sq);
+
+/**
+ * @brief Select the quadrature rule for a pair of triangles using the
+ * near-field pair table.
+ *
+ * If the pair @f$(t,s)@f$ is contained in the table set up by
+ * @ref setup_pairs_singquad2d, the quadrature case and the permutations are
+ * taken from the table. Otherwise this function falls back to
+ * @ref select_quadrature_singquad2d.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object containing all necessary
+ * quadrature rules.
+ * @param t Index of the triangle @f$ t @f$.
+ * @param s Index of the triangle @f$ s @f$.
+ * @param tv An array defining the 3 vertices of triangle @f$ t @f$.
+ * @param sv An array defining the 3 vertices of triangle @f$ s @f$.
+ * @param tp Returning a permutation array of the vertices for @f$ t @f$.
+ * @param sp Returning a permutation array of the vertices for @f$ s @f$.
+ * @param x Returning the quadrature points for the triangle @f$ t @f$.
+ * @param y Returning the quadrature points for the triangle @f$ s @f$.
+ * @param w Returning the quadrature weights.
+ * @param n Returning the total number of quadrature points.
+ * @param base Returning a constant offset.
+ * @return Returns the number of common vertices for triangle @f$ t @f$ and
+ * @f$ s @f$, which defines the current quadrature case.
+ */
+HEADER_PREFIX uint
+lookup_quadrature_singquad2d(pcsingquad2d sq, uint t, uint s, const uint *tv,
+    const uint *sv, uint *tp, uint *sp, real **x, real **y, real **w, uint *n,
+    field *base);
+
+/* ------------------------------------------------------------
+ Distance-adaptive regular quadrature
+ ------------------------------------------------------------ */
+
+/**
+ * @brief Set up the distance-adaptive quadrature for disjoint pairs of
+ * triangles.
+ *
+ * The tensor Gauss rules of all orders
+ * @f$o \in \{1,\ldots,q\}@f$ are built once and cached in
+ * <tt>sq</tt>, only the last column of the weights is filled, i.e. the
+ * rules still have to be weighted by @ref weight_basisfunc_ll_singquad2d or
+ * @ref weight_basisfunc_cl_singquad2d if linear basis functions are used.
+ *
+ * For a pair of triangles with distance @f$\delta@f$ and diameter
+ * @f$h@f$, the relative quadrature error of the order @f$o@f$ behaves
+ * like @f$(5(1+\delta/h))^{-2o}@f$, this rate has been observed for the
+ * Laplace and low-frequency Helmholtz kernels. The rule of order @f$q@f$
+ * is used for @f$\delta \leq h@f$, all other pairs use the smallest
+ * order @f$o \geq q_{\min}@f$ whose estimated error is a hundred times
+ * smaller than the error of order @f$q@f$ for touching triangles, i.e.
+ * @f$(5(1+\delta/h))^{2o} \geq 100 \cdot 5^{2q}@f$. The safety factor
+ * covers the larger constants observed for low orders.
+ *
+ * @remark The estimate does not take oscillations into account, for
+ * high wavenumbers <tt>qmin</tt> has to be large enough to resolve them.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object.
+ * @param gr Currently used geometry.
+ * @param qmin Minimal order, has to be between 1 and <tt>sq->q</tt>.
+ */
+HEADER_PREFIX void
+setup_adaptive_singquad2d(psingquad2d sq, pcsurface3d gr, uint qmin);
+
+/**
+ * @brief Switch off the distance-adaptive quadrature of a
+ * @ref _singquad2d "singquad2d" object and release the cached rules.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object.
+ */
+HEADER_PREFIX void
+del_adaptive_singquad2d(psingquad2d sq);
+
+/**
+ * @brief Select the regular quadrature rule for a disjoint pair of
+ * triangles using the distance-adaptive mode.
+ *
+ * @param sq A @ref _singquad2d "singquad2d" object prepared by
+ * @ref setup_adaptive_singquad2d.
+ * @param t Index of the triangle @f$ t @f$.
+ * @param s Index of the triangle @f$ s @f$.
+ * @param x Returning the quadrature points for the triangle @f$ t @f$.
+ * @param y Returning the quadrature points for the triangle @f$ s @f$.
+ * @param w Returning the quadrature weights.
+ * @param n Returning the total number of quadrature points.
+ * @param base Returning a constant offset.
+ * @return Returns the order of the selected rule.
+ */
+HEADER_PREFIX uint
+select_adaptive_singquad2d(pcsingquad2d sq, uint t, uint s, real **x,
+    real **y, real **w, uint *n, field *base);
+
 /** @} */
 
 #endif /* SINGQUAD2D_H_ */
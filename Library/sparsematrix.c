@@ -358,6 +358,83 @@ mvm_sparsematrix_avector(field alpha, bool trans, pcsparsematrix a,
     addeval_sparsematrix_avector(alpha, a, x, y);
 }
 
+void
+addeval_sparsematrix_amatrix(field alpha, pcsparsematrix a, pcamatrix X,
+			     pamatrix Y)
+{
+  const uint *row = a->row;
+  const uint *col = a->col;
+  pcfield   coeff = a->coeff;
+  uint      rows = a->rows;
+  uint      cols = X->cols;
+  uint      ldx = X->ld;
+  uint      ldy = Y->ld;
+  pcfield   xv;
+  pfield    sum;
+  field     val;
+  uint      i, j, k;
+
+  assert(a->rows == Y->rows);
+  assert(a->cols == X->rows);
+  assert(X->cols == Y->cols);
+
+  sum = allocfield(cols);
+
+  /* Every non-zero entry is loaded once and applied to all columns */
+  for (i = 0; i < rows; i++) {
+    for (k = 0; k < cols; k++)
+      sum[k] = 0.0;
+
+    for (j = row[i]; j < row[i + 1]; j++) {
+      val = coeff[j];
+      xv = X->a + col[j];
+      for (k = 0; k < cols; k++)
+	sum[k] += val * xv[k * ldx];
+    }
+
+    for (k = 0; k < cols; k++)
+      Y->a[i + k * ldy] += alpha * sum[k];
+  }
+
+  freemem(sum);
+}
+
+void
+addevaltrans_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+				  pcamatrix X, pamatrix Y)
+{
+  const uint *row = a->row;
+  const uint *col = a->col;
+  pcfield   coeff = a->coeff;
+  uint      rows = a->rows;
+  uint      cols = X->cols;
+  uint      ldx = X->ld;
+  uint      ldy = Y->ld;
+  pfield    xs, yv;
+  field     val;
+  uint      i, j, k;
+
+  assert(a->rows == X->rows);
+  assert(a->cols == Y->rows);
+  assert(X->cols == Y->cols);
+
+  xs = allocfield(cols);
+
+  for (i = 0; i < rows; i++) {
+    for (k = 0; k < cols; k++)
+      xs[k] = alpha * X->a[i + k * ldx];
+
+    for (j = row[i]; j < row[i + 1]; j++) {
+      val = CONJ(coeff[j]);
+      yv = Y->a + col[j];
+      for (k = 0; k < cols; k++)
+	yv[k * ldy] += val * xs[k];
+    }
+  }
+
+  freemem(xs);
+}
+
 real
 norm2_sparsematrix(pcsparsematrix a)
 {
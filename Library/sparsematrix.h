@@ -221,6 +221,31 @@ HEADER_PREFIX void
 mvm_sparsematrix_avector(field alpha, bool trans, pcsparsematrix a,
 		 pcavector x, pavector y);
 
+/** @brief Multiply a matrix @f$A@f$ by a block of vectors,
+ *  @f$Y \gets Y + \alpha A X@f$.
+ *
+ *  Every non-zero coefficient is applied to all columns of @f$X@f$
+ *  before the next one is loaded.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param a Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addeval_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+			     pcamatrix X, pamatrix Y);
+
+/** @brief Multiply the adjoint of a matrix @f$A@f$ by a block of vectors,
+ *  @f$Y \gets Y + \alpha A^* X@f$.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param a Matrix @f$A@f$.
+ *  @param X Source matrix @f$X@f$.
+ *  @param Y Target matrix @f$Y@f$. */
+HEADER_PREFIX void
+addevaltrans_sparsematrix_amatrix(field alpha, pcsparsematrix a,
+				  pcamatrix X, pamatrix Y);
+
 /** @brief Approximate the spectral norm @f$\|A\|_2@f$ of a matrix @f$A@f$.
  *
  *  The spectral norm is approximated by applying a few steps of the power
@@ -22,6 +22,7 @@ new_truncmode()
   tm->blocks = false;
   tm->zeta_level = 1.0;
   tm->zeta_age = 1.0;
+  tm->randomized = false;
 
   return tm;
 }
@@ -52,6 +52,9 @@ struct _truncmode {
   real zeta_level;
   /** @brief Block-age-dependent tolerance factor */
   real zeta_age;
+  /** @brief If set to <tt>true</tt> high-rank truncations use a randomized
+   *  range finder instead of a full SVD. */
+  bool randomized;
 };
 
 /* ------------------------------------------------------------
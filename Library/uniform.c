@@ -27,6 +27,7 @@ new_uniform(pclusterbasis rb, pclusterbasis cb)
   ref_col_uniform(u, cb);
 
   init_amatrix(&u->S, rb->k, cb->k);
+  u->CS = NULL;
 
   return u;
 }
@@ -36,6 +37,8 @@ del_uniform(puniform u)
 {
   assert(u != 0);
 
+  if (u->CS)
+    del_qmatrix(u->CS);
   uninit_amatrix(&u->S);
 
   unref_row_uniform(u);
@@ -147,6 +150,8 @@ getsize_uniform(pcuniform u)
 
   sz = sizeof(uniform);
   sz += getsize_heap_amatrix(&u->S);
+  if (u->CS)
+    sz += getsize_qmatrix(u->CS);
 
   return sz;
 }
@@ -158,6 +163,12 @@ getsize_uniform(pcuniform u)
 void
 clear_uniform(puniform u)
 {
+  if (u->CS) {
+    resize_amatrix(&u->S, u->S.rows, u->CS->cols);
+    del_qmatrix(u->CS);
+    u->CS = NULL;
+  }
+
   clear_amatrix(&u->S);
 }
 
@@ -270,7 +281,7 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
 
     clear_avector(yt);
 
-    mvm_amatrix_avector(alpha, true, &u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, true, u, xt, yt);
 
     expand_clusterbasis_avector(u->cb, yt, y);
 
@@ -285,7 +296,7 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
 
     clear_avector(yt);
 
-    mvm_amatrix_avector(alpha, false, &u->S, xt, yt);
+    mvm_coupling_uniform_avector(alpha, false, u, xt, yt);
 
     expand_clusterbasis_avector(u->rb, yt, y);
 
@@ -294,6 +305,67 @@ mvm_uniform_avector(field alpha, bool trans, pcuniform u,
   }
 }
 
+void
+mvm_coupling_uniform_avector(field alpha, bool trans, pcuniform u,
+			     pcavector xt, pavector yt)
+{
+  if (u->CS) {
+    if (trans)
+      addevaltrans_qmatrix_avector(alpha, u->CS, xt, yt);
+    else
+      addeval_qmatrix_avector(alpha, u->CS, xt, yt);
+  }
+  else
+    mvm_amatrix_avector(alpha, trans, &u->S, xt, yt);
+}
+
+/* ------------------------------------------------------------
+   Lossy compression
+   ------------------------------------------------------------ */
+
+void
+compress_uniform(pctruncmode tm, real eps, puniform u)
+{
+  real     *tol;
+  real      rho;
+  uint      cols = u->S.cols;
+  uint      j;
+
+  assert(u->CS == NULL);
+
+  /* Reference norm matching the truncation mode */
+  if (tm && tm->absolute)
+    rho = 1.0;
+  else if (tm && tm->frobenius)
+    rho = normfrob_amatrix(&u->S);
+  else
+    rho = norm2_amatrix(&u->S);
+
+  /* Every column contributes at most (eps rho)^2 / cols to the squared
+   * Frobenius norm of the error */
+  tol = allocreal(cols);
+  for (j = 0; j < cols; j++)
+    tol[j] = eps * rho / REAL_SQRT((real) cols);
+
+  u->CS = new_qmatrix(&u->S, tol);
+  resize_amatrix(&u->S, u->S.rows, 0);
+
+  freemem(tol);
+}
+
+void
+decompress_uniform(puniform u)
+{
+  if (u->CS == NULL)
+    return;
+
+  resize_amatrix(&u->S, u->S.rows, u->CS->cols);
+  decompress_qmatrix(u->CS, &u->S);
+
+  del_qmatrix(u->CS);
+  u->CS = NULL;
+}
+
 /* ------------------------------------------------------------
    Conversion operations
    ------------------------------------------------------------ */
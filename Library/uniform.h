@@ -43,7 +43,9 @@ typedef const uniform *pcuniform;
 #include "clusterbasis.h"
 #include "clusteroperator.h"
 #include "rkmatrix.h"
+#include "qmatrix.h"
 /* CORE 3 */
+#include "truncation.h"
 /* SIMPLE */
 /* PARTICLES */
 /* BEM */
@@ -72,6 +74,10 @@ struct _uniform {
   pclusterbasis cb;
   /** @brief Coupling matrix */
   amatrix S;
+  /** @brief Compressed coupling matrix, see @ref compress_uniform.
+   *  If set, <tt>S</tt> has no columns and the block can only be
+   *  multiplied by vectors until @ref decompress_uniform is called. */
+  pqmatrix CS;
   /** @brief Next row block in list */
   puniform rnext;
   /** @brief Previous row block in list */
@@ -260,6 +266,56 @@ normfrob_fast_uniform(pcuniform u, pcclusteroperator rw, pcclusteroperator cw);
 HEADER_PREFIX void
 mvm_uniform_avector(field alpha, bool trans, pcuniform u, pcavector x, pavector y);
 
+/** @brief Multiply the coupling matrix @f$S_b@f$ or its adjoint by
+ *  a coefficient vector, @f$\hat y \gets \hat y + \alpha S_b \hat x@f$
+ *  or @f$\hat y \gets \hat y + \alpha S_b^* \hat x@f$.
+ *
+ *  Works for compressed coupling matrices as well.
+ *
+ *  @param alpha Scaling factor @f$\alpha@f$.
+ *  @param trans Set if @f$S_b^*@f$ is to be used instead of @f$S_b@f$.
+ *  @param u @ref _uniform "uniform" matrix.
+ *  @param xt Source coefficients @f$\hat x@f$.
+ *  @param yt Target coefficients @f$\hat y@f$. */
+HEADER_PREFIX void
+mvm_coupling_uniform_avector(field alpha, bool trans, pcuniform u,
+			     pcavector xt, pavector yt);
+
+/* ------------------------------------------------------------
+ Lossy compression
+ ------------------------------------------------------------ */
+
+/** @brief Store the coupling matrix in a lossy compressed format with
+ *  adaptive precision.
+ *
+ *  Every column @f$s_j@f$ of @f$S_b@f$ is stored with the number of
+ *  bits required for an error of @f$\epsilon \rho / \sqrt{k}@f$, where
+ *  @f$k@f$ is the number of columns and @f$\rho@f$ is one for absolute,
+ *  @f$\|S_b\|_2@f$ for relative spectral and @f$\|S_b\|_F@f$ for
+ *  relative Frobenius errors according to <tt>tm</tt>.
+ *  The error of the coupling matrix is therefore bounded by
+ *  @f$\epsilon \rho@f$, and columns with a small norm need fewer bits.
+ *  If the cluster bases are orthogonal, this is also the error of the
+ *  block.
+ *
+ *  The compressed block can only be multiplied by vectors,
+ *  e.g., by @ref mvm_uniform_avector, other operations require
+ *  @ref decompress_uniform.
+ *
+ *  @param tm Truncation mode.
+ *  @param eps Accuracy @f$\epsilon@f$.
+ *  @param u @ref _uniform "uniform" matrix. */
+HEADER_PREFIX void
+compress_uniform(pctruncmode tm, real eps, puniform u);
+
+/** @brief Restore a coupling matrix compressed by @ref compress_uniform.
+ *
+ *  Does nothing if the coupling matrix is not compressed.
+ *
+ *  @param u @ref _uniform "uniform" matrix. */
+HEADER_PREFIX void
+decompress_uniform(puniform u);
+
 /* ------------------------------------------------------------
  Conversion operations
  ------------------------------------------------------------ */
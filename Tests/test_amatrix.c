@@ -572,6 +572,39 @@ check_clear_copy_lower(pcamatrix a)
   uninit_amatrix(a3);
 }
 
+static void
+check_scratch_amatrix(pcamatrix a)
+{
+  amatrix   tmp1, tmp2, tmp3;
+  pamatrix  s1, s2, s3;
+  real      error;
+  uint      l;
+
+  /* Two rounds: the large matrix first exceeds the scratch stack,
+   * afterwards the stack has been enlarged */
+  for (l = 0; l < 2; l++) {
+    s1 = init_scratch_amatrix(&tmp1, a->rows, a->cols);
+    copy_amatrix(false, a, s1);
+    s2 = init_scratch_amatrix(&tmp2, 300, 300);
+    clear_amatrix(s2);
+    s3 = init_scratch_amatrix(&tmp3, a->rows, a->cols);
+    copy_amatrix(false, a, s3);
+
+    /* Release out of order */
+    uninit_amatrix(s2);
+    error = norm2diff_amatrix(s1, s3) / norm2_amatrix(a);
+    uninit_amatrix(s1);
+    error += norm2diff_amatrix(a, s3) / norm2_amatrix(a);
+    uninit_amatrix(s3);
+
+    (void) printf("Checking init_scratch_amatrix\n"
+		  "  Accuracy %g, %sokay\n", error,
+		  (error < tolerance ? "" : "    NOT "));
+    if (error >= tolerance)
+      problems++;
+  }
+}
+
 static void
 set_unit(pamatrix R)
 {
@@ -914,6 +947,10 @@ main()
   del_amatrix(r);
   del_amatrix(l);
 
+  /* Check temporary matrices */
+  (void) printf("----------------------------------------\n");
+  check_scratch_amatrix(acopy);
+
   /* Check triangular matrix multiplication */
   (void) printf("----------------------------------------\n");
   check_triangularaddmul(false, false, false, false);
@@ -61,6 +61,43 @@ norm2diff_sparsematrix_hmatrix(pcsparsematrix G2, pchmatrix G1)
 }  
 */
 
+static real
+blockeval_error_sparsematrix(bool trans, pcsparsematrix sp)
+{
+  amatrix   tmp1, tmp2;
+  avector   tmp3, tmp4;
+  pamatrix  X, Y;
+  pavector  x, y;
+  uint      rows = (trans ? sp->cols : sp->rows);
+  uint      cols = (trans ? sp->rows : sp->cols);
+  real      error, norm;
+  uint      j;
+
+  X = init_amatrix(&tmp1, cols, 4);
+  Y = init_zero_amatrix(&tmp2, rows, 4);
+  random_amatrix(X);
+
+  if (trans)
+    addevaltrans_sparsematrix_amatrix(1.0, sp, X, Y);
+  else
+    addeval_sparsematrix_amatrix(1.0, sp, X, Y);
+  norm = normfrob_amatrix(Y);
+
+  for (j = 0; j < X->cols; j++) {
+    x = init_column_avector(&tmp3, X, j);
+    y = init_column_avector(&tmp4, Y, j);
+    mvm_sparsematrix_avector(-1.0, trans, sp, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+  error = normfrob_amatrix(Y) / norm;
+
+  uninit_amatrix(Y);
+  uninit_amatrix(X);
+
+  return error;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -159,6 +196,19 @@ main(int argc, char **argv)
   if (!IS_IN_RANGE(0.0, error, 1.0e-16))
     problems++;
 
+  printf("========================================\n"
+	 "  Multiplying sparse matrix with blocks of vectors\n");
+
+  error = blockeval_error_sparsematrix(false, sp);
+  printf("error = %g\n", error);
+  if (!IS_IN_RANGE(0.0, error, 1.0e-14))
+    problems++;
+
+  error = blockeval_error_sparsematrix(true, sp);
+  printf("error adjoint = %g\n", error);
+  if (!IS_IN_RANGE(0.0, error, 1.0e-14))
+    problems++;
+
   printf("========================================\n" "  Cleaning up\n");
   for (i = 0; i <= L; i++) {
     j = L - i;
@@ -4,7 +4,9 @@
 #include "harith.h"
 #include "h2matrix.h"
 #include "h2arith.h"
+#include "h2update.h"
 #include "truncation.h"
+#include "flath2matrix.h"
 
 #include "laplacebem2d.h"
 
@@ -28,6 +30,243 @@ static real tolerance = 1.0e-6;
 static real tolerance = 1.0e-12;
 #endif
 
+static void
+check_blockeval_h2matrix(bool trans, pch2matrix h2)
+{
+  amatrix   xtmp, ytmp;
+  pamatrix  X, Y;
+  avector   xvtmp, yvtmp;
+  pavector  x, y;
+  real      error, norm;
+  uint      rows = (trans ? h2->cb->t->size : h2->rb->t->size);
+  uint      cols = (trans ? h2->rb->t->size : h2->cb->t->size);
+  uint      j;
+
+  X = init_amatrix(&xtmp, cols, 7);
+  Y = init_zero_amatrix(&ytmp, rows, 7);
+  random_amatrix(X);
+
+  if (trans)
+    addevaltrans_h2matrix_amatrix(alpha, h2, X, Y);
+  else
+    addeval_h2matrix_amatrix(alpha, h2, X, Y);
+  norm = normfrob_amatrix(Y);
+
+  for (j = 0; j < X->cols; j++) {
+    x = init_column_avector(&xvtmp, X, j);
+    y = init_column_avector(&yvtmp, Y, j);
+    mvm_h2matrix_avector(-alpha, trans, h2, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+  error = normfrob_amatrix(Y) / norm;
+
+  (void) printf("Checking %s_h2matrix_amatrix\n"
+		"  Accuracy %g, %sokay\n",
+		(trans ? "addevaltrans" : "addeval"), error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_amatrix(Y);
+  uninit_amatrix(X);
+}
+
+static void
+check_flath2matrix(bool single, pch2matrix h2)
+{
+  pflath2matrix fh;
+  avector   xtmp, ytmp;
+  pavector  x, y;
+  real      error, norm, tol;
+  bool      trans;
+  uint      rows, cols, l;
+
+  fh = (single ? build_from_h2matrix_single_flath2matrix(h2) :
+	build_from_h2matrix_flath2matrix(h2));
+  tol = (single ? 1.0e-5 : tolerance);
+
+  for (l = 0; l < 2; l++) {
+    trans = (l == 1);
+    rows = (trans ? h2->cb->t->size : h2->rb->t->size);
+    cols = (trans ? h2->rb->t->size : h2->cb->t->size);
+
+    x = init_avector(&xtmp, cols);
+    y = init_zero_avector(&ytmp, rows);
+    random_avector(x);
+
+    if (trans)
+      addevaltrans_flath2matrix_avector(alpha, fh, x, y);
+    else
+      addeval_flath2matrix_avector(alpha, fh, x, y);
+    norm = norm2_avector(y);
+
+    mvm_h2matrix_avector(-alpha, trans, h2, x, y);
+    error = norm2_avector(y) / norm;
+
+    (void) printf("Checking %s%s_flath2matrix_avector\n"
+		  "  Accuracy %g, %sokay\n", (single ? "single precision " : ""),
+		  (trans ? "addevaltrans" : "addeval"), error,
+		  (IS_IN_RANGE(0.0, error, tol) ? "" : "    NOT "));
+    if (!IS_IN_RANGE(0.0, error, tol))
+      problems++;
+
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+
+  del_flath2matrix(fh);
+}
+
+static void
+check_compress_h2matrix(pch2matrix h2)
+{
+  ph2matrix c;
+  ptruncmode tm;
+  avector   xtmp, ytmp;
+  pavector  x, y;
+  real      error, norm, eps;
+  size_t    sz, csz;
+  bool      trans;
+  uint      l;
+
+  eps = 1.0e-6;
+  tm = new_releucl_truncmode();
+
+  c = clone_h2matrix(h2, h2->rb, h2->cb);
+  sz = getfarsize_h2matrix(c);
+  compress_h2matrix(tm, eps, c);
+  csz = getfarsize_h2matrix(c);
+  (void) printf("Compressing coupling matrices, %.1f KB instead of %.1f KB\n",
+		csz / 1024.0, sz / 1024.0);
+  if (csz >= sz)
+    problems++;
+
+  for (l = 0; l < 2; l++) {
+    trans = (l == 1);
+
+    x = init_avector(&xtmp, (trans ? h2->rb->t->size : h2->cb->t->size));
+    y = init_zero_avector(&ytmp, (trans ? h2->cb->t->size : h2->rb->t->size));
+    random_avector(x);
+
+    mvm_h2matrix_avector(alpha, trans, h2, x, y);
+    norm = norm2_avector(y);
+    mvm_h2matrix_avector(-alpha, trans, c, x, y);
+    error = norm2_avector(y) / norm;
+
+    (void) printf("Checking compressed %s_h2matrix_avector\n"
+		  "  Accuracy %g, %sokay\n", (trans ? "addevaltrans" : "addeval"),
+		  error, (IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+    if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+      problems++;
+
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+
+  decompress_h2matrix(c);
+  error = norm2diff_h2matrix(h2, c) / norm2_h2matrix(h2);
+  (void) printf("Checking decompress_h2matrix\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+    problems++;
+
+  del_h2matrix(c);
+  del_truncmode(tm);
+}
+
+static void
+check_arena_h2matrix(pbem2d bem, pblock b, pch2matrix h2)
+{
+  ph2matrix c;
+  pclusterbasis cb;
+  real      error;
+
+  c = build_from_block_arena_h2matrix(b, h2->rb, h2->cb);
+  assemble_bem2d_h2matrix(bem, b, c);
+
+  (void) printf("Checking build_from_block_arena_h2matrix, arena %.1f KB\n",
+		getsize_arena(c->arena) / 1024.0);
+  if (!contains_arena(c->arena, c) || !contains_arena(c->arena, c->son))
+    problems++;
+
+  error = norm2diff_h2matrix(h2, c) / norm2_h2matrix(h2);
+  (void) printf("  Accuracy %g, %sokay\n", error,
+		(error <= tolerance ? "" : "    NOT "));
+  if (error > tolerance)
+    problems++;
+
+  del_h2matrix(c);
+
+  (void) printf("Checking build_from_cluster_arena_clusterbasis\n");
+  cb = build_from_cluster_arena_clusterbasis(h2->rb->t);
+  if (cb->arena == NULL || !contains_arena(cb->arena, cb)
+      || (cb->sons > 0 && !contains_arena(cb->arena, cb->son[0])))
+    problems++;
+  resize_clusterbasis(cb, 2);
+  del_clusterbasis(cb);
+}
+
+static void
+check_rkaccum_h2matrix(pch2matrix h2)
+{
+  ph2matrix h2copy, G, Gorig;
+  pclusterbasis rbcopy, cbcopy;
+  pclusteroperator rwf, cwf;
+  ptruncmode tm;
+  prkaccum  ra;
+  prkmatrix r;
+  pamatrix  D, Dorig;
+  real      error, norm;
+  uint      i;
+
+  assert(h2->son != NULL);
+
+  rbcopy = clone_clusterbasis(h2->rb);
+  cbcopy = clone_clusterbasis(h2->cb);
+  h2copy = clone_h2matrix(h2, rbcopy, cbcopy);
+
+  tm = new_releucl_truncmode();
+  rwf = prepare_row_clusteroperator(h2copy->rb, h2copy->cb, tm);
+  cwf = prepare_col_clusteroperator(h2copy->rb, h2copy->cb, tm);
+
+  /* Off-diagonal block, updated in the same way as by the factorizations */
+  G = h2copy->son[h2copy->rsons - 1];
+  Gorig = h2->son[h2->rsons - 1];
+  Dorig = convert_h2matrix_amatrix(false, Gorig);
+
+  /* Small maximal rank, so that both truncation and flushing are used */
+  ra = new_rkaccum(G, rwf->son[0], cwf->son[0], tm, tolerance, 4);
+  r = new_rkmatrix(G->rb->t->size, G->cb->t->size, 3);
+  for (i = 0; i < 3; i++) {
+    random_amatrix(&r->A);
+    random_amatrix(&r->B);
+    add_rkaccum(r, ra);
+    addmul_amatrix(1.0, false, &r->A, true, &r->B, Dorig);
+  }
+  del_rkaccum(ra);
+
+  D = convert_h2matrix_amatrix(false, G);
+  norm = normfrob_amatrix(Dorig);
+  add_amatrix(-1.0, false, Dorig, D);
+  error = normfrob_amatrix(D) / norm;
+
+  (void) printf("Checking add_rkaccum and flush_rkaccum\n"
+		"  Accuracy %g, %sokay\n", error,
+		(error <= 10.0 * tolerance ? "" : "    NOT "));
+  if (error > 10.0 * tolerance)
+    problems++;
+
+  del_amatrix(D);
+  del_rkmatrix(r);
+  del_amatrix(Dorig);
+  del_clusteroperator(cwf);
+  del_clusteroperator(rwf);
+  del_truncmode(tm);
+  del_h2matrix(h2copy);
+}
+
 int
 main()
 {
@@ -74,6 +313,18 @@ main()
   h2 = build_from_block_h2matrix(block2, rb, cb);
   assemble_bem2d_h2matrix(bem2, block2, h2);
 
+  check_blockeval_h2matrix(false, h2);
+  check_blockeval_h2matrix(true, h2);
+
+  check_flath2matrix(false, h2);
+  check_flath2matrix(true, h2);
+
+  check_compress_h2matrix(h2);
+
+  check_arena_h2matrix(bem2, block2, h2);
+
+  check_rkaccum_h2matrix(h2);
+
   (void) printf("Creating random solution and right-hand side\n");
   x = new_avector(n);
   random_avector(x);
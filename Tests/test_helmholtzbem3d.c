@@ -46,6 +46,10 @@ addeval_A(field alpha, void *matrix, pcavector x, pavector y)
     break;
   }
 
+  /* Combined operators already contain the single layer part */
+  if (eval->V == NULL)
+    return;
+
   switch (eval->Vtype) {
   case AMATRIX:
     addeval_amatrix_avector(beta, (pamatrix) eval->V, x, y);
@@ -505,17 +509,609 @@ test_system(matrixtype mattype, const char *apprxtype,
   freemem(hdata.source);
 }
 
+static void
+test_accuracy(pbem3d bem, accuracybem3d accuracy, const char *name,
+	      pcamatrix Nfull, real tol)
+{
+  pamatrix  N;
+  real      error;
+
+  N = new_amatrix(Nfull->rows, Nfull->cols);
+
+  bem->accuracy = accuracy;
+  bem->nearfield(NULL, NULL, bem, false, N);
+  bem->accuracy = ACCURACY_FULL_BEM3D;
+
+  error = norm2diff_amatrix(N, Nfull) / norm2_amatrix(Nfull);
+  printf("rel. error %s accuracy : %.5e       %s\n", name, error,
+	 (error <= tol ? "    okay" : "NOT okay"));
+
+  if (error > tol)
+    problems++;
+
+  del_amatrix(N);
+}
+
+static void
+test_pairs(pbem3d bem, pcblock broot, const char *name, pcamatrix Nfull)
+{
+  pamatrix  N;
+  real      error;
+
+  setup_nearfield_pairs_bem3d(bem, broot);
+
+  N = new_amatrix(Nfull->rows, Nfull->cols);
+  bem->nearfield(NULL, NULL, bem, false, N);
+
+  error = norm2diff_amatrix(N, Nfull) / norm2_amatrix(Nfull);
+  printf("rel. error %s pair table : %.5e       %s\n", name, error,
+	 (error <= 1.0e-14 ? "    okay" : "NOT okay"));
+
+  if (error > 1.0e-14)
+    problems++;
+
+  del_amatrix(N);
+}
+
+static void
+test_adaptive(pcsurface3d gr, field * kvec, uint q,
+	      basisfunctionbem3d basis_neumann,
+	      basisfunctionbem3d basis_dirichlet, bool exterior)
+{
+  pbem3d    bem, bem_ref;
+  pamatrix  N, Nfixed, Nref;
+  real      error, error_fixed;
+  uint      nn, nd, i;
+
+  nn = basis_neumann == BASIS_LINEAR_BEM3D ? gr->vertices : gr->triangles;
+  nd = basis_dirichlet == BASIS_LINEAR_BEM3D ? gr->vertices : gr->triangles;
+
+  for (i = 0; i < 2; ++i) {
+    if (i == 0) {
+      bem = new_slp_helmholtz_bem3d(kvec, gr, q + 1, q + 2, basis_neumann);
+      bem_ref = new_slp_helmholtz_bem3d(kvec, gr, q + 3, q + 2,
+					basis_neumann);
+      N = new_amatrix(nn, nn);
+      Nfixed = new_amatrix(nn, nn);
+      Nref = new_amatrix(nn, nn);
+    }
+    else {
+      bem = new_dlp_helmholtz_bem3d(kvec, gr, q + 1, q + 2, basis_neumann,
+				    basis_dirichlet, exterior ? 0.5 : -0.5);
+      bem_ref = new_dlp_helmholtz_bem3d(kvec, gr, q + 3, q + 2,
+					basis_neumann, basis_dirichlet,
+					exterior ? 0.5 : -0.5);
+      N = new_amatrix(nn, nd);
+      Nfixed = new_amatrix(nn, nd);
+      Nref = new_amatrix(nn, nd);
+    }
+
+    bem_ref->nearfield(NULL, NULL, bem_ref, false, Nref);
+    bem->nearfield(NULL, NULL, bem, false, Nfixed);
+
+    setup_adaptive_quadrature_bem3d(bem, 1);
+    bem->nearfield(NULL, NULL, bem, false, N);
+
+    error_fixed = norm2diff_amatrix(Nfixed, Nref) / norm2_amatrix(Nref);
+    error = norm2diff_amatrix(N, Nref) / norm2_amatrix(Nref);
+    printf("rel. error %s adaptive quadrature : %.5e (fixed %.5e) %s\n",
+	   (i == 0 ? "V " : "KM"), error, error_fixed,
+	   (error <= 1.1 * error_fixed ? "    okay" : "NOT okay"));
+    if (error > 1.1 * error_fixed)
+      problems++;
+
+    del_amatrix(Nref);
+    del_amatrix(Nfixed);
+    del_amatrix(N);
+    del_helmholtz_bem3d(bem_ref);
+    del_helmholtz_bem3d(bem);
+  }
+  printf("\n");
+}
+
+static void
+test_combined(const char *apprxtype, pcamatrix Afull, pblock broot,
+	      pbem3d bem, phmatrix A, basisfunctionbem3d basis, bool exterior,
+	      real low, real high)
+{
+  pavector  x, b;
+  struct _eval_A eval;
+  helmholtz_data hdata;
+  real      errorA, error_solve, eps_solve;
+  uint      steps;
+  boundary_func3d rhs = (boundary_func3d) rhs_dirichlet_point_helmholtzbem3d;
+
+  eps_solve = 1.0e-12;
+  steps = 1000;
+
+  printf("Testing: %c%c %s Hmatrix combined %s\n"
+	 "====================================\n\n",
+	 basis == BASIS_LINEAR_BEM3D ? 'l' : 'c',
+	 basis == BASIS_LINEAR_BEM3D ? 'l' : 'c',
+	 (exterior == true ? "exterior" : "interior"), apprxtype);
+
+  assemble_bem3d_hmatrix(bem, broot, A);
+  errorA = norm2diff_amatrix_hmatrix(A, Afull) / norm2_amatrix(Afull);
+  printf("rel. error K%c0.5*M-i*eta*V : %.5e\n",
+	 (exterior == true ? '+' : '-'), errorA);
+
+  eval.V = NULL;
+  eval.Vtype = HMATRIX;
+  eval.KM = A;
+  eval.KMtype = HMATRIX;
+  eval.eta = bem->k;
+
+  hdata.kvec = bem->kvec;
+  hdata.source = allocreal(3);
+  if (exterior) {
+    hdata.source[0] = 0.0, hdata.source[1] = 0.0, hdata.source[2] = 0.2;
+  }
+  else {
+    hdata.source[0] = 0.0, hdata.source[1] = 0.0, hdata.source[2] = 5.0;
+  }
+
+  x = new_avector(Afull->cols);
+  b = new_avector(Afull->rows);
+
+  printf("Solving Dirichlet problem:\n");
+
+  if (basis == BASIS_LINEAR_BEM3D) {
+    integrate_bem3d_linear_avector(bem, rhs, b, (void *) &hdata);
+  }
+  else {
+    integrate_bem3d_const_avector(bem, rhs, b, (void *) &hdata);
+  }
+
+  solve_gmres_bem3d(HMATRIX, (void *) &eval, b, x, eps_solve, steps);
+
+  error_solve = max_rel_outer_error(bem, &hdata, x, rhs, basis);
+
+  printf("max. rel. error : %.5e       %s\n", error_solve,
+	 (IS_IN_RANGE(low, error_solve, high) ? "    okay" : "NOT okay"));
+
+  if (!IS_IN_RANGE(low, error_solve, high))
+    problems++;
+
+  printf("\n");
+
+  del_avector(x);
+  del_avector(b);
+  freemem(hdata.source);
+}
+
+static void
+test_wave(pcsurface3d gr, field * kvec, uint q, pcluster rootn,
+	  pcluster rootd, real eta, basisfunctionbem3d basis_neumann,
+	  basisfunctionbem3d basis_dirichlet, bool exterior)
+{
+  pbem3d    bem[3];
+  field     kv[3][3];
+  pblock    broot;
+  phmatrix  G[3], Gref;
+  pclusterbasis rb, cb;
+  ph2matrix G2[3], G2ref;
+  real      error;
+  uint      j, nk, m;
+
+  nk = 3;
+  m = 4;
+
+  for (j = 0; j < nk; ++j) {
+    kv[j][0] = (0.5 + 0.5 * j) * kvec[0];
+    kv[j][1] = (0.5 + 0.5 * j) * kvec[1];
+    kv[j][2] = (0.5 + 0.5 * j) * kvec[2];
+    bem[j] = new_dlp_helmholtz_bem3d(kv[j], gr, q, q + 2, basis_neumann,
+				     basis_dirichlet, exterior ? 0.5 : -0.5);
+  }
+
+  /* Hmatrix */
+  broot = build_nonstrict_block(rootn, rootd, &eta, admissible_max_cluster);
+  for (j = 0; j < nk; ++j) {
+    setup_hmatrix_aprx_inter_row_bem3d(bem[j], rootn, rootd, broot, m);
+    G[j] = build_from_block_hmatrix(broot, 0);
+  }
+  assemble_bem3d_wave_hmatrix(bem, nk, broot, G);
+
+  Gref = build_from_block_hmatrix(broot, 0);
+  for (j = 0; j < nk; ++j) {
+    assemble_bem3d_hmatrix(bem[j], broot, Gref);
+    error = norm2diff_hmatrix(G[j], Gref) / norm2_hmatrix(Gref);
+    printf("rel. error wavenumber %.2f Hmatrix  : %.5e       %s\n",
+	   bem[j]->k, error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+    if (error > 1.0e-13)
+      problems++;
+    del_hmatrix(G[j]);
+  }
+  del_hmatrix(Gref);
+  del_block(broot);
+
+  /* H2matrix sharing the interpolation cluster bases */
+  broot = build_strict_block(rootn, rootd, &eta, admissible_max_cluster);
+  rb = build_from_cluster_clusterbasis(rootn);
+  cb = build_from_cluster_clusterbasis(rootd);
+  for (j = 0; j < nk; ++j) {
+    setup_h2matrix_aprx_inter_bem3d(bem[j], rb, cb, broot, m);
+    G2[j] = build_from_block_h2matrix(broot, rb, cb);
+  }
+  assemble_bem3d_h2matrix_row_clusterbasis(bem[0], rb);
+  assemble_bem3d_h2matrix_col_clusterbasis(bem[0], cb);
+  assemble_bem3d_wave_h2matrix(bem, nk, broot, G2);
+
+  G2ref = build_from_block_h2matrix(broot, rb, cb);
+  for (j = 0; j < nk; ++j) {
+    assemble_bem3d_h2matrix(bem[j], broot, G2ref);
+    error = norm2diff_h2matrix(G2[j], G2ref) / norm2_h2matrix(G2ref);
+    printf("rel. error wavenumber %.2f H2matrix : %.5e       %s\n",
+	   bem[j]->k, error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+    if (error > 1.0e-13)
+      problems++;
+    del_h2matrix(G2[j]);
+  }
+  del_h2matrix(G2ref);
+  del_block(broot);
+  printf("\n");
+
+  for (j = 0; j < nk; ++j) {
+    del_helmholtz_bem3d(bem[j]);
+  }
+}
+
+static void
+test_matrixfree(pbem3d bem, pcluster rootn, pcluster rootd, real eta)
+{
+  pblock    broot;
+  phmatrix  G, Gfree;
+  pclusterbasis rb, cb;
+  ph2matrix G2, G2free;
+  pavector  x, y, yfree, xt, yt, ytfree;
+  real      error;
+  uint      m;
+
+  m = 4;
+
+  x = new_avector(rootd->size);
+  y = new_avector(rootn->size);
+  yfree = new_avector(rootn->size);
+  xt = new_avector(rootn->size);
+  yt = new_avector(rootd->size);
+  ytfree = new_avector(rootd->size);
+  random_avector(x);
+  random_avector(xt);
+
+  /* Hmatrix */
+  broot = build_nonstrict_block(rootn, rootd, &eta, admissible_max_cluster);
+  setup_hmatrix_aprx_inter_row_bem3d(bem, rootn, rootd, broot, m);
+  G = build_from_block_hmatrix(broot, 0);
+  assemble_bem3d_hmatrix(bem, broot, G);
+  Gfree = build_from_block_matrixfree_hmatrix(broot, 0, fill_bem3d_amatrix,
+					      bem);
+  assemble_bem3d_hmatrix(bem, broot, Gfree);
+
+  clear_avector(y);
+  clear_avector(yfree);
+  addeval_hmatrix_avector(1.0, G, x, y);
+  addeval_hmatrix_avector(1.0, Gfree, x, yfree);
+  add_avector(-1.0, y, yfree);
+  error = norm2_avector(yfree) / norm2_avector(y);
+  printf("rel. error matrix-free Hmatrix            : %.5e       %s\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  clear_avector(yt);
+  clear_avector(ytfree);
+  addevaltrans_hmatrix_avector(1.0, G, xt, yt);
+  addevaltrans_hmatrix_avector(1.0, Gfree, xt, ytfree);
+  add_avector(-1.0, yt, ytfree);
+  error = norm2_avector(ytfree) / norm2_avector(yt);
+  printf("rel. error matrix-free Hmatrix adjoint    : %.5e       %s\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  del_hmatrix(Gfree);
+  del_hmatrix(G);
+  del_block(broot);
+
+  /* H2matrix */
+  broot = build_strict_block(rootn, rootd, &eta, admissible_max_cluster);
+  rb = build_from_cluster_clusterbasis(rootn);
+  cb = build_from_cluster_clusterbasis(rootd);
+  setup_h2matrix_aprx_inter_bem3d(bem, rb, cb, broot, m);
+  G2 = build_from_block_h2matrix(broot, rb, cb);
+  G2free = build_from_block_matrixfree_h2matrix(broot, rb, cb,
+						fill_bem3d_amatrix, bem);
+  assemble_bem3d_h2matrix_row_clusterbasis(bem, rb);
+  assemble_bem3d_h2matrix_col_clusterbasis(bem, cb);
+  assemble_bem3d_h2matrix(bem, broot, G2);
+  assemble_bem3d_h2matrix(bem, broot, G2free);
+
+  clear_avector(y);
+  clear_avector(yfree);
+  addeval_h2matrix_avector(1.0, G2, x, y);
+  addeval_h2matrix_avector(1.0, G2free, x, yfree);
+  add_avector(-1.0, y, yfree);
+  error = norm2_avector(yfree) / norm2_avector(y);
+  printf("rel. error matrix-free H2matrix           : %.5e       %s\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  clear_avector(yt);
+  clear_avector(ytfree);
+  addevaltrans_h2matrix_avector(1.0, G2, xt, yt);
+  addevaltrans_h2matrix_avector(1.0, G2free, xt, ytfree);
+  add_avector(-1.0, yt, ytfree);
+  error = norm2_avector(ytfree) / norm2_avector(yt);
+  printf("rel. error matrix-free H2matrix adjoint   : %.5e       %s\n\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  del_h2matrix(G2free);
+  del_h2matrix(G2);
+  del_block(broot);
+
+  del_avector(ytfree);
+  del_avector(yt);
+  del_avector(xt);
+  del_avector(yfree);
+  del_avector(y);
+  del_avector(x);
+}
+
+static void
+test_matrixfree_symm(pbem3d bem, pcluster root, real eta)
+{
+  pblock    broot;
+  phmatrix  G, Gfree;
+  pclusterbasis rb, cb;
+  ph2matrix G2, G2free;
+  pavector  x, y, yfree;
+  real      error;
+  uint      m;
+
+  m = 4;
+
+  x = new_avector(root->size);
+  y = new_avector(root->size);
+  yfree = new_avector(root->size);
+  random_avector(x);
+
+  /* Hmatrix, only the lower triangular part is used */
+  broot = build_nonstrict_block(root, root, &eta, admissible_max_cluster);
+  setup_hmatrix_aprx_inter_row_bem3d(bem, root, root, broot, m);
+  G = build_from_block_hmatrix(broot, 0);
+  assemble_bem3d_hmatrix(bem, broot, G);
+  Gfree = build_from_block_matrixfree_hmatrix(broot, 0, fill_bem3d_amatrix,
+					      bem);
+  assemble_bem3d_hmatrix(bem, broot, Gfree);
+
+  clear_avector(y);
+  clear_avector(yfree);
+  addevalsymm_hmatrix_avector(1.0, G, x, y);
+  addevalsymm_hmatrix_avector(1.0, Gfree, x, yfree);
+  add_avector(-1.0, y, yfree);
+  error = norm2_avector(yfree) / norm2_avector(y);
+  printf("rel. error matrix-free Hmatrix symmetric  : %.5e       %s\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  del_hmatrix(Gfree);
+  del_hmatrix(G);
+  del_block(broot);
+
+  /* H2matrix */
+  broot = build_strict_block(root, root, &eta, admissible_max_cluster);
+  rb = build_from_cluster_clusterbasis(root);
+  cb = build_from_cluster_clusterbasis(root);
+  setup_h2matrix_aprx_inter_bem3d(bem, rb, cb, broot, m);
+  G2 = build_from_block_h2matrix(broot, rb, cb);
+  G2free = build_from_block_matrixfree_h2matrix(broot, rb, cb,
+						fill_bem3d_amatrix, bem);
+  assemble_bem3d_h2matrix_row_clusterbasis(bem, rb);
+  assemble_bem3d_h2matrix_col_clusterbasis(bem, cb);
+  assemble_bem3d_h2matrix(bem, broot, G2);
+  assemble_bem3d_h2matrix(bem, broot, G2free);
+
+  clear_avector(y);
+  clear_avector(yfree);
+  addevalsymm_h2matrix_avector(1.0, G2, x, y);
+  addevalsymm_h2matrix_avector(1.0, G2free, x, yfree);
+  add_avector(-1.0, y, yfree);
+  error = norm2_avector(yfree) / norm2_avector(y);
+  printf("rel. error matrix-free H2matrix symmetric : %.5e       %s\n\n",
+	 error, (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-13)
+    problems++;
+
+  del_h2matrix(G2free);
+  del_h2matrix(G2);
+  del_block(broot);
+
+  del_avector(yfree);
+  del_avector(y);
+  del_avector(x);
+}
+
+static void
+test_window(pcsurface3d gr, field * kvec, uint q, uint clf, real eta,
+	    basisfunctionbem3d basis)
+{
+  pbem3d    bem;
+  pcluster  root;
+  pblock    broot;
+  pamatrix  Vfull;
+  phmatrix  V, Vref;
+  pclusterbasis rb, cb;
+  ph2matrix V2;
+  real      data[2];
+  size_t    sz, szref;
+  real      error;
+  uint      m;
+
+  m = 4;
+
+  bem = new_slp_window_helmholtz_bem3d(kvec, gr, q, q + 2, basis, 0.5, 1.0);
+  root = build_bem3d_cluster(bem, clf, basis);
+
+  Vfull = new_amatrix(root->size, root->size);
+  bem->nearfield(NULL, NULL, bem, false, Vfull);
+
+  data[0] = eta;
+  data[1] = bem->window_b;
+
+  /* Hmatrix with structural zeros compared to a plain Hmatrix */
+  broot = build_nonstrict_block(root, root, data,
+				admissible_max_cutoff_cluster);
+  setup_hmatrix_aprx_inter_row_bem3d(bem, root, root, broot, m);
+  V = build_from_block_cutoff_hmatrix(broot, 0, bem->window_b);
+  assemble_bem3d_hmatrix(bem, broot, V);
+  Vref = build_from_block_hmatrix(broot, m * m * m);
+  del_block(broot);
+
+  sz = getsize_hmatrix(V);
+  szref = getsize_hmatrix(Vref);
+  printf("storage windowed Hmatrix        : %.2f KB of %.2f KB %s\n",
+	 sz / 1024.0, szref / 1024.0, (sz < szref ? "    okay" : "NOT okay"));
+  if (sz >= szref)
+    problems++;
+
+  error = norm2diff_amatrix_hmatrix(V, Vfull) / norm2_amatrix(Vfull);
+  printf("rel. error windowed Hmatrix     : %.5e       %s\n", error,
+	 (error <= 1.0e-3 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-3)
+    problems++;
+
+  del_hmatrix(Vref);
+  del_hmatrix(V);
+
+  /* H2matrix with absent uniform blocks */
+  broot = build_strict_block(root, root, data,
+			     admissible_max_cutoff_cluster);
+  rb = build_from_cluster_clusterbasis(root);
+  cb = build_from_cluster_clusterbasis(root);
+  setup_h2matrix_aprx_inter_bem3d(bem, rb, cb, broot, m);
+  V2 = build_from_block_cutoff_h2matrix(broot, rb, cb, bem->window_b);
+  assemble_bem3d_h2matrix_row_clusterbasis(bem, rb);
+  assemble_bem3d_h2matrix_col_clusterbasis(bem, cb);
+  assemble_bem3d_h2matrix(bem, broot, V2);
+
+  error = norm2diff_amatrix_h2matrix(V2, Vfull) / norm2_amatrix(Vfull);
+  printf("rel. error windowed H2matrix    : %.5e       %s\n\n", error,
+	 (error <= 1.0e-3 ? "    okay" : "NOT okay"));
+  if (error > 1.0e-3)
+    problems++;
+
+  del_h2matrix(V2);
+  del_block(broot);
+  del_amatrix(Vfull);
+  freemem(root->idx);
+  del_cluster(root);
+  del_helmholtz_bem3d(bem);
+}
+
+static void
+test_dh2(pcsurface3d gr, uint q, uint clf, real eta,
+	 basisfunctionbem3d basis_neumann, basisfunctionbem3d basis_dirichlet)
+{
+  pbem3d    bem_slp, bem_dlp;
+  pcluster  rootn, rootd;
+  pblock    broot;
+  pamatrix  Afull;
+  pdclusterbasis rb, cb;
+  pdh2matrix A;
+  field     kvec[3];
+  real      data[3];
+  real      error;
+  uint      m;
+
+  m = 4;
+
+  kvec[0] = 0.0, kvec[1] = 8.0, kvec[2] = 0.0;
+
+  bem_slp = new_slp_helmholtz_bem3d(kvec, gr, q, q + 2, basis_neumann);
+  bem_dlp = new_dlp_helmholtz_bem3d(kvec, gr, q, q + 2, basis_neumann,
+				    basis_dirichlet, 0.0);
+  rootn = build_bem3d_cluster(bem_slp, clf, basis_neumann);
+  rootd = build_bem3d_cluster(bem_dlp, clf, basis_dirichlet);
+
+  data[0] = eta;
+  data[1] = 16.0;
+  data[2] = bem_slp->k;
+
+  /* Single layer potential */
+  Afull = new_amatrix(rootn->size, rootn->size);
+  bem_slp->nearfield(NULL, NULL, bem_slp, false, Afull);
+
+  broot = build_strict_block(rootn, rootn, data,
+			     admissible_parabolic_cluster);
+  rb = build_from_cluster_dclusterbasis(rootn, bem_slp->k, 0.15);
+  cb = build_from_cluster_dclusterbasis(rootn, bem_slp->k, 0.15);
+  setup_dh2matrix_aprx_inter_bem3d(bem_slp, m);
+  A = build_from_block_dh2matrix(broot, rb, cb);
+  assemble_bem3d_dh2matrix_row_dclusterbasis(bem_slp, rb);
+  assemble_bem3d_dh2matrix_col_dclusterbasis(bem_slp, cb);
+  assemble_bem3d_dh2matrix(bem_slp, A);
+
+  error = norm2diff_amatrix_dh2matrix(A, Afull) / norm2_amatrix(Afull);
+  printf("rel. error directional SLP      : %.5e       %s\n", error,
+	 (error <= 5.0e-3 ? "    okay" : "NOT okay"));
+  if (error > 5.0e-3)
+    problems++;
+
+  del_dh2matrix(A);
+  del_dclusterbasis(cb);
+  del_dclusterbasis(rb);
+  del_block(broot);
+  del_amatrix(Afull);
+
+  /* Double layer potential */
+  Afull = new_amatrix(rootn->size, rootd->size);
+  bem_dlp->nearfield(NULL, NULL, bem_dlp, false, Afull);
+
+  broot = build_strict_block(rootn, rootd, data,
+			     admissible_parabolic_cluster);
+  rb = build_from_cluster_dclusterbasis(rootn, bem_dlp->k, 0.15);
+  cb = build_from_cluster_dclusterbasis(rootd, bem_dlp->k, 0.15);
+  setup_dh2matrix_aprx_inter_bem3d(bem_dlp, m);
+  A = build_from_block_dh2matrix(broot, rb, cb);
+  assemble_bem3d_dh2matrix_row_dclusterbasis(bem_dlp, rb);
+  assemble_bem3d_dh2matrix_col_dclusterbasis(bem_dlp, cb);
+  assemble_bem3d_dh2matrix(bem_dlp, A);
+
+  error = norm2diff_amatrix_dh2matrix(A, Afull) / norm2_amatrix(Afull);
+  printf("rel. error directional DLP      : %.5e       %s\n\n", error,
+	 (error <= 5.0e-3 ? "    okay" : "NOT okay"));
+  if (error > 5.0e-3)
+    problems++;
+
+  del_dh2matrix(A);
+  del_dclusterbasis(cb);
+  del_dclusterbasis(rb);
+  del_block(broot);
+  del_amatrix(Afull);
+
+  freemem(rootd->idx);
+  del_cluster(rootd);
+  freemem(rootn->idx);
+  del_cluster(rootn);
+  del_helmholtz_bem3d(bem_dlp);
+  del_helmholtz_bem3d(bem_slp);
+}
+
 void
 test_suite(pcsurface3d gr, field * kvec, uint q, uint clf, real eta,
 	   basisfunctionbem3d basis_neumann,
 	   basisfunctionbem3d basis_dirichlet, bool exterior, real error_min,
 	   real error_max)
 {
-  pbem3d    bem_slp, bem_dlp;
+  pbem3d    bem_slp, bem_dlp, bem_bw;
   pcluster  rootn, rootd;
   pblock    brootV, brootKM;
-  pamatrix  Vfull, KMfull;
-  phmatrix  V, KM;
+  pamatrix  Vfull, KMfull, Afull, Asum;
+  phmatrix  V, KM, A;
   pclusterbasis Vrb, Vcb, KMrb, KMcb;
   ph2matrix V2, KM2;
   uint      nn, nd;
@@ -524,6 +1120,7 @@ test_suite(pcsurface3d gr, field * kvec, uint q, uint clf, real eta,
   uint      l;
   real      delta;
   real      eps_aca;
+  real      error;
 
   nn = basis_neumann == BASIS_LINEAR_BEM3D ? gr->vertices : gr->triangles;
   nd = basis_dirichlet == BASIS_LINEAR_BEM3D ? gr->vertices : gr->triangles;
@@ -546,6 +1143,30 @@ test_suite(pcsurface3d gr, field * kvec, uint q, uint clf, real eta,
   bem_slp->nearfield(NULL, NULL, bem_slp, false, Vfull);
   bem_dlp->nearfield(NULL, NULL, bem_dlp, false, KMfull);
 
+  /*
+   * Test reduced accuracy of the kernel evaluation
+   */
+
+  test_accuracy(bem_slp, ACCURACY_HIGH_BEM3D, "V high", Vfull, 1.0e-9);
+  test_accuracy(bem_slp, ACCURACY_LOW_BEM3D, "V low", Vfull, 1.0e-5);
+  test_accuracy(bem_dlp, ACCURACY_HIGH_BEM3D, "KM high", KMfull, 1.0e-9);
+  test_accuracy(bem_dlp, ACCURACY_LOW_BEM3D, "KM low", KMfull, 1.0e-5);
+  printf("\n");
+
+  /*
+   * Test precomputed near-field pair table
+   */
+
+  test_pairs(bem_slp, brootV, "V", Vfull);
+  test_pairs(bem_dlp, brootKM, "KM", KMfull);
+  printf("\n");
+
+  /*
+   * Test distance-adaptive regular quadrature
+   */
+
+  test_adaptive(gr, kvec, q, basis_neumann, basis_dirichlet, exterior);
+
   /*
    * Test Interpolation
    */
@@ -663,6 +1284,83 @@ test_suite(pcsurface3d gr, field * kvec, uint q, uint clf, real eta,
   test_system(HMATRIX, "HCA2", Vfull, KMfull, brootV, bem_slp, V, brootKM,
 	      bem_dlp, KM, basis_neumann, basis_dirichlet, exterior,
 	      error_min, error_max);
+  /*
+   * Test simultaneous assembly for several wavenumbers
+   */
+
+  test_wave(gr, kvec, q, rootn, rootd, eta, basis_neumann, basis_dirichlet,
+	    exterior);
+
+  /*
+   * Test matrix-free nearfield
+   */
+
+  test_matrixfree(bem_dlp, rootn, rootd, eta);
+  test_matrixfree_symm(bem_slp, rootn, eta);
+
+  /*
+   * Test windowed kernel with structural zero blocks
+   */
+
+  test_window(gr, kvec, q, clf, eta, basis_neumann);
+
+  /*
+   * Test directional H2-matrices for a higher wavenumber
+   */
+
+  test_dh2(gr, q, clf, eta, basis_neumann, basis_dirichlet);
+
+  /*
+   * Test fused assembly of the Brakhage-Werner operator
+   */
+
+  if (basis_neumann == basis_dirichlet) {
+    bem_bw = new_combined_helmholtz_bem3d(kvec, gr, q, q + 2, basis_neumann,
+					  exterior ? 0.5 : -0.5,
+					  -I * bem_slp->k);
+
+    Afull = new_amatrix(nn, nd);
+    bem_bw->nearfield(NULL, NULL, bem_bw, false, Afull);
+
+    Asum = new_amatrix(nn, nd);
+    copy_amatrix(false, KMfull, Asum);
+    add_amatrix(-I * bem_slp->k, false, Vfull, Asum);
+    error = norm2diff_amatrix(Afull, Asum) / norm2_amatrix(Asum);
+    printf("rel. error fused K%c0.5*M-i*eta*V : %.5e       %s\n\n",
+	   (exterior == true ? '+' : '-'), error,
+	   (error <= 1.0e-13 ? "    okay" : "NOT okay"));
+    if (error > 1.0e-13)
+      problems++;
+    del_amatrix(Asum);
+
+    A = build_from_block_hmatrix(brootKM, 0);
+
+    m = 4;
+    setup_hmatrix_aprx_inter_row_bem3d(bem_bw, rootn, rootd, brootKM, m);
+    test_combined("Interpolation row", Afull, brootKM, bem_bw, A,
+		  basis_neumann, exterior, error_min, error_max);
+    setup_hmatrix_aprx_inter_col_bem3d(bem_bw, rootn, rootd, brootKM, m);
+    test_combined("Interpolation column", Afull, brootKM, bem_bw, A,
+		  basis_neumann, exterior, error_min, error_max);
+
+    m = 5;
+    l = 1;
+    delta = 0.5;
+    setup_hmatrix_aprx_green_row_bem3d(bem_bw, rootn, rootd, brootKM, m, l,
+				       delta, build_bem3d_cube_quadpoints);
+    test_combined("Green row", Afull, brootKM, bem_bw, A, basis_neumann,
+		  exterior, error_min, error_max);
+
+    eps_aca = 1.0e-2;
+    setup_hmatrix_aprx_paca_bem3d(bem_bw, rootn, rootd, brootKM, eps_aca);
+    test_combined("ACA partial pivoting", Afull, brootKM, bem_bw, A,
+		  basis_neumann, exterior, error_min, error_max);
+
+    del_hmatrix(A);
+    del_amatrix(Afull);
+    del_helmholtz_bem3d(bem_bw);
+  }
+
   /*
    * H2-matrix
    */
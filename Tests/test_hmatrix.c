@@ -2,7 +2,9 @@
 #include "settings.h"
 #include "hmatrix.h"
 #include "harith.h"
+#include "harith2.h"
 #include "hcoarsen.h"
+#include "flathmatrix.h"
 
 #include "laplacebem2d.h"
 
@@ -46,6 +48,418 @@ check_addhmatrix(phmatrix a, real tol)
   del_hmatrix(acopy);
 }
 
+static void
+check_flathmatrix(pchmatrix a)
+{
+  pflathmatrix fh;
+  amatrix   xtmp, ytmp, ztmp;
+  pamatrix  X, Y, Z;
+  avector   xvtmp, yvtmp, zvtmp;
+  pavector  x, y, z;
+  real      error, norm;
+  uint      n = a->rc->size;
+  uint      m = a->cc->size;
+  uint      cols = 5;
+  uint      j;
+
+  fh = build_from_hmatrix_flathmatrix(a);
+
+  x = init_avector(&xvtmp, m);
+  y = init_avector(&yvtmp, n);
+  z = init_avector(&zvtmp, n);
+  random_avector(x);
+  random_avector(y);
+  copy_avector(y, z);
+
+  addeval_hmatrix_avector(alpha, a, x, y);
+  addeval_flathmatrix_avector(-alpha, fh, x, y);
+  add_avector(-1.0, z, y);
+  norm = norm2_avector(z);
+  error = norm2_avector(y) / norm;
+  (void) printf("Checking addeval_flathmatrix_avector\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_avector(z);
+  uninit_avector(y);
+  uninit_avector(x);
+
+  x = init_avector(&xvtmp, n);
+  y = init_avector(&yvtmp, m);
+  z = init_avector(&zvtmp, m);
+  random_avector(x);
+  random_avector(y);
+  copy_avector(y, z);
+
+  addevaltrans_hmatrix_avector(alpha, a, x, y);
+  addevaltrans_flathmatrix_avector(-alpha, fh, x, y);
+  add_avector(-1.0, z, y);
+  norm = norm2_avector(z);
+  error = norm2_avector(y) / norm;
+  (void) printf("Checking addevaltrans_flathmatrix_avector\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_avector(z);
+  uninit_avector(y);
+  uninit_avector(x);
+
+  X = init_amatrix(&xtmp, m, cols);
+  Y = init_amatrix(&ytmp, n, cols);
+  Z = init_amatrix(&ztmp, n, cols);
+  random_amatrix(X);
+  random_amatrix(Y);
+  copy_amatrix(false, Y, Z);
+
+  for (j = 0; j < cols; j++) {
+    x = init_column_avector(&xvtmp, X, j);
+    y = init_column_avector(&yvtmp, Y, j);
+    addeval_hmatrix_avector(alpha, a, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+  addmul_flathmatrix_amatrix_amatrix(-alpha, false, fh, X, Y);
+  add_amatrix(-1.0, false, Z, Y);
+  norm = norm2_amatrix(Z);
+  error = norm2_amatrix(Y) / norm;
+  (void) printf("Checking addmul_flathmatrix_amatrix_amatrix\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_amatrix(Z);
+  uninit_amatrix(Y);
+  uninit_amatrix(X);
+
+  X = init_amatrix(&xtmp, n, cols);
+  Y = init_amatrix(&ytmp, m, cols);
+  Z = init_amatrix(&ztmp, m, cols);
+  random_amatrix(X);
+  random_amatrix(Y);
+  copy_amatrix(false, Y, Z);
+
+  for (j = 0; j < cols; j++) {
+    x = init_column_avector(&xvtmp, X, j);
+    y = init_column_avector(&yvtmp, Y, j);
+    addevaltrans_hmatrix_avector(alpha, a, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+  addmul_flathmatrix_amatrix_amatrix(-alpha, true, fh, X, Y);
+  add_amatrix(-1.0, false, Z, Y);
+  norm = norm2_amatrix(Z);
+  error = norm2_amatrix(Y) / norm;
+  (void) printf("Checking adjoint addmul_flathmatrix_amatrix_amatrix\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_amatrix(Z);
+  uninit_amatrix(Y);
+  uninit_amatrix(X);
+
+  del_flathmatrix(fh);
+
+  /* Single precision coefficients, only the storage is rounded */
+  fh = build_from_hmatrix_single_flathmatrix(a);
+
+  /* Relative to the norm of the product, not of a random vector */
+  x = init_avector(&xvtmp, m);
+  y = init_zero_avector(&yvtmp, n);
+  random_avector(x);
+
+  addeval_flathmatrix_avector(alpha, fh, x, y);
+  norm = norm2_avector(y);
+  addeval_hmatrix_avector(-alpha, a, x, y);
+  error = norm2_avector(y) / norm;
+  (void) printf("Checking single precision addeval_flathmatrix_avector\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 1.0e-5) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-5))
+    problems++;
+
+  uninit_avector(y);
+  uninit_avector(x);
+
+  x = init_avector(&xvtmp, n);
+  y = init_zero_avector(&yvtmp, m);
+  random_avector(x);
+
+  addevaltrans_flathmatrix_avector(alpha, fh, x, y);
+  norm = norm2_avector(y);
+  addevaltrans_hmatrix_avector(-alpha, a, x, y);
+  error = norm2_avector(y) / norm;
+  (void) printf("Checking single precision addevaltrans_flathmatrix_avector\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 1.0e-5) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 1.0e-5))
+    problems++;
+
+  uninit_avector(y);
+  uninit_avector(x);
+
+  del_flathmatrix(fh);
+}
+
+static void
+check_compress_hmatrix(pchmatrix a)
+{
+  phmatrix  c;
+  ptruncmode tm;
+  avector   xtmp, ytmp;
+  pavector  x, y;
+  real      error, norm, eps;
+  size_t    sz, csz;
+  bool      trans;
+  uint      l;
+
+  eps = 1.0e-6;
+  tm = new_releucl_truncmode();
+
+  c = clone_hmatrix(a);
+  sz = getsize_hmatrix(c);
+  compress_hmatrix(tm, eps, c);
+  csz = getsize_hmatrix(c);
+  (void) printf("Compressing low-rank leaves, %.1f KB instead of %.1f KB\n",
+		csz / 1024.0, sz / 1024.0);
+  if (csz >= sz)
+    problems++;
+
+  for (l = 0; l < 2; l++) {
+    trans = (l == 1);
+
+    x = init_avector(&xtmp, (trans ? a->rc->size : a->cc->size));
+    y = init_zero_avector(&ytmp, (trans ? a->cc->size : a->rc->size));
+    random_avector(x);
+
+    mvm_hmatrix_avector(alpha, trans, a, x, y);
+    norm = norm2_avector(y);
+    mvm_hmatrix_avector(-alpha, trans, c, x, y);
+    error = norm2_avector(y) / norm;
+
+    (void) printf("Checking compressed %s_hmatrix_avector\n"
+		  "  Accuracy %g, %sokay\n", (trans ? "addevaltrans" : "addeval"),
+		  error, (IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+    if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+      problems++;
+
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+
+  decompress_hmatrix(c);
+  error = norm2diff_hmatrix(a, c) / norm2_hmatrix(a);
+  (void) printf("Checking decompress_hmatrix\n"
+		"  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+    problems++;
+
+  del_hmatrix(c);
+  del_truncmode(tm);
+}
+
+static void
+check_random_rkmatrix()
+{
+  prkmatrix r, r2;
+  pamatrix  G, D;
+  ptruncmode tm;
+  real      error, norm, eps;
+  uint      rows, cols, k, i, j;
+
+  rows = 200;
+  cols = 150;
+  k = 40;
+  eps = 1.0e-6;
+
+  tm = new_releucl_truncmode();
+  tm->randomized = true;
+
+  /* Low-rank matrix with exponentially decaying singular values */
+  r = new_rkmatrix(rows, cols, k);
+  random_amatrix(&r->A);
+  random_amatrix(&r->B);
+  for (j = 0; j < k; j++)
+    for (i = 0; i < rows; i++)
+      r->A.a[i + j * r->A.ld] *= REAL_POW(0.5, j);
+
+  G = new_amatrix(rows, cols);
+  clear_amatrix(G);
+  add_rkmatrix_amatrix(1.0, false, r, G);
+  norm = norm2_amatrix(G);
+  D = new_amatrix(rows, cols);
+
+  r2 = new_rkmatrix(rows, cols, 0);
+  decomp_random_rkmatrix(G, tm, eps, r2);
+  copy_amatrix(false, G, D);
+  add_rkmatrix_amatrix(-1.0, false, r2, D);
+  error = norm2_amatrix(D) / norm;
+  (void) printf("Checking decomp_random_rkmatrix, rank %u\n"
+		"  Accuracy %g, %sokay\n", r2->k, error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps) || r2->k >= k)
+    problems++;
+
+  copy_rkmatrix(false, r, r2);
+  trunc_rkmatrix(tm, eps, r2);
+  copy_amatrix(false, G, D);
+  add_rkmatrix_amatrix(-1.0, false, r2, D);
+  error = norm2_amatrix(D) / norm;
+  (void) printf("Checking randomized trunc_rkmatrix, rank %u\n"
+		"  Accuracy %g, %sokay\n", r2->k, error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps) || r2->k >= k)
+    problems++;
+
+  copy_rkmatrix(false, r, r2);
+  add_rkmatrix(alpha, r, tm, eps, r2);
+  copy_amatrix(false, G, D);
+  scale_amatrix(1.0 + alpha, D);
+  add_rkmatrix_amatrix(-1.0, false, r2, D);
+  error = norm2_amatrix(D) / (ABS(1.0 + alpha) * norm);
+  (void) printf("Checking randomized add_rkmatrix, rank %u\n"
+		"  Accuracy %g, %sokay\n", r2->k, error,
+		(IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, 10.0 * eps) || r2->k >= k)
+    problems++;
+
+  del_rkmatrix(r2);
+  del_amatrix(D);
+  del_amatrix(G);
+  del_rkmatrix(r);
+  del_truncmode(tm);
+}
+
+static void
+check_arena_hmatrix(pbem2d bem, pblock b, pchmatrix a)
+{
+  phmatrix  c;
+  real      error;
+
+  c = build_from_block_arena_hmatrix(b, 0);
+  assemblecoarsen_bem2d_hmatrix(bem, b, c);
+
+  (void) printf("Checking build_from_block_arena_hmatrix, arena %.1f KB\n",
+		getsize_arena(c->arena) / 1024.0);
+  if (!contains_arena(c->arena, c) || !contains_arena(c->arena, c->son))
+    problems++;
+
+  error = norm2diff_hmatrix(a, c) / norm2_hmatrix(a);
+  (void) printf("  Accuracy %g, %sokay\n", error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  del_hmatrix(c);
+}
+
+static void
+check_parallel_factorization_hmatrix(pbem2d bem, pblock b, real eps)
+{
+  phmatrix  a;
+  pavector  x, rhs;
+  real      error;
+  uint      n, variant;
+
+  n = b->rc->size;
+
+  x = new_avector(n);
+  random_avector(x);
+  rhs = new_avector(n);
+
+  for (variant = 0; variant < 4; variant++) {
+    a = build_from_block_hmatrix(b, 0);
+    assemble_bem2d_hmatrix(bem, b, a);
+    coarsen_hmatrix(a, NULL, eps, true);
+
+    clear_avector(rhs);
+    addevalsymm_hmatrix_avector(1.0, a, x, rhs);
+
+    switch (variant) {
+    case 0:
+      (void) printf("Checking lrdecomp_parallel_hmatrix\n");
+      lrdecomp_parallel_hmatrix(a, 0, eps);
+      lrsolve_hmatrix_avector(false, a, rhs);
+      break;
+    case 1:
+      (void) printf("Checking choldecomp_parallel_hmatrix\n");
+      choldecomp_parallel_hmatrix(a, 0, eps);
+      cholsolve_hmatrix_avector(a, rhs);
+      break;
+    case 2:
+      (void) printf("Checking lrdecomp2_parallel_hmatrix\n");
+      lrdecomp2_parallel_hmatrix(a, 0, eps);
+      lrsolve_hmatrix_avector(false, a, rhs);
+      break;
+    default:
+      (void) printf("Checking choldecomp2_parallel_hmatrix\n");
+      choldecomp2_parallel_hmatrix(a, 0, eps);
+      cholsolve_hmatrix_avector(a, rhs);
+    }
+
+    add_avector(-1.0, x, rhs);
+    error = norm2_avector(rhs) / norm2_avector(x);
+    (void) printf("  Accuracy %g, %sokay\n", error,
+		  IS_IN_RANGE(0.0, error, 10.0 * eps) ? "" : "    NOT ");
+    if (!IS_IN_RANGE(0.0, error, 10.0 * eps))
+      problems++;
+
+    del_hmatrix(a);
+  }
+
+  del_avector(rhs);
+  del_avector(x);
+}
+
+static void
+check_blockeval_hmatrix(bool trans, pchmatrix a)
+{
+  amatrix   xtmp, ytmp;
+  pamatrix  X, Y;
+  avector   xvtmp, yvtmp;
+  pavector  x, y;
+  real      error, norm;
+  uint      rows = (trans ? a->cc->size : a->rc->size);
+  uint      cols = (trans ? a->rc->size : a->cc->size);
+  uint      j;
+
+  X = init_amatrix(&xtmp, cols, 7);
+  Y = init_zero_amatrix(&ytmp, rows, 7);
+  random_amatrix(X);
+
+  if (trans)
+    addevaltrans_hmatrix_amatrix(alpha, a, X, Y);
+  else
+    addeval_hmatrix_amatrix(alpha, a, X, Y);
+  norm = normfrob_amatrix(Y);
+
+  for (j = 0; j < X->cols; j++) {
+    x = init_column_avector(&xvtmp, X, j);
+    y = init_column_avector(&yvtmp, Y, j);
+    mvm_hmatrix_avector(-alpha, trans, a, x, y);
+    uninit_avector(y);
+    uninit_avector(x);
+  }
+  error = normfrob_amatrix(Y) / norm;
+
+  (void) printf("Checking %s_hmatrix_amatrix\n"
+		"  Accuracy %g, %sokay\n",
+		(trans ? "addevaltrans" : "addeval"), error,
+		(IS_IN_RANGE(0.0, error, tolerance) ? "" : "    NOT "));
+  if (!IS_IN_RANGE(0.0, error, tolerance))
+    problems++;
+
+  uninit_amatrix(Y);
+  uninit_amatrix(X);
+}
+
 static void
 check_triangularsolve(bool lower, bool unit, bool atrans,
 		      pchmatrix a, bool xtrans, real tol)
@@ -422,6 +836,19 @@ main(int argc, char **argv)
 
   check_addhmatrix(a, tol);
 
+  check_flathmatrix(a);
+
+  check_compress_hmatrix(a);
+
+  check_random_rkmatrix();
+
+  check_arena_hmatrix(bem2, block2, a);
+
+  check_parallel_factorization_hmatrix(bem2, block2, eps_aca);
+
+  check_blockeval_hmatrix(false, a);
+  check_blockeval_hmatrix(true, a);
+
   del_hmatrix(a);
 
   (void) printf("----------------------------------------\n"
@@ -19,11 +19,18 @@ gauss_seidel(void *pdata, pavector r)
   triangularsolve_amatrix_avector(true, false, false, A, r);
 }
 
+static void
+addevalblock_amatrix(field alpha, void *matrix, pcamatrix X, pamatrix Y)
+{
+  addmul_amatrix(alpha, false, (pcamatrix) matrix, false, X, Y);
+}
+
 int
 main()
 {
   pamatrix  A;
   pamatrix  qr;
+  pamatrix  B, X, R, P, AP;
   pavector  b, x;
   pavector  r, p, a, q, rhat, tau;
   real      error;
@@ -168,6 +175,58 @@ main()
     problems++;
   }
 
+  (void) printf("Testing block conjugate gradient method\n");
+  B = new_zero_amatrix(n, 4);
+  X = new_amatrix(n, 4);
+  R = new_amatrix(n, 4);
+  P = new_amatrix(n, 4);
+  AP = new_amatrix(n, 4);
+
+  random_spd_amatrix(A, 1.0);
+  random_amatrix(X);
+
+  init_blockcg(addevalblock_amatrix, A, B, X, R, P, AP);
+  steps = 0;
+  error = normfrob_amatrix(R);
+  while (steps < 2 * n && error > 1e-8) {
+    step_blockcg(addevalblock_amatrix, A, B, X, R, P, AP);
+    steps++;
+    error = normfrob_amatrix(R);
+
+    printf("  Step %u: residual %.2e\n", steps, error);
+  }
+  (void) printf("  %u steps, residual norm %.2e:", steps, error);
+  if (steps <= n && error <= 1e-8)
+    printf("    Okay\n");
+  else {
+    printf("    NOT Okay\n");
+    problems++;
+  }
+
+  (void) printf("Testing block GMRES method\n");
+  random_invertible_amatrix(A, 1.0);
+  random_amatrix(B);
+  clear_amatrix(X);
+
+  steps = solve_blockgmres(addevalblock_amatrix, A, B, X, 1e-10, kmax,
+			   2 * n);
+  copy_amatrix(false, B, R);
+  addmul_amatrix(-1.0, false, A, false, X, R);
+  error = normfrob_amatrix(R) / normfrob_amatrix(B);
+  (void) printf("  %u steps, relative residual norm %.2e:", steps, error);
+  if (steps <= n && error <= 1e-8)
+    printf("    Okay\n");
+  else {
+    printf("    NOT Okay\n");
+    problems++;
+  }
+
+  del_amatrix(AP);
+  del_amatrix(P);
+  del_amatrix(R);
+  del_amatrix(X);
+  del_amatrix(B);
+
   del_avector(tau);
   del_amatrix(qr);
   del_avector(q);
@@ -114,6 +114,22 @@ L2gamma_l_diff_norm2(pbem3d bem, pavector x, boundary_func3d rhs, void *data)
   return norm;
 }
 
+/* Number of admissible leaves of a block tree */
+static uint
+count_admissible_block(pcblock b)
+{
+  uint      n, i;
+
+  if (b->son == NULL)
+    return (b->a ? 1 : 0);
+
+  n = 0;
+  for (i = 0; i < b->rsons * b->csons; i++)
+    n += count_admissible_block(b->son[i]);
+
+  return n;
+}
+
 /* Simple convenience wrapper for conjugate gradient solver */
 static void
 solve_cg_bem3d(matrixtype type, void *A, pavector b, pavector x,
@@ -456,6 +472,18 @@ test_suite(pcsurface3d gr, uint q, uint clf, real eta,
   test_system(HMATRIX, "ACA partial pivoting", Vfull, KMfull, brootV, bem_slp,
 	      V, brootKM, bem_dlp, KM, basis_neumann, basis_dirichlet,
 	      exterior, error_min, error_max);
+  setup_hmatrix_aprx_blockpaca_bem3d(bem_slp, rootn, rootn, brootV, eps_aca,
+				     4);
+  setup_hmatrix_aprx_blockpaca_bem3d(bem_dlp, rootn, rootd, brootKM, eps_aca,
+				     4);
+  test_system(HMATRIX, "ACA blocked partial pivoting", Vfull, KMfull, brootV,
+	      bem_slp, V, brootKM, bem_dlp, KM, basis_neumann,
+	      basis_dirichlet, exterior, error_min, error_max);
+  setup_hmatrix_aprx_rand_bem3d(bem_slp, rootn, rootn, brootV, eps_aca);
+  setup_hmatrix_aprx_rand_bem3d(bem_dlp, rootn, rootd, brootKM, eps_aca);
+  test_system(HMATRIX, "Randomized range finder", Vfull, KMfull, brootV,
+	      bem_slp, V, brootKM, bem_dlp, KM, basis_neumann,
+	      basis_dirichlet, exterior, error_min, error_max);
 
   setup_hmatrix_aprx_hca_bem3d(bem_slp, rootn, rootn, brootV, m, eps_aca);
   setup_hmatrix_aprx_hca_bem3d(bem_slp, rootn, rootd, brootKM, m, eps_aca);
@@ -494,6 +522,31 @@ test_suite(pcsurface3d gr, uint q, uint clf, real eta,
 	      brootKM, bem_dlp, KM2, basis_neumann, basis_dirichlet, exterior,
 	      error_min, error_max);
 
+  setup_h2matrix_aprx_inter_cached_bem3d(bem_slp, Vrb, Vcb, brootV, m);
+  setup_h2matrix_aprx_inter_cached_bem3d(bem_dlp, KMrb, KMcb, brootKM, m);
+  test_system(H2MATRIX, "Interpolation cached", Vfull, KMfull, brootV,
+	      bem_slp, V2, brootKM, bem_dlp, KM2, basis_neumann,
+	      basis_dirichlet, exterior, error_min, error_max);
+  printf("Cached coupling matrices V : %u of %u blocks, %.1f + %.1f KB\n",
+	 getcachedcouplings_bem3d(bem_slp), count_admissible_block(brootV),
+	 getsize_h2matrix(V2) / 1024.0,
+	 getsize_couplingcache_bem3d(bem_slp) / 1024.0);
+  printf("Cached coupling matrices KM: %u of %u blocks, %.1f + %.1f KB\n\n",
+	 getcachedcouplings_bem3d(bem_dlp), count_admissible_block(brootKM),
+	 getsize_h2matrix(KM2) / 1024.0,
+	 getsize_couplingcache_bem3d(bem_dlp) / 1024.0);
+  if (getcachedcouplings_bem3d(bem_slp) == 0
+      || getcachedcouplings_bem3d(bem_slp) > count_admissible_block(brootV)
+      || getcachedcouplings_bem3d(bem_dlp) == 0
+      || getcachedcouplings_bem3d(bem_dlp) > count_admissible_block(brootKM))
+    problems++;
+
+  setup_h2matrix_aprx_varinter_bem3d(bem_slp, Vrb, Vcb, brootV, m, 0.5);
+  setup_h2matrix_aprx_varinter_bem3d(bem_dlp, KMrb, KMcb, brootKM, m, 0.5);
+  test_system(H2MATRIX, "Variable-order interpolation", Vfull, KMfull,
+	      brootV, bem_slp, V2, brootKM, bem_dlp, KM2, basis_neumann,
+	      basis_dirichlet, exterior, error_min, error_max);
+
   /*
    * Test Greenhybrid
    */
@@ -537,6 +590,72 @@ test_suite(pcsurface3d gr, uint q, uint clf, real eta,
   del_laplace_bem3d(bem_dlp);
 }
 
+/* Coupling matrix cache on a cylinder: translated clusters along the axis
+ * have to share their coupling matrices */
+static void
+test_couplingcache()
+{
+  pmacrosurface3d mg;
+  psurface3d gr;
+  pbem3d    bem;
+  pcluster  root;
+  pblock    broot;
+  pclusterbasis rb, cb;
+  ph2matrix V, Vc;
+  real      eta, error;
+  uint      blocks, couplings;
+
+  eta = 1.0;
+
+  mg = new_cylinder_macrosurface3d();
+  gr = build_from_macrosurface3d_surface3d(mg, 4);
+
+  bem = new_slp_laplace_bem3d(gr, 2, 4, BASIS_CONSTANT_BEM3D);
+  root = build_bem3d_cluster(bem, 16, BASIS_CONSTANT_BEM3D);
+  broot = build_nonstrict_block(root, root, &eta, admissible_max_cluster);
+  rb = build_from_cluster_clusterbasis(root);
+  cb = build_from_cluster_clusterbasis(root);
+
+  printf("----------------------------------------\n"
+	 "Testing coupling matrix cache on cylinder with %u triangles\n"
+	 "----------------------------------------\n\n", gr->triangles);
+
+  setup_h2matrix_aprx_inter_bem3d(bem, rb, cb, broot, 3);
+  assemble_bem3d_h2matrix_row_clusterbasis(bem, rb);
+  assemble_bem3d_h2matrix_col_clusterbasis(bem, cb);
+  V = build_from_block_h2matrix(broot, rb, cb);
+  assemble_bem3d_h2matrix(bem, broot, V);
+
+  setup_h2matrix_aprx_inter_cached_bem3d(bem, rb, cb, broot, 3);
+  Vc = build_from_block_h2matrix(broot, rb, cb);
+  assemble_bem3d_h2matrix(bem, broot, Vc);
+
+  blocks = count_admissible_block(broot);
+  couplings = getcachedcouplings_bem3d(bem);
+  error = norm2diff_h2matrix(V, Vc) / norm2_h2matrix(V);
+
+  printf("Cached coupling matrices: %u of %u blocks\n", couplings, blocks);
+  printf("Storage: %.1f KB uncached, %.1f + %.1f KB cached\n",
+	 getsize_h2matrix(V) / 1024.0, getsize_h2matrix(Vc) / 1024.0,
+	 getsize_couplingcache_bem3d(bem) / 1024.0);
+  printf("rel. error         : %.5e       %s\n\n", error,
+	 (couplings < blocks && error < 1.0e-12) ? "okay" : "NOT okay");
+  if (couplings >= blocks || error >= 1.0e-12)
+    problems++;
+
+  del_h2matrix(Vc);
+  del_couplingcache_bem3d(bem);
+  if (getcachedcouplings_bem3d(bem) != 0)
+    problems++;
+  del_h2matrix(V);
+  del_block(broot);
+  freemem(root->idx);
+  del_cluster(root);
+  del_laplace_bem3d(bem);
+  del_surface3d(gr);
+  del_macrosurface3d(mg);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -620,6 +739,8 @@ main(int argc, char **argv)
   del_surface3d(gr);
   del_macrosurface3d(mg);
 
+  test_couplingcache();
+
   (void) printf("----------------------------------------\n"
 		"  %u matrices and\n"
 		"  %u vectors still active\n"